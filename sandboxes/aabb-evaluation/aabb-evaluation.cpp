@@ -4,7 +4,7 @@
 
 #include <libslic3r/TriangleMesh.hpp>
 #include <libslic3r/AABBTreeIndirect.hpp>
-#include <libslic3r/SLA/EigenMesh3D.hpp>
+#include <libslic3r/AABBTreeWide.hpp>
 
 #include <Shiny/Shiny.h>
 
@@ -13,6 +13,7 @@
 #pragma warning(disable: 4244)
 #pragma warning(disable: 4267)
 #endif
+#include <igl/per_vertex_normals.h>
 #include <igl/ray_mesh_intersect.h>
 #include <igl/point_mesh_squared_distance.h>
 #include <igl/remove_duplicate_vertices.h>
@@ -28,12 +29,43 @@ const std::string USAGE_STR = {
 
 using namespace Slic3r;
 
+// Cast the ambient occlusion rays of a single vertex as packets of N rays. The last packet is padded with copies of the last ray.
+template<int N, typename TreeType>
+static int num_hits_packet(const TriangleMesh &mesh, const TreeType &tree, const Eigen::MatrixXd &dirs, const Eigen::Vector3d &origin, const Eigen::Vector3d &normal)
+{
+    const int num_samples = int(dirs.rows());
+    int       num_hits    = 0;
+    for (int s = 0; s < num_samples; s += N) {
+        std::array<Eigen::Vector3d, N> origins;
+        std::array<Eigen::Vector3d, N> directions;
+        for (int i = 0; i < N; ++ i) {
+            Eigen::Vector3d d = dirs.row(std::min(s + i, num_samples - 1));
+            if (d.dot(normal) < 0)
+                // reverse ray
+                d *= -1;
+            origins[i]    = origin + 1e-4 * d;
+            directions[i] = d;
+        }
+        std::array<igl::Hit, N> hits;
+        uint32_t mask = AABBTreeIndirect::intersect_ray_packet_first_hit<N>(mesh.its.vertices, mesh.its.indices, tree, origins, directions, hits);
+        for (int i = 0; i < N && s + i < num_samples; ++ i)
+            if ((mask >> i) & 1)
+                ++ num_hits;
+    }
+    return num_hits;
+}
+
 void profile(const TriangleMesh &mesh)
 {
     Eigen::MatrixXd V;
     Eigen::MatrixXi F;
     Eigen::MatrixXd vertex_normals;
-    sla::to_eigen_mesh(mesh, V, F);
+    V.resize(mesh.its.vertices.size(), 3);
+    F.resize(mesh.its.indices.size(), 3);
+    for (size_t i = 0; i < mesh.its.vertices.size(); ++ i)
+        V.row(i) = mesh.its.vertices[i].cast<double>();
+    for (size_t i = 0; i < mesh.its.indices.size(); ++ i)
+        F.row(i) = mesh.its.indices[i];
     igl::per_vertex_normals(V, F, vertex_normals);
 
     static constexpr int num_samples = 100;
@@ -92,6 +124,89 @@ void profile(const TriangleMesh &mesh)
         }
     }
 
+    // Wide (BVH4 / BVH8) trees and ray packets, compared against the binary tree.
+    Eigen::MatrixXd occlusion_output_wide;
+    Eigen::MatrixXd occlusion_output_ref;
+    {
+        AABBTreeIndirect::Tree3f tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(mesh.its.vertices, mesh.its.indices);
+        AABBTreeIndirect::Tree3fBVH4 tree4;
+        AABBTreeIndirect::Tree3fBVH8 tree8;
+        {
+            PROFILE_BLOCK(AABBIndirect_BVH4_Init);
+            tree4.build(tree);
+        }
+        {
+            PROFILE_BLOCK(AABBIndirect_BVH8_Init);
+            tree8.build(tree);
+        }
+        auto check = [&occlusion_output_ref, &occlusion_output_wide](const char *name) {
+            double max_diff = (occlusion_output_wide - occlusion_output_ref).cwiseAbs().maxCoeff();
+            if (max_diff > 0.)
+                std::cout << name << ": ambient occlusion differs from the binary tree by " << max_diff << std::endl;
+        };
+        auto ambient_occlusion = [&](auto &&num_hits) {
+            occlusion_output_wide.resize(num_vertices, 1);
+            for (int ivertex = 0; ivertex < num_vertices; ++ ivertex) {
+                const Eigen::Vector3d origin = mesh.its.vertices[ivertex].template cast<double>();
+                const Eigen::Vector3d normal = vertex_normals.row(ivertex).template cast<double>();
+                occlusion_output_wide(ivertex) = (double)num_hits(origin, normal)/(double)num_samples;
+            }
+        };
+        auto single = [&](const auto &tree) {
+            return [&](const Eigen::Vector3d &origin, const Eigen::Vector3d &normal) {
+                int num_hits = 0;
+                for (int s = 0; s < num_samples; s++) {
+                    Eigen::Vector3d d = dirs.row(s);
+                    if(d.dot(normal) < 0) {
+                        // reverse ray
+                        d *= -1;
+                    }
+                    igl::Hit hit;
+                    if (AABBTreeIndirect::intersect_ray_first_hit(mesh.its.vertices, mesh.its.indices, tree, (origin + 1e-4 * d).eval(), d, hit))
+                        ++ num_hits;
+                }
+                return num_hits;
+            };
+        };
+        auto packet = [&](const auto &tree, auto packet_size) {
+            return [&tree, &mesh, &dirs](const Eigen::Vector3d &origin, const Eigen::Vector3d &normal) {
+                return num_hits_packet<decltype(packet_size)::value>(mesh, tree, dirs, origin, normal);
+            };
+        };
+        ambient_occlusion(single(tree));
+        occlusion_output_ref = occlusion_output_wide;
+        {
+            PROFILE_BLOCK(EigenMesh3D_AABBIndirectBVH4_AmbientOcclusion);
+            ambient_occlusion(single(tree4));
+        }
+        check("BVH4");
+        {
+            PROFILE_BLOCK(EigenMesh3D_AABBIndirectBVH8_AmbientOcclusion);
+            ambient_occlusion(single(tree8));
+        }
+        check("BVH8");
+        {
+            PROFILE_BLOCK(EigenMesh3D_AABBIndirectPacket4_AmbientOcclusion);
+            ambient_occlusion(packet(tree, std::integral_constant<int, 4>()));
+        }
+        check("Packet4");
+        {
+            PROFILE_BLOCK(EigenMesh3D_AABBIndirectPacket8_AmbientOcclusion);
+            ambient_occlusion(packet(tree, std::integral_constant<int, 8>()));
+        }
+        check("Packet8");
+        {
+            PROFILE_BLOCK(EigenMesh3D_AABBIndirectBVH4Packet4_AmbientOcclusion);
+            ambient_occlusion(packet(tree4, std::integral_constant<int, 4>()));
+        }
+        check("BVH4 Packet4");
+        {
+            PROFILE_BLOCK(EigenMesh3D_AABBIndirectBVH8Packet8_AmbientOcclusion);
+            ambient_occlusion(packet(tree8, std::integral_constant<int, 8>()));
+        }
+        check("BVH8 Packet8");
+    }
+
     Eigen::MatrixXd occlusion_output1;
     {
         std::vector<Vec3d> vertices;
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libslic3r/TriangleMesh.hpp>
+#include <libslic3r/QuadricEdgeCollapse.hpp>
+#include <libslic3r/AABBTreeIndirect.hpp>
+#include <libslic3r/Format/OBJ.hpp>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+
+#include "libnest2d/tools/benchmark.h"
+
+// Compares the serial its_quadric_edge_collapse() with its_quadric_edge_collapse_partitioned()
+// by run time and by a distance of the simplified mesh to the source mesh.
+//
+// Usage: its_simplification [ratio] [mesh.obj|mesh.stl|directory]...
+// Without a mesh argument only the synthetic meshes are measured, pass tests/data to measure the test models.
+
+namespace Slic3r {
+
+struct MeasureResult
+{
+    size_t triangles    = 0;
+    double time_s       = 0.;
+    double volume_delta = 0.;
+    double avg_distance = 0.;
+    double max_distance = 0.;
+};
+
+// Distance of the simplified mesh vertices to the source mesh surface.
+static void measure_distance(const indexed_triangle_set &source, const AABBTreeIndirect::Tree3f &tree, const indexed_triangle_set &simplified, MeasureResult &r)
+{
+    double sum = 0.;
+    for (const Vec3f &v : simplified.vertices) {
+        size_t hit_idx;
+        Vec3f  hit_point;
+        double d = std::sqrt(AABBTreeIndirect::squared_distance_to_indexed_triangle_set(source.vertices, source.indices, tree, v, hit_idx, hit_point));
+        sum += d;
+        r.max_distance = std::max(r.max_distance, d);
+    }
+    r.avg_distance = simplified.vertices.empty() ? 0. : sum / simplified.vertices.size();
+}
+
+template<class SimplifyFn>
+static MeasureResult measure(const indexed_triangle_set &its, const AABBTreeIndirect::Tree3f &tree, uint32_t triangle_count, SimplifyFn fn)
+{
+    indexed_triangle_set simplified = its;
+    Benchmark b;
+    b.start();
+    fn(simplified, triangle_count);
+    b.stop();
+
+    MeasureResult r;
+    r.triangles    = simplified.indices.size();
+    r.time_s       = b.getElapsedSec();
+    r.volume_delta = std::abs(its_volume(simplified) - its_volume(its));
+    measure_distance(its, tree, simplified, r);
+    return r;
+}
+
+static void print(const std::string &name, const MeasureResult &r)
+{
+    std::cout << "  " << name << ": " << r.triangles << " triangles, " << r.time_s << " s, volume delta " << r.volume_delta
+              << ", avg distance " << r.avg_distance << ", max distance " << r.max_distance << std::endl;
+}
+
+static void measure_mesh(const std::string &name, const indexed_triangle_set &its, double ratio)
+{
+    const uint32_t triangle_count = uint32_t(its.indices.size() * ratio);
+    std::cout << name << ": " << its.indices.size() << " -> " << triangle_count << " triangles" << std::endl;
+    AABBTreeIndirect::Tree3f tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+    MeasureResult serial      = measure(its, tree, triangle_count, [](indexed_triangle_set &its, uint32_t cnt) { its_quadric_edge_collapse(its, cnt); });
+    MeasureResult partitioned = measure(its, tree, triangle_count, [](indexed_triangle_set &its, uint32_t cnt) { its_quadric_edge_collapse_partitioned(its, cnt); });
+    print("serial     ", serial);
+    print("partitioned", partitioned);
+    std::cout << "  speedup " << serial.time_s / std::max(partitioned.time_s, 1e-9) << std::endl;
+}
+
+static bool load_mesh(const boost::filesystem::path &path, indexed_triangle_set &its)
+{
+    TriangleMesh mesh;
+    std::string  ext = path.extension().string();
+    if (boost::iequals(ext, ".obj")) {
+        ObjInfo     obj_info;
+        std::string message;
+        if (! load_obj(path.string().c_str(), &mesh, obj_info, message))
+            return false;
+    } else if (boost::iequals(ext, ".stl")) {
+        if (! mesh.ReadSTLFile(path.string().c_str()))
+            return false;
+    } else
+        return false;
+    its = std::move(mesh.its);
+    return ! its.indices.empty();
+}
+
+} // namespace Slic3r
+
+int main(int argc, char *argv[])
+{
+    using namespace Slic3r;
+
+    double ratio = 0.05;
+    int    iarg  = 1;
+    if (argc > 1 && std::atof(argv[1]) > 0. && std::atof(argv[1]) < 1.) {
+        ratio = std::atof(argv[1]);
+        ++ iarg;
+    }
+
+    for (; iarg < argc; ++ iarg) {
+        boost::filesystem::path path(argv[iarg]);
+        std::vector<boost::filesystem::path> files;
+        if (boost::filesystem::is_directory(path)) {
+            for (const auto &entry : boost::filesystem::directory_iterator(path))
+                files.emplace_back(entry.path());
+            std::sort(files.begin(), files.end());
+        } else
+            files.emplace_back(path);
+        for (const boost::filesystem::path &file : files)
+            if (indexed_triangle_set its; load_mesh(file, its))
+                measure_mesh(file.filename().string(), its, ratio);
+    }
+
+    // Synthetic meshes up to ~10M triangles.
+    for (double fa : { 2. * PI / 360., 2. * PI / 1000., 2. * PI / 2000., 2. * PI / 4500. }) {
+        indexed_triangle_set sphere = its_make_sphere(10., fa);
+        measure_mesh("sphere " + std::to_string(sphere.indices.size()), sphere, ratio);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -22,11 +22,12 @@
 #include <cstring>
 #include <iostream>
 #include <math.h>
+#include <atomic>
+#include <mutex>
+#include <boost/thread.hpp>
 
 #if defined(__linux__) || defined(__LINUX__)
 #include <condition_variable>
-#include <mutex>
-#include <boost/thread.hpp>
 //add json logic
 #include "nlohmann/json.hpp"
 
@@ -47,7 +48,9 @@ using namespace nlohmann;
 
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Config.hpp"
+#include "libslic3r/FileCache.hpp"
 #include "libslic3r/Geometry.hpp"
+#include "libslic3r/GCode/LayerGCodeSpool.hpp"
 #include "libslic3r/GCode/PostProcessor.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/ModelArrange.hpp"
@@ -63,6 +66,7 @@ using namespace nlohmann;
 #include "libslic3r/Utils.hpp"
 #include "libslic3r/Time.hpp"
 #include "libslic3r/Thread.hpp"
+#include "libslic3r/Trace.hpp"
 #include "libslic3r/BlacklistedLibraryCheck.hpp"
 #include "libslic3r/FlushVolCalc.hpp"
 
@@ -89,6 +93,12 @@ using namespace nlohmann;
 #include <X11/Xlib.h>
 #endif
 
+#if defined(__linux__) || defined(__LINUX__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #ifdef SLIC3R_GUI
     #include "slic3r/GUI/GUI_Init.hpp"
 #endif /* SLIC3R_GUI */
@@ -181,6 +191,8 @@ typedef struct  _sliced_plate_info{
     size_t make_perimeters_time {0};
     size_t infill_time {0};
     size_t generate_support_material_time {0};
+    // Allocations of the PrintObject steps summed over the objects of the plate.
+    std::array<AllocationStats, posCount> step_allocations;
     size_t triangle_count{0};
     std::string warning_message;
 
@@ -207,6 +219,218 @@ typedef struct _sliced_info {
 }sliced_info_t;
 std::vector<PrintBase::SlicingStatus> g_slicing_warnings;
 
+//plate deferred to be sliced together with other plates, with its own Print
+typedef struct _cli_plate_job {
+    int index {0};
+    sliced_plate_info_t sliced_plate_info;
+    long long start_time {0};
+    long long deferred_time {0};
+    long long end_time {0};
+    std::unordered_map<std::string, long long> slice_time;
+    PrintBase* print {nullptr};
+    Slic3r::GUI::GCodeResult* gcode_result {nullptr};
+    std::string outfile;
+    std::vector<PrintBase::SlicingStatus> slicing_warnings;
+    //error message of the slicing or export exception
+    std::string error;
+}cli_plate_job_t;
+
+//BBS: caches kept warm between the jobs of a slicing daemon
+typedef struct _cli_cached_model {
+    Model               model;
+    DynamicPrintConfig  config;
+    //the auxiliary files of the plates point into aux_dir, the backup directory of the 3mf is removed between the jobs
+    std::vector<PlateData> plate_data;
+    std::vector<Preset> presets;
+    bool                is_bbl_3mf {false};
+    Semver              file_version;
+    std::string         aux_dir;
+
+    _cli_cached_model() = default;
+    _cli_cached_model(const _cli_cached_model&) = delete;
+    _cli_cached_model& operator=(const _cli_cached_model&) = delete;
+    ~_cli_cached_model()
+    {
+        if (!aux_dir.empty()) {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(aux_dir, ec);
+        }
+    }
+}cli_cached_model_t;
+
+//a settings file parsed by load_config_file(), the cli loads the profiles from the json files instead of a PresetBundle
+typedef struct _cli_cached_config {
+    DynamicPrintConfig  config;
+    std::string         config_type;
+    std::string         config_name;
+    std::string         filament_id;
+    std::string         config_from;
+}cli_cached_config_t;
+
+#define CLI_WARM_CACHE_MAX_MODELS 8
+#define CLI_WARM_CACHE_MAX_CONFIGS 256
+
+typedef struct _cli_warm_cache {
+    //key: file path, load strategy and plate to slice
+    FileCache<cli_cached_model_t> models {CLI_WARM_CACHE_MAX_MODELS};
+    //key: file path and substitution rule, the machine, process and filament settings of the jobs
+    FileCache<cli_cached_config_t> configs {CLI_WARM_CACHE_MAX_CONFIGS};
+    //print and gcode result of each plate, swapped into the PartPlateList of every job
+    std::vector<std::pair<PrintBase*, Slic3r::GUI::GCodeResult*>> prints;
+
+    ~_cli_warm_cache()
+    {
+        for (auto& print : prints) {
+            delete print.first;
+            delete print.second;
+        }
+        prints.clear();
+    }
+
+    static std::string model_key(const std::string& file, LoadStrategy strategy, int plate_to_slice)
+    {
+        return file + "|" + std::to_string((int)strategy) + "|" + std::to_string(plate_to_slice);
+    }
+
+    static std::string config_key(const std::string& file, ForwardCompatibilitySubstitutionRule rule)
+    {
+        return file + "|" + std::to_string((int)rule);
+    }
+
+    bool load_model(const std::string& file, LoadStrategy strategy, int plate_to_slice, Model& model, DynamicPrintConfig& config,
+        PlateDataPtrs& plate_data_list, std::vector<Preset*>& project_presets, bool& is_bbl_3mf, Semver& file_version)
+    {
+        const std::string key = model_key(file, strategy, plate_to_slice);
+        const cli_cached_model_t* cached = models.find(key);
+        if (!cached)
+            return false;
+
+        //the cached copies of the auxiliary files have been removed behind our back, load the 3mf again
+        for (const PlateData& plate_data : cached->plate_data) {
+            for (const std::string* path : { &plate_data.gcode_file, &plate_data.thumbnail_file, &plate_data.no_light_thumbnail_file,
+                                             &plate_data.top_file, &plate_data.pick_file, &plate_data.pattern_bbox_file })
+                if (!path->empty() && !boost::filesystem::exists(*path)) {
+                    BOOST_LOG_TRIVIAL(warning) << boost::format("warm cache: %1% of %2% is missing, reload it") % *path % file;
+                    models.erase(key);
+                    return false;
+                }
+        }
+
+        model = cached->model;
+        config = cached->config;
+        for (const PlateData& plate_data : cached->plate_data)
+            plate_data_list.push_back(new PlateData(plate_data));
+        for (const Preset& preset : cached->presets)
+            project_presets.push_back(new Preset(preset));
+        is_bbl_3mf = cached->is_bbl_3mf;
+        file_version = cached->file_version;
+        BOOST_LOG_TRIVIAL(info) << boost::format("warm cache: reuse the loaded model of %1%, hits %2%, misses %3%") % file % models.hits() % models.misses();
+        return true;
+    }
+
+    void store_model(const std::string& file, LoadStrategy strategy, int plate_to_slice, const Model& model, const DynamicPrintConfig& config,
+        const PlateDataPtrs& plate_data_list, size_t plate_data_begin, const std::vector<Preset*>& project_presets, size_t presets_begin, bool is_bbl_3mf, const Semver& file_version)
+    {
+        const std::string key = model_key(file, strategy, plate_to_slice);
+        cli_cached_model_t* cached = models.insert(key, file);
+        if (!cached)
+            return;
+        cached->aux_dir = (boost::filesystem::temp_directory_path() / "bambu_cli_warm_cache" / boost::filesystem::unique_path()).string();
+        for (size_t index = plate_data_begin; index < plate_data_list.size(); index++) {
+            cached->plate_data.push_back(*plate_data_list[index]);
+            //keep a copy of the auxiliary files, so that a warm job writes the same output as a cold one
+            if (!copy_PlateData_auxiliary_files(cached->plate_data.back(), cached->aux_dir)) {
+                models.erase(key);
+                return;
+            }
+        }
+        cached->model = model;
+        cached->config = config;
+        for (size_t index = presets_begin; index < project_presets.size(); index++)
+            cached->presets.push_back(*project_presets[index]);
+        cached->is_bbl_3mf = is_bbl_3mf;
+        cached->file_version = file_version;
+    }
+
+    bool load_config(const std::string& file, ForwardCompatibilitySubstitutionRule rule, DynamicPrintConfig& config, std::string& config_type,
+        std::string& config_name, std::string& filament_id, std::string& config_from)
+    {
+        const cli_cached_config_t* cached = configs.find(config_key(file, rule));
+        if (!cached)
+            return false;
+        config = cached->config;
+        config_type = cached->config_type;
+        config_name = cached->config_name;
+        filament_id = cached->filament_id;
+        config_from = cached->config_from;
+        BOOST_LOG_TRIVIAL(info) << boost::format("warm cache: reuse the loaded setting file %1%") % file;
+        return true;
+    }
+
+    void store_config(const std::string& file, ForwardCompatibilitySubstitutionRule rule, const DynamicPrintConfig& config, const std::string& config_type,
+        const std::string& config_name, const std::string& filament_id, const std::string& config_from)
+    {
+        cli_cached_config_t* cached = configs.insert(config_key(file, rule), file);
+        if (!cached)
+            return;
+        cached->config = config;
+        cached->config_type = config_type;
+        cached->config_name = config_name;
+        cached->filament_id = filament_id;
+        cached->config_from = config_from;
+    }
+
+    //exchange the prints of the plates with the cached ones, so that Print::apply() of the next job can reuse the unchanged steps
+    void swap_prints(Slic3r::GUI::PartPlateList& partplate_list)
+    {
+        while (prints.size() < (size_t)partplate_list.get_plate_count())
+            prints.emplace_back(new Print(), new Slic3r::GUI::GCodeResult());
+        partplate_list.swap_prints(prints);
+    }
+}cli_warm_cache_t;
+
+//only valid while running as a daemon
+cli_warm_cache_t* g_cli_warm_cache = nullptr;
+
+//swap the cached prints into the plates for slicing, and back into the cache on every return path
+typedef struct _cli_warm_prints_guard {
+    Slic3r::GUI::PartPlateList& m_partplate_list;
+    bool m_swapped {false};
+
+    _cli_warm_prints_guard(Slic3r::GUI::PartPlateList& partplate_list) : m_partplate_list(partplate_list) {}
+    ~_cli_warm_prints_guard()
+    {
+        if (m_swapped)
+            g_cli_warm_cache->swap_prints(m_partplate_list);
+    }
+
+    void swap_in()
+    {
+        if (!g_cli_warm_cache || m_swapped)
+            return;
+        g_cli_warm_cache->swap_prints(m_partplate_list);
+        m_swapped = true;
+    }
+}cli_warm_prints_guard_t;
+
+//record the trace of this run, and export it on every return path
+typedef struct _cli_trace_guard {
+    std::string m_path;
+
+    void start(const std::string& path)
+    {
+        m_path = path;
+        Trace::start();
+    }
+    ~_cli_trace_guard()
+    {
+        if (m_path.empty())
+            return;
+        Trace::stop();
+        Trace::export_chrome_json(m_path);
+    }
+}cli_trace_guard_t;
+
 #if defined(__linux__) || defined(__LINUX__)
 #define PIPE_BUFFER_SIZE 512
 
@@ -462,6 +686,8 @@ void record_exit_reson(std::string outputdir, int code, int plate_id, std::strin
         j["error_string"] = error_message;
         j["prepare_time"] = sliced_info.prepare_time;
         j["export_time"] = sliced_info.export_time;
+        j["allocator"] = allocator_name();
+        j["peak_rss"] = peak_rss();
 
         if (code != 0)
         {
@@ -480,6 +706,16 @@ void record_exit_reson(std::string outputdir, int code, int plate_id, std::strin
             plate_json["make_perimeters_time"] = sliced_plate_info.make_perimeters_time;
             plate_json["infill_time"] = sliced_plate_info.infill_time;
             plate_json["generate_support_material_time"] = sliced_plate_info.generate_support_material_time;
+            json steps_json;
+            for (int step = 0; step < int(posCount); ++ step) {
+                const AllocationStats &stats = sliced_plate_info.step_allocations[step];
+                json step_json = { {"peak_rss", stats.peak_rss} };
+                // The allocations are only counted if built with SLIC3R_ALLOCATION_STATS, otherwise they are unavailable.
+                step_json["allocations"] = allocation_stats_available() ? json(stats.allocations) : json(nullptr);
+                step_json["bytes"]       = allocation_stats_available() ? json(stats.bytes) : json(nullptr);
+                steps_json[print_object_step_name(PrintObjectStep(step))] = std::move(step_json);
+            }
+            plate_json["step_allocations"] = steps_json;
             plate_json["triangle_count"] = sliced_plate_info.triangle_count;
             plate_json["warning_message"] = sliced_plate_info.warning_message;
 
@@ -1539,6 +1775,7 @@ int CLI::run(int argc, char **argv)
     bool allow_rotations = true, skip_modified_gcodes = false, avoid_extrusion_cali_region = false, skip_useless_pick = false, allow_newer_file = false, current_is_multi_extruder = false, new_is_multi_extruder = false, allow_mix_temp = false, enable_wrapping_detect = false;
     Semver file_version;
     Slic3r::GUI::Camera::ViewAngleType camera_view = Slic3r::GUI::Camera::ViewAngleType::Iso;
+    int parallel_plates = 1;
     std::map<size_t, bool> orients_requirement;
     std::vector<Preset*> project_presets;
     std::vector<NozzleVolumeType> current_nozzle_volume_type, new_nozzle_volume_type;
@@ -1604,6 +1841,26 @@ int CLI::run(int argc, char **argv)
     if (allow_mix_temp_option)
         allow_mix_temp = allow_mix_temp_option->value;
 
+    ConfigOptionInt* parallel_plates_option = m_config.option<ConfigOptionInt>("parallel_plates");
+    if (parallel_plates_option) {
+        parallel_plates = parallel_plates_option->value;
+        if (parallel_plates <= 0)
+            parallel_plates = std::max(1, int(boost::thread::hardware_concurrency()));
+    }
+
+    cli_trace_guard_t trace_guard;
+    ConfigOptionString* trace_output_option = m_config.option<ConfigOptionString>("trace_output");
+    if (trace_output_option && !trace_output_option->value.empty()) {
+        BOOST_LOG_TRIVIAL(info) << boost::format("Will record the trace to %1%")%trace_output_option->value;
+        trace_guard.start(trace_output_option->value);
+    }
+
+    ConfigOptionInt* gcode_memory_limit_option = m_config.option<ConfigOptionInt>("gcode_memory_limit");
+    if (gcode_memory_limit_option && gcode_memory_limit_option->value > 0) {
+        BOOST_LOG_TRIVIAL(info) << boost::format("Limit the G-code held by the export to %1% MB")%gcode_memory_limit_option->value;
+        set_gcode_export_memory_limit(size_t(gcode_memory_limit_option->value) << 20);
+    }
+
     ConfigOptionInt* camera_view_option = m_config.option<ConfigOptionInt>("camera_view");
     if (camera_view_option)
         camera_view = (Slic3r::GUI::Camera::ViewAngleType)(camera_view_option->value);
@@ -1742,7 +1999,13 @@ int CLI::run(int argc, char **argv)
                 // BBS: adjust whebackup
                 //LoadStrategy strategy = LoadStrategy::LoadModel | LoadStrategy::LoadConfig|LoadStrategy::AddDefaultInstances;
                 //if (load_aux) strategy = strategy | LoadStrategy::LoadAuxiliary;
-                model = Model::read_from_file(file, &config, &config_substitutions, strategy, &plate_data_src, &project_presets, &is_bbl_3mf, &file_version, nullptr, nullptr, nullptr, plate_to_slice);
+                if (!g_cli_warm_cache || !g_cli_warm_cache->load_model(file, strategy, plate_to_slice, model, config, plate_data_src, project_presets, is_bbl_3mf, file_version)) {
+                    size_t plate_data_begin = plate_data_src.size(), presets_begin = project_presets.size();
+                    model = Model::read_from_file(file, &config, &config_substitutions, strategy, &plate_data_src, &project_presets, &is_bbl_3mf, &file_version, nullptr, nullptr, nullptr, plate_to_slice);
+                    //the substitutions are reported per load, only cache the files loaded without them
+                    if (g_cli_warm_cache && config_substitutions.empty())
+                        g_cli_warm_cache->store_model(file, strategy, plate_to_slice, model, config, plate_data_src, plate_data_begin, project_presets, presets_begin, is_bbl_3mf, file_version);
+                }
                 if (is_bbl_3mf)
                 {
                     if (!first_file)
@@ -2093,6 +2356,9 @@ int CLI::run(int argc, char **argv)
             boost::nowide::cerr << __FUNCTION__<< ": can not find setting file: " << file << std::endl;
             return CLI_FILE_NOTFOUND;
         }
+        //the daemon keeps the parsed setting files between the jobs
+        if (g_cli_warm_cache && g_cli_warm_cache->load_config(file, config_substitution_rule, config, config_type, config_name, filament_id, config_from))
+            return 0;
         ConfigSubstitutions config_substitutions;
         try {
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< ":load setting file "<< file << ", with rule "<< config_substitution_rule << std::endl;
@@ -2145,6 +2411,9 @@ int CLI::run(int argc, char **argv)
             }
             else {
                 BOOST_LOG_TRIVIAL(info) << "no substitutions performed from file " << file << "\n";
+                //the substitutions are logged per load, only cache the files loaded without them
+                if (g_cli_warm_cache)
+                    g_cli_warm_cache->store_config(file, config_substitution_rule, config, config_type, config_name, filament_id, config_from);
             }
             //config.erase("inherits");
             //config.erase("compatible_printers");
@@ -3881,6 +4150,7 @@ int CLI::run(int argc, char **argv)
 
     //BBS: partplate list
     Slic3r::GUI::PartPlateList partplate_list(NULL, m_models.data(), printer_technology);
+    cli_warm_prints_guard_t warm_prints_guard(partplate_list);
     //use Pointfs insteadof Points
     Pointfs current_printable_area = m_print_config.opt<ConfigOptionPoints>("printable_area")->values;
     Pointfs current_exclude_area = m_print_config.opt<ConfigOptionPoints>("bed_exclude_area")->values;
@@ -6091,6 +6361,257 @@ int CLI::run(int argc, char **argv)
                 //Print       fff_print;
                 std::vector<size_t> plate_triangle_counts(partplate_list.get_plate_count(), 0);
 
+                // The outfile is processed by a PlaceholderParser.
+                auto get_plate_outfile = [&outfile_dir](Slic3r::GUI::PartPlate* part_plate, int index) {
+                    std::string plate_outfile;
+                    if (outfile_dir.empty()) {
+                        plate_outfile = part_plate->get_tmp_gcode_path();
+                    }
+                    else {
+                        plate_outfile = outfile_dir + "/plate_" + std::to_string(index + 1) + ".gcode";
+                        part_plate->set_tmp_gcode_path(plate_outfile);
+                    }
+                    return plate_outfile;
+                };
+                auto process_plate = [&](PrintBase* print, int index, std::unordered_map<std::string, long long>& slice_time) {
+                    if (load_slicedata) {
+                        std::string plate_dir = load_slice_data_dir+"/"+std::to_string(index+1);
+                        int ret = print->load_cached_data(plate_dir);
+                        if (ret) {
+                            BOOST_LOG_TRIVIAL(warning) << "plate "<< index+1<< ": load Slicing data error, ret=" << ret;
+                            BOOST_LOG_TRIVIAL(warning) << "plate "<< index+1<< ": switch normal slicing";
+                            print->process();
+                        }
+                        else {
+                            BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": load cached data success, go on.";
+#if defined(__linux__) || defined(__LINUX__)
+                            if (g_cli_callback_mgr.is_started()) {
+                                PrintBase::SlicingStatus slicing_status{69, "Cache data loaded"};
+                                cli_status_callback(slicing_status);
+                            }
+#endif
+                            print->process(nullptr, true);
+                            BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": finished print::process.";
+                        }
+                    }
+                    else {
+                        print->process(&slice_time);
+                        BOOST_LOG_TRIVIAL(info) << "print::process: first time_using_cache is " << slice_time[TIME_USING_CACHE] << " secs.";
+                    }
+                };
+                //check the conflicts and the warnings of a processed plate
+                // Returns CLI_SUCCESS or the error code the CLI exits with, the error is already recorded.
+                auto check_plate_process = [&](Print* print_fff, int index, std::vector<PrintBase::SlicingStatus>& slicing_warnings, sliced_plate_info_t& sliced_plate_info) -> int {
+                    std::string conflict_result = print_fff->get_conflict_string();
+                    if (!conflict_result.empty()) {
+                       BOOST_LOG_TRIVIAL(error) << "plate "<< index+1<< ": found slicing result conflict!"<< std::endl;
+                       record_exit_reson(outfile_dir, CLI_GCODE_PATH_CONFLICTS, index+1, cli_errors[CLI_GCODE_PATH_CONFLICTS], sliced_info);
+                       return CLI_GCODE_PATH_CONFLICTS;
+                    }
+
+                    //check the warnings
+                    if (!slicing_warnings.empty())
+                    {
+                        for (unsigned int i = 0; i < slicing_warnings.size(); i++)
+                        {
+                            PrintBase::SlicingStatus& status = slicing_warnings[i];
+                            if ((status.warning_step != -1) && (status.message_type != PrintStateBase::SlicingDefaultNotification))
+                            {
+                                sliced_plate_info.warning_message = status.text;
+
+                                if (status.warning_level == PrintStateBase::WarningLevel::NON_CRITICAL) {
+                                    BOOST_LOG_TRIVIAL(warning) << "plate "<< index+1<< ": found NON_CRITICAL slicing warnings: "<<status.text <<std::endl;
+                                }
+                                else {
+                                    BOOST_LOG_TRIVIAL(warning) << boost::format("plate %1%: found slicing warnings: %2%, no_check=%3%")%(index+1) %status.text %no_check;
+                                    if (!no_check) {
+                                        //only following message will be reported under import mode
+                                        if (status.message_type == PrintStateBase::SlicingEmptyGcodeLayers
+                                            || status.message_type == PrintStateBase::SlicingGcodeOverlap)
+                                        {
+                                            sliced_info.sliced_plates.push_back(sliced_plate_info);
+                                            record_exit_reson(outfile_dir, CLI_SLICING_ERROR, index+1, cli_errors[CLI_SLICING_ERROR], sliced_info);
+                                            return CLI_SLICING_ERROR;
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                        slicing_warnings.clear();
+                    }
+                    return CLI_SUCCESS;
+                };
+                //check the exported gcode and collect the statistics of a sliced plate, returns as check_plate_process()
+                auto finish_plate = [&](int index, PrintBase* print, Slic3r::GUI::GCodeResult* gcode_result, const std::string& outfile, sliced_plate_info_t& sliced_plate_info,
+                                        std::unordered_map<std::string, long long>& slice_time, long long start_time) -> int {
+                    Slic3r::GUI::PartPlate* part_plate = partplate_list.get_plate(index);
+                    sliced_plate_info.triangle_count = plate_triangle_counts[index];
+                    if (gcode_result && gcode_result->gcode_check_result.error_code) {
+                        BOOST_LOG_TRIVIAL(error) << "plate " << index + 1 << ": found gcode unprintable! gcode_result->gcode_check_result.error_code = "
+                                << gcode_result->gcode_check_result.error_code << std::endl;
+                        //found gcode error
+                        if (gcode_result->gcode_check_result.error_code & 0b1100) {
+                            record_exit_reson(outfile_dir, CLI_GCODE_PATH_OUTSIDE, index + 1, cli_errors[CLI_GCODE_PATH_OUTSIDE], sliced_info);
+                            return CLI_GCODE_PATH_OUTSIDE;
+                        }
+                        else if (gcode_result->gcode_check_result.error_code & 0b10000) {
+                            record_exit_reson(outfile_dir, CLI_GCODE_IN_WRAPPING_DETECT_AREA, index + 1, cli_errors[CLI_GCODE_IN_WRAPPING_DETECT_AREA], sliced_info);
+                            return CLI_GCODE_IN_WRAPPING_DETECT_AREA;
+                        }
+                        else if (gcode_result->gcode_check_result.error_code & 0b00011) {
+                            record_exit_reson(outfile_dir, CLI_GCODE_PATH_IN_UNPRINTABLE_AREA, index + 1, cli_errors[CLI_GCODE_PATH_IN_UNPRINTABLE_AREA], sliced_info);
+                            return CLI_GCODE_PATH_IN_UNPRINTABLE_AREA;
+                        }
+                    }
+
+                    if (gcode_result && gcode_result->filament_printable_reuslt.has_value()) {
+                        //found gcode error
+                        BOOST_LOG_TRIVIAL(error) << "plate " << index + 1 << ": found some filament unprintable on current bed- "<< gcode_result->filament_printable_reuslt.plate_name << std::endl;
+                        record_exit_reson(outfile_dir, CLI_FILAMENT_UNPRINTABLE_ON_FIRST_LAYER, index + 1, cli_errors[CLI_FILAMENT_UNPRINTABLE_ON_FIRST_LAYER], sliced_info);
+                        return CLI_FILAMENT_UNPRINTABLE_ON_FIRST_LAYER;
+                    }
+
+                    BOOST_LOG_TRIVIAL(info) << "Slicing result exported to " << outfile << std::endl;
+                    part_plate->update_slice_result_valid_state(true);
+#if defined(__linux__) || defined(__LINUX__)
+                    if (g_cli_callback_mgr.is_started()) {
+                        PrintBase::SlicingStatus slicing_status{100, "Slicing finished"};
+                        cli_status_callback(slicing_status);
+                    }
+#endif
+                    if (export_slicedata) {
+                        BOOST_LOG_TRIVIAL(info) << boost::format("plate %1% will export Slicing data to %2%")%(index+1) %export_slice_data_dir;
+                        std::string plate_dir = export_slice_data_dir+"/"+std::to_string(index+1);
+                        bool with_space = (get_logging_level() >= 4)?true:false;
+                        int ret = print->export_cached_data(plate_dir, sliced_plate_info.obj_cached_cnt, with_space);
+                        if (ret) {
+                            BOOST_LOG_TRIVIAL(error) << "plate "<< index+1<< ": export Slicing data error, ret=" << ret;
+                            export_slicedata_error = true;
+                            if (fs::exists(plate_dir))
+                                fs::remove_all(plate_dir);
+                            record_exit_reson(outfile_dir, ret, index+1, cli_errors[ret], sliced_info);
+                            return ret;
+                        }
+                        BOOST_LOG_TRIVIAL(info) << boost::format("plate %1% exported %2% objects")%(index+1) %(sliced_plate_info.obj_cached_cnt);
+                    }
+                    long long end_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
+                    sliced_plate_info.sliced_time = end_time - start_time;
+                    sliced_plate_info.sliced_time_with_cache = slice_time[TIME_USING_CACHE];
+                    sliced_plate_info.make_perimeters_time = slice_time[TIME_MAKE_PERIMETERS];
+                    sliced_plate_info.infill_time = slice_time[TIME_INFILL];
+                    sliced_plate_info.generate_support_material_time = slice_time[TIME_GENERATE_SUPPORT];
+                    if (const Print *print_fff = dynamic_cast<const Print*>(print); print_fff != nullptr)
+                        for (int step = 0; step < int(posCount); ++ step)
+                            sliced_plate_info.step_allocations[step] = print_fff->step_allocation_stats(PrintObjectStep(step));
+
+                    //get predication and filament change
+                    PrintEstimatedStatistics& print_estimated_stat = gcode_result->print_statistics;
+                    const PrintEstimatedStatistics::Mode& time_mode = print_estimated_stat.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)];
+                    auto it_wipe = std::find_if(time_mode.roles_times.begin(), time_mode.roles_times.end(), [](const std::pair<ExtrusionRole, float>& item) { return ExtrusionRole::erWipeTower == item.first; });
+                    sliced_plate_info.total_predication = time_mode.time;
+                    sliced_plate_info.main_predication = time_mode.time - time_mode.prepare_time;
+                    sliced_plate_info.filament_change_times = print_estimated_stat.total_filament_changes;
+                    if (it_wipe != time_mode.roles_times.end()) {
+                        //filament changes time will be included in prime tower time later
+                        //ConfigOptionFloat* machine_load_filament_time_opt = m_print_config.option<ConfigOptionFloat>("machine_load_filament_time");
+                        //ConfigOptionFloat* machine_unload_filament_time_opt = m_print_config.option<ConfigOptionFloat>("machine_unload_filament_time");
+                        sliced_plate_info.main_predication -= it_wipe->second;
+                        //sliced_plate_info.main_predication -= sliced_plate_info.filament_change_times * (machine_load_filament_time_opt->value + machine_unload_filament_time_opt->value);
+                    }
+                    auto it_flush = std::find_if(time_mode.roles_times.begin(), time_mode.roles_times.end(), [](const std::pair<ExtrusionRole, float>& item) { return ExtrusionRole::erFlush == item.first; });
+                    if (it_flush != time_mode.roles_times.end()) {
+                        sliced_plate_info.main_predication -= it_flush->second;
+                    }
+                    bool has_tool_change = false;
+                    auto custom_gcodes_iter = model.plates_custom_gcodes.find(index);
+                    if (custom_gcodes_iter != model.plates_custom_gcodes.end())
+                    {
+                        CustomGCode::Info custom_gcodes = custom_gcodes_iter->second;
+                        for (const CustomGCode::Item& custom_gcode : custom_gcodes.gcodes)
+                            if (custom_gcode.type == CustomGCode::ToolChange) {
+                                has_tool_change = true;
+                                break;
+                            }
+                    }
+                    if (has_tool_change)
+                        sliced_plate_info.layer_filament_change = print_estimated_stat.total_filament_changes;
+
+                    //filaments
+                    auto* filament_ids = dynamic_cast<const ConfigOptionStrings*>(m_print_config.option("filament_ids"));
+                    std::vector<float>        filament_diameters = gcode_result->filament_diameters;
+                    std::vector<float>        filament_densities = gcode_result->filament_densities;
+
+                    for (auto& iter : print_estimated_stat.total_volumes_per_extruder)
+                    {
+                        filament_info_t filament_info;
+
+                        filament_info.id = iter.first + 1;
+                        filament_info.total_used_g = iter.second;
+
+                        if (filament_ids && (filament_info.id <= filament_ids->values.size()))
+                            filament_info.filament_id = filament_ids->values[iter.first];
+                        else
+                            filament_info.filament_id = "unknown";
+
+                        auto main_iter = print_estimated_stat.model_volumes_per_extruder.find(iter.first);
+                        if (main_iter != print_estimated_stat.model_volumes_per_extruder.end())
+                            filament_info.main_used_g = main_iter->second;
+
+                        auto support_iter = print_estimated_stat.support_volumes_per_extruder.find(iter.first);
+                        if (support_iter != print_estimated_stat.support_volumes_per_extruder.end())
+                            filament_info.main_used_g += support_iter->second;
+
+                        double koef = 0.001;
+                        //filament_info.main_used_m = koef * filament_info.main_used_m / (PI * sqr(0.5 * filament_diameters[filament_info.id]));
+                        filament_info.main_used_g = koef * filament_info.main_used_g * filament_densities[iter.first];
+                        filament_info.total_used_g = koef * filament_info.total_used_g * filament_densities[iter.first];
+
+                        sliced_plate_info.filaments.push_back(std::move(filament_info));
+                    }
+
+                    //objects
+                    ModelObjectPtrs plate_objects = part_plate->get_objects_on_this_plate();
+                    for (ModelObject* object : plate_objects)
+                    {
+                        object_info_t object_info;
+                        object_info.id = object->id().id;
+                        object_info.name = object->name;
+                        object_info.triangle_count = object->facets_count();
+
+                        BoundingBoxf3 bbox_f = object->bounding_box();
+                        object_info.bbox_x = bbox_f.min.x();
+                        object_info.bbox_y = bbox_f.min.y();
+                        object_info.bbox_z = bbox_f.min.z();
+                        object_info.bbox_width = bbox_f.max.x() - object_info.bbox_x;
+                        object_info.bbox_depth = bbox_f.max.y() - object_info.bbox_y;
+                        object_info.bbox_height = bbox_f.max.z() - object_info.bbox_z;
+
+                        sliced_plate_info.objects.push_back(std::move(object_info));
+                    }
+
+                    if (max_slicing_time_per_plate != 0) {
+                        long long time_cost = end_time - start_time;
+                        if (time_cost > max_slicing_time_per_plate * 1000) {
+                            sliced_plate_info.warning_message = (boost::format("plate %1%'s slice time %2% exceeds the limit %3%, return error.")%(index+1) %time_cost %(max_slicing_time_per_plate * 1000)).str();
+                            BOOST_LOG_TRIVIAL(error) << sliced_plate_info.warning_message;
+                            sliced_info.sliced_plates.push_back(sliced_plate_info);
+                            record_exit_reson(outfile_dir, CLI_SLICING_TIME_EXCEEDS_LIMIT, index+1, cli_errors[CLI_SLICING_TIME_EXCEEDS_LIMIT], sliced_info);
+                            return CLI_SLICING_TIME_EXCEEDS_LIMIT;
+                        }
+                    }
+                    sliced_info.sliced_plates.push_back(sliced_plate_info);
+                    return CLI_SUCCESS;
+                };
+                // Plates deferred to be sliced concurrently, each plate has its own Print instance.
+                std::vector<cli_plate_job_t> pending_plates;
+                bool slice_in_parallel = (parallel_plates > 1) && (plate_to_slice == 0) && (partplate_list.get_plate_count() > 1);
+#if defined(__linux__) || defined(__LINUX__)
+                // The progress is reported to the pipe for a single plate at a time.
+                if (g_cli_callback_mgr.is_started())
+                    slice_in_parallel = false;
+#endif
+                if (printer_technology == ptFFF)
+                    warm_prints_guard.swap_in();
                 while(!finished)
                 {
                     //BBS: slice every partplate one by one
@@ -6662,69 +7183,27 @@ int CLI::run(int argc, char **argv)
                                 const PrintConfig& print_config = print_fff->config();
                                 Model::setExtruderParams(m_print_config, filament_count);
                                 Model::setPrintSpeedTable(m_print_config, print_config);
-                                if (load_slicedata) {
-                                    std::string plate_dir = load_slice_data_dir+"/"+std::to_string(index+1);
-                                    int ret = print->load_cached_data(plate_dir);
-                                    if (ret) {
-                                        BOOST_LOG_TRIVIAL(warning) << "plate "<< index+1<< ": load Slicing data error, ret=" << ret;
-                                        BOOST_LOG_TRIVIAL(warning) << "plate "<< index+1<< ": switch normal slicing";
-                                        print->process();
-                                    }
-                                    else {
-                                        BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": load cached data success, go on.";
-#if defined(__linux__) || defined(__LINUX__)
-                                        if (g_cli_callback_mgr.is_started()) {
-                                            PrintBase::SlicingStatus slicing_status{69, "Cache data loaded"};
-                                            cli_status_callback(slicing_status);
-                                        }
-#endif
-                                        print->process(nullptr, true);
-                                        BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": finished print::process.";
-                                    }
-                                }
-                                else {
-                                    print->process(&slice_time);
-                                    BOOST_LOG_TRIVIAL(info) << "print::process: first time_using_cache is " << slice_time[TIME_USING_CACHE] << " secs.";
+                                print_fff->capture_brim_model_params();
+                                if (slice_in_parallel && is_bbl_vendor_preset && (printer_technology == ptFFF)) {
+                                    // No thumbnails are rendered for this plate, thus it may be sliced and exported outside of the main thread.
+                                    // It is checked and reported in the plate order after all the deferred plates are sliced.
+                                    cli_plate_job_t plate_job;
+                                    plate_job.index             = index;
+                                    plate_job.sliced_plate_info = sliced_plate_info;
+                                    plate_job.start_time        = start_time;
+                                    plate_job.deferred_time     = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
+                                    plate_job.slice_time        = slice_time;
+                                    plate_job.print             = print;
+                                    plate_job.gcode_result      = gcode_result;
+                                    plate_job.outfile           = get_plate_outfile(part_plate, index);
+                                    BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": deferred to be sliced in parallel.";
+                                    pending_plates.emplace_back(std::move(plate_job));
+                                    continue;
                                 }
+                                process_plate(print, index, slice_time);
                                 if (printer_technology == ptFFF) {
-                                    std::string conflict_result = print_fff->get_conflict_string();
-                                    if (!conflict_result.empty()) {
-                                       BOOST_LOG_TRIVIAL(error) << "plate "<< index+1<< ": found slicing result conflict!"<< std::endl;
-                                       record_exit_reson(outfile_dir, CLI_GCODE_PATH_CONFLICTS, index+1, cli_errors[CLI_GCODE_PATH_CONFLICTS], sliced_info);
-                                       flush_and_exit(CLI_GCODE_PATH_CONFLICTS);
-                                    }
-
-                                    //check the warnings
-                                    if (!g_slicing_warnings.empty())
-                                    {
-                                        for (unsigned int i = 0; i < g_slicing_warnings.size(); i++)
-                                        {
-                                            PrintBase::SlicingStatus& status = g_slicing_warnings[i];
-                                            if ((status.warning_step != -1) && (status.message_type != PrintStateBase::SlicingDefaultNotification))
-                                            {
-                                                sliced_plate_info.warning_message = status.text;
-
-                                                if (status.warning_level == PrintStateBase::WarningLevel::NON_CRITICAL) {
-                                                    BOOST_LOG_TRIVIAL(warning) << "plate "<< index+1<< ": found NON_CRITICAL slicing warnings: "<<status.text <<std::endl;
-                                                }
-                                                else {
-                                                    BOOST_LOG_TRIVIAL(warning) << boost::format("plate %1%: found slicing warnings: %2%, no_check=%3%")%(index+1) %status.text %no_check;
-                                                    if (!no_check) {
-                                                        //only following message will be reported under import mode
-                                                        if (status.message_type == PrintStateBase::SlicingEmptyGcodeLayers
-                                                            || status.message_type == PrintStateBase::SlicingGcodeOverlap)
-                                                        {
-                                                            sliced_info.sliced_plates.push_back(sliced_plate_info);
-                                                            record_exit_reson(outfile_dir, CLI_SLICING_ERROR, index+1, cli_errors[CLI_SLICING_ERROR], sliced_info);
-                                                            flush_and_exit(CLI_SLICING_ERROR);
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        g_slicing_warnings.clear();
-                                    }
-                                    sliced_plate_info.triangle_count = plate_triangle_counts[index];
+                                    if (int ret = check_plate_process(print_fff, index, g_slicing_warnings, sliced_plate_info); ret != CLI_SUCCESS)
+                                        flush_and_exit(ret);
 
                                     auto cli_generate_thumbnails = [&partplate_list, &model, &glvolume_collection, &colors_out, &shader, &p_opengl_mgr](const ThumbnailsParams& params) -> ThumbnailsList{
                                         ThumbnailsList thumbnails;
@@ -6745,15 +7224,7 @@ int CLI::run(int argc, char **argv)
                                         return thumbnails;
                                     };
 
-                                    // The outfile is processed by a PlaceholderParser.
-                                    //outfile = part_plate->get_tmp_gcode_path();
-                                    if (outfile_dir.empty()) {
-                                        outfile = part_plate->get_tmp_gcode_path();
-                                    }
-                                    else {
-                                        outfile = outfile_dir + "/plate_" + std::to_string(index + 1) + ".gcode";
-                                        part_plate->set_tmp_gcode_path(outfile);
-                                    }
+                                    outfile = get_plate_outfile(part_plate, index);
                                     BOOST_LOG_TRIVIAL(info) << "process finished, will export gcode temporily to " << outfile << std::endl;
                                     temp_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
                                     if (is_bbl_vendor_preset) {
@@ -6766,184 +7237,79 @@ int CLI::run(int argc, char **argv)
                                     }
                                     slice_time[TIME_USING_CACHE] = slice_time[TIME_USING_CACHE] + ((long long)Slic3r::Utils::get_current_milliseconds_time_utc() - temp_time);
                                     BOOST_LOG_TRIVIAL(info) << "export_gcode finished: time_using_cache update to " << slice_time[TIME_USING_CACHE] << " secs.";
-
-                                    if (gcode_result && gcode_result->gcode_check_result.error_code) {
-                                        BOOST_LOG_TRIVIAL(error) << "plate " << index + 1 << ": found gcode unprintable! gcode_result->gcode_check_result.error_code = "
-                                                << gcode_result->gcode_check_result.error_code << std::endl;
-                                        //found gcode error
-                                        if (gcode_result->gcode_check_result.error_code & 0b1100) {
-                                            record_exit_reson(outfile_dir, CLI_GCODE_PATH_OUTSIDE, index + 1, cli_errors[CLI_GCODE_PATH_OUTSIDE], sliced_info);
-                                            flush_and_exit(CLI_GCODE_PATH_OUTSIDE);
-                                        }
-                                        else if (gcode_result->gcode_check_result.error_code & 0b10000) {
-                                            record_exit_reson(outfile_dir, CLI_GCODE_IN_WRAPPING_DETECT_AREA, index + 1, cli_errors[CLI_GCODE_IN_WRAPPING_DETECT_AREA], sliced_info);
-                                            flush_and_exit(CLI_GCODE_IN_WRAPPING_DETECT_AREA);
-                                        }
-                                        else if (gcode_result->gcode_check_result.error_code & 0b00011) {
-                                            record_exit_reson(outfile_dir, CLI_GCODE_PATH_IN_UNPRINTABLE_AREA, index + 1, cli_errors[CLI_GCODE_PATH_IN_UNPRINTABLE_AREA], sliced_info);
-                                            flush_and_exit(CLI_GCODE_PATH_IN_UNPRINTABLE_AREA);
-                                        }
-                                    }
-
-                                    if (gcode_result && gcode_result->filament_printable_reuslt.has_value()) {
-                                        //found gcode error
-                                        BOOST_LOG_TRIVIAL(error) << "plate " << index + 1 << ": found some filament unprintable on current bed- "<< gcode_result->filament_printable_reuslt.plate_name << std::endl;
-                                        record_exit_reson(outfile_dir, CLI_FILAMENT_UNPRINTABLE_ON_FIRST_LAYER, index + 1, cli_errors[CLI_FILAMENT_UNPRINTABLE_ON_FIRST_LAYER], sliced_info);
-                                        flush_and_exit(CLI_FILAMENT_UNPRINTABLE_ON_FIRST_LAYER);
-                                    }
-
-                                    //outfile_final = (dynamic_cast<Print*>(print))->print_statistics().finalize_output_path(outfile);
-                                    //m_fff_print->export_gcode(m_temp_output_path, m_gcode_result, [this](const ThumbnailsParams& params) { return this->render_thumbnails(params); });
-                                }/* else {
-                                    outfile = sla_print.output_filepath(outfile);
-                                    // We need to finalize the filename beforehand because the export function sets the filename inside the zip metadata
-                                    outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
-                                    sla_archive.export_print(outfile_final, sla_print);
-                                }*/
-                                /*if (outfile != outfile_final) {
-                                    if (Slic3r::rename_file(outfile, outfile_final)) {
-                                        boost::nowide::cerr << "Renaming file " << outfile << " to " << outfile_final << " failed" << std::endl;
-                                        record_exit_reson(outfile_dir, 1, index+1, cli_errors[1], sliced_info);
-                                        flush_and_exit(1);
-                                    }
-                                    outfile = outfile_final;
-                                }*/
-                                // Run the post-processing scripts if defined.
-                                //run_post_process_scripts(outfile, print->full_print_config());
-                                BOOST_LOG_TRIVIAL(info) << "Slicing result exported to " << outfile << std::endl;
-                                part_plate->update_slice_result_valid_state(true);
-#if defined(__linux__) || defined(__LINUX__)
-                                if (g_cli_callback_mgr.is_started()) {
-                                    PrintBase::SlicingStatus slicing_status{100, "Slicing finished"};
-                                    cli_status_callback(slicing_status);
+                                    // There is no preview, don't hold the moves of every plate until the end.
+                                    if (gcode_result)
+                                        gcode_result->release_moves();
                                 }
-#endif
-                                if (export_slicedata) {
-                                    BOOST_LOG_TRIVIAL(info) << boost::format("plate %1% will export Slicing data to %2%")%(index+1) %export_slice_data_dir;
-                                    std::string plate_dir = export_slice_data_dir+"/"+std::to_string(index+1);
-                                    bool with_space = (get_logging_level() >= 4)?true:false;
-                                    int ret = print->export_cached_data(plate_dir, sliced_plate_info.obj_cached_cnt, with_space);
-                                    if (ret) {
-                                        BOOST_LOG_TRIVIAL(error) << "plate "<< index+1<< ": export Slicing data error, ret=" << ret;
-                                        export_slicedata_error = true;
-                                        if (fs::exists(plate_dir))
-                                            fs::remove_all(plate_dir);
-                                        record_exit_reson(outfile_dir, ret, index+1, cli_errors[ret], sliced_info);
-                                        flush_and_exit(ret);
-                                    }
-                                    BOOST_LOG_TRIVIAL(info) << boost::format("plate %1% exported %2% objects")%(index+1) %(sliced_plate_info.obj_cached_cnt);
-                                }
-                                end_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
-                                sliced_plate_info.sliced_time = end_time - start_time;
-                                sliced_plate_info.sliced_time_with_cache = slice_time[TIME_USING_CACHE];
-                                sliced_plate_info.make_perimeters_time = slice_time[TIME_MAKE_PERIMETERS];
-                                sliced_plate_info.infill_time = slice_time[TIME_INFILL];
-                                sliced_plate_info.generate_support_material_time = slice_time[TIME_GENERATE_SUPPORT];
-
-                                //get predication and filament change
-                                PrintEstimatedStatistics& print_estimated_stat = gcode_result->print_statistics;
-                                const PrintEstimatedStatistics::Mode& time_mode = print_estimated_stat.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)];
-                                auto it_wipe = std::find_if(time_mode.roles_times.begin(), time_mode.roles_times.end(), [](const std::pair<ExtrusionRole, float>& item) { return ExtrusionRole::erWipeTower == item.first; });
-                                sliced_plate_info.total_predication = time_mode.time;
-                                sliced_plate_info.main_predication = time_mode.time - time_mode.prepare_time;
-                                sliced_plate_info.filament_change_times = print_estimated_stat.total_filament_changes;
-                                if (it_wipe != time_mode.roles_times.end()) {
-                                    //filament changes time will be included in prime tower time later
-                                    //ConfigOptionFloat* machine_load_filament_time_opt = m_print_config.option<ConfigOptionFloat>("machine_load_filament_time");
-                                    //ConfigOptionFloat* machine_unload_filament_time_opt = m_print_config.option<ConfigOptionFloat>("machine_unload_filament_time");
-                                    sliced_plate_info.main_predication -= it_wipe->second;
-                                    //sliced_plate_info.main_predication -= sliced_plate_info.filament_change_times * (machine_load_filament_time_opt->value + machine_unload_filament_time_opt->value);
-                                }
-                                auto it_flush = std::find_if(time_mode.roles_times.begin(), time_mode.roles_times.end(), [](const std::pair<ExtrusionRole, float>& item) { return ExtrusionRole::erFlush == item.first; });
-                                if (it_flush != time_mode.roles_times.end()) {
-                                    sliced_plate_info.main_predication -= it_flush->second;
-                                }
-                                bool has_tool_change = false;
-                                auto custom_gcodes_iter = model.plates_custom_gcodes.find(index);
-                                if (custom_gcodes_iter != model.plates_custom_gcodes.end())
-                                {
-                                    CustomGCode::Info custom_gcodes = custom_gcodes_iter->second;
-                                    for (const CustomGCode::Item& custom_gcode : custom_gcodes.gcodes)
-                                        if (custom_gcode.type == CustomGCode::ToolChange) {
-                                            has_tool_change = true;
-                                            break;
+                                if (int ret = finish_plate(index, print, gcode_result, outfile, sliced_plate_info, slice_time, start_time); ret != CLI_SUCCESS)
+                                    flush_and_exit(ret);
+                            } catch (const std::exception &ex) {
+                                BOOST_LOG_TRIVIAL(error) << "found slicing or export error for partplate "<<index+1 << std::endl;
+                                boost::nowide::cerr << ex.what() << std::endl;
+                                //continue;
+                                record_exit_reson(outfile_dir, CLI_SLICING_ERROR, index+1, cli_errors[CLI_SLICING_ERROR], sliced_info);
+                                flush_and_exit(CLI_SLICING_ERROR);
+                            }
+                        }
+                    }
+                    if (!pending_plates.empty()) {
+                        int thread_count = std::min<int>(parallel_plates, int(pending_plates.size()));
+                        BOOST_LOG_TRIVIAL(info) << boost::format("slicing %1% plates, %2% plates at a time")%pending_plates.size() %thread_count;
+                        std::atomic<size_t> next_plate { 0 };
+                        std::mutex          warnings_mutex;
+                        auto slice_pending_plates = [&pending_plates, &next_plate, &warnings_mutex, &process_plate]() {
+                            for (size_t i = next_plate ++; i < pending_plates.size(); i = next_plate ++) {
+                                cli_plate_job_t& plate_job = pending_plates[i];
+                                // Don't account the time the plate waited for a free thread.
+                                plate_job.start_time += (long long)Slic3r::Utils::get_current_milliseconds_time_utc() - plate_job.deferred_time;
+                                try {
+                                    plate_job.print->set_status_callback([&plate_job, &warnings_mutex](const PrintBase::SlicingStatus& slicing_status) {
+                                        if (slicing_status.warning_step != -1) {
+                                            std::lock_guard<std::mutex> lock(warnings_mutex);
+                                            plate_job.slicing_warnings.push_back(slicing_status);
                                         }
+                                    });
+                                    BOOST_LOG_TRIVIAL(info) << "start Print::process for partplate "<<plate_job.index+1 << " in parallel" << std::endl;
+                                    process_plate(plate_job.print, plate_job.index, plate_job.slice_time);
+                                    long long temp_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
+                                    plate_job.outfile = dynamic_cast<Print*>(plate_job.print)->export_gcode(plate_job.outfile, plate_job.gcode_result, nullptr);
+                                    if (plate_job.gcode_result)
+                                        plate_job.gcode_result->release_moves();
+                                    plate_job.slice_time[TIME_USING_CACHE] += (long long)Slic3r::Utils::get_current_milliseconds_time_utc() - temp_time;
+                                } catch (const std::exception &ex) {
+                                    plate_job.error = ex.what();
                                 }
-                                if (has_tool_change)
-                                    sliced_plate_info.layer_filament_change = print_estimated_stat.total_filament_changes;
-
-                                //filaments
-                                auto* filament_ids = dynamic_cast<const ConfigOptionStrings*>(m_print_config.option("filament_ids"));
-                                std::vector<float>        filament_diameters = gcode_result->filament_diameters;
-                                std::vector<float>        filament_densities = gcode_result->filament_densities;
-
-                                for (auto& iter : print_estimated_stat.total_volumes_per_extruder)
-                                {
-                                    filament_info_t filament_info;
-
-                                    filament_info.id = iter.first + 1;
-                                    filament_info.total_used_g = iter.second;
-
-                                    if (filament_ids && (filament_info.id <= filament_ids->values.size()))
-                                        filament_info.filament_id = filament_ids->values[iter.first];
-                                    else
-                                        filament_info.filament_id = "unknown";
-
-                                    auto main_iter = print_estimated_stat.model_volumes_per_extruder.find(iter.first);
-                                    if (main_iter != print_estimated_stat.model_volumes_per_extruder.end())
-                                        filament_info.main_used_g = main_iter->second;
-
-                                    auto support_iter = print_estimated_stat.support_volumes_per_extruder.find(iter.first);
-                                    if (support_iter != print_estimated_stat.support_volumes_per_extruder.end())
-                                        filament_info.main_used_g += support_iter->second;
-
-                                    double koef = 0.001;
-                                    //filament_info.main_used_m = koef * filament_info.main_used_m / (PI * sqr(0.5 * filament_diameters[filament_info.id]));
-                                    filament_info.main_used_g = koef * filament_info.main_used_g * filament_densities[iter.first];
-                                    filament_info.total_used_g = koef * filament_info.total_used_g * filament_densities[iter.first];
-
-                                    sliced_plate_info.filaments.push_back(std::move(filament_info));
-                                }
-
-                                //objects
-                                ModelObjectPtrs plate_objects = part_plate->get_objects_on_this_plate();
-                                for (ModelObject* object : plate_objects)
-                                {
-                                    object_info_t object_info;
-                                    object_info.id = object->id().id;
-                                    object_info.name = object->name;
-                                    object_info.triangle_count = object->facets_count();
-
-                                    BoundingBoxf3 bbox_f = object->bounding_box();
-                                    object_info.bbox_x = bbox_f.min.x();
-                                    object_info.bbox_y = bbox_f.min.y();
-                                    object_info.bbox_z = bbox_f.min.z();
-                                    object_info.bbox_width = bbox_f.max.x() - object_info.bbox_x;
-                                    object_info.bbox_depth = bbox_f.max.y() - object_info.bbox_y;
-                                    object_info.bbox_height = bbox_f.max.z() - object_info.bbox_z;
-
-                                    sliced_plate_info.objects.push_back(std::move(object_info));
-                                }
-
-                                if (max_slicing_time_per_plate != 0) {
-                                    long long time_cost = end_time - start_time;
-                                    if (time_cost > max_slicing_time_per_plate * 1000) {
-                                        sliced_plate_info.warning_message = (boost::format("plate %1%'s slice time %2% exceeds the limit %3%, return error.")%(index+1) %time_cost %(max_slicing_time_per_plate * 1000)).str();
-                                        BOOST_LOG_TRIVIAL(error) << sliced_plate_info.warning_message;
-                                        sliced_info.sliced_plates.push_back(sliced_plate_info);
-                                        record_exit_reson(outfile_dir, CLI_SLICING_TIME_EXCEEDS_LIMIT, index+1, cli_errors[CLI_SLICING_TIME_EXCEEDS_LIMIT], sliced_info);
-                                        flush_and_exit(CLI_SLICING_TIME_EXCEEDS_LIMIT);
-                                    }
-                                }
-                                sliced_info.sliced_plates.push_back(sliced_plate_info);
+                                plate_job.end_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
+                            }
+                        };
+                        std::vector<boost::thread> threads;
+                        for (int i = 1; i < thread_count; i ++)
+                            threads.emplace_back(create_thread(slice_pending_plates));
+                        slice_pending_plates();
+                        for (boost::thread& thread : threads)
+                            thread.join();
+
+                        // Check and report the plates in the plate order, thus the result does not depend on the order the plates finished in.
+                        for (cli_plate_job_t& plate_job : pending_plates) {
+                            int index = plate_job.index;
+                            try {
+                                if (!plate_job.error.empty())
+                                    throw Slic3r::RuntimeError(plate_job.error);
+                                if (int ret = check_plate_process(dynamic_cast<Print*>(plate_job.print), index, plate_job.slicing_warnings, plate_job.sliced_plate_info); ret != CLI_SUCCESS)
+                                    flush_and_exit(ret);
+                                outfile = plate_job.outfile;
+                                // Don't account the time the plate waited for the other plates to its slicing time.
+                                long long wait_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc() - plate_job.end_time;
+                                if (int ret = finish_plate(index, plate_job.print, plate_job.gcode_result, outfile, plate_job.sliced_plate_info, plate_job.slice_time, plate_job.start_time + wait_time); ret != CLI_SUCCESS)
+                                    flush_and_exit(ret);
                             } catch (const std::exception &ex) {
                                 BOOST_LOG_TRIVIAL(error) << "found slicing or export error for partplate "<<index+1 << std::endl;
                                 boost::nowide::cerr << ex.what() << std::endl;
-                                //continue;
                                 record_exit_reson(outfile_dir, CLI_SLICING_ERROR, index+1, cli_errors[CLI_SLICING_ERROR], sliced_info);
                                 flush_and_exit(CLI_SLICING_ERROR);
                             }
                         }
+                        pending_plates.clear();
                     }
                     if (pre_check&& (partplate_list.get_plate_count() > 1))
                         pre_check = false;
@@ -8033,6 +8399,105 @@ std::string CLI::output_filepath(const ModelObject &object, unsigned int index,
     return output_path;
 }
 
+//BBS: run as a slicing daemon, the loaded models and the prints are kept warm between the jobs
+//every connection to the unix socket sends one json line, {"args": ["--slice", "0", ...]} to run a job, or {"command": "quit"} to stop the daemon
+//and gets one json line back, {"return_code": 0, "time": 1234}
+int CLI::run_daemon(const char* program, const std::string& socket_path)
+{
+#if defined(__linux__) || defined(__LINUX__)
+    struct sockaddr_un addr;
+    if (socket_path.empty() || (socket_path.size() >= sizeof(addr.sun_path))) {
+        boost::nowide::cerr << "invalid daemon socket path: " << socket_path << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        boost::nowide::cerr << "can not create the daemon socket, errno " << errno << std::endl;
+        return CLI_ENVIRONMENT_ERROR;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(socket_path.c_str());
+    if ((::bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) || (::listen(listen_fd, 8) < 0)) {
+        boost::nowide::cerr << "can not listen on the daemon socket " << socket_path << ", errno " << errno << std::endl;
+        ::close(listen_fd);
+        return CLI_ENVIRONMENT_ERROR;
+    }
+    boost::nowide::cout << "slicing daemon listening on " << socket_path << std::endl;
+
+    cli_warm_cache_t warm_cache;
+    g_cli_warm_cache = &warm_cache;
+    bool quit = false;
+    while (!quit)
+    {
+        int conn_fd = ::accept(listen_fd, nullptr, nullptr);
+        if (conn_fd < 0) {
+            if (errno == EINTR)
+                continue;
+            boost::nowide::cerr << "daemon accept failed, errno " << errno << std::endl;
+            break;
+        }
+
+        std::string request;
+        char buffer[4096];
+        while (request.find('\n') == std::string::npos) {
+            ssize_t count = ::read(conn_fd, buffer, sizeof(buffer));
+            if (count <= 0)
+                break;
+            request.append(buffer, count);
+        }
+
+        json reply;
+        try {
+            json j = json::parse(request.substr(0, request.find('\n')));
+            if (j.contains("command") && (j["command"].get<std::string>() == "quit")) {
+                quit = true;
+                reply["return_code"] = CLI_SUCCESS;
+            }
+            else {
+                std::vector<std::string> args;
+                args.emplace_back(program);
+                for (const auto& arg : j.at("args"))
+                    args.emplace_back(arg.get<std::string>());
+                std::vector<char*> argv_ptrs(args.size() + 1, nullptr);
+                for (size_t i = 0; i < args.size(); ++i)
+                    argv_ptrs[i] = args[i].data();
+
+                g_slicing_warnings.clear();
+                long long start_time = (long long)Slic3r::Utils::get_current_milliseconds_time_utc();
+                int ret = CLI().run((int)args.size(), argv_ptrs.data());
+                reply["return_code"] = ret;
+                reply["time"] = (long long)Slic3r::Utils::get_current_milliseconds_time_utc() - start_time;
+            }
+        }
+        catch (const std::exception& ex) {
+            reply["return_code"] = CLI_INVALID_PARAMS;
+            reply["error"] = ex.what();
+        }
+
+        std::string response = reply.dump() + "\n";
+        size_t written = 0;
+        while (written < response.size()) {
+            ssize_t count = ::write(conn_fd, response.data() + written, response.size() - written);
+            if (count <= 0)
+                break;
+            written += count;
+        }
+        ::close(conn_fd);
+    }
+
+    g_cli_warm_cache = nullptr;
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+    return CLI_SUCCESS;
+#else
+    boost::nowide::cerr << "the slicing daemon is only supported on linux" << std::endl;
+    return CLI_INVALID_PARAMS;
+#endif
+}
+
 //BBS: dump stack debug codes, don't delete currently
 //#include <dbghelp.h>
 //#pragma comment(lib, "version.lib")
@@ -8090,6 +8555,15 @@ LONG WINAPI VectoredExceptionHandler(PEXCEPTION_POINTERS pExceptionInfo)
     return EXCEPTION_CONTINUE_SEARCH;
 }*/
 
+//BBS: --daemon <socket> keeps the process alive and runs the jobs sent to the socket, returns the socket path or nullptr
+static const char* daemon_socket_path(int argc, char **argv)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+        if ((strcmp(argv[i], "--daemon") == 0) || (strcmp(argv[i], "-daemon") == 0))
+            return argv[i + 1];
+    return nullptr;
+}
+
 #if defined(_MSC_VER) || defined(__MINGW32__)
 extern "C" {
     __declspec(dllexport) int __stdcall bambustu_main(int argc, wchar_t **argv)
@@ -8114,12 +8588,17 @@ extern "C" {
             *a     = 0;
             });
         // Call the UTF8 main.
+        if (const char *socket_path = daemon_socket_path(argc, argv_ptrs.data()))
+            // not supported on windows, run_daemon() reports the error
+            return CLI::run_daemon(argv_ptrs.front(), socket_path);
         return CLI().run(argc, argv_ptrs.data());
     }
 }
 #else /* _MSC_VER */
 int main(int argc, char **argv)
 {
+    if (const char *socket_path = daemon_socket_path(argc, argv))
+        return CLI::run_daemon(argv[0], socket_path);
     return CLI().run(argc, argv);
 }
 #endif /* _MSC_VER */
@@ -117,6 +117,8 @@ typedef struct _plate_obj_size_info {
 class CLI {
 public:
     int run(int argc, char **argv);
+    //run the jobs received on a unix socket in this process, keeping the loaded models and prints between them
+    static int run_daemon(const char* program, const std::string& socket_path);
 
 private:
     DynamicPrintAndCLIConfig    m_config;
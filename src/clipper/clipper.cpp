@@ -170,6 +170,16 @@ void PolyTree::RemoveOutermostPolygon()
         this->Clear();
 }
 
+PolyNode& PolyTree::AddNode(PolyNode &parent, Path &&contour)
+{
+    assert(AllNodes.size() < AllNodes.capacity());
+    AllNodes.emplace_back(PolyNode());
+    PolyNode &node = AllNodes.back();
+    node.Contour = std::move(contour);
+    parent.AddChild(node);
+    return node;
+}
+
 //------------------------------------------------------------------------------
 // Miscellaneous global functions
 //------------------------------------------------------------------------------
@@ -757,12 +767,12 @@ TEdge* ClipperBase::ProcessBound(TEdge* E, bool NextIsForward)
 }
 //------------------------------------------------------------------------------
 
-bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
+bool ClipperBase::AddPath(const IntPoint *pg, size_t size, PolyType PolyTyp, bool Closed)
 {
   CLIPPERLIB_PROFILE_FUNC();
   // Remove duplicate end point from a closed input path.
   // Remove duplicate points from the end of the input path.
-  int highI = (int)pg.size() -1;
+  int highI = (int)size -1;
   if (Closed) 
     while (highI > 0 && (pg[highI] == pg[0])) 
       --highI;
@@ -772,7 +782,7 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
     return false;
 
   // Allocate a new edge array.
-  std::vector<TEdge> edges(highI + 1);
+  TempVector<TEdge> edges(highI + 1);
   // Fill in the edge array.
   bool result = AddPathInternal(pg, highI, PolyTyp, Closed, edges.data());
   if (result)
@@ -781,7 +791,7 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
   return result;
 }
 
-bool ClipperBase::AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges)
+bool ClipperBase::AddPathInternal(const IntPoint *pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges)
 {
   CLIPPERLIB_PROFILE_FUNC();
 #ifdef use_lines
@@ -792,7 +802,7 @@ bool ClipperBase::AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, b
     throw clipperException("AddPath: Open paths have been disabled.");
 #endif
 
-  assert(highI >= 0 && highI < pg.size());
+  assert(highI >= 0);
 
   //1. Basic (first) edge initialization ...
   try
@@ -1067,7 +1077,7 @@ void Clipper::Reset()
 {
   CLIPPERLIB_PROFILE_FUNC();
   ClipperBase::Reset();
-  m_Scanbeam = std::priority_queue<cInt>();
+  m_Scanbeam = decltype(m_Scanbeam)();
   m_Maxima.clear();
   m_ActiveEdges = 0;
   m_SortedEdges = 0;
@@ -1192,7 +1202,8 @@ OutPt* Clipper::AllocateOutPt()
     pt = m_OutPts.back() + (m_OutPtsChunkLast ++);
   } else {
     // The last chunk is full. Allocate a new one.
-    m_OutPts.push_back(new OutPt[m_OutPtsChunkSize]);
+    m_OutPts.push_back(TempAllocator<OutPt>(m_OutPts.get_allocator()).allocate(m_OutPtsChunkSize));
+    std::uninitialized_default_construct_n(m_OutPts.back(), m_OutPtsChunkSize);
     m_OutPtsChunkLast = 1;
     pt = m_OutPts.back();
   }
@@ -1202,9 +1213,9 @@ OutPt* Clipper::AllocateOutPt()
 void Clipper::DisposeAllOutRecs()
 {
   for (OutPt *pts : m_OutPts)
-    delete[] pts;
+    TempAllocator<OutPt>(m_OutPts.get_allocator()).deallocate(pts, m_OutPtsChunkSize);
   for (OutRec *rec : m_PolyOuts)
-    delete rec;
+    TempAllocator<OutRec>(m_PolyOuts.get_allocator()).deallocate(rec, 1);
   m_OutPts.clear();
   m_OutPtsFree = nullptr;
   m_OutPtsChunkLast = m_OutPtsChunkSize;
@@ -1988,7 +1999,7 @@ void Clipper::AppendPolygon(TEdge *e1, TEdge *e2) const
 
 OutRec* Clipper::CreateOutRec()
 {
-  OutRec* result = new OutRec;
+  OutRec* result = new (TempAllocator<OutRec>(m_PolyOuts.get_allocator()).allocate(1)) OutRec;
   result->IsHole = false;
   result->IsOpen = false;
   result->FirstLeft = 0;
@@ -2224,8 +2235,8 @@ void Clipper::ProcessHorizontal(TEdge *horzEdge)
   if (!eLastHorz->NextInLML)
     eMaxPair = GetMaximaPair(eLastHorz);
 
-  std::vector<cInt>::const_iterator maxIt;
-  std::vector<cInt>::const_reverse_iterator maxRit;
+  TempVector<cInt>::const_iterator maxIt;
+  TempVector<cInt>::const_reverse_iterator maxRit;
   if (!m_Maxima.empty())
   {
       //get the first maxima in range (X) ...
@@ -3507,7 +3518,7 @@ void ClipperOffset::DoOffset(double delta)
     {
       PolyNode& node = *m_polyNodes.Childs[i];
       if (node.m_endtype == etClosedPolygon)
-        m_destPolys.push_back(node.Contour);
+        m_destPolys.emplace_back(node.Contour.begin(), node.Contour.end());
     }
     return;
   }
@@ -3535,7 +3546,7 @@ void ClipperOffset::DoOffset(double delta)
   for (int i = 0; i < m_polyNodes.ChildCount(); i++)
   {
     PolyNode& node = *m_polyNodes.Childs[i];
-    m_srcPoly = node.Contour;
+    m_srcPoly.assign(node.Contour.begin(), node.Contour.end());
 
     int len = (int)m_srcPoly.size();
     if (len == 0 || (delta <= 0 && (len < 3 || node.m_endtype != etClosedPolygon)))
@@ -3935,7 +3946,7 @@ void CleanPolygon(const Path& in_poly, Path& out_poly, double distance)
     return;
   }
 
-  std::vector<OutPt> outPts(size);
+  TempVector<OutPt> outPts(size);
   for (size_t i = 0; i < size; ++i)
   {
     outPts[i].Pt = in_poly[i];
@@ -58,6 +58,7 @@
 #include <ostream>
 #include <functional>
 #include <queue>
+#include <memory>
 
 #ifdef CLIPPERLIB_NAMESPACE_PREFIX
   namespace CLIPPERLIB_NAMESPACE_PREFIX {
@@ -113,6 +114,17 @@ using DoublePoint = Eigen::Matrix<double, 2, 1, Eigen::DontAlign>;
 typedef std::vector<IntPoint> Path;
 typedef std::vector<Path> Paths;
 
+// Allocator of the intermediate data of Clipper and ClipperOffset, which is released when the clipping is done.
+// It may be overridden by the CLIPPERLIB_ALLOCATOR template, for example by an arena allocator.
+// If CLIPPERLIB_TEMP_FRAME is defined, Clipper and ClipperOffset hold an instance of it for their whole life time,
+// which may release the memory of an arena allocator at once when the clipper is destroyed.
+#ifdef CLIPPERLIB_ALLOCATOR
+template<typename T> using TempAllocator = CLIPPERLIB_ALLOCATOR<T>;
+#else // CLIPPERLIB_ALLOCATOR
+template<typename T> using TempAllocator = std::allocator<T>;
+#endif // CLIPPERLIB_ALLOCATOR
+template<typename T> using TempVector = std::vector<T, TempAllocator<T>>;
+
 inline Path& operator <<(Path& poly, const IntPoint& p) {poly.push_back(p); return poly;}
 inline Paths& operator <<(Paths& polys, const Path& p) {polys.push_back(p); return polys;}
 
@@ -181,6 +193,11 @@ public:
     void Clear() {  AllNodes.clear(); Childs.clear(); }
     int Total() const;
     void RemoveOutermostPolygon();
+    // Filling the tree with contours produced by another polygon engine (the Clipper2 backend of ClipperUtils).
+    // ReserveNodes() clears the tree and has to be called with the total number of nodes before AddNode() is called,
+    // the nodes are stored in AllNodes and their addresses must not change.
+    void ReserveNodes(size_t cnt) { this->Clear(); AllNodes.reserve(cnt); }
+    PolyNode& AddNode(PolyNode &parent, Path &&contour);
 private:
     PolyTree(const PolyTree &src) = delete;
     PolyTree& operator=(const PolyTree &src) = delete;
@@ -298,7 +315,8 @@ public:
 #endif // CLIPPERLIB_INT32
     m_HasOpenPaths(false) {}
   ~ClipperBase() { Clear(); }
-  bool AddPath(const Path &pg, PolyType PolyTyp, bool Closed);
+  bool AddPath(const Path &pg, PolyType PolyTyp, bool Closed) { return AddPath(pg.data(), pg.size(), PolyTyp, Closed); }
+  bool AddPath(const IntPoint *pg, size_t size, PolyType PolyTyp, bool Closed);
 
   template<typename PathsProvider>
   bool AddPaths(PathsProvider &&paths_provider, PolyType PolyTyp, bool Closed)
@@ -306,13 +324,16 @@ public:
     size_t num_paths = paths_provider.size();
     if (num_paths == 0)
         return false;
-    if (num_paths == 1)
-        return AddPath(*paths_provider.begin(), PolyTyp, Closed);
+    if (num_paths == 1) {
+        const auto &pg = *paths_provider.begin();
+        return AddPath(pg.data(), pg.size(), PolyTyp, Closed);
+    }
 
-    std::vector<int> num_edges(num_paths, 0);
+    TempVector<int> num_edges(num_paths, 0);
     int num_edges_total = 0;
     size_t i = 0;
-    for (const Path &pg : paths_provider) {
+    // The paths may be Paths or vectors of IntPoint with another allocator.
+    for (const auto &pg : paths_provider) {
       // Remove duplicate end point from a closed input path.
       // Remove duplicate points from the end of the input path.
       int highI = (int)pg.size() -1;
@@ -330,14 +351,14 @@ public:
       return false;
 
     // Allocate a new edge array.
-    std::vector<TEdge> edges(num_edges_total);
+    TempVector<TEdge> edges(num_edges_total);
     // Fill in the edge array.
     bool result = false;
     TEdge *p_edge = edges.data();
     i = 0;
-    for (const Path &pg : paths_provider) {
+    for (const auto &pg : paths_provider) {
       if (num_edges[i]) {
-        bool res = AddPathInternal(pg, num_edges[i] - 1, PolyTyp, Closed, p_edge);
+        bool res = AddPathInternal(pg.data(), num_edges[i] - 1, PolyTyp, Closed, p_edge);
         if (res) {
           p_edge += num_edges[i];
           result = true;
@@ -358,15 +379,19 @@ public:
   bool PreserveCollinear() const {return m_PreserveCollinear;};
   void PreserveCollinear(bool value) {m_PreserveCollinear = value;};
 protected:
-  bool AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
+  bool AddPathInternal(const IntPoint *pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
   TEdge* AddBoundsToLML(TEdge *e, bool IsClosed);
   void Reset();
   TEdge* ProcessBound(TEdge* E, bool IsClockwise);
   TEdge* DescendToMin(TEdge *&E);
   void AscendToMax(TEdge *&E, bool Appending, bool IsClosed);
 
+#ifdef CLIPPERLIB_TEMP_FRAME
+  // Constructed before and destroyed after all the containers of the intermediate data, including those of Clipper.
+  CLIPPERLIB_TEMP_FRAME    m_TempFrame;
+#endif // CLIPPERLIB_TEMP_FRAME
   // Local minima (Y, left edge, right edge) sorted by ascending Y.
-  std::vector<LocalMinimum> m_MinimaList;
+  TempVector<LocalMinimum> m_MinimaList;
 
 #ifdef CLIPPERLIB_INT32
   static constexpr const bool m_UseFullRange = false;
@@ -377,7 +402,7 @@ protected:
 #endif // CLIPPERLIB_INT32
 
   // A vector of edges per each input path.
-  std::vector<std::vector<TEdge>> m_edges;
+  TempVector<TempVector<TEdge>> m_edges;
   // Don't remove intermediate vertices of a collinear sequence of points.
   bool             m_PreserveCollinear;
   // Is any of the paths inserted by AddPath() or AddPaths() open?
@@ -421,22 +446,22 @@ protected:
 private:
   
   // Output polygons.
-  std::vector<OutRec*>  m_PolyOuts;
+  TempVector<OutRec*>  m_PolyOuts;
   // Output points, allocated by a continuous sets of m_OutPtsChunkSize.
-  std::vector<OutPt*>   m_OutPts;
+  TempVector<OutPt*>   m_OutPts;
   // List of free output points, to be used before taking a point from m_OutPts or allocating a new chunk.
   OutPt                *m_OutPtsFree;
   size_t                m_OutPtsChunkSize;
   size_t                m_OutPtsChunkLast;
 
-  std::vector<Join>     m_Joins;
-  std::vector<Join>     m_GhostJoins;
-  std::vector<IntersectNode> m_IntersectList;
+  TempVector<Join>     m_Joins;
+  TempVector<Join>     m_GhostJoins;
+  TempVector<IntersectNode> m_IntersectList;
   ClipType              m_ClipType;
   // A priority queue (a binary heap) of Y coordinates.
-  std::priority_queue<cInt> m_Scanbeam;
+  std::priority_queue<cInt, TempVector<cInt>> m_Scanbeam;
   // Maxima are collected by ProcessEdgesAtTopOfScanbeam(), consumed by ProcessHorizontal().
-  std::vector<cInt>     m_Maxima;
+  TempVector<cInt>     m_Maxima;
   TEdge                *m_ActiveEdges;
   TEdge                *m_SortedEdges;
   PolyFillType          m_ClipFillType;
@@ -524,10 +549,14 @@ public:
   double ShortestEdgeLength;
 
 private:
-  Paths m_destPolys;
-  Path m_srcPoly;
-  Path m_destPoly;
-  std::vector<DoublePoint> m_normals;
+#ifdef CLIPPERLIB_TEMP_FRAME
+  // Constructed before and destroyed after all the containers of the intermediate data.
+  CLIPPERLIB_TEMP_FRAME m_TempFrame;
+#endif // CLIPPERLIB_TEMP_FRAME
+  TempVector<TempVector<IntPoint>> m_destPolys;
+  TempVector<IntPoint> m_srcPoly;
+  TempVector<IntPoint> m_destPoly;
+  TempVector<DoublePoint> m_normals;
   double m_delta, m_sinA, m_sin, m_cos;
   double m_miterLim, m_StepsPerRad;
   // x: index of the lowest contour in m_polyNodes
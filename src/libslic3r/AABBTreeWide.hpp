@@ -0,0 +1,436 @@
+// Wide (4 or 8 children per node) layout of AABBTreeIndirect::Tree and ray packet queries.
+// Both the wide node layout and the ray packets store the coordinates as structures of arrays,
+// so that the slab tests of one ray against Width boxes or of N rays against one box are plain
+// fixed length loops over contiguous memory, which the compilers vectorize to SSE / AVX / NEON.
+
+#ifndef slic3r_AABBTreeWide_hpp_
+#define slic3r_AABBTreeWide_hpp_
+
+#include <array>
+#include <cstdint>
+
+#include "AABBTreeIndirect.hpp"
+
+namespace Slic3r {
+namespace AABBTreeIndirect {
+
+// AABB tree with Width children per node, collapsed from a balanced binary AABBTreeIndirect::Tree.
+// Bounding boxes of all children of a node are stored together in a structure of arrays,
+// thus a ray is tested against all the children of a node at once.
+template<int AWidth, int ANumDimensions, typename ACoordType>
+class WideTree
+{
+public:
+    static constexpr int    Width         = AWidth;
+    static constexpr int    NumDimensions = ANumDimensions;
+    using                   CoordType     = ACoordType;
+    using                   BinaryTree    = Tree<NumDimensions, CoordType>;
+    static_assert(Width == 4 || Width == 8, "WideTree supports BVH4 and BVH8 layouts only");
+
+    enum : size_t {
+        // Child slot is not used.
+        npos = size_t(-1),
+    };
+
+    struct Node {
+        // Bounding boxes of the children. Unused slots hold an empty (inverted) box.
+        CoordType   min[NumDimensions][Width];
+        CoordType   max[NumDimensions][Width];
+        // Index of a child WideTree node for an inner child, index of the external source entity for a leaf child, npos if unused.
+        size_t      child[Width];
+        // Bit i is set if child i is a leaf.
+        uint32_t    leaf_mask = 0;
+        // Bit i is set if child slot i is used. The slab test of an axis parallel ray does not reject
+        // the inverted box of an unused slot (0 * inf), thus the slab test results are masked.
+        uint32_t    used_mask = 0;
+
+        bool        is_used(int i) const { return (this->used_mask >> i) & 1; }
+        bool        is_leaf(int i) const { return (this->leaf_mask >> i) & 1; }
+    };
+
+    void clear() { m_nodes.clear(); }
+
+    // Collapse log2(Width) levels of the binary tree into a single node of the wide tree.
+    void build(const BinaryTree &tree)
+    {
+        m_nodes.clear();
+        if (tree.empty())
+            return;
+        m_nodes.reserve(tree.nodes().size() / (Width - 1) + 1);
+        m_nodes.emplace_back();
+        this->build_recursive(tree, 0, 0);
+    }
+
+    const std::vector<Node>&    nodes() const { return m_nodes; }
+    const Node&                 node(size_t idx) const { return m_nodes[idx]; }
+    bool                        empty() const { return m_nodes.empty(); }
+
+private:
+    // Collect the binary tree descendants of binary_idx, which become the children of a single wide node.
+    // Inner nodes are expanded until Width children are collected.
+    static int collect_children(const BinaryTree &tree, size_t binary_idx, std::array<size_t, Width> &out)
+    {
+        int cnt = 0;
+        out[cnt ++] = binary_idx;
+        for (bool expanded = true; expanded && cnt < Width;) {
+            expanded = false;
+            // Expand the inner node with the largest bounding box first.
+            int         best = -1;
+            CoordType   best_size = CoordType(-1);
+            for (int i = 0; i < cnt; ++ i)
+                if (const auto &n = tree.node(out[i]); n.is_inner()) {
+                    CoordType size = n.bbox.diagonal().squaredNorm();
+                    if (size > best_size) {
+                        best      = i;
+                        best_size = size;
+                    }
+                }
+            if (best != -1) {
+                size_t idx = out[best];
+                out[best]  = BinaryTree::left_child_idx(idx);
+                if (tree.node(BinaryTree::right_child_idx(idx)).is_valid())
+                    out[cnt ++] = BinaryTree::right_child_idx(idx);
+                expanded = true;
+            }
+        }
+        return cnt;
+    }
+
+    void build_recursive(const BinaryTree &tree, size_t binary_idx, size_t wide_idx)
+    {
+        std::array<size_t, Width> children;
+        int cnt = collect_children(tree, binary_idx, children);
+        for (int i = 0; i < Width; ++ i) {
+            Node &node = m_nodes[wide_idx];
+            if (i >= cnt) {
+                for (int d = 0; d < NumDimensions; ++ d) {
+                    node.min[d][i] = std::numeric_limits<CoordType>::max();
+                    node.max[d][i] = std::numeric_limits<CoordType>::lowest();
+                }
+                node.child[i] = npos;
+                continue;
+            }
+            const auto &src = tree.node(children[i]);
+            node.used_mask |= uint32_t(1) << i;
+            for (int d = 0; d < NumDimensions; ++ d) {
+                node.min[d][i] = src.bbox.min()(d);
+                node.max[d][i] = src.bbox.max()(d);
+            }
+            if (src.is_leaf()) {
+                node.child[i]   = src.idx;
+                node.leaf_mask |= uint32_t(1) << i;
+            } else {
+                // m_nodes may be reallocated by the recursion, don't keep the reference.
+                size_t child_idx = m_nodes.size();
+                m_nodes.emplace_back();
+                m_nodes[wide_idx].child[i] = child_idx;
+                this->build_recursive(tree, children[i], child_idx);
+            }
+        }
+    }
+
+    std::vector<Node> m_nodes;
+};
+
+template<int Width> using WideTree3f = WideTree<Width, 3, float>;
+template<int Width> using WideTree3d = WideTree<Width, 3, double>;
+using Tree3fBVH4 = WideTree3f<4>;
+using Tree3fBVH8 = WideTree3f<8>;
+
+template<int Width, typename CoordType>
+inline WideTree<Width, 3, CoordType> build_wide_tree(const Tree<3, CoordType> &tree)
+{
+    WideTree<Width, 3, CoordType> out;
+    out.build(tree);
+    return out;
+}
+
+// Packet of N rays stored as a structure of arrays. The rays are expected to be coherent
+// (similar origins and directions) for the packet traversal to pay off, for example rays cast
+// from a single point or parallel rays cast from neighboring points.
+template<int N, typename AScalar>
+struct RayPacket
+{
+    using Scalar = AScalar;
+    static constexpr int Size = N;
+
+    Scalar      origin[3][N];
+    Scalar      dir[3][N];
+    Scalar      invdir[3][N];
+
+    template<typename VectorType>
+    RayPacket(const std::array<VectorType, N> &origins, const std::array<VectorType, N> &dirs)
+    {
+        for (int i = 0; i < N; ++ i)
+            for (int d = 0; d < 3; ++ d) {
+                origin[d][i] = Scalar(origins[i](d));
+                dir[d][i]    = Scalar(dirs[i](d));
+                invdir[d][i] = Scalar(1) / dir[d][i];
+            }
+    }
+
+    Eigen::Matrix<Scalar, 3, 1> ray_origin(int i) const { return { origin[0][i], origin[1][i], origin[2][i] }; }
+    Eigen::Matrix<Scalar, 3, 1> ray_dir(int i)    const { return { dir[0][i], dir[1][i], dir[2][i] }; }
+};
+
+namespace detail {
+    // Slab test of N rays against a single box. Rays with their t interval <0, tmax> intersecting the box are marked in the returned mask.
+    template<int N, typename Scalar>
+    inline uint32_t packet_box_intersect(const RayPacket<N, Scalar> &packet, const Scalar (&bmin)[3], const Scalar (&bmax)[3], const Scalar (&tmax)[N])
+    {
+        Scalar t0[N];
+        Scalar t1[N];
+        for (int i = 0; i < N; ++ i) {
+            t0[i] = Scalar(0);
+            t1[i] = tmax[i];
+        }
+        for (int d = 0; d < 3; ++ d)
+            for (int i = 0; i < N; ++ i) {
+                Scalar a = (bmin[d] - packet.origin[d][i]) * packet.invdir[d][i];
+                Scalar b = (bmax[d] - packet.origin[d][i]) * packet.invdir[d][i];
+                t0[i] = std::max(t0[i], std::min(a, b));
+                t1[i] = std::min(t1[i], std::max(a, b));
+            }
+        uint32_t mask = 0;
+        for (int i = 0; i < N; ++ i)
+            mask |= uint32_t(t0[i] <= t1[i]) << i;
+        return mask;
+    }
+
+    template<int N, typename Scalar, typename CoordType>
+    inline uint32_t packet_box_intersect(const RayPacket<N, Scalar> &packet, const Eigen::AlignedBox<CoordType, 3> &box, const Scalar (&tmax)[N])
+    {
+        const Scalar bmin[3] = { Scalar(box.min().x()), Scalar(box.min().y()), Scalar(box.min().z()) };
+        const Scalar bmax[3] = { Scalar(box.max().x()), Scalar(box.max().y()), Scalar(box.max().z()) };
+        return packet_box_intersect(packet, bmin, bmax, tmax);
+    }
+
+    // Slab test of a single ray against all children of a wide node. Returns a mask of the intersected children,
+    // tnear receives the entry parameters for ordering the traversal.
+    template<typename WideTreeType, typename Scalar>
+    inline uint32_t wide_node_intersect(const typename WideTreeType::Node &node, const Scalar (&origin)[3], const Scalar (&invdir)[3], Scalar tmax,
+                                        Scalar (&tnear)[WideTreeType::Width])
+    {
+        static constexpr int Width = WideTreeType::Width;
+        Scalar t1[Width];
+        for (int i = 0; i < Width; ++ i) {
+            tnear[i] = Scalar(0);
+            t1[i]    = tmax;
+        }
+        for (int d = 0; d < 3; ++ d)
+            for (int i = 0; i < Width; ++ i) {
+                Scalar a = (Scalar(node.min[d][i]) - origin[d]) * invdir[d];
+                Scalar b = (Scalar(node.max[d][i]) - origin[d]) * invdir[d];
+                tnear[i] = std::max(tnear[i], std::min(a, b));
+                t1[i]    = std::min(t1[i], std::max(a, b));
+            }
+        uint32_t mask = 0;
+        for (int i = 0; i < Width; ++ i)
+            mask |= uint32_t(tnear[i] <= t1[i]) << i;
+        return mask & node.used_mask;
+    }
+
+    // Ray - triangle test of the rays marked in mask against a single triangle, updating the closest hits.
+    template<int N, typename Scalar, typename VertexType, typename IndexedFaceType>
+    inline void packet_triangle_first_hit(const RayPacket<N, Scalar> &packet, uint32_t mask,
+        const std::vector<VertexType> &vertices, const std::vector<IndexedFaceType> &faces, size_t face_idx, double eps,
+        Scalar (&tmax)[N], igl::Hit *hits, uint32_t &hit_mask)
+    {
+        const IndexedFaceType &face = faces[face_idx];
+        for (int i = 0; i < N; ++ i)
+            if ((mask >> i) & 1) {
+                double t, u, v;
+                if (intersect_triangle(packet.ray_origin(i), packet.ray_dir(i), vertices[face(0)], vertices[face(1)], vertices[face(2)], t, u, v, eps)
+                    && t > 0. && t < tmax[i]) {
+                    tmax[i]   = Scalar(t);
+                    hits[i]   = igl::Hit { int(face_idx), -1, float(u), float(v), float(t) };
+                    hit_mask |= uint32_t(1) << i;
+                }
+            }
+    }
+} // namespace detail
+
+// Find a first intersection of a ray with indexed triangle set using a wide AABB tree.
+// Semantics is the same as of intersect_ray_first_hit() over the binary AABBTreeIndirect::Tree.
+template<typename VertexType, typename IndexedFaceType, int Width, typename CoordType, typename VectorType>
+inline bool intersect_ray_first_hit(
+    const std::vector<VertexType>           &vertices,
+    const std::vector<IndexedFaceType>      &faces,
+    const WideTree<Width, 3, CoordType>     &tree,
+    const VectorType                        &origin,
+    const VectorType                        &dir,
+    igl::Hit                                &hit,
+    const double                             eps = 0.000001)
+{
+    using Scalar   = typename VectorType::Scalar;
+    using TreeType = WideTree<Width, 3, CoordType>;
+    if (tree.empty())
+        return false;
+    const Scalar org[3]    = { origin.x(), origin.y(), origin.z() };
+    const Scalar invdir[3] = { Scalar(1) / dir.x(), Scalar(1) / dir.y(), Scalar(1) / dir.z() };
+    Scalar       tmax      = std::numeric_limits<Scalar>::infinity();
+    bool         found     = false;
+    std::vector<size_t> stack;
+    stack.reserve(64);
+    stack.emplace_back(0);
+    while (! stack.empty()) {
+        const typename TreeType::Node &node = tree.node(stack.back());
+        stack.pop_back();
+        Scalar   tnear[Width];
+        uint32_t mask = detail::wide_node_intersect<TreeType>(node, org, invdir, tmax, tnear);
+        // Push the inner children far to near, so that the nearest one is traversed first.
+        size_t   stack_begin = stack.size();
+        for (int i = 0; i < Width; ++ i)
+            if ((mask >> i) & 1) {
+                if (node.is_leaf(i)) {
+                    const IndexedFaceType &face = faces[node.child[i]];
+                    double t, u, v;
+                    if (detail::intersect_triangle(origin, dir, vertices[face(0)], vertices[face(1)], vertices[face(2)], t, u, v, eps)
+                        && t > 0. && t < tmax) {
+                        tmax  = Scalar(t);
+                        hit   = igl::Hit { int(node.child[i]), -1, float(u), float(v), float(t) };
+                        found = true;
+                    }
+                } else
+                    stack.emplace_back(i);
+            }
+        std::sort(stack.begin() + stack_begin, stack.end(), [&tnear](size_t l, size_t r) { return tnear[l] > tnear[r]; });
+        for (size_t i = stack_begin; i < stack.size(); ++ i)
+            stack[i] = node.child[stack[i]];
+    }
+    return found;
+}
+
+// Find first intersections of a packet of N rays with indexed triangle set using the binary AABBTreeIndirect::Tree.
+// Each ray is traversed with the same semantics as intersect_ray_first_hit(), the packet shares the tree traversal,
+// testing all its rays against each visited bounding box at once.
+// Returns a mask of the rays which intersected the mesh, hits are valid for those rays only.
+template<int N, typename VertexType, typename IndexedFaceType, typename CoordType, typename VectorType>
+inline uint32_t intersect_ray_packet_first_hit(
+    const std::vector<VertexType>           &vertices,
+    const std::vector<IndexedFaceType>      &faces,
+    const Tree<3, CoordType>                &tree,
+    const std::array<VectorType, N>         &origins,
+    const std::array<VectorType, N>         &dirs,
+    std::array<igl::Hit, N>                 &hits,
+    const double                             eps = 0.000001)
+{
+    static_assert(N == 4 || N == 8, "Ray packets of 4 or 8 rays are supported");
+    using Scalar = typename VectorType::Scalar;
+    if (tree.empty())
+        return 0;
+    const RayPacket<N, Scalar> packet(origins, dirs);
+    Scalar   tmax[N];
+    std::fill(tmax, tmax + N, std::numeric_limits<Scalar>::infinity());
+    uint32_t hit_mask = 0;
+    std::vector<size_t> stack;
+    stack.reserve(64);
+    stack.emplace_back(0);
+    while (! stack.empty()) {
+        size_t      node_idx = stack.back();
+        stack.pop_back();
+        const auto &node = tree.node(node_idx);
+        uint32_t    mask = detail::packet_box_intersect(packet, node.bbox, tmax);
+        if (mask == 0)
+            continue;
+        if (node.is_leaf())
+            detail::packet_triangle_first_hit(packet, mask, vertices, faces, node.idx, eps, tmax, hits.data(), hit_mask);
+        else {
+            size_t left  = Tree<3, CoordType>::left_child_idx(node_idx);
+            size_t right = left + 1;
+            // Traverse the child closer along the direction of the first active ray first.
+            int    axis;
+            (node.bbox.max() - node.bbox.min()).maxCoeff(&axis);
+            int    first = 0;
+            while (! ((mask >> first) & 1))
+                ++ first;
+            if (packet.dir[axis][first] < 0)
+                std::swap(left, right);
+            if (tree.node(right).is_valid())
+                stack.emplace_back(right);
+            stack.emplace_back(left);
+        }
+    }
+    return hit_mask;
+}
+
+// Find first intersections of a packet of N rays with indexed triangle set using a wide AABB tree.
+// All rays of the packet are tested against each child of a visited wide node, the children intersected by any ray are traversed.
+template<int N, typename VertexType, typename IndexedFaceType, int Width, typename CoordType, typename VectorType>
+inline uint32_t intersect_ray_packet_first_hit(
+    const std::vector<VertexType>           &vertices,
+    const std::vector<IndexedFaceType>      &faces,
+    const WideTree<Width, 3, CoordType>     &tree,
+    const std::array<VectorType, N>         &origins,
+    const std::array<VectorType, N>         &dirs,
+    std::array<igl::Hit, N>                 &hits,
+    const double                             eps = 0.000001)
+{
+    static_assert(N == 4 || N == 8, "Ray packets of 4 or 8 rays are supported");
+    using Scalar   = typename VectorType::Scalar;
+    using TreeType = WideTree<Width, 3, CoordType>;
+    if (tree.empty())
+        return 0;
+    const RayPacket<N, Scalar> packet(origins, dirs);
+    Scalar   tmax[N];
+    std::fill(tmax, tmax + N, std::numeric_limits<Scalar>::infinity());
+    uint32_t hit_mask = 0;
+    std::vector<size_t> stack;
+    stack.reserve(64);
+    stack.emplace_back(0);
+    while (! stack.empty()) {
+        const typename TreeType::Node &node = tree.node(stack.back());
+        stack.pop_back();
+        // Rays (bits 0..N-1) intersecting each child.
+        uint32_t ray_masks[Width] = { 0 };
+        for (int j = 0; j < Width; ++ j)
+            if (node.is_used(j)) {
+                const Scalar bmin[3] = { Scalar(node.min[0][j]), Scalar(node.min[1][j]), Scalar(node.min[2][j]) };
+                const Scalar bmax[3] = { Scalar(node.max[0][j]), Scalar(node.max[1][j]), Scalar(node.max[2][j]) };
+                ray_masks[j] = detail::packet_box_intersect(packet, bmin, bmax, tmax);
+            }
+        for (int j = Width - 1; j >= 0; -- j)
+            if (ray_masks[j] != 0) {
+                if (node.is_leaf(j))
+                    detail::packet_triangle_first_hit(packet, ray_masks[j], vertices, faces, node.child[j], eps, tmax, hits.data(), hit_mask);
+                else
+                    stack.emplace_back(node.child[j]);
+            }
+    }
+    return hit_mask;
+}
+
+// Find first intersections of a fan of rays cast from a single origin with indexed triangle set using a wide AABB tree.
+// The rays of a fan are coherent, thus they are traced in packets of N rays, the rays left over are traced one by one.
+// hit_fn(ray_idx, hit) is called for each ray which intersected the mesh.
+template<int N, typename VertexType, typename IndexedFaceType, int Width, typename CoordType, typename VectorType, typename HitFn>
+inline void intersect_ray_fan_first_hits(
+    const std::vector<VertexType>           &vertices,
+    const std::vector<IndexedFaceType>      &faces,
+    const WideTree<Width, 3, CoordType>     &tree,
+    const VectorType                        &origin,
+    const std::vector<VectorType>           &dirs,
+    HitFn                                  &&hit_fn,
+    const double                             eps = 0.000001)
+{
+    std::array<VectorType, N> origins;
+    origins.fill(origin);
+    size_t ray_idx = 0;
+    for (; ray_idx + N <= dirs.size(); ray_idx += N) {
+        std::array<VectorType, N> packet_dirs;
+        std::copy(dirs.begin() + ray_idx, dirs.begin() + ray_idx + N, packet_dirs.begin());
+        std::array<igl::Hit, N> hits;
+        uint32_t mask = intersect_ray_packet_first_hit<N>(vertices, faces, tree, origins, packet_dirs, hits, eps);
+        for (int i = 0; i < N; ++ i)
+            if ((mask >> i) & 1)
+                hit_fn(ray_idx + i, hits[i]);
+    }
+    for (; ray_idx < dirs.size(); ++ ray_idx)
+        if (igl::Hit hit; intersect_ray_first_hit(vertices, faces, tree, origin, dirs[ray_idx], hit, eps))
+            hit_fn(ray_idx, hit);
+}
+
+} // namespace AABBTreeIndirect
+} // namespace Slic3r
+
+#endif /* slic3r_AABBTreeWide_hpp_ */
@@ -0,0 +1,152 @@
+#include "AllocationStats.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef SLIC3R_SCALABLE_ALLOCATOR
+    #include <tbb/scalable_allocator.h>
+#endif // SLIC3R_SCALABLE_ALLOCATOR
+
+#ifdef WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace Slic3r {
+
+#ifdef SLIC3R_ALLOCATION_STATS
+// The counters of a thread are selected round robin when the thread allocates first.
+static constexpr const unsigned AllocationCounterShards = 64;
+
+struct alignas(64) AllocationCounterShard
+{
+    std::atomic<size_t> allocations { 0 };
+    std::atomic<size_t> bytes       { 0 };
+};
+
+// Constant initialized, thus valid for the allocations of the static constructors.
+static AllocationCounterShard s_allocation_counters[AllocationCounterShards];
+static std::atomic<unsigned>  s_next_allocation_counter_shard { 0 };
+static thread_local int       s_allocation_counter_shard = -1;
+
+static inline void count_allocation(size_t bytes)
+{
+    if (s_allocation_counter_shard == -1)
+        s_allocation_counter_shard = int(s_next_allocation_counter_shard.fetch_add(1, std::memory_order_relaxed) % AllocationCounterShards);
+    AllocationCounterShard &shard = s_allocation_counters[s_allocation_counter_shard];
+    // A shard is only shared by every 64th thread, thus its cache line is hardly ever contended.
+    shard.allocations.fetch_add(1, std::memory_order_relaxed);
+    shard.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+#endif // SLIC3R_ALLOCATION_STATS
+
+#if defined(SLIC3R_ALLOCATION_STATS) || defined(SLIC3R_SCALABLE_ALLOCATOR)
+static inline void* raw_allocate(size_t bytes)
+{
+#ifdef SLIC3R_SCALABLE_ALLOCATOR
+    return scalable_malloc(bytes);
+#else
+    return std::malloc(bytes);
+#endif
+}
+
+static inline void raw_free(void *ptr)
+{
+#ifdef SLIC3R_SCALABLE_ALLOCATOR
+    scalable_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+static void* counted_allocate(size_t bytes)
+{
+#ifdef SLIC3R_ALLOCATION_STATS
+    count_allocation(bytes);
+#endif // SLIC3R_ALLOCATION_STATS
+    if (bytes == 0)
+        bytes = 1;
+    for (;;) {
+        if (void *ptr = raw_allocate(bytes); ptr != nullptr)
+            return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+#endif // SLIC3R_ALLOCATION_STATS || SLIC3R_SCALABLE_ALLOCATOR
+
+bool allocation_stats_available()
+{
+#ifdef SLIC3R_ALLOCATION_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationStats allocation_stats()
+{
+    AllocationStats out;
+#ifdef SLIC3R_ALLOCATION_STATS
+    for (const AllocationCounterShard &shard : s_allocation_counters) {
+        out.allocations += shard.allocations.load(std::memory_order_relaxed);
+        out.bytes       += shard.bytes.load(std::memory_order_relaxed);
+    }
+#endif // SLIC3R_ALLOCATION_STATS
+    out.peak_rss = peak_rss();
+    return out;
+}
+
+size_t peak_rss()
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return size_t(pmc.PeakWorkingSetSize);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    #ifdef __APPLE__
+        return size_t(usage.ru_maxrss);
+    #else
+        // getrusage returns the value in kB on linux
+        return size_t(usage.ru_maxrss) * 1024;
+    #endif
+    }
+#endif
+    return 0;
+}
+
+const char* allocator_name()
+{
+#ifdef SLIC3R_SCALABLE_ALLOCATOR
+    return "tbbmalloc";
+#else
+    return "malloc";
+#endif
+}
+
+} // namespace Slic3r
+
+#if defined(SLIC3R_ALLOCATION_STATS) || defined(SLIC3R_SCALABLE_ALLOCATOR)
+// Replacements of the global allocation functions. The nothrow variants are replaced as well, so that they are
+// paired with the replaced delete even if a sanitizer intercepts the standard ones. The over-aligned variants
+// are left to the standard library, they are rare and they are paired with their own delete.
+void* operator new(std::size_t bytes) { return Slic3r::counted_allocate(bytes); }
+void* operator new[](std::size_t bytes) { return Slic3r::counted_allocate(bytes); }
+void* operator new(std::size_t bytes, const std::nothrow_t &) noexcept
+    { try { return Slic3r::counted_allocate(bytes); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t bytes, const std::nothrow_t &) noexcept
+    { try { return Slic3r::counted_allocate(bytes); } catch (...) { return nullptr; } }
+void  operator delete(void *ptr) noexcept { Slic3r::raw_free(ptr); }
+void  operator delete[](void *ptr) noexcept { Slic3r::raw_free(ptr); }
+void  operator delete(void *ptr, std::size_t) noexcept { Slic3r::raw_free(ptr); }
+void  operator delete[](void *ptr, std::size_t) noexcept { Slic3r::raw_free(ptr); }
+void  operator delete(void *ptr, const std::nothrow_t &) noexcept { Slic3r::raw_free(ptr); }
+void  operator delete[](void *ptr, const std::nothrow_t &) noexcept { Slic3r::raw_free(ptr); }
+#endif // SLIC3R_ALLOCATION_STATS || SLIC3R_SCALABLE_ALLOCATOR
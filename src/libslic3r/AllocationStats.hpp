@@ -0,0 +1,48 @@
+#ifndef slic3r_AllocationStats_hpp_
+#define slic3r_AllocationStats_hpp_
+
+#include <algorithm>
+#include <cstddef>
+
+namespace Slic3r {
+
+// Telemetry of the heap allocations of the process.
+//
+// If built with SLIC3R_ALLOCATION_STATS, libslic3r replaces the global operator new and delete to count
+// the allocations. The counters are sharded over cache lines, so that the TBB workers allocating in parallel
+// do not contend on them. Otherwise the allocations are not counted, only the peak RSS is reported.
+// If built with SLIC3R_SCALABLE_ALLOCATOR, operator new allocates from TBB's scalable allocator (tbbmalloc),
+// which serves the threads from their own pools, otherwise it allocates by malloc().
+struct AllocationStats
+{
+    // Calls to operator new and the bytes requested by them.
+    size_t allocations { 0 };
+    size_t bytes       { 0 };
+    // Peak resident set size of the process in bytes, zero if not known.
+    size_t peak_rss    { 0 };
+
+    // Allocations made since the rhs snapshot, the peak RSS is the one of this snapshot.
+    AllocationStats operator-(const AllocationStats &rhs) const
+        { return { allocations - rhs.allocations, bytes - rhs.bytes, peak_rss }; }
+    // Sums the allocations, the peak RSS is the higher one.
+    AllocationStats& operator+=(const AllocationStats &rhs) {
+        allocations += rhs.allocations;
+        bytes       += rhs.bytes;
+        peak_rss     = std::max(peak_rss, rhs.peak_rss);
+        return *this;
+    }
+};
+
+// True if the allocations are counted, that is if built with SLIC3R_ALLOCATION_STATS.
+bool            allocation_stats_available();
+// Snapshot of the counters of the whole process, they are never reset.
+// The allocations and bytes are zero if the allocations are not counted.
+AllocationStats allocation_stats();
+// Peak resident set size of the process since its start in bytes, zero if not known.
+size_t          peak_rss();
+// Allocator serving operator new, "tbbmalloc" or "malloc".
+const char*     allocator_name();
+
+} // namespace Slic3r
+
+#endif // slic3r_AllocationStats_hpp_
@@ -1,11 +1,211 @@
 #include "ArcFitter.hpp"
 #include "Polyline.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <limits>
 
 namespace Slic3r {
 
+namespace {
+
+// Incremental equivalent of ArcSegment::try_create_arc() over a sequence of points growing by a single point,
+// returning identical results. try_create_arc() checks all points and segments against the candidate circle,
+// which is quadratic in the number of points of a long smooth arc.
+// The distance of a point or a segment from a circle changes by at most the sum of the shifts of the center and radius,
+// thus the points and segments checked at the previous steps are kept bounded against an anchor circle and only the
+// new point and segment are checked, while the bound plus the drift of the candidate circle from the anchor stays within
+// tolerance. The points and segments are checked one by one only if the bound is exceeded, re-anchoring the bound.
+class IncrementalArcFitter
+{
+public:
+    IncrementalArcFitter(double max_radius, double tolerance, double path_tolerance_percent) :
+        m_max_radius(max_radius), m_tolerance(tolerance), m_path_tolerance_percent(path_tolerance_percent) {}
+
+    void reserve(size_t num_points) { m_points.reserve(num_points); }
+
+    void push_back(const Point &pt) {
+        //BBS: same summation as Polyline::length()
+        if (! m_points.empty())
+            m_length += Line(m_points.back(), pt).length();
+        m_points.push_back(pt);
+    }
+
+    void reset(const Point &p1, const Point &p2) {
+        m_points.clear();
+        m_length      = 0;
+        m_num_covered = 1;
+        m_failed_item = std::numeric_limits<size_t>::max();
+        this->push_back(p1);
+        this->push_back(p2);
+    }
+
+    // Same as ArcSegment::try_create_arc(points, target_arc, Polyline(points).length(), ...) over the points pushed.
+    bool try_create_arc(ArcSegment &target_arc) {
+        assert(m_points.size() >= 3);
+        CircleFit fit;
+        if (! this->try_create_circle(fit))
+            return false;
+        int mid_point_index = ((m_points.size() - 2) / 2) + 1;
+        ArcSegment test_arc;
+        if (! ArcSegment::try_create_arc(fit.circle, m_points.front(), m_points[mid_point_index], m_points.back(), test_arc, m_length, m_path_tolerance_percent) ||
+            ! ArcSegment::are_points_within_slice(test_arc, m_points))
+            return false;
+        target_arc = test_arc;
+        this->accept(fit);
+        return true;
+    }
+
+private:
+    struct CircleFit {
+        Circle circle;
+        // Upper bound of the deviation of the points and segments not covered by m_max_deviation yet.
+        double new_deviation { 0 };
+        // All the points and segments were checked against this circle, max_deviation is their maximum deviation.
+        bool   checked_all { false };
+        double max_deviation { 0 };
+    };
+
+    // Same as Circle::try_create_circle(m_points, m_max_radius, m_tolerance, fit.circle).
+    bool try_create_circle(CircleFit &fit) {
+        size_t count = m_points.size();
+        size_t middle_index = count / 2;
+        if (count == 3)
+            return Circle::try_create_circle(m_points[0], m_points[middle_index], m_points[count - 1], m_max_radius, fit.circle) && this->fits(fit, nullptr);
+        Point middle_point = (count % 2 == 0) ? (m_points[middle_index] + m_points[middle_index - 1]) / 2 :
+                                                (m_points[middle_index - 1] + m_points[middle_index + 1]) / 2;
+        if (Circle::try_create_circle(m_points[0], middle_point, m_points[count - 1], m_max_radius, fit.circle) && this->fits(fit, nullptr))
+            return true;
+
+        CircleFit test_fit;
+        double least_deviation;
+        bool found_circle = false;
+        double current_deviation;
+        for (size_t index = 1; index < count - 1; index++) {
+            if (index == middle_index)
+                continue;
+            if (Circle::try_create_circle(m_points[0], m_points[index], m_points[count - 1], m_max_radius, test_fit.circle) && this->fits(test_fit, &current_deviation)) {
+                if (! found_circle || current_deviation < least_deviation) {
+                    found_circle = true;
+                    least_deviation = current_deviation;
+                    fit = test_fit;
+                }
+            }
+        }
+        return found_circle;
+    }
+
+    // Same result as ! fit.circle.is_over_deviation(m_points, m_tolerance), resp. fit.circle.get_deviation_sum_squared(m_points, m_tolerance, *sum_squared)
+    // if sum_squared is set.
+    bool fits(CircleFit &fit, double *sum_squared) {
+        const Circle &circle = fit.circle;
+        const size_t  count  = m_points.size();
+        double        deviation;
+        // Points and segments added since the last accepted circle.
+        fit.new_deviation = 0;
+        for (size_t index = std::max<size_t>(m_num_covered - 1, 1); index < count - 1; ++ index)
+            if ((deviation = circle.get_deviation(m_points[index])) > m_tolerance)
+                return false;
+            else
+                fit.new_deviation = std::max(fit.new_deviation, deviation);
+        for (size_t index = m_num_covered - 1; index < count - 1; ++ index)
+            if (circle.get_deviation(m_points[index], m_points[index + 1], deviation) && deviation > m_tolerance)
+                return false;
+            else
+                fit.new_deviation = std::max(fit.new_deviation, segment_deviation(circle, m_points[index], m_points[index + 1]));
+
+        fit.checked_all = m_num_covered == 1;
+        if (fit.checked_all) {
+            fit.max_deviation = fit.new_deviation;
+            if (sum_squared)
+                return circle.get_deviation_sum_squared(m_points, m_tolerance, *sum_squared);
+            return true;
+        }
+        if (sum_squared == nullptr && m_max_deviation + this->drift(circle) + DeviationBoundMargin <= m_tolerance)
+            return true;
+
+        //BBS: check the point or segment out of tolerance last time first, then all of them in the order of Circle::get_deviation_sum_squared()
+        if (m_failed_item < 2 * count - 2 && ! this->item_fits(circle, m_failed_item))
+            return false;
+        fit.checked_all   = true;
+        fit.max_deviation = 0;
+        double total_deviation = 0;
+        for (size_t item = 2; item < 2 * count - 2; item += 2)
+            if ((deviation = circle.get_deviation(m_points[item / 2])) > m_tolerance) {
+                m_failed_item = item;
+                return false;
+            } else {
+                total_deviation += deviation * deviation;
+                fit.max_deviation = std::max(fit.max_deviation, deviation);
+            }
+        for (size_t item = 1; item < 2 * count - 2; item += 2) {
+            const Point &p1 = m_points[item / 2];
+            const Point &p2 = m_points[item / 2 + 1];
+            if (circle.get_deviation(p1, p2, deviation)) {
+                total_deviation += deviation * deviation;
+                if (deviation > m_tolerance) {
+                    m_failed_item = item;
+                    return false;
+                }
+            }
+            fit.max_deviation = std::max(fit.max_deviation, segment_deviation(circle, p1, p2));
+        }
+        if (sum_squared)
+            *sum_squared = total_deviation;
+        return true;
+    }
+
+    // Point index / 2 for even item, segment index / 2 for odd item.
+    bool item_fits(const Circle &circle, size_t item) const {
+        double deviation;
+        return item % 2 == 0 ?
+            circle.get_deviation(m_points[item / 2]) <= m_tolerance :
+            ! circle.get_deviation(m_points[item / 2], m_points[item / 2 + 1], deviation) || deviation <= m_tolerance;
+    }
+
+    void accept(const CircleFit &fit) {
+        if (fit.checked_all) {
+            m_anchor        = fit.circle;
+            m_max_deviation = fit.max_deviation;
+        } else
+            m_max_deviation = std::max(m_max_deviation, fit.new_deviation + this->drift(fit.circle));
+        m_num_covered = m_points.size();
+    }
+
+    // Upper bound of the change of the deviation of any point or segment between the anchor circle and circle.
+    double drift(const Circle &circle) const {
+        return (circle.center - m_anchor.center).cast<double>().norm() + std::abs(circle.radius - m_anchor.radius);
+    }
+
+    // Deviation of the closest point of a segment from the circle. Circle::get_deviation() of a segment rounds the closest point
+    // to integers and skips the segments, the closest point of which is an end point.
+    static double segment_deviation(const Circle &circle, const Point &p1, const Point &p2) {
+        Vec2d  v  = (p2 - p1).cast<double>();
+        Vec2d  w  = (circle.center - p1).cast<double>();
+        double l2 = v.squaredNorm();
+        double t  = l2 > 0. ? std::clamp(w.dot(v) / l2, 0., 1.) : 0.;
+        return std::abs((w - t * v).norm() - circle.radius);
+    }
+
+    // Rounding of the closest point of a segment to integers plus numeric noise, in scaled coordinates.
+    static constexpr double DeviationBoundMargin = 2.;
+
+    const double m_max_radius;
+    const double m_tolerance;
+    const double m_path_tolerance_percent;
+    Points       m_points;
+    double       m_length { 0 };
+    // The points [1, m_num_covered - 1) and segments [0, m_num_covered - 1) deviate at most m_max_deviation from m_anchor.
+    size_t       m_num_covered { 1 };
+    Circle       m_anchor;
+    double       m_max_deviation { 0 };
+    // Point (even) or segment (odd) out of tolerance at the last check of all of them.
+    size_t       m_failed_item { std::numeric_limits<size_t>::max() };
+};
+
+} // namespace
+
 void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData>& result, double tolerance)
 {
 #ifdef DEBUG_ARC_FITTING
@@ -39,20 +239,18 @@ void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData
     size_t back_index = 0;
     ArcSegment last_arc;
     bool can_fit = false;
-    Points current_segment;
-    current_segment.reserve(points.size());
+    //BBS: current segment, fitted incrementally
+    IncrementalArcFitter fitter(DEFAULT_SCALED_MAX_RADIUS, tolerance, DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE);
+    fitter.reserve(points.size());
     ArcSegment target_arc;
     for (size_t i = 0; i < points.size(); i++) {
         //BBS: point in stack is not enough, build stack first
         back_index = i;
-        current_segment.push_back(points[i]);
+        fitter.push_back(points[i]);
         if (back_index - front_index < 2)
             continue;
 
-        can_fit = ArcSegment::try_create_arc(current_segment, target_arc, Polyline(current_segment).length(),
-                                             DEFAULT_SCALED_MAX_RADIUS,
-                                             tolerance,
-                                             DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE);
+        can_fit = fitter.try_create_arc(target_arc);
         if (can_fit) {
             //BBS: can be fit as arc, then save arc data temperarily
             last_arc = target_arc;
@@ -79,9 +277,7 @@ void ArcFitter::do_arc_fitting(const Points& points, std::vector<PathFittingData
                     result.back().end_point_index = front_index + 1;
             }
             front_index = back_index - 1;
-            current_segment.clear();
-            current_segment.push_back(points[front_index]);
-            current_segment.push_back(points[front_index + 1]);
+            fitter.reset(points[front_index], points[front_index + 1]);
         }
     }
 	//BBS: handle the remain data
@@ -8,6 +8,7 @@
 #include "libslic3r.h"
 #include "PrintConfig.hpp"
 #include "Model.hpp"
+#include "ScratchArena.hpp"
 #include <algorithm>
 #include <numeric>
 #include <unordered_set>
@@ -586,16 +587,17 @@ double getadhesionCoeff(const PrintObject* printObject)
                 extrudersFirstLayer.push_back(regionPtr->region().extruder(frExternalPerimeter));
         }
     }
+    const std::map<size_t, ExtruderParams> &extruder_params = print->brim_extruder_params();
     double adhesionCoeff = 1;
     for (const ModelVolume* modelVolume : objectVolumes) {
         for (auto iter = extrudersFirstLayer.begin(); iter != extrudersFirstLayer.end(); iter++)
             if (modelVolume->extruder_id() == *iter) {
-                if (Model::extruderParamsMap.find(modelVolume->extruder_id()) != Model::extruderParamsMap.end())
-                    if (Model::extruderParamsMap.at(modelVolume->extruder_id()).materialName == "PETG" ||
-                        Model::extruderParamsMap.at(modelVolume->extruder_id()).materialName == "PCTG") {
+                if (extruder_params.find(modelVolume->extruder_id()) != extruder_params.end())
+                    if (extruder_params.at(modelVolume->extruder_id()).materialName == "PETG" ||
+                        extruder_params.at(modelVolume->extruder_id()).materialName == "PCTG") {
                         adhesionCoeff = 2;
-                    } else if (Model::extruderParamsMap.at(modelVolume->extruder_id()).materialName == "TPU" ||
-                               Model::extruderParamsMap.at(modelVolume->extruder_id()).materialName == "TPU-AMS") {
+                    } else if (extruder_params.at(modelVolume->extruder_id()).materialName == "TPU" ||
+                               extruder_params.at(modelVolume->extruder_id()).materialName == "TPU-AMS") {
                         adhesionCoeff = 0.5;
                     }
             }
@@ -716,7 +718,8 @@ bool compSecondMoment(const ExPolygons& expolys, double& smExpolysX, double& smE
 
 
 //BBS: config brimwidth by volumes
-double configBrimWidthByVolumes(double deltaT, double adhension, double maxSpeed, const ModelVolume* modelVolumePtr, const ExPolygons& expolys)
+double configBrimWidthByVolumes(double deltaT, double adhension, double maxSpeed, const ModelVolume* modelVolumePtr, const ExPolygons& expolys,
+                                const std::map<size_t, ExtruderParams> &extruder_params)
 {
     // height of a volume
     double height = 0;
@@ -743,7 +746,7 @@ double configBrimWidthByVolumes(double deltaT, double adhension, double maxSpeed
     const double& bboxX = bbox2.size()(0);
     const double& bboxY = bbox2.size()(1);
     double thermalLength = sqrt(bboxX * bboxX + bboxY * bboxY) * SCALING_FACTOR;
-    double thermalLengthRef = Model::getThermalLength(modelVolumePtr);
+    double thermalLengthRef = Model::getThermalLength(modelVolumePtr, extruder_params);
 
     double height_to_area = std::max(height / Ixx * (bbox2.size()(1) * SCALING_FACTOR), height / Iyy * (bbox2.size()(0) * SCALING_FACTOR));
     double brim_width = adhension * std::min(std::min(std::max(height_to_area * maxSpeed / 24, thermalLength * 8. / thermalLengthRef * std::min(height, 30.) / 30.), 18.), 1.5 * thermalLength);
@@ -757,7 +760,8 @@ double configBrimWidthByVolumes(double deltaT, double adhension, double maxSpeed
 }
 
 //BBS: config brimwidth by group of volumes
-double configBrimWidthByVolumeGroups(double adhension, double maxSpeed, const std::vector<ModelVolume*> modelVolumePtrs, const ExPolygons& expolys, double &groupHeight)
+double configBrimWidthByVolumeGroups(double adhension, double maxSpeed, const std::vector<ModelVolume*> modelVolumePtrs, const ExPolygons& expolys, double &groupHeight,
+                                     const std::map<size_t, ExtruderParams> &extruder_params)
 {
     // height of a group of volumes
     double height = 0;
@@ -792,7 +796,7 @@ double configBrimWidthByVolumeGroups(double adhension, double maxSpeed, const st
     const double& bboxX = bbox2.size()(0);
     const double& bboxY = bbox2.size()(1);
     double thermalLength = sqrt(bboxX * bboxX + bboxY * bboxY) * SCALING_FACTOR;
-    double thermalLengthRef = Model::getThermalLength(modelVolumePtrs);
+    double thermalLengthRef = Model::getThermalLength(modelVolumePtrs, extruder_params);
 
     double height_to_area = std::max(height / Ixx * (bbox2.size()(1) * SCALING_FACTOR), height / Iyy * (bbox2.size()(0) * SCALING_FACTOR)) * height / 1920;
     double brim_width = adhension * std::min(std::min(std::max(height_to_area * maxSpeed, 0. * thermalLength * 8. / thermalLengthRef * std::min(height, 30.) / 30.), 18.), 1.5 * thermalLength);
@@ -905,7 +909,7 @@ static ExPolygons outer_inner_brim_area(const Print& print,
             if (objectWithExtruder.second == extruderNo && brimToWrite.at(object->id()).obj) {
                 double             deltaT = getTemperatureFromExtruder(object);
                 double             adhension = getadhesionCoeff(object);
-                double             maxSpeed = Model::findMaxSpeed(object->model_object());
+                double             maxSpeed = Model::findMaxSpeed(object->model_object(), print.brim_speed_map());
 
                 //BBS: collect holes area which is used to limit the brim of inner island
                 Polygons holes_area;
@@ -936,7 +940,7 @@ static ExPolygons outer_inner_brim_area(const Print& print,
                     double groupHeight = 0.;
                     // config brim width in auto-brim mode
                     if (has_brim_auto) {
-                        double brimWidthRaw = configBrimWidthByVolumeGroups(adhension, maxSpeed, groupVolumePtrs, volumeGroup.slices, groupHeight);
+                        double brimWidthRaw = configBrimWidthByVolumeGroups(adhension, maxSpeed, groupVolumePtrs, volumeGroup.slices, groupHeight, print.brim_extruder_params());
                         brim_width = scale_(floor(brimWidthRaw / flowWidth / 2) * flowWidth * 2);
                     }
 
@@ -1054,7 +1058,7 @@ static ExPolygons outer_inner_brim_area(const Print& print,
     int  extruder_nums = print.config().nozzle_diameter.values.size();
     std::vector<Polygons> extruder_unprintable_area;
     if (extruder_nums == 1)
-        extruder_unprintable_area.emplace_back(Polygons{Model::getBedPolygon()});
+        extruder_unprintable_area.emplace_back(Polygons{print.brim_speed_map().bed_poly});
     else {
         extruder_unprintable_area = print.get_extruder_printable_polygons();
     }
@@ -1121,6 +1125,7 @@ static ExPolygons outer_inner_brim_area(const Print& print,
             tbb::parallel_for(tbb::blocked_range<int>(0, tempAreas.size()),
                 [&tempAreas, &objectIslands, &print, &otherExPolys, &brimMutex, &retained](const tbb::blocked_range<int>& range) {
                     for (auto ia = range.begin(); ia != range.end(); ++ia) {
+                        ScratchArenaScope scratch;
                         tbb::spin_mutex::scoped_lock lock;
                         ExPolygons otherExPoly;
 
@@ -1320,6 +1325,7 @@ static void make_inner_island_brim(const Print& print, const ConstPrintObjectPtr
                     tbb::parallel_for(tbb::blocked_range<size_t>(0, loops_pl.size()),
                         [&loops_pl_by_levels, &loops_pl, &brimable_area](const tbb::blocked_range<size_t>& range) {
                             for (size_t i = range.begin(); i < range.end(); ++i) {
+                                ScratchArenaScope scratch;
                                 loops_pl_by_levels[i] = chain_polylines(intersection_pl({ std::move(loops_pl[i]) }, brimable_area));
                             }
                         });
@@ -1658,6 +1664,7 @@ ExtrusionEntityCollection makeBrimInfill(const ExPolygons& singleBrimArea, const
         tbb::parallel_for(tbb::blocked_range<size_t>(0, loops_pl.size()),
             [&loops_pl_by_levels, &loops_pl, &islands_area](const tbb::blocked_range<size_t>& range) {
                 for (size_t i = range.begin(); i < range.end(); ++i) {
+                    ScratchArenaScope scratch;
                     loops_pl_by_levels[i] = chain_polylines({ std::move(loops_pl[i]) });
                     //loops_pl_by_levels[i] = chain_polylines(intersection_pl({ std::move(loops_pl[i]) }, islands_area));
                 }
@@ -1781,6 +1788,7 @@ ExtrusionEntityCollection make_brim(const Print &print, PrintTryCancel try_cance
         tbb::parallel_for(tbb::blocked_range<size_t>(0, loops_pl.size()),
             [&loops_pl_by_levels, &loops_pl, &islands_area](const tbb::blocked_range<size_t> &range) {
                 for (size_t i = range.begin(); i < range.end(); ++i) {
+                    ScratchArenaScope scratch;
                     loops_pl_by_levels[i] = chain_polylines(intersection_pl({ std::move(loops_pl[i]) }, islands_area));
                 }
             });
@@ -102,30 +102,35 @@ double Circle::get_polar_radians(const Point& p1) const
     return polar_radians;
 }
 
-bool Circle::is_over_deviation(const Points& points, const double tolerance)
+double Circle::get_deviation(const Point& p) const
+{
+    Point temp = p - center;
+    double distance_from_center = sqrt((double)temp.x() * (double)temp.x() + (double)temp.y() * (double)temp.y());
+    return std::fabs(distance_from_center - radius);
+}
+
+bool Circle::get_deviation(const Point& p1, const Point& p2, double& deviation) const
 {
     Point closest_point;
-    Point temp;
-    double distance_from_center;
+    if (!get_closest_perpendicular_point(p1, p2, center, closest_point))
+        return false;
+    deviation = get_deviation(closest_point);
+    return true;
+}
+
+bool Circle::is_over_deviation(const Points& points, const double tolerance) const
+{
+    double deviation;
     // BBS: skip the first and last points since they has fit perfectly.
     for (size_t index = 0; index < points.size() - 1; index++)
     {
-        if (index != 0)
-        {
-            //BBS: check fitting tolerance
-            temp = points[index] - center;
-            distance_from_center = sqrt((double)temp.x() * (double)temp.x() + (double)temp.y() * (double)temp.y());
-            if (std::fabs(distance_from_center - radius) > tolerance)
-                return true;
-        }
+        //BBS: check fitting tolerance
+        if (index != 0 && get_deviation(points[index]) > tolerance)
+            return true;
 
         //BBS: Check the point perpendicular from the segment to the circle's center
-        if (get_closest_perpendicular_point(points[index], points[(size_t)index + 1], center, closest_point)) {
-            temp = closest_point - center;
-            distance_from_center = sqrt((double)temp.x() * (double)temp.x() + (double)temp.y() * (double)temp.y());
-            if (std::fabs(distance_from_center - radius) > tolerance)
-                return true;
-        }
+        if (get_deviation(points[index], points[index + 1], deviation) && deviation > tolerance)
+            return true;
     }
     return false;
 }
@@ -152,32 +157,25 @@ bool Circle::get_closest_perpendicular_point(const Point& p1, const Point& p2, c
     return true;
 }
 
-bool Circle::get_deviation_sum_squared(const Points& points, const double tolerance, double& total_deviation)
+bool Circle::get_deviation_sum_squared(const Points& points, const double tolerance, double& total_deviation) const
 {
     total_deviation = 0;
-    Point temp;
-    double distance_from_center,  deviation;
+    double deviation;
     // BBS: skip the first and last points since they are on the circle
-    for (int index = 1; index < points.size() - 1; index++)
+    for (size_t index = 1; index < points.size() - 1; index++)
     {
         //BBS: make sure the length from the center of our circle to the test point is 
         // at or below our max distance.
-        temp = points[index] - center;
-        distance_from_center = sqrt((double)temp.x() * (double)temp.x() + (double)temp.y() * (double)temp.y());
-        deviation = std::fabs(distance_from_center - radius);
+        deviation = get_deviation(points[index]);
         total_deviation += deviation * deviation;
         if (deviation > tolerance)
             return false;
 
     }
-    Point closest_point;
     //BBS: check the point perpendicular from the segment to the circle's center
-    for (int index = 0; index < points.size() - 1; index++)
+    for (size_t index = 0; index < points.size() - 1; index++)
     {
-        if (get_closest_perpendicular_point(points[index], points[(size_t)index + 1], center, closest_point)) {
-            temp = closest_point - center;
-            distance_from_center = sqrt((double)temp.x() * (double)temp.x() + (double)temp.y() * (double)temp.y());
-            deviation = std::fabs(distance_from_center - radius);
+        if (get_deviation(points[index], points[index + 1], deviation)) {
             total_deviation += deviation * deviation;
             if (deviation > tolerance)
                 return false;
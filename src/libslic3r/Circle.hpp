@@ -29,8 +29,12 @@ public:
     static bool try_create_circle(const Point &p1, const Point &p2, const Point &p3, const double max_radius, Circle& new_circle);
     static bool try_create_circle(const Points& points, const double max_radius, const double tolerance, Circle& new_circle);
     double get_polar_radians(const Point& p1) const;
-    bool is_over_deviation(const Points& points, const double tolerance);
-    bool get_deviation_sum_squared(const Points& points, const double tolerance, double& sum_deviation);
+    //BBS: deviation of a point from the circle
+    double get_deviation(const Point& p) const;
+    //BBS: deviation of the point of segment p1 p2 closest to the center, false if the closest point is not inside the segment
+    bool get_deviation(const Point& p1, const Point& p2, double& deviation) const;
+    bool is_over_deviation(const Points& points, const double tolerance) const;
+    bool get_deviation_sum_squared(const Points& points, const double tolerance, double& sum_deviation) const;
 
     //BBS: only support calculate on X-Y plane, Z is useless
     static Vec3f calc_tangential_vector(const Vec3f& pos, const Vec3f& center_pos, const bool is_ccw);
@@ -115,11 +119,7 @@ public:
     static bool are_points_within_slice(const ArcSegment& test_arc, const Points &points);
     // BBS: this function is used to detect whether a ray cross the segment
     static bool ray_intersects_segment(const Point& rayOrigin, const Vec2d& rayDirection, const Line& segment);
-    // BBS: these three functions are used to calculate related arguments of arc in unscale_field.
-    static float calc_arc_radian(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
-    static float calc_arc_radius(Vec3f start_pos, Vec3f center_pos);
-    static float calc_arc_length(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
-private:
+    // BBS: create the arc from a circle already fitted to the points, with the direction given by the start, middle and end point
     static bool try_create_arc(
         const Circle& c,
         const Point& start_point,
@@ -128,6 +128,10 @@ private:
         ArcSegment& target_arc,
         double approximate_length,
         double path_tolerance_percent = DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE);
+    // BBS: these three functions are used to calculate related arguments of arc in unscale_field.
+    static float calc_arc_radian(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
+    static float calc_arc_radius(Vec3f start_pos, Vec3f center_pos);
+    static float calc_arc_length(Vec3f start_pos, Vec3f end_pos, Vec3f center_pos, bool is_ccw);
 };
 
 }
@@ -2,6 +2,18 @@
 #include "Geometry.hpp"
 #include "ShortestPath.hpp"
 
+#include <atomic>
+#include <numeric>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+
+#include <clipper2/clipper.h>
+
 // #define CLIPPER_UTILS_DEBUG
 
 #ifdef CLIPPER_UTILS_DEBUG
@@ -162,16 +174,217 @@ void clip_clipper_polygon_with_subject_bbox(const Polygon &src, const BoundingBo
 {
     Polygons out;
     out.reserve(number_polygons(src));
-    for (const ExPolygon &p : src) {
-        Polygons temp = clip_clipper_polygons_with_subject_bbox(p, bbox, get_entire_polygons);
-        out.insert(out.end(), temp.begin(), temp.end());
-    }
+    for (const ExPolygon &p : src)
+        append(out, clip_clipper_polygons_with_subject_bbox(p, bbox, get_entire_polygons));
 
     out.erase(std::remove_if(out.begin(), out.end(), [](const Polygon &polygon) {return polygon.empty(); }), out.end());
     return out;
 }
 }
 
+#ifdef SLIC3R_CLIPPER2_BACKEND
+static constexpr const ClipperBackend DefaultClipperBackend = ClipperBackend::Clipper2;
+#else
+static constexpr const ClipperBackend DefaultClipperBackend = ClipperBackend::ClipperLib;
+#endif
+
+static std::atomic<ClipperBackend>& clipper_backend_state()
+{
+    static std::atomic<ClipperBackend> backend { [] {
+        if (const char *env = ::getenv("SLIC3R_CLIPPER_BACKEND"); env != nullptr) {
+            if (boost::iequals(env, "clipper2"))
+                return ClipperBackend::Clipper2;
+            if (boost::iequals(env, "clipperlib"))
+                return ClipperBackend::ClipperLib;
+            BOOST_LOG_TRIVIAL(error) << "Unknown SLIC3R_CLIPPER_BACKEND \"" << env << "\", the default Clipper backend is used.";
+        }
+        return DefaultClipperBackend;
+    }() };
+    return backend;
+}
+
+ClipperBackend clipper_backend() { return clipper_backend_state().load(std::memory_order_relaxed); }
+void           set_clipper_backend(ClipperBackend backend) { clipper_backend_state().store(backend, std::memory_order_relaxed); }
+
+// Adaptors executing the ClipperLib operations below by Clipper2Lib, producing the ClipperLib result types.
+namespace Clipper2Backend {
+    inline Clipper2Lib::ClipType clip_type(ClipperLib::ClipType clip_type)
+    {
+        switch (clip_type) {
+        case ClipperLib::ctIntersection: return Clipper2Lib::ClipType::Intersection;
+        case ClipperLib::ctUnion:        return Clipper2Lib::ClipType::Union;
+        case ClipperLib::ctDifference:   return Clipper2Lib::ClipType::Difference;
+        default:                         return Clipper2Lib::ClipType::Xor;
+        }
+    }
+
+    inline Clipper2Lib::FillRule fill_rule(ClipperLib::PolyFillType fill_type)
+    {
+        switch (fill_type) {
+        case ClipperLib::pftEvenOdd:  return Clipper2Lib::FillRule::EvenOdd;
+        case ClipperLib::pftNonZero:  return Clipper2Lib::FillRule::NonZero;
+        case ClipperLib::pftPositive: return Clipper2Lib::FillRule::Positive;
+        default:                      return Clipper2Lib::FillRule::Negative;
+        }
+    }
+
+    inline Clipper2Lib::JoinType join_type(ClipperLib::JoinType join_type)
+    {
+        switch (join_type) {
+        case ClipperLib::jtSquare: return Clipper2Lib::JoinType::Square;
+        case ClipperLib::jtRound:  return Clipper2Lib::JoinType::Round;
+        default:                   return Clipper2Lib::JoinType::Miter;
+        }
+    }
+
+    inline Clipper2Lib::EndType end_type(ClipperLib::EndType end_type)
+    {
+        switch (end_type) {
+        case ClipperLib::etClosedPolygon: return Clipper2Lib::EndType::Polygon;
+        case ClipperLib::etClosedLine:    return Clipper2Lib::EndType::Joined;
+        case ClipperLib::etOpenButt:      return Clipper2Lib::EndType::Butt;
+        case ClipperLib::etOpenSquare:    return Clipper2Lib::EndType::Square;
+        default:                          return Clipper2Lib::EndType::Round;
+        }
+    }
+
+    inline Clipper2Lib::Path64 to_path64(const Points &path)
+    {
+        Clipper2Lib::Path64 out;
+        out.reserve(path.size());
+        for (const Point &pt : path)
+            out.emplace_back(pt.x(), pt.y());
+        return out;
+    }
+
+    template<typename PathsProvider>
+    inline Clipper2Lib::Paths64 to_paths64(PathsProvider &&paths)
+    {
+        Clipper2Lib::Paths64 out;
+        out.reserve(paths.size());
+        for (const Points &path : paths)
+            out.emplace_back(to_path64(path));
+        return out;
+    }
+
+    inline ClipperLib::Path to_path(const Clipper2Lib::Path64 &path)
+    {
+        ClipperLib::Path out;
+        out.reserve(path.size());
+        for (const Clipper2Lib::Point64 &pt : path)
+            out.emplace_back(coord_t(pt.x), coord_t(pt.y));
+        return out;
+    }
+
+    inline ClipperLib::Paths to_paths(const Clipper2Lib::Paths64 &paths)
+    {
+        ClipperLib::Paths out;
+        out.reserve(paths.size());
+        for (const Clipper2Lib::Path64 &path : paths)
+            out.emplace_back(to_path(path));
+        return out;
+    }
+
+    static size_t polytree_count_nodes(const Clipper2Lib::PolyPath64 &node)
+    {
+        size_t cnt = node.Count();
+        for (const auto &child : node)
+            cnt += polytree_count_nodes(*child);
+        return cnt;
+    }
+
+    static void polytree_add_nodes(const Clipper2Lib::PolyPath64 &src, ClipperLib::PolyNode &dst, ClipperLib::PolyTree &tree)
+    {
+        for (const auto &child : src)
+            polytree_add_nodes(*child, tree.AddNode(dst, to_path(child->Polygon())), tree);
+    }
+
+    inline void execute(Clipper2Lib::Clipper64 &clipper, ClipperLib::ClipType clipType, ClipperLib::PolyFillType fillType, ClipperLib::Paths &out)
+    {
+        Clipper2Lib::Paths64 solution;
+        clipper.Execute(clip_type(clipType), fill_rule(fillType), solution);
+        out = to_paths(solution);
+    }
+
+    inline void execute(Clipper2Lib::Clipper64 &clipper, ClipperLib::ClipType clipType, ClipperLib::PolyFillType fillType, ClipperLib::PolyTree &out)
+    {
+        Clipper2Lib::PolyTree64 solution;
+        clipper.Execute(clip_type(clipType), fill_rule(fillType), solution);
+        out.ReserveNodes(polytree_count_nodes(solution));
+        polytree_add_nodes(solution, out, out);
+    }
+
+    template<class TResult, class TSubj, class TClip>
+    TResult clipper_do(const ClipperLib::ClipType clipType, TSubj &&subject, TClip &&clip, const ClipperLib::PolyFillType fillType)
+    {
+        Clipper2Lib::Clipper64 clipper;
+        clipper.AddSubject(to_paths64(std::forward<TSubj>(subject)));
+        clipper.AddClip(to_paths64(std::forward<TClip>(clip)));
+        TResult retval;
+        execute(clipper, clipType, fillType, retval);
+        return retval;
+    }
+
+    // Union with ClipperLib::pftNegative and reversed orientation of the output of the shrunk paths
+    // together with an enclosing rectangle. The enclosing rectangle is the first path of the output, as it is with ClipperLib.
+    template<class TResult>
+    TResult shrink_union(const ClipperLib::Paths &shrunk)
+    {
+        Clipper2Lib::Paths64   subject = to_paths64(shrunk);
+        Clipper2Lib::Rect64    r       = Clipper2Lib::GetBounds(subject);
+        subject.push_back({ { r.left - 10, r.bottom + 10 }, { r.right + 10, r.bottom + 10 }, { r.right + 10, r.top - 10 }, { r.left - 10, r.top - 10 } });
+        Clipper2Lib::Clipper64 clipper;
+        clipper.ReverseSolution(true);
+        clipper.AddSubject(subject);
+        TResult retval;
+        execute(clipper, ClipperLib::ctUnion, ClipperLib::pftNegative, retval);
+        if constexpr (std::is_same_v<TResult, ClipperLib::Paths>) {
+            // Clipper2 does not sort the output paths.
+            auto it_outer = std::max_element(retval.begin(), retval.end(),
+                [](const ClipperLib::Path &l, const ClipperLib::Path &r) { return std::abs(ClipperLib::Area(l)) < std::abs(ClipperLib::Area(r)); });
+            if (it_outer != retval.end())
+                std::swap(*it_outer, retval.front());
+        }
+        return retval;
+    }
+
+    // Offset a single path the way ClipperLib::ClipperOffset does: a closed path is reoriented to have a positive area
+    // before it is offsetted, thus the output contours are CCW oriented.
+    // ClipperLib::ClipperOffset::ShortestEdgeLength has no counterpart in Clipper2, the input is offsetted as is.
+    inline ClipperLib::Paths offset_path(const Points &path, const double delta, ClipperLib::JoinType joinType, double miterLimit, ClipperLib::EndType endType)
+    {
+        // ClipperLib clamps the miter limit to 2 from below.
+        Clipper2Lib::ClipperOffset co(joinType == jtRound ? 2. : std::max(2., miterLimit), joinType == jtRound ? miterLimit : 0.25);
+        Clipper2Lib::Path64        path64 = to_path64(path);
+        if (endType == ClipperLib::etClosedPolygon && ! ClipperLib::Orientation(path))
+            std::reverse(path64.begin(), path64.end());
+        co.AddPath(path64, join_type(joinType), end_type(endType));
+        Clipper2Lib::Paths64 solution;
+        co.Execute(delta, solution);
+        return to_paths(solution);
+    }
+} // namespace Clipper2Backend
+
+// Offset a single path with ClipperLib::ClipperOffset or with its Clipper2 counterpart.
+// Execute reorients the contours so that the outer most contour has a positive area. Thus the output
+// contours will be CCW oriented even though the input paths are CW oriented.
+static ClipperLib::Paths clipper_offset_path(const Points &path, const float delta, ClipperLib::JoinType joinType, double miterLimit, ClipperLib::EndType endType = ClipperLib::etClosedPolygon)
+{
+    if (clipper_backend() == ClipperBackend::Clipper2)
+        return Clipper2Backend::offset_path(path, delta, joinType, miterLimit, endType);
+
+    ClipperLib::ClipperOffset co;
+    if (joinType == jtRound)
+        co.ArcTolerance = miterLimit;
+    else
+        co.MiterLimit = miterLimit;
+    co.ShortestEdgeLength = double(std::abs(delta * ClipperOffsetShortestEdgeFactor));
+    co.AddPath(path, joinType, endType);
+    ClipperLib::Paths out;
+    co.Execute(out, delta);
+    return out;
+}
+
 static ExPolygons PolyTreeToExPolygons(ClipperLib::PolyTree &&polytree)
 {
     struct Inner {
@@ -272,23 +485,14 @@ bool has_duplicate_points(const ClipperLib::PolyTree &polytree)
 template<typename PathsProvider>
 static ClipperLib::Paths raw_offset(PathsProvider &&paths, float offset, ClipperLib::JoinType joinType, double miterLimit, ClipperLib::EndType endType = ClipperLib::etClosedPolygon)
 {
-    ClipperLib::ClipperOffset co;
     ClipperLib::Paths out;
     out.reserve(paths.size());
-    ClipperLib::Paths out_this;
-    if (joinType == jtRound)
-        co.ArcTolerance = miterLimit;
-    else
-        co.MiterLimit = miterLimit;
-    co.ShortestEdgeLength = std::abs(offset * ClipperOffsetShortestEdgeFactor);
     for (const ClipperLib::Path &path : paths) {
-        co.Clear();
         // Execute reorients the contours so that the outer most contour has a positive area. Thus the output
         // contours will be CCW oriented even though the input paths are CW oriented.
         // Offset is applied after contour reorientation, thus the signum of the offset value is reversed.
-        co.AddPath(path, joinType, endType);
         bool ccw = endType == ClipperLib::etClosedPolygon ? ClipperLib::Orientation(path) : true;
-        co.Execute(out_this, ccw ? offset : - offset);
+        ClipperLib::Paths out_this = clipper_offset_path(path, ccw ? offset : - offset, joinType, miterLimit, endType);
         if (! ccw) {
             // Reverse the resulting contours.
             for (ClipperLib::Path &path : out_this)
@@ -313,6 +517,8 @@ TResult clipper_do(
     TClip &&                       clip,
     const ClipperLib::PolyFillType fillType)
 {
+    if (clipper_backend() == ClipperBackend::Clipper2)
+        return Clipper2Backend::clipper_do<TResult>(clipType, std::forward<TSubj>(subject), std::forward<TClip>(clip), fillType);
     ClipperLib::Clipper clipper;
     clipper.AddPaths(std::forward<TSubj>(subject), ClipperLib::ptSubject, true);
     clipper.AddPaths(std::forward<TClip>(clip),    ClipperLib::ptClip,    true);
@@ -342,6 +548,8 @@ TResult clipper_union(
     // fillType pftNonZero and pftPositive "should" produce the same result for "normalized with implicit union" set of polygons
     const ClipperLib::PolyFillType fillType = ClipperLib::pftNonZero)
 {
+    if (clipper_backend() == ClipperBackend::Clipper2)
+        return Clipper2Backend::clipper_do<TResult>(ClipperLib::ctUnion, std::forward<TSubj>(subject), ClipperUtils::EmptyPathsProvider(), fillType);
     ClipperLib::Clipper clipper;
     clipper.AddPaths(std::forward<TSubj>(subject), ClipperLib::ptSubject, true);
     TResult retval;
@@ -385,12 +593,16 @@ static TResult shrink_paths(PathsProvider &&paths, float offset, ClipperLib::Joi
     //assert(offset > 0);
     TResult out;
     if (auto raw = raw_offset(std::forward<PathsProvider>(paths), - offset, joinType, miterLimit); ! raw.empty()) {
-        ClipperLib::Clipper clipper;
-        clipper.AddPaths(raw, ClipperLib::ptSubject, true);
-        ClipperLib::IntRect r = clipper.GetBounds();
-        clipper.AddPath({ { r.left - 10, r.bottom + 10 }, { r.right + 10, r.bottom + 10 }, { r.right + 10, r.top - 10 }, { r.left - 10, r.top - 10 } }, ClipperLib::ptSubject, true);
-        clipper.ReverseSolution(true);
-        clipper.Execute(ClipperLib::ctUnion, out, ClipperLib::pftNegative, ClipperLib::pftNegative);
+        if (clipper_backend() == ClipperBackend::Clipper2) {
+            out = Clipper2Backend::shrink_union<TResult>(raw);
+        } else {
+            ClipperLib::Clipper clipper;
+            clipper.AddPaths(raw, ClipperLib::ptSubject, true);
+            ClipperLib::IntRect r = clipper.GetBounds();
+            clipper.AddPath({ { r.left - 10, r.bottom + 10 }, { r.right + 10, r.bottom + 10 }, { r.right + 10, r.top - 10 }, { r.left - 10, r.top - 10 } }, ClipperLib::ptSubject, true);
+            clipper.ReverseSolution(true);
+            clipper.Execute(ClipperLib::ctUnion, out, ClipperLib::pftNegative, ClipperLib::pftNegative);
+        }
         remove_outermost_polygon(out);
     }
     return out;
@@ -437,17 +649,7 @@ Polygons contour_to_polygons(const Polygons &polygons, const float line_width, C
 static int offset_expolygon_inner(const Slic3r::ExPolygon &expoly, const float delta, ClipperLib::JoinType joinType, double miterLimit, ClipperLib::Paths &out)
 {
     // 1) Offset the outer contour.
-    ClipperLib::Paths contours;
-    {
-        ClipperLib::ClipperOffset co;
-        if (joinType == jtRound)
-            co.ArcTolerance = miterLimit;
-        else
-            co.MiterLimit = miterLimit;
-        co.ShortestEdgeLength = double(std::abs(delta * ClipperOffsetShortestEdgeFactor));
-        co.AddPath(expoly.contour.points, joinType, ClipperLib::etClosedPolygon);
-        co.Execute(contours, delta);
-    }
+    ClipperLib::Paths contours = clipper_offset_path(expoly.contour.points, delta, joinType, miterLimit);
     if (contours.empty())
         // No need to try to offset the holes.
         return 0;
@@ -459,21 +661,11 @@ static int offset_expolygon_inner(const Slic3r::ExPolygon &expoly, const float d
         // 2) Offset the holes one by one, collect the offsetted holes.
         ClipperLib::Paths holes;
         {
-            for (const Polygon &hole : expoly.holes) {
-                ClipperLib::ClipperOffset co;
-                if (joinType == jtRound)
-                    co.ArcTolerance = miterLimit;
-                else
-                    co.MiterLimit = miterLimit;
-                co.ShortestEdgeLength = double(std::abs(delta * ClipperOffsetShortestEdgeFactor));
-                co.AddPath(hole.points, joinType, ClipperLib::etClosedPolygon);
-                ClipperLib::Paths out2;
+            for (const Polygon &hole : expoly.holes)
                 // Execute reorients the contours so that the outer most contour has a positive area. Thus the output
                 // contours will be CCW oriented even though the input paths are CW oriented.
                 // Offset is applied after contour reorientation, thus the signum of the offset value is reversed.
-                co.Execute(out2, - delta);
-                append(holes, std::move(out2));
-            }
+                append(holes, clipper_offset_path(hole.points, - delta, joinType, miterLimit));
         }
 
         // 3) Subtract holes from the contours.
@@ -644,6 +836,9 @@ inline ClipperLib::PolyTree clipper_do_polytree(
     PathProvider2                  &&clip,
     const ClipperLib::PolyFillType   fillType)
 {
+    if (clipper_backend() == ClipperBackend::Clipper2)
+        // Clipper2 builds the PolyTree efficiently, no need for the workaround.
+        return Clipper2Backend::clipper_do<ClipperLib::PolyTree>(clipType, std::forward<PathProvider1>(subject), std::forward<PathProvider2>(clip), fillType);
     // Perform the operation with the output to input_subject.
     // This pass does not generate a PolyTree, which is a very expensive operation with the current Clipper library
     // if there are overapping edges.
@@ -712,16 +907,270 @@ Slic3r::Polygons intersection(const Slic3r::Surfaces &subject, const Slic3r::ExP
     { return _clipper(ClipperLib::ctIntersection, ClipperUtils::SurfacesProvider(subject), ClipperUtils::ExPolygonsProvider(clip), do_safety_offset); }
 // BBS
 Slic3r::Polygons intersection(const Slic3r::Polygons& subject, const Slic3r::Polygon& clip, ApplySafetyOffset do_safety_offset)
-{
-    Slic3r::Polygons clip_temp;
-    clip_temp.push_back(clip);
-    return intersection(subject, clip_temp, do_safety_offset);
-}
+    { return _clipper(ClipperLib::ctIntersection, ClipperUtils::PolygonsProvider(subject), ClipperUtils::SinglePathProvider(clip.points), do_safety_offset); }
+
+// Union of inputs with many islands (full bed arrays, lattices, merged volume slices) with the pftNonZero rule.
+// The islands are grouped into clusters of islands with overlapping bounding boxes. Islands of different clusters
+// don't interact, thus small clusters are packed into batches united in parallel and their results are just concatenated.
+// A large cluster is split spatially and united by a parallel tree reduction. The reduction is only valid if the union
+// of the cluster is a plain set union, thus it is only applied if the islands of the cluster are all oriented the same way,
+// or if they are ExPolygons with holes inside their contours.
+namespace ParallelUnion {
+    // Below this number of points the union is performed by a single Clipper call.
+    static constexpr const size_t MinPoints  = 20000;
+    // Number of points of the batches of small clusters and of the leaves of the tree reduction.
+    static constexpr const size_t LeafPoints = 5000;
+
+    // Contour with its holes.
+    struct Island {
+        const Points   *contour;
+        const Polygons *holes;
+        BoundingBox     bbox;
+        size_t          num_points;
+        // Orientation of the contour. Holes of ExPolygons are expected to be oriented the other way.
+        bool            ccw;
+    };
+
+    class IslandsProvider {
+    public:
+        IslandsProvider(const std::vector<const Points*> &paths) : m_paths(paths) {}
+
+        struct iterator : public ClipperUtils::PathsProviderIteratorBase {
+        public:
+            explicit iterator(std::vector<const Points*>::const_iterator it) : m_it(it) {}
+            const Points& operator*() const { return **m_it; }
+            bool operator==(const iterator &rhs) const { return m_it == rhs.m_it; }
+            bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+            const Points& operator++(int) { return **(m_it ++); }
+            iterator& operator++() { ++ m_it; return *this; }
+        private:
+            std::vector<const Points*>::const_iterator m_it;
+        };
+
+        iterator cbegin() const { return iterator(m_paths.begin()); }
+        iterator begin()  const { return this->cbegin(); }
+        iterator cend()   const { return iterator(m_paths.end()); }
+        iterator end()    const { return this->cend(); }
+        size_t   size()   const { return m_paths.size(); }
+
+    private:
+        const std::vector<const Points*> &m_paths;
+    };
+
+    static void add_island(std::vector<Island> &islands, const Points &contour, const Polygons *holes, bool ccw)
+    {
+        Island island { &contour, holes, BoundingBox(), contour.size(), ccw };
+        island.bbox.merge(contour);
+        if (holes)
+            for (const Polygon &hole : *holes) {
+                island.bbox.merge(hole.points);
+                island.num_points += hole.size();
+            }
+        if (island.bbox.defined)
+            islands.emplace_back(island);
+    }
+
+    static std::vector<Island> islands(const Polygons &polygons)
+    {
+        std::vector<Island> out;
+        out.reserve(polygons.size());
+        for (const Polygon &polygon : polygons)
+            add_island(out, polygon.points, nullptr, ClipperLib::Orientation(polygon.points));
+        return out;
+    }
+    static std::vector<Island> islands(const ExPolygons &expolygons)
+    {
+        std::vector<Island> out;
+        out.reserve(expolygons.size());
+        for (const ExPolygon &expoly : expolygons)
+            add_island(out, expoly.contour.points, &expoly.holes, true);
+        return out;
+    }
+    static std::vector<Island> islands(const Surfaces &surfaces)
+    {
+        std::vector<Island> out;
+        out.reserve(surfaces.size());
+        for (const Surface &surface : surfaces)
+            add_island(out, surface.expolygon.contour.points, &surface.expolygon.holes, true);
+        return out;
+    }
+
+    template<typename PathsProvider>
+    static size_t count_points(const PathsProvider &paths)
+    {
+        size_t cnt = 0;
+        for (const Points &path : paths)
+            cnt += path.size();
+        return cnt;
+    }
+
+    static std::vector<const Points*> collect_paths(const Island *begin, const Island *end)
+    {
+        std::vector<const Points*> paths;
+        for (const Island *island = begin; island != end; ++ island) {
+            paths.emplace_back(island->contour);
+            if (island->holes)
+                for (const Polygon &hole : *island->holes)
+                    paths.emplace_back(&hole.points);
+        }
+        return paths;
+    }
+
+    // Clusters of islands with overlapping bounding boxes, found by a sweep along the X axis.
+    // The islands of each cluster keep their input order, the clusters are sorted by their first island.
+    static std::vector<std::vector<Island>> clusters(std::vector<Island> &&islands)
+    {
+        std::vector<size_t> parent(islands.size());
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&parent](size_t i) {
+            while (parent[i] != i)
+                i = parent[i] = parent[parent[i]];
+            return i;
+        };
+
+        std::vector<size_t> sorted(islands.size());
+        std::iota(sorted.begin(), sorted.end(), 0);
+        std::sort(sorted.begin(), sorted.end(), [&islands](size_t l, size_t r) { return islands[l].bbox.min.x() < islands[r].bbox.min.x(); });
+        std::vector<size_t> active;
+        for (size_t idx : sorted) {
+            const BoundingBox &bbox = islands[idx].bbox;
+            active.erase(std::remove_if(active.begin(), active.end(), [&islands, &bbox](size_t i) { return islands[i].bbox.max.x() < bbox.min.x(); }), active.end());
+            for (size_t i : active)
+                if (islands[i].bbox.min.y() <= bbox.max.y() && bbox.min.y() <= islands[i].bbox.max.y())
+                    parent[find(i)] = find(idx);
+            active.emplace_back(idx);
+        }
+
+        std::vector<std::vector<Island>> out;
+        std::vector<size_t>              cluster_of_root(islands.size(), size_t(-1));
+        for (size_t i = 0; i < islands.size(); ++ i) {
+            size_t &cluster = cluster_of_root[find(i)];
+            if (cluster == size_t(-1)) {
+                cluster = out.size();
+                out.emplace_back();
+            }
+            out[cluster].emplace_back(islands[i]);
+        }
+        return out;
+    }
+
+    // Splits the islands along the longer axis of their bounding box, unites both halves in parallel
+    // and returns the concatenation of both unions.
+    static ClipperLib::Paths reduce_halves(Island *begin, Island *end);
+
+    // Parallel tree reduction of a range of islands.
+    static ClipperLib::Paths reduce(Island *begin, Island *end)
+    {
+        size_t num_points = 0;
+        for (const Island *island = begin; island != end; ++ island)
+            num_points += island->num_points;
+        return num_points <= LeafPoints || end - begin < 2 ?
+            clipper_union<ClipperLib::Paths>(IslandsProvider(collect_paths(begin, end))) :
+            clipper_union<ClipperLib::Paths>(reduce_halves(begin, end));
+    }
+
+    static ClipperLib::Paths reduce_halves(Island *begin, Island *end)
+    {
+        BoundingBox bbox;
+        for (const Island *island = begin; island != end; ++ island)
+            bbox.merge(island->bbox);
+        const int axis = bbox.size().x() > bbox.size().y() ? 0 : 1;
+        Island *middle = begin + (end - begin) / 2;
+        std::nth_element(begin, middle, end, [axis](const Island &l, const Island &r)
+            { return int64_t(l.bbox.min(axis)) + l.bbox.max(axis) < int64_t(r.bbox.min(axis)) + r.bbox.max(axis); });
+        ClipperLib::Paths lower, upper;
+        tbb::parallel_invoke([begin, middle, &lower]() { lower = reduce(begin, middle); }, [middle, end, &upper]() { upper = reduce(middle, end); });
+        append(lower, std::move(upper));
+        return lower;
+    }
+
+    template<class TResult> TResult unite(const ClipperLib::Paths &paths);
+    template<> Polygons unite<Polygons>(const ClipperLib::Paths &paths)
+        { return to_polygons(clipper_union<ClipperLib::Paths>(paths)); }
+    template<> ExPolygons unite<ExPolygons>(const ClipperLib::Paths &paths)
+        { return PolyTreeToExPolygons(clipper_do_polytree(ClipperLib::ctUnion, paths, ClipperUtils::EmptyPathsProvider(), ClipperLib::pftNonZero)); }
+
+    template<class TResult> TResult unite(const std::vector<const Points*> &paths);
+    template<> Polygons unite<Polygons>(const std::vector<const Points*> &paths)
+        { return to_polygons(clipper_union<ClipperLib::Paths>(IslandsProvider(paths))); }
+    template<> ExPolygons unite<ExPolygons>(const std::vector<const Points*> &paths)
+        { return PolyTreeToExPolygons(clipper_do_polytree(ClipperLib::ctUnion, IslandsProvider(paths), ClipperUtils::EmptyPathsProvider(), ClipperLib::pftNonZero)); }
+
+    // Returns false if the union shall rather be done by a single Clipper call.
+    template<class TResult>
+    static bool unite(std::vector<Island> &&islands, TResult &out)
+    {
+        std::vector<std::vector<Island>> clusters = ParallelUnion::clusters(std::move(islands));
+
+        // Jobs: batches of small clusters, large clusters to be reduced and large clusters to be united at once.
+        struct Job {
+            std::vector<std::vector<Island>*> clusters;
+            size_t                            num_points { 0 };
+            bool                              reduce { false };
+        };
+        std::vector<Job> jobs;
+        Job              batch;
+        for (std::vector<Island> &cluster : clusters) {
+            size_t num_points = 0;
+            for (const Island &island : cluster)
+                num_points += island.num_points;
+            if (num_points > LeafPoints) {
+                bool same_orientation = std::all_of(cluster.begin(), cluster.end(), [&cluster](const Island &island) { return island.ccw == cluster.front().ccw; });
+                jobs.push_back({ { &cluster }, num_points, same_orientation && cluster.size() > 1 });
+            } else {
+                if (batch.num_points + num_points > LeafPoints && ! batch.clusters.empty()) {
+                    jobs.emplace_back(std::move(batch));
+                    batch = Job();
+                }
+                batch.clusters.emplace_back(&cluster);
+                batch.num_points += num_points;
+            }
+        }
+        if (! batch.clusters.empty())
+            jobs.emplace_back(std::move(batch));
+        if (jobs.size() == 1 && ! jobs.front().reduce)
+            // A single cluster, which cannot be reduced in parallel.
+            return false;
+
+        std::vector<TResult> results(jobs.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, jobs.size(), 1), [&jobs, &results](const tbb::blocked_range<size_t> &range) {
+            for (size_t job_id = range.begin(); job_id < range.end(); ++ job_id) {
+                Job &job = jobs[job_id];
+                if (job.reduce) {
+                    std::vector<Island> &cluster = *job.clusters.front();
+                    results[job_id] = unite<TResult>(reduce_halves(cluster.data(), cluster.data() + cluster.size()));
+                } else {
+                    std::vector<const Points*> paths;
+                    for (const std::vector<Island> *cluster : job.clusters)
+                        append(paths, collect_paths(cluster->data(), cluster->data() + cluster->size()));
+                    results[job_id] = unite<TResult>(paths);
+                }
+            }
+        });
+
+        out.clear();
+        size_t cnt = 0;
+        for (const TResult &result : results)
+            cnt += result.size();
+        out.reserve(cnt);
+        for (TResult &result : results)
+            append(out, std::move(result));
+        return true;
+    }
+} // namespace ParallelUnion
 
 Slic3r::Polygons union_(const Slic3r::Polygons &subject)
-    { return _clipper(ClipperLib::ctUnion, ClipperUtils::PolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ApplySafetyOffset::No); }
+{
+    if (Polygons out; ParallelUnion::count_points(ClipperUtils::PolygonsProvider(subject)) >= ParallelUnion::MinPoints && ParallelUnion::unite(ParallelUnion::islands(subject), out))
+        return out;
+    return _clipper(ClipperLib::ctUnion, ClipperUtils::PolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ApplySafetyOffset::No);
+}
 Slic3r::Polygons union_(const Slic3r::ExPolygons &subject)
-    { return _clipper(ClipperLib::ctUnion, ClipperUtils::ExPolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ApplySafetyOffset::No); }
+{
+    if (Polygons out; ParallelUnion::count_points(ClipperUtils::ExPolygonsProvider(subject)) >= ParallelUnion::MinPoints && ParallelUnion::unite(ParallelUnion::islands(subject), out))
+        return out;
+    return _clipper(ClipperLib::ctUnion, ClipperUtils::ExPolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ApplySafetyOffset::No);
+}
 Slic3r::Polygons union_(const Slic3r::Polygons &subject, const ClipperLib::PolyFillType fillType)
     { return to_polygons(clipper_do<ClipperLib::Paths>(ClipperLib::ctUnion, ClipperUtils::PolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), fillType, ApplySafetyOffset::No)); }
 Slic3r::Polygons union_(const Slic3r::Polygons &subject, const Slic3r::Polygons &subject2)
@@ -768,22 +1217,10 @@ Slic3r::ExPolygons diff_ex(const Slic3r::SurfacesPtr& subject, const Slic3r::ExP
     { return _clipper_ex(ClipperLib::ctDifference, ClipperUtils::SurfacesPtrProvider(subject), ClipperUtils::ExPolygonsProvider(clip), do_safety_offset);}
 // BBS
 inline Slic3r::ExPolygons diff_ex(const Slic3r::Polygon& subject, const Slic3r::Polygons& clip, ApplySafetyOffset do_safety_offset)
-{
-    Slic3r::Polygons subject_temp;
-    subject_temp.push_back(subject);
-
-    return diff_ex(subject_temp, clip, do_safety_offset);
-}
+    { return _clipper_ex(ClipperLib::ctDifference, ClipperUtils::SinglePathProvider(subject.points), ClipperUtils::PolygonsProvider(clip), do_safety_offset); }
 
 inline Slic3r::ExPolygons diff_ex(const Slic3r::Polygon& subject, const Slic3r::Polygon& clip, ApplySafetyOffset do_safety_offset)
-{
-    Slic3r::Polygons subject_temp;
-    Slic3r::Polygons clip_temp;
-
-    subject_temp.push_back(subject);
-    clip_temp.push_back(clip);
-    return diff_ex(subject_temp, clip_temp, do_safety_offset);
-}
+    { return _clipper_ex(ClipperLib::ctDifference, ClipperUtils::SinglePathProvider(subject.points), ClipperUtils::SinglePathProvider(clip.points), do_safety_offset); }
 
 Slic3r::ExPolygons intersection_ex(const Slic3r::Polygons &subject, const Slic3r::Polygons &clip, ApplySafetyOffset do_safety_offset)
     { return _clipper_ex(ClipperLib::ctIntersection, ClipperUtils::PolygonsProvider(subject), ClipperUtils::PolygonsProvider(clip), do_safety_offset); }
@@ -811,16 +1248,28 @@ Slic3r::ExPolygons intersection_ex(const Slic3r::SurfacesPtr &subject, const Sli
     { return _clipper_ex(ClipperLib::ctIntersection, ClipperUtils::SurfacesPtrProvider(subject), ClipperUtils::ExPolygonsProvider(clip), do_safety_offset); }
 // May be used to "heal" unusual models (3DLabPrints etc.) by providing fill_type (pftEvenOdd, pftNonZero, pftPositive, pftNegative).
 Slic3r::ExPolygons union_ex(const Slic3r::Polygons &subject, ClipperLib::PolyFillType fill_type)
-    { return _clipper_ex(ClipperLib::ctUnion, ClipperUtils::PolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ApplySafetyOffset::No, fill_type); }
+{
+    if (ExPolygons out; fill_type == ClipperLib::pftNonZero && ParallelUnion::count_points(ClipperUtils::PolygonsProvider(subject)) >= ParallelUnion::MinPoints && ParallelUnion::unite(ParallelUnion::islands(subject), out))
+        return out;
+    return _clipper_ex(ClipperLib::ctUnion, ClipperUtils::PolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ApplySafetyOffset::No, fill_type);
+}
 Slic3r::ExPolygons union_ex(const Slic3r::ExPolygons &subject)
-    { return PolyTreeToExPolygons(clipper_do_polytree(ClipperLib::ctUnion, ClipperUtils::ExPolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ClipperLib::pftNonZero)); }
+{
+    if (ExPolygons out; ParallelUnion::count_points(ClipperUtils::ExPolygonsProvider(subject)) >= ParallelUnion::MinPoints && ParallelUnion::unite(ParallelUnion::islands(subject), out))
+        return out;
+    return PolyTreeToExPolygons(clipper_do_polytree(ClipperLib::ctUnion, ClipperUtils::ExPolygonsProvider(subject), ClipperUtils::EmptyPathsProvider(), ClipperLib::pftNonZero));
+}
 Slic3r::ExPolygons union_ex(const Slic3r::ExPolygons &subject, const Slic3r::Polygons &subject2)
 {
     return PolyTreeToExPolygons(
         clipper_do_polytree(ClipperLib::ctUnion, ClipperUtils::ExPolygonsProvider(subject), ClipperUtils::PolygonsProvider(subject2), ClipperLib::pftNonZero));
 }
-    Slic3r::ExPolygons union_ex(const Slic3r::Surfaces &subject)
-    { return PolyTreeToExPolygons(clipper_do_polytree(ClipperLib::ctUnion, ClipperUtils::SurfacesProvider(subject), ClipperUtils::EmptyPathsProvider(), ClipperLib::pftNonZero)); }
+Slic3r::ExPolygons union_ex(const Slic3r::Surfaces &subject)
+{
+    if (ExPolygons out; ParallelUnion::count_points(ClipperUtils::SurfacesProvider(subject)) >= ParallelUnion::MinPoints && ParallelUnion::unite(ParallelUnion::islands(subject), out))
+        return out;
+    return PolyTreeToExPolygons(clipper_do_polytree(ClipperLib::ctUnion, ClipperUtils::SurfacesProvider(subject), ClipperUtils::EmptyPathsProvider(), ClipperLib::pftNonZero));
+}
 // BBS
 Slic3r::ExPolygons union_ex(const Slic3r::ExPolygons& poly1, const Slic3r::ExPolygons& poly2, bool safety_offset_)
     {
@@ -840,6 +1289,18 @@ Slic3r::ExPolygons xor_ex(const Slic3r::ExPolygons &subject, const Slic3r::ExPol
 template<typename PathsProvider1, typename PathsProvider2>
 Polylines _clipper_pl_open(ClipperLib::ClipType clipType, PathsProvider1 &&subject, PathsProvider2 &&clip)
 {
+    if (clipper_backend() == ClipperBackend::Clipper2) {
+        Clipper2Lib::Clipper64 clipper;
+        clipper.AddOpenSubject(Clipper2Backend::to_paths64(std::forward<PathsProvider1>(subject)));
+        clipper.AddClip(Clipper2Backend::to_paths64(std::forward<PathsProvider2>(clip)));
+        Clipper2Lib::Paths64 solution_closed, solution_open;
+        clipper.Execute(Clipper2Backend::clip_type(clipType), Clipper2Lib::FillRule::NonZero, solution_closed, solution_open);
+        Polylines retval;
+        retval.reserve(solution_open.size());
+        for (const Clipper2Lib::Path64 &path : solution_open)
+            retval.emplace_back(Clipper2Backend::to_path(path));
+        return retval;
+    }
     ClipperLib::Clipper clipper;
     clipper.AddPaths(std::forward<PathsProvider1>(subject), ClipperLib::ptSubject, false);
     clipper.AddPaths(std::forward<PathsProvider2>(clip), ClipperLib::ptClip, true);
@@ -48,6 +48,21 @@ enum class ApplySafetyOffset {
     Yes
 };
 
+// Polygon engine executing the boolean operations and offsets below.
+enum class ClipperBackend {
+    // Legacy ClipperLib, see clipper.cpp.
+    ClipperLib,
+    // Clipper2Lib. The Z variants, simplify_polygons() and the operations requesting StrictlySimple output
+    // are always executed by ClipperLib.
+    Clipper2
+};
+
+// Clipper2 is the default backend if compiled with SLIC3R_CLIPPER2_BACKEND, ClipperLib otherwise.
+// The default may be overridden by the SLIC3R_CLIPPER_BACKEND environment variable ("clipper2" or "clipperlib").
+// The backend is global, it shall only be switched while no slicing is running.
+ClipperBackend clipper_backend();
+void           set_clipper_backend(ClipperBackend backend);
+
 namespace ClipperUtils {
     class PathsProviderIteratorBase {
     public:
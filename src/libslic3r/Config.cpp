@@ -9,6 +9,7 @@
 #include <iostream>
 #include <iomanip>
 #include <regex>
+#include <unordered_map>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/erase.hpp>
@@ -318,12 +319,55 @@ ConfigOption* ConfigOptionDef::create_default_option() const
     return this->create_empty_option();
 }
 
+struct ConfigOptionKeyTableData
+{
+    std::unordered_map<t_config_option_key, t_config_option_key_id> ids;
+    std::vector<const t_config_option_key*>                          keys;
+};
+
+// Constructed on first use, as the static ConfigDefs intern their keys during static initialization.
+static ConfigOptionKeyTableData& config_option_key_table()
+{
+    static ConfigOptionKeyTableData data;
+    return data;
+}
+
+t_config_option_key_id ConfigOptionKeyTable::intern(const t_config_option_key &opt_key)
+{
+    ConfigOptionKeyTableData &data = config_option_key_table();
+    auto [it, inserted] = data.ids.emplace(opt_key, t_config_option_key_id(data.keys.size()));
+    if (inserted)
+        // Node based container, the key address is stable.
+        data.keys.emplace_back(&it->first);
+    return it->second;
+}
+
+t_config_option_key_id ConfigOptionKeyTable::find(const t_config_option_key &opt_key)
+{
+    const ConfigOptionKeyTableData &data = config_option_key_table();
+    auto it = data.ids.find(opt_key);
+    return it == data.ids.end() ? CONFIG_OPTION_KEY_ID_INVALID : it->second;
+}
+
+const t_config_option_key& ConfigOptionKeyTable::key(t_config_option_key_id opt_key_id)
+{
+    const ConfigOptionKeyTableData &data = config_option_key_table();
+    assert(opt_key_id < data.keys.size());
+    return *data.keys[opt_key_id];
+}
+
+size_t ConfigOptionKeyTable::size()
+{
+    return config_option_key_table().keys.size();
+}
+
 // Assignment of the serialization IDs is not thread safe. The Defs shall be initialized from the main thread!
 ConfigOptionDef* ConfigDef::add(const t_config_option_key &opt_key, ConfigOptionType type)
 {
 	static size_t serialization_key_ordinal_last = 0;
     ConfigOptionDef *opt = &this->options[opt_key];
     opt->opt_key = opt_key;
+    opt->opt_key_id = ConfigOptionKeyTable::intern(opt_key);
     opt->type = type;
     opt->serialization_key_ordinal = ++ serialization_key_ordinal_last;
     this->by_serialization_key_ordinal[opt->serialization_key_ordinal] = opt;
@@ -481,6 +525,15 @@ void ConfigBase::apply_only(const ConfigBase &other, const t_config_option_keys
     }
 }
 
+// Resolve a pair of options of the same key, using the interned key ID if the key is known to a ConfigDef.
+static inline std::pair<const ConfigOption*, const ConfigOption*> config_option_pair(const ConfigBase &lhs, const ConfigBase &rhs, const t_config_option_key &opt_key)
+{
+    t_config_option_key_id id = ConfigOptionKeyTable::find(opt_key);
+    return id == CONFIG_OPTION_KEY_ID_INVALID ?
+        std::make_pair(lhs.option(opt_key), rhs.option(opt_key)) :
+        std::make_pair(lhs.optptr_by_id(id), rhs.optptr_by_id(id));
+}
+
 // Are the two configs equal? Ignoring options not present in both configs.
 //BBS: add skipped keys logic
 bool ConfigBase::equals(const ConfigBase &other, const std::set<std::string>* skipped_keys) const
@@ -488,8 +541,7 @@ bool ConfigBase::equals(const ConfigBase &other, const std::set<std::string>* sk
     for (const t_config_option_key &opt_key : this->keys()) {
         if (skipped_keys && (skipped_keys->count(opt_key) != 0))
             continue;
-        const ConfigOption *this_opt  = this->option(opt_key);
-        const ConfigOption *other_opt = other.option(opt_key);
+        auto [this_opt, other_opt] = config_option_pair(*this, other, opt_key);
         if (this_opt != nullptr && other_opt != nullptr && *this_opt != *other_opt)
             return false;
     }
@@ -501,8 +553,7 @@ t_config_option_keys ConfigBase::diff(const ConfigBase &other) const
 {
     t_config_option_keys diff;
     for (const t_config_option_key &opt_key : this->keys()) {
-        const ConfigOption *this_opt  = this->option(opt_key);
-        const ConfigOption *other_opt = other.option(opt_key);
+        auto [this_opt, other_opt] = config_option_pair(*this, other, opt_key);
         if (this_opt != nullptr && other_opt != nullptr && *this_opt != *other_opt)
             diff.emplace_back(opt_key);
     }
@@ -514,8 +565,7 @@ t_config_option_keys ConfigBase::equal(const ConfigBase &other) const
 {
     t_config_option_keys equal;
     for (const t_config_option_key &opt_key : this->keys()) {
-        const ConfigOption *this_opt  = this->option(opt_key);
-        const ConfigOption *other_opt = other.option(opt_key);
+        auto [this_opt, other_opt] = config_option_pair(*this, other, opt_key);
         if (this_opt != nullptr && other_opt != nullptr && *this_opt == *other_opt)
             equal.emplace_back(opt_key);
     }
@@ -1510,8 +1560,11 @@ void ConfigBase::null_nullables()
 
 DynamicConfig::DynamicConfig(const ConfigBase& rhs, const t_config_option_keys& keys)
 {
-	for (const t_config_option_key& opt_key : keys)
-		this->options[opt_key] = std::unique_ptr<ConfigOption>(rhs.option(opt_key)->clone());
+	for (const t_config_option_key& opt_key : keys) {
+		ConfigOption *opt = rhs.option(opt_key)->clone();
+		this->options[opt_key] = std::unique_ptr<ConfigOption>(opt);
+		this->index_option(opt_key, opt);
+	}
 }
 
 bool DynamicConfig::operator==(const DynamicConfig &rhs) const
@@ -1533,6 +1586,7 @@ size_t DynamicConfig::remove_nil_options()
 	size_t cnt_removed = 0;
 	for (auto it = options.begin(); it != options.end();)
 		if (it->second->is_nil()) {
+			this->index_option(it->first, nullptr);
 			it = options.erase(it);
 			++ cnt_removed;
 		} else
@@ -1542,6 +1596,11 @@ size_t DynamicConfig::remove_nil_options()
 
 ConfigOption* DynamicConfig::optptr(const t_config_option_key &opt_key, bool create)
 {
+    if (t_config_option_key_id id = ConfigOptionKeyTable::find(opt_key); id != CONFIG_OPTION_KEY_ID_INVALID) {
+        // Fast path: The key is known to a ConfigDef, thus the option is held by the flat index if it is set.
+        if (ConfigOption *opt = this->optptr_by_id(id); opt != nullptr || ! create)
+            return opt;
+    }
     auto it = options.find(opt_key);
     if (it != options.end())
         // Option was found.
@@ -1560,11 +1619,14 @@ ConfigOption* DynamicConfig::optptr(const t_config_option_key &opt_key, bool cre
         return nullptr;
     ConfigOption *opt = optdef->create_default_option();
     this->options.emplace_hint(it, opt_key, std::unique_ptr<ConfigOption>(opt));
+    this->index_option(opt_key, opt);
     return opt;
 }
 
 const ConfigOption* DynamicConfig::optptr(const t_config_option_key &opt_key) const
 {
+    if (t_config_option_key_id id = ConfigOptionKeyTable::find(opt_key); id != CONFIG_OPTION_KEY_ID_INVALID)
+        return this->optptr_by_id(id);
     auto it = options.find(opt_key);
     return (it == options.end()) ? nullptr : it->second.get();
 }
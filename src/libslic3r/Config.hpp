@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <map>
 #include <climits>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <functional>
@@ -77,6 +78,25 @@ namespace Slic3r {
 // Name of the configuration option.
 typedef std::string                 t_config_option_key;
 typedef std::vector<std::string>    t_config_option_keys;
+// Process wide unique integer identifier of a configuration option name, see ConfigOptionKeyTable.
+typedef uint32_t                    t_config_option_key_id;
+static constexpr const t_config_option_key_id CONFIG_OPTION_KEY_ID_INVALID = t_config_option_key_id(-1);
+
+// Process wide table of interned configuration option names.
+// The option names are interned by ConfigDef::add() when the static configuration definitions are being constructed,
+// therefore the IDs are dense and the table does not change once the definitions are initialized.
+// Similarly to ConfigDef::add(), interning is not thread safe, while the lookups are.
+class ConfigOptionKeyTable
+{
+public:
+    // Returns an ID of an already interned opt_key, or interns a new one.
+    static t_config_option_key_id       intern(const t_config_option_key &opt_key);
+    // Returns CONFIG_OPTION_KEY_ID_INVALID if opt_key has not been interned.
+    static t_config_option_key_id       find(const t_config_option_key &opt_key);
+    static const t_config_option_key&   key(t_config_option_key_id opt_key_id);
+    // Number of interned keys, the IDs are in <0, size()).
+    static size_t                       size();
+};
 
 extern std::string  escape_string_cstyle(const std::string &str);
 extern std::string  escape_strings_cstyle(const std::vector<std::string> &strs);
@@ -2247,6 +2267,8 @@ public:
 
 	// Identifier of this option. It is stored here so that it is accessible through the by_serialization_key_ordinal map.
 	t_config_option_key 				opt_key;
+    // Interned opt_key, see ConfigOptionKeyTable. Assigned by ConfigDef::add().
+    t_config_option_key_id              opt_key_id      = CONFIG_OPTION_KEY_ID_INVALID;
     // What type? bool, int, string etc.
     ConfigOptionType                    type            = coNone;
 	// If a type is nullable, then it accepts a "nil" value (scalar) or "nil" values (vector).
@@ -2476,6 +2498,9 @@ public:
 
     // Find a ConfigOption instance for a given name.
     virtual const ConfigOption* optptr(const t_config_option_key &opt_key) const = 0;
+    // Find a ConfigOption instance for an interned name. Overridden by the stores indexed by t_config_option_key_id.
+    virtual const ConfigOption* optptr_by_id(t_config_option_key_id opt_key_id) const
+        { return this->optptr(ConfigOptionKeyTable::key(opt_key_id)); }
 
     bool 						has(const t_config_option_key &opt_key) const { return this->optptr(opt_key) != nullptr; }
 
@@ -2664,7 +2689,8 @@ class DynamicConfig : public virtual ConfigBase
 public:
     DynamicConfig() = default;
     DynamicConfig(const DynamicConfig &rhs) { *this = rhs; }
-    DynamicConfig(DynamicConfig &&rhs) noexcept : options(std::move(rhs.options)) { rhs.options.clear(); }
+    DynamicConfig(DynamicConfig &&rhs) noexcept : options(std::move(rhs.options)), options_by_id(std::move(rhs.options_by_id))
+        { rhs.options.clear(); rhs.options_by_id.clear(); }
 	explicit DynamicConfig(const ConfigBase &rhs, const t_config_option_keys &keys);
 	explicit DynamicConfig(const ConfigBase& rhs) : DynamicConfig(rhs, rhs.keys()) {}
 	virtual ~DynamicConfig() override = default;
@@ -2675,8 +2701,11 @@ public:
     {
         assert(this->def() == nullptr || this->def() == rhs.def());
         this->clear();
-        for (const auto &kvp : rhs.options)
-            this->options[kvp.first].reset(kvp.second->clone());
+        for (const auto &kvp : rhs.options) {
+            ConfigOption *opt = kvp.second->clone();
+            this->options.emplace_hint(this->options.end(), kvp.first, std::unique_ptr<ConfigOption>(opt));
+            this->index_option(kvp.first, opt);
+        }
         return *this;
     }
 
@@ -2686,8 +2715,10 @@ public:
     {
         assert(this->def() == nullptr || this->def() == rhs.def());
         this->clear();
-        this->options = std::move(rhs.options);
+        this->options       = std::move(rhs.options);
+        this->options_by_id = std::move(rhs.options_by_id);
         rhs.options.clear();
+        rhs.options_by_id.clear();
         return *this;
     }
 
@@ -2698,14 +2729,18 @@ public:
         assert(this->def() == nullptr || this->def() == rhs.def());
         for (const auto &kvp : rhs.options) {
             auto it = this->options.find(kvp.first);
-            if (it == this->options.end())
-                this->options[kvp.first].reset(kvp.second->clone());
-            else {
+            if (it == this->options.end()) {
+                ConfigOption *opt = kvp.second->clone();
+                this->options[kvp.first].reset(opt);
+                this->index_option(kvp.first, opt);
+            } else {
                 assert(it->second->type() == kvp.second->type());
                 if (it->second->type() == kvp.second->type())
                     *it->second = *kvp.second;
-                else
+                else {
                     it->second.reset(kvp.second->clone());
+                    this->index_option(kvp.first, it->second.get());
+                }
             }
         }
         return *this;
@@ -2717,6 +2752,7 @@ public:
     {
         assert(this->def() == nullptr || this->def() == rhs.def());
         for (auto &kvp : rhs.options) {
+            ConfigOption *opt = kvp.second.get();
             auto it = this->options.find(kvp.first);
             if (it == this->options.end()) {
                 this->options.insert(std::make_pair(kvp.first, std::move(kvp.second)));
@@ -2724,8 +2760,10 @@ public:
                 assert(it->second->type() == kvp.second->type());
                 it->second = std::move(kvp.second);
             }
+            this->index_option(kvp.first, opt);
         }
         rhs.options.clear();
+        rhs.options_by_id.clear();
         return *this;
     }
 
@@ -2735,11 +2773,13 @@ public:
     void swap(DynamicConfig &other)
     {
         std::swap(this->options, other.options);
+        std::swap(this->options_by_id, other.options_by_id);
     }
 
     void clear()
     {
         this->options.clear();
+        this->options_by_id.clear();
     }
 
     bool erase(const t_config_option_key &opt_key)
@@ -2747,6 +2787,7 @@ public:
         auto it = this->options.find(opt_key);
         if (it == this->options.end())
             return false;
+        this->index_option(opt_key, nullptr);
         this->options.erase(it);
         return true;
     }
@@ -2765,6 +2806,15 @@ public:
     const ConfigOption*     optptr(const t_config_option_key &opt_key) const override;
     // Overrides ConfigBase::optptr(). Find ando/or create a ConfigOption instance for a given name.
     ConfigOption*           optptr(const t_config_option_key &opt_key, bool create = false) override;
+    // Overrides ConfigOptionResolver::optptr_by_id(). Constant time lookup through the flat index.
+    const ConfigOption*     optptr_by_id(t_config_option_key_id opt_key_id) const override
+        { return opt_key_id < this->options_by_id.size() ? this->options_by_id[opt_key_id] : nullptr; }
+    ConfigOption*           optptr_by_id(t_config_option_key_id opt_key_id)
+        { return opt_key_id < this->options_by_id.size() ? this->options_by_id[opt_key_id] : nullptr; }
+    template<class T> T*    opt_by_id(t_config_option_key_id opt_key_id)
+        { return dynamic_cast<T*>(this->optptr_by_id(opt_key_id)); }
+    template<class T> const T* opt_by_id(t_config_option_key_id opt_key_id) const
+        { return dynamic_cast<const T*>(this->optptr_by_id(opt_key_id)); }
     // Overrides ConfigBase::keys(). Collect names of all configuration values maintained by this configuration store.
     t_config_option_keys    keys() const override;
     bool                    empty() const { return options.empty(); }
@@ -2775,6 +2825,7 @@ public:
     bool                    set_key_value(const std::string &opt_key, ConfigOption *opt)
     {
         auto it = this->options.find(opt_key);
+        this->index_option(opt_key, opt);
         if (it == this->options.end()) {
             this->options[opt_key].reset(opt);
             return true;
@@ -2833,10 +2884,34 @@ public:
     size_t                        												 size()   const { return options.size(); }
 
 private:
+    // Store opt into the flat index, or remove opt_key from the index if opt is null.
+    // Options with keys not known to any ConfigDef are only held by the map.
+    void                    index_option(const t_config_option_key &opt_key, ConfigOption *opt)
+    {
+        t_config_option_key_id id = ConfigOptionKeyTable::find(opt_key);
+        if (id == CONFIG_OPTION_KEY_ID_INVALID)
+            return;
+        if (id >= this->options_by_id.size()) {
+            if (opt == nullptr)
+                return;
+            this->options_by_id.resize(id + 1, nullptr);
+        }
+        this->options_by_id[id] = opt;
+    }
+    void                    reindex()
+    {
+        this->options_by_id.clear();
+        for (auto &kvp : this->options)
+            this->index_option(kvp.first, kvp.second.get());
+    }
+
+    // Owner of the options, sorted by the option key.
     std::map<t_config_option_key, std::unique_ptr<ConfigOption>> options;
+    // Flat index into options by the interned option key, null if the option is not set.
+    std::vector<ConfigOption*>                                   options_by_id;
 
 	friend class cereal::access;
-	template<class Archive> void serialize(Archive &ar) { ar(options); }
+	template<class Archive> void serialize(Archive &ar) { ar(options); if (Archive::is_loading::value) this->reindex(); }
 };
 
 // Configuration store with a static definition of configuration values.
@@ -0,0 +1,101 @@
+#ifndef slic3r_FileCache_hpp_
+#define slic3r_FileCache_hpp_
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+
+#include <boost/filesystem/operations.hpp>
+
+namespace Slic3r {
+
+// Values loaded from files, which are kept while the files are unchanged on disk.
+// A value is stored under a key naming the file and the way it was loaded. It is dropped once the time stamp or the size
+// of its file changes. No more than max_entries values are kept, the least recently used one is dropped first.
+// The slicing daemon of the CLI keeps the loaded models and settings warm between its jobs this way.
+template<typename Value>
+class FileCache
+{
+public:
+    explicit FileCache(size_t max_entries) : m_max_entries(std::max<size_t>(1, max_entries)) {}
+
+    // Value stored under the key, nullptr if there is none or if its file changed since the value was stored.
+    Value* find(const std::string &key)
+    {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            ++ m_misses;
+            return nullptr;
+        }
+        Stamp stamp;
+        if (! file_stamp(it->second.path, stamp) || stamp != it->second.stamp) {
+            m_entries.erase(it);
+            ++ m_misses;
+            return nullptr;
+        }
+        it->second.last_used = ++ m_use_count;
+        ++ m_hits;
+        return &it->second.value;
+    }
+
+    // Default constructed value to be filled in by the caller, replacing the value stored under the key.
+    // Returns nullptr and stores nothing if the file at path cannot be accessed.
+    Value* insert(const std::string &key, const std::string &path)
+    {
+        Stamp stamp;
+        if (! file_stamp(path, stamp))
+            return nullptr;
+        m_entries.erase(key);
+        if (m_entries.size() >= m_max_entries)
+            m_entries.erase(std::min_element(m_entries.begin(), m_entries.end(),
+                [](const auto &lhs, const auto &rhs) { return lhs.second.last_used < rhs.second.last_used; }));
+        Entry &entry    = m_entries[key];
+        entry.path      = path;
+        entry.stamp     = stamp;
+        entry.last_used = ++ m_use_count;
+        return &entry.value;
+    }
+
+    // Drops the value stored under the key, e.g. when it could not be filled in completely.
+    void    erase(const std::string &key) { m_entries.erase(key); }
+    void    clear()        { m_entries.clear(); }
+    size_t  size()   const { return m_entries.size(); }
+    size_t  hits()   const { return m_hits; }
+    size_t  misses() const { return m_misses; }
+
+private:
+    struct Stamp {
+        std::time_t last_write_time { 0 };
+        uintmax_t   file_size       { 0 };
+        bool operator!=(const Stamp &rhs) const { return last_write_time != rhs.last_write_time || file_size != rhs.file_size; }
+    };
+
+    struct Entry {
+        std::string path;
+        Stamp       stamp;
+        Value       value;
+        size_t      last_used { 0 };
+    };
+
+    static bool file_stamp(const std::string &path, Stamp &stamp)
+    {
+        boost::system::error_code ec;
+        stamp.last_write_time = boost::filesystem::last_write_time(path, ec);
+        if (ec)
+            return false;
+        stamp.file_size = boost::filesystem::file_size(path, ec);
+        return ! ec;
+    }
+
+    size_t                       m_max_entries;
+    std::map<std::string, Entry> m_entries;
+    size_t                       m_use_count { 0 };
+    size_t                       m_hits      { 0 };
+    size_t                       m_misses    { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_FileCache_hpp_
@@ -777,7 +777,10 @@ Polylines Layer::generate_sparse_infill_polylines_for_anchoring(FillAdaptive::Oc
         case ipOctagramSpiral:
         case ipZigZag:
         case ipCrossZag:
-		case ipLockedZag: break;
+		case ipLockedZag:
+        case ipSchwarzP:
+        case ipSchwarzD:
+        case ipNeovius: break;
         }
 
 		// Create the filler object.
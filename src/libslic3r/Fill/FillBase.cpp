@@ -16,6 +16,7 @@
 #include "FillHoneycomb.hpp"
 #include "Fill3DHoneycomb.hpp"
 #include "FillGyroid.hpp"
+#include "FillTpms.hpp"
 #include "FillPlanePath.hpp"
 #include "FillLine.hpp"
 #include "FillRectilinear.hpp"
@@ -61,6 +62,9 @@ Fill* Fill::new_from_type(const InfillPattern type)
     case ipCrossZag:            return new FillCrossZag();
     case ipFloatingConcentric:  return new FillFloatingConcentric();
     case ipLockedZag:           return new FillLockedZag();
+    case ipSchwarzP:            return new FillTpms(TpmsSurface::SchwarzP);
+    case ipSchwarzD:            return new FillTpms(TpmsSurface::SchwarzD);
+    case ipNeovius:             return new FillTpms(TpmsSurface::Neovius);
     default: throw Slic3r::InvalidArgument("unknown type");
     }
 }
@@ -3277,7 +3277,7 @@ void FillMonotonicLineWGapFill::fill_surface_extrusion(const Surface* surface, c
             opening_ex(gapfill_areas, float(min / 2.)),
             offset2_ex(gapfill_areas, -float(max / 2.), float(max / 2. + ClipperSafetyOffset)));
         //BBS: sort the gap_ex to avoid mess travel
-        Points ordering_points;
+        ScratchPoints ordering_points;
         ordering_points.reserve(gaps_ex.size());
         ExPolygons gaps_ex_sorted;
         gaps_ex_sorted.reserve(gaps_ex.size());
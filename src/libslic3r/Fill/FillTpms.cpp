@@ -0,0 +1,263 @@
+#include "../ClipperUtils.hpp"
+#include "../ShortestPath.hpp"
+#include "../Surface.hpp"
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "FillGyroid.hpp"
+#include "FillTpms.hpp"
+
+namespace Slic3r {
+
+// A row of the surface sampled at y, z is a * sin(x) + b * cos(x) + c.
+struct TpmsRow
+{
+    float a;
+    float b;
+    float c;
+};
+
+static inline TpmsRow tpms_row(TpmsSurface surface, double sy, double cy, double sz, double cz)
+{
+    switch (surface) {
+    // sin(x) cos(y) + sin(y) cos(z) + sin(z) cos(x)
+    case TpmsSurface::Gyroid:   return { float(cy), float(sz), float(sy * cz) };
+    // cos(x) + cos(y) + cos(z)
+    case TpmsSurface::SchwarzP: return { 0.f, 1.f, float(cy + cz) };
+    // sin(x) sin(y) sin(z) + sin(x) cos(y) cos(z) + cos(x) sin(y) cos(z) + cos(x) cos(y) sin(z)
+    case TpmsSurface::SchwarzD: return { float(sy * sz + cy * cz), float(sy * cz + cy * sz), 0.f };
+    // 3 (cos(x) + cos(y) + cos(z)) + 4 cos(x) cos(y) cos(z)
+    case TpmsSurface::Neovius:  return { 0.f, float(3. + 4. * cy * cz), float(3. * (cy + cz)) };
+    }
+    assert(false);
+    return { 0.f, 0.f, 0.f };
+}
+
+// Evaluates the samples of a row and their signs, kept free of branches and aliasing for the compiler to vectorize it.
+static void tpms_evaluate_row(const TpmsRow row, const float * __restrict sin_x, const float * __restrict cos_x, float * __restrict out, uint8_t * __restrict inside, size_t n)
+{
+    for (size_t i = 0; i < n; ++ i) {
+        const float v = row.a * sin_x[i] + row.b * cos_x[i] + row.c;
+        out[i]    = v;
+        inside[i] = v >= 0.f;
+    }
+}
+
+// Marks the cells of a row with the corners on both sides of the isoline, vectorized as well.
+static void tpms_crossed_cells(const uint8_t * __restrict inside_lo, const uint8_t * __restrict inside_hi, uint8_t * __restrict crossed, size_t n)
+{
+    for (size_t i = 0; i < n; ++ i)
+        crossed[i] = (inside_lo[i] ^ inside_lo[i + 1]) | (inside_lo[i] ^ inside_hi[i]) | (inside_hi[i] ^ inside_hi[i + 1]);
+}
+
+Polylines tpms_isolines(TpmsSurface surface, double z, double width, double height, double step, double scale)
+{
+    assert(step > 0.);
+    const size_t nx = size_t(std::ceil(width / step)) + 1;
+    const size_t ny = size_t(std::ceil(height / step)) + 1;
+    if (nx < 2 || ny < 2)
+        return {};
+
+    std::vector<float> sin_x(nx), cos_x(nx);
+    for (size_t i = 0; i < nx; ++ i) {
+        sin_x[i] = float(sin(double(i) * step));
+        cos_x[i] = float(cos(double(i) * step));
+    }
+    const double sz = sin(z);
+    const double cz = cos(z);
+
+    // The isoline vertices and their neighbors, each vertex lies on a grid edge shared by at most two cells.
+    std::vector<Point>              points;
+    std::vector<std::array<int, 2>> links;
+    auto add_vertex = [&points, &links, step, scale](double x, double y) {
+        points.emplace_back(coord_t(std::round(x * step * scale)), coord_t(std::round(y * step * scale)));
+        links.push_back({ -1, -1 });
+        return int(points.size() - 1);
+    };
+    auto link = [&links](int a, int b) {
+        links[a][links[a][0] == -1 ? 0 : 1] = b;
+        links[b][links[b][0] == -1 ? 0 : 1] = a;
+    };
+    // Vertex on the edge between the samples v0 at t = 0 and v1 at t = 1, if the isoline crosses it.
+    auto crossing = [](float v0, float v1) { return v0 / (v0 - v1); };
+
+    // Two rows of the samples, their signs and the cells between them crossed by the isoline, padded to be scanned by 8 cells.
+    // The vertices on the horizontal edges below and above the current row of cells and on its vertical edges, -1 if not created.
+    std::vector<float>   row_lo(nx), row_hi(nx);
+    std::vector<uint8_t> inside_lo(nx), inside_hi(nx), crossed(nx + 7, 0);
+    std::vector<int>     horizontal_lo(nx - 1, -1), horizontal_hi(nx - 1, -1), vertical(nx, -1);
+
+    tpms_evaluate_row(tpms_row(surface, 0., 1., sz, cz), sin_x.data(), cos_x.data(), row_lo.data(), inside_lo.data(), nx);
+    for (size_t i = 0; i + 1 < nx; ++ i)
+        if (inside_lo[i] != inside_lo[i + 1])
+            horizontal_lo[i] = add_vertex(double(i) + crossing(row_lo[i], row_lo[i + 1]), 0.);
+    for (size_t j = 0; j + 1 < ny; ++ j) {
+        const double y = double(j + 1) * step;
+        const TpmsRow row = tpms_row(surface, sin(y), cos(y), sz, cz);
+        tpms_evaluate_row(row, sin_x.data(), cos_x.data(), row_hi.data(), inside_hi.data(), nx);
+        tpms_crossed_cells(inside_lo.data(), inside_hi.data(), crossed.data(), nx - 1);
+        std::fill(horizontal_hi.begin(), horizontal_hi.end(), -1);
+        std::fill(vertical.begin(), vertical.end(), -1);
+        for (size_t i = 0; i + 1 < nx; ++ i) {
+            // Most of the cells are not crossed by the isoline, skip them by 8.
+            uint64_t next_cells;
+            memcpy(&next_cells, crossed.data() + i, sizeof(next_cells));
+            if (next_cells == 0) {
+                i += 7;
+                continue;
+            }
+            if (! crossed[i])
+                continue;
+            // The bottom vertex was created with the previous row of cells, the left one with the previous cell.
+            int &bottom = horizontal_lo[i], &right = vertical[i + 1], &top = horizontal_hi[i], &left = vertical[i];
+            if (left == -1 && inside_lo[i] != inside_hi[i])
+                left = add_vertex(double(i), double(j) + crossing(row_lo[i], row_hi[i]));
+            if (inside_lo[i + 1] != inside_hi[i + 1])
+                right = add_vertex(double(i + 1), double(j) + crossing(row_lo[i + 1], row_hi[i + 1]));
+            if (inside_hi[i] != inside_hi[i + 1])
+                top = add_vertex(double(i) + crossing(row_hi[i], row_hi[i + 1]), double(j + 1));
+            const int cell = inside_lo[i] | (inside_lo[i + 1] << 1) | (inside_hi[i + 1] << 2) | (inside_hi[i] << 3);
+            switch (cell) {
+            case 1:
+            case 14: link(left, bottom); break;
+            case 2:
+            case 13: link(bottom, right); break;
+            case 3:
+            case 12: link(left, right); break;
+            case 4:
+            case 11: link(right, top); break;
+            case 6:
+            case 9:  link(bottom, top); break;
+            case 7:
+            case 8:  link(left, top); break;
+            case 5:
+            case 10:
+                // Saddle, resolved by the sample at the center of the cell.
+                if ((row_lo[i] + row_lo[i + 1] + row_hi[i] + row_hi[i + 1] >= 0.f) == (cell == 5)) {
+                    link(left, top);
+                    link(bottom, right);
+                } else {
+                    link(left, bottom);
+                    link(right, top);
+                }
+                break;
+            }
+        }
+        row_lo.swap(row_hi);
+        inside_lo.swap(inside_hi);
+        horizontal_lo.swap(horizontal_hi);
+    }
+
+    // Chain the vertices into polylines, first the open ones starting at the border of the tile, then the closed ones.
+    Polylines         out;
+    std::vector<bool> visited(points.size(), false);
+    auto trace = [&](int start, bool closed) {
+        Polyline polyline;
+        int      current = start;
+        for (;;) {
+            visited[current] = true;
+            if (polyline.points.empty() || polyline.points.back() != points[current])
+                polyline.points.emplace_back(points[current]);
+            const std::array<int, 2> &next = links[current];
+            if (next[0] != -1 && ! visited[next[0]])
+                current = next[0];
+            else if (next[1] != -1 && ! visited[next[1]])
+                current = next[1];
+            else
+                break;
+        }
+        if (closed)
+            polyline.points.emplace_back(points[start]);
+        if (polyline.points.size() > 1)
+            out.emplace_back(std::move(polyline));
+    };
+    for (int i = 0; i < int(points.size()); ++ i)
+        if (! visited[i] && links[i][1] == -1)
+            trace(i, false);
+    for (int i = 0; i < int(points.size()); ++ i)
+        if (! visited[i])
+            trace(i, true);
+    return out;
+}
+
+double FillTpms::density_adjust(TpmsSurface surface)
+{
+    // Divided by the infill line length per unit area averaged over the layers relative to the gyroid: 0.768 for Schwarz P,
+    // 1.239 for Schwarz D and 1.089 for Neovius.
+    switch (surface) {
+    case TpmsSurface::Gyroid:   return FillGyroid::DensityAdjust;
+    case TpmsSurface::SchwarzP: return FillGyroid::DensityAdjust / 0.768;
+    case TpmsSurface::SchwarzD: return FillGyroid::DensityAdjust / 1.239;
+    case TpmsSurface::Neovius:  return FillGyroid::DensityAdjust / 1.089;
+    }
+    assert(false);
+    return FillGyroid::DensityAdjust;
+}
+
+void FillTpms::_fill_surface_single(
+    const FillParams                &params,
+    unsigned int                     thickness_layers,
+    const std::pair<float, Point>   &direction,
+    ExPolygon                        expolygon,
+    Polylines                       &polylines_out)
+{
+    if (std::abs(this->angle) >= EPSILON)
+        expolygon.rotate(-this->angle);
+
+    BoundingBox bb = expolygon.contour.bounding_box();
+    // Density adjusted to have a good %of weight.
+    double      density_adjusted = std::max(0., params.density * density_adjust(m_surface) / params.multiline);
+    // Distance between the surface waves in scaled coordinates, one period is 2 PI distance long.
+    coord_t     distance = coord_t(scale_(this->spacing) / density_adjusted);
+
+    // align bounding box to a multiple of our grid module
+    bb.merge(align_to_grid(bb.min, Point(2*M_PI*distance, 2*M_PI*distance)));
+
+    // Sample the surface finer than half of the line spacing, the chord error of the isolines is then well below the line width.
+    // The number of samples per unit area does not depend on the density, thus the sparse infill is not capped.
+    const double period  = 2. * M_PI * unscale<double>(distance);
+    const int    samples = std::max(int(std::ceil(period / (0.5 * this->spacing))), 8);
+    Polylines polylines = tpms_isolines(
+        m_surface,
+        scale_(this->z) / distance,
+        double(bb.size().x()) / distance,
+        double(bb.size().y()) / distance,
+        2. * M_PI / samples,
+        distance);
+
+    // shift the polyline to the grid origin
+    for (Polyline &pl : polylines)
+        pl.translate(bb.min);
+    // Apply multiline offset if needed
+    multiline_fill(polylines, params, spacing);
+
+    polylines = intersection_pl(polylines, expolygon);
+
+    if (! polylines.empty()) {
+        // Remove very small bits, but be careful to not remove infill lines connecting thin walls!
+        // The infill perimeter lines should be separated by around a single infill line width.
+        const double minlength = scale_(0.8 * this->spacing);
+        polylines.erase(
+            std::remove_if(polylines.begin(), polylines.end(), [minlength](const Polyline &pl) { return pl.length() < minlength; }),
+            polylines.end());
+    }
+
+    if (! polylines.empty()) {
+        // connect lines
+        size_t polylines_out_first_idx = polylines_out.size();
+        if (params.dont_connect())
+            append(polylines_out, chain_polylines(polylines));
+        else
+            this->connect_infill(std::move(polylines), expolygon, polylines_out, this->spacing, params);
+
+        // new paths must be rotated back
+        if (std::abs(this->angle) >= EPSILON) {
+            for (auto it = polylines_out.begin() + polylines_out_first_idx; it != polylines_out.end(); ++ it)
+                it->rotate(this->angle);
+        }
+    }
+}
+
+} // namespace Slic3r
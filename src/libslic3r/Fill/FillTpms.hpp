@@ -0,0 +1,51 @@
+#ifndef slic3r_FillTpms_hpp_
+#define slic3r_FillTpms_hpp_
+
+#include "../libslic3r.h"
+
+#include "FillBase.hpp"
+
+namespace Slic3r {
+
+// Triply periodic minimal surfaces, approximated by their level set formulas with a period of 2 PI along each axis.
+enum class TpmsSurface {
+    Gyroid,
+    SchwarzP,
+    SchwarzD,
+    Neovius,
+};
+
+// Zero isolines of the surface sliced at height z, sampled over the rectangle [0, width] x [0, height] with a grid of the given step.
+// All the input values are in the units of the surface, the output points are multiplied by scale.
+// The surface is separable in x and y, thus each row of the grid is evaluated as a * sin(x) + b * cos(x) + c
+// from the sines and cosines tabulated once for the whole tile, which the compiler vectorizes.
+// The isolines are traced by marching squares, the polylines ending at the border of the tile are open, the others are closed.
+Polylines tpms_isolines(TpmsSurface surface, double z, double width, double height, double step, double scale);
+
+class FillTpms : public Fill
+{
+public:
+    FillTpms(TpmsSurface surface) : m_surface(surface) {}
+    Fill* clone() const override { return new FillTpms(*this); }
+
+    bool use_bridge_flow() const override { return false; }
+    bool is_self_crossing() override { return false; }
+
+    // Density adjustment to have the same %of weight as the gyroid, scaled by the surface area per unit cell.
+    static double density_adjust(TpmsSurface surface);
+
+protected:
+    void _fill_surface_single(
+        const FillParams                &params,
+        unsigned int                     thickness_layers,
+        const std::pair<float, Point>   &direction,
+        ExPolygon                        expolygon,
+        Polylines                       &polylines_out) override;
+
+private:
+    TpmsSurface m_surface;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_FillTpms_hpp_
@@ -13,6 +13,7 @@
 #include "../I18N.hpp"
 
 #include "bbs_3mf.hpp"
+#include "mesh_xml_parser.hpp"
 
 #include <limits>
 #include <stdexcept>
@@ -24,6 +25,7 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/nowide/fstream.hpp>
@@ -42,6 +44,7 @@ namespace pt = boost::property_tree;
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/task_arena.h>
 
 #include <expat.h>
 #include <Eigen/Dense>
@@ -291,6 +294,9 @@ static constexpr const char* MMU_SEGMENTATION_ATTR = "paint_color";
 // BBS
 static constexpr const char* FACE_PROPERTY_ATTR = "face_property";
 
+// String attributes of the triangles collected by MeshXmlFilter, in the order of Geometry::append().
+static const std::vector<std::string> MESH_XML_TRIANGLE_ATTRIBUTES { CUSTOM_SUPPORTS_ATTR, CUSTOM_FUZZY_SKIN_ATTR, CUSTOM_SEAM_ATTR, MMU_SEGMENTATION_ATTR, FACE_PROPERTY_ATTR };
+
 static constexpr const char* KEY_ATTR = "key";
 static constexpr const char* VALUE_ATTR = "value";
 static constexpr const char* FIRST_TRIANGLE_ID_ATTR = "firstid";
@@ -729,6 +735,21 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 custom_seam.clear();
                 mmu_segmentation.clear();
             }
+
+            // appends the vertices resp. triangles parsed by MeshXmlFilter, same as _handle_start_vertex() / _handle_start_triangle()
+            void append(MeshXmlChunk &&chunk, float unit_factor) {
+                vertices.reserve(vertices.size() + chunk.vertices.size());
+                for (const Vec3f &v : chunk.vertices)
+                    vertices.emplace_back(unit_factor * v.x(), unit_factor * v.y(), unit_factor * v.z());
+                if (! chunk.triangles.empty()) {
+                    Slic3r::append(triangles, std::move(chunk.triangles));
+                    Slic3r::append(custom_supports, std::move(chunk.triangle_attributes[0]));
+                    Slic3r::append(custom_fuzzy_skin, std::move(chunk.triangle_attributes[1]));
+                    Slic3r::append(custom_seam, std::move(chunk.triangle_attributes[2]));
+                    Slic3r::append(mmu_segmentation, std::move(chunk.triangle_attributes[3]));
+                    Slic3r::append(face_properties, std::move(chunk.triangle_attributes[4]));
+                }
+            }
         };
 
         struct CurrentObject
@@ -1139,6 +1160,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         void _extract_auxiliary_file_from_archive(mz_zip_archive& archive, const mz_zip_archive_file_stat& stat, Model& model);
         void _extract_file_from_archive(mz_zip_archive& archive, const mz_zip_archive_file_stat& stat);
+        // Collects the sub model files referenced by the objects placed on the plate, returns false if the plate or the object list is not found.
+        bool _collect_plate_sub_model_paths(mz_zip_archive& archive, int plate_id, std::set<std::string>& sub_model_paths);
         void _extract_embossed_svg_shape_file(const std::string &filename, mz_zip_archive &archive, const mz_zip_archive_file_stat &stat);
 
         void _extract_filament_sequence_from_archive(mz_zip_archive& archive, const mz_zip_archive_file_stat &stat);
@@ -1690,6 +1713,18 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             _extract_xml_from_archive(archive, sub_rels, _handle_start_relationships_element, _handle_end_relationships_element);
             int index = 0;
 
+            // Loading a single plate (CLI): only parse the sub models of the objects placed on that plate,
+            // the other objects are skipped when the objects are assembled anyway.
+            // The G-codes and thumbnails of the other plates are still extracted, a re-exported project keeps them.
+            std::set<std::string> plate_sub_model_paths;
+            if (plate_id > 0 && !m_load_restore && _collect_plate_sub_model_paths(archive, plate_id, plate_sub_model_paths)) {
+                size_t num_sub_models = m_sub_model_paths.size();
+                m_sub_model_paths.erase(std::remove_if(m_sub_model_paths.begin(), m_sub_model_paths.end(), [&plate_sub_model_paths](const std::string& path) {
+                    return plate_sub_model_paths.count(boost::algorithm::trim_left_copy_if(path, boost::algorithm::is_any_of("/"))) == 0;
+                }), m_sub_model_paths.end());
+                BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" << __LINE__ << boost::format(", plate %1%: loading %2% of %3% sub models\n") % plate_id % m_sub_model_paths.size() % num_sub_models;
+            }
+
 #if 0
             for (auto path : m_sub_model_paths) {
                 if (proFn) {
@@ -2440,16 +2475,25 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         XML_SetEntityDeclHandler(m_xml_parser, nullptr);
         XML_SetExternalEntityRefHandler(m_xml_parser, nullptr);
 
+        // The mesh data is parsed by the specialised scanner in parallel, expat handles the rest.
+        MeshXmlFilter filter(MESH_XML_TRIANGLE_ATTRIBUTES,
+            [this](const char *s, size_t n, bool is_final) { return XML_Parse(m_xml_parser, s, (int)n, is_final ? 1 : 0) && !parse_error(); },
+            [this](MeshXmlChunk &&chunk) {
+                if (m_curr_object)
+                    m_curr_object->geometry.append(std::move(chunk), m_unit_factor);
+            });
+
         struct CallbackData
         {
             XML_Parser& parser;
             _BBS_3MF_Importer& importer;
             const mz_zip_archive_file_stat& stat;
+            MeshXmlFilter& filter;
 
-            CallbackData(XML_Parser& parser, _BBS_3MF_Importer& importer, const mz_zip_archive_file_stat& stat) : parser(parser), importer(importer), stat(stat) {}
+            CallbackData(XML_Parser& parser, _BBS_3MF_Importer& importer, const mz_zip_archive_file_stat& stat, MeshXmlFilter& filter) : parser(parser), importer(importer), stat(stat), filter(filter) {}
         };
 
-        CallbackData data(m_xml_parser, *this, stat);
+        CallbackData data(m_xml_parser, *this, stat, filter);
 
         mz_bool res = 0;
 
@@ -2457,7 +2501,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         {
             mz_file_write_func callback = [](void* pOpaque, mz_uint64 file_ofs, const void* pBuf, size_t n)->size_t {
                 CallbackData* data = (CallbackData*)pOpaque;
-                if (!XML_Parse(data->parser, (const char*)pBuf, (int)n, (file_ofs + n == data->stat.m_uncomp_size) ? 1 : 0) || data->importer.parse_error()) {
+                if (!data->filter.feed((const char*)pBuf, n, file_ofs + n == data->stat.m_uncomp_size)) {
                     char error_buf[1024];
                     ::snprintf(error_buf, 1024, "Error (%s) while parsing '%s' at line %d", data->importer.parse_error_message(), data->stat.m_filename, (int)XML_GetCurrentLineNumber(data->parser));
                     throw Slic3r::FileIOError(error_buf);
@@ -2736,6 +2780,72 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         return;
     }
 
+    bool _BBS_3MF_Importer::_collect_plate_sub_model_paths(mz_zip_archive& archive, int plate_id, std::set<std::string>& sub_model_paths)
+    {
+        auto read_tree = [&archive](std::string path, pt::ptree& tree) {
+            if (!path.empty() && path.front() == '/')
+                path = path.substr(1);
+            mz_zip_archive_file_stat stat;
+            int index = mz_zip_reader_locate_file(&archive, path.c_str(), nullptr, 0);
+            if (index < 0 || !mz_zip_reader_file_stat(&archive, index, &stat) || stat.m_uncomp_size == 0)
+                return false;
+            std::string buffer((size_t)stat.m_uncomp_size, 0);
+            if (mz_zip_reader_extract_to_mem(&archive, stat.m_file_index, (void*)buffer.data(), (size_t)stat.m_uncomp_size, 0) == 0)
+                return false;
+            std::istringstream iss(buffer);
+            pt::read_xml(iss, tree);
+            return true;
+        };
+
+        try {
+            // ids of the objects instanced on the plate
+            pt::ptree config_tree;
+            if (!read_tree(BBS_MODEL_CONFIG_FILE, config_tree))
+                return false;
+            std::set<int> object_ids;
+            bool          plate_found = false;
+            for (const auto& plate : config_tree.get_child(CONFIG_TAG)) {
+                if (plate.first != PLATE_TAG)
+                    continue;
+                int              plater_id = -1;
+                std::vector<int> plate_object_ids;
+                for (const auto& item : plate.second) {
+                    if (item.first == METADATA_TAG && item.second.get<std::string>("<xmlattr>.key", "") == PLATERID_ATTR)
+                        plater_id = item.second.get<int>("<xmlattr>.value", -1);
+                    else if (item.first == INSTANCE_TAG) {
+                        for (const auto& metadata : item.second)
+                            if (metadata.first == METADATA_TAG && metadata.second.get<std::string>("<xmlattr>.key", "") == OBJECT_ID_ATTR)
+                                plate_object_ids.push_back(metadata.second.get<int>("<xmlattr>.value", -1));
+                    }
+                }
+                if (plater_id == plate_id) {
+                    plate_found = true;
+                    object_ids.insert(plate_object_ids.begin(), plate_object_ids.end());
+                }
+            }
+            if (!plate_found)
+                return false;
+
+            // sub models referenced by the components of these objects in the root model
+            pt::ptree model_tree;
+            if (!read_tree(m_start_part_path, model_tree))
+                return false;
+            for (const auto& object : model_tree.get_child(std::string(MODEL_TAG) + "." + RESOURCES_TAG)) {
+                if (object.first != OBJECT_TAG || object_ids.count(object.second.get<int>("<xmlattr>.id", -1)) == 0)
+                    continue;
+                if (auto components = object.second.get_child_optional(COMPONENTS_TAG))
+                    for (const auto& component : *components)
+                        if (component.first == COMPONENT_TAG)
+                            sub_model_paths.insert(boost::algorithm::trim_left_copy_if(component.second.get<std::string>(std::string("<xmlattr>.") + PPATH_ATTR, ""), boost::algorithm::is_any_of("/")));
+            }
+        }
+        catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << ":" << __LINE__ << boost::format(", failed to collect the objects of plate %1%, loading all: %2%\n") % plate_id % e.what();
+            return false;
+        }
+        return true;
+    }
+
     void _BBS_3MF_Importer::_extract_layer_heights_profile_config_from_archive(mz_zip_archive& archive, const mz_zip_archive_file_stat& stat)
     {
         if (stat.m_uncomp_size > 0) {
@@ -5577,16 +5687,25 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         XML_SetEntityDeclHandler(object_xml_parser, nullptr);
         XML_SetExternalEntityRefHandler(object_xml_parser, nullptr);
 
+        // The mesh data is parsed by the specialised scanner in parallel, expat handles the rest.
+        MeshXmlFilter filter(MESH_XML_TRIANGLE_ATTRIBUTES,
+            [this](const char *s, size_t n, bool is_final) { return XML_Parse(object_xml_parser, s, (int)n, is_final ? 1 : 0) && !object_parse_error(); },
+            [this](MeshXmlChunk &&chunk) {
+                if (current_object)
+                    current_object->geometry.append(std::move(chunk), object_unit_factor);
+            });
+
         struct CallbackData
         {
             XML_Parser& parser;
             _BBS_3MF_Importer::ObjectImporter& importer;
             const mz_zip_archive_file_stat& stat;
+            MeshXmlFilter& filter;
 
-            CallbackData(XML_Parser& parser, _BBS_3MF_Importer::ObjectImporter& importer, const mz_zip_archive_file_stat& stat) : parser(parser), importer(importer), stat(stat) {}
+            CallbackData(XML_Parser& parser, _BBS_3MF_Importer::ObjectImporter& importer, const mz_zip_archive_file_stat& stat, MeshXmlFilter& filter) : parser(parser), importer(importer), stat(stat), filter(filter) {}
         };
 
-        CallbackData data(object_xml_parser, *this, stat);
+        CallbackData data(object_xml_parser, *this, stat, filter);
 
         mz_bool res = 0;
 
@@ -5594,7 +5713,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         {
             mz_file_write_func callback = [](void* pOpaque, mz_uint64 file_ofs, const void* pBuf, size_t n)->size_t {
                 CallbackData* data = (CallbackData*)pOpaque;
-                if (!XML_Parse(data->parser, (const char*)pBuf, (int)n, (file_ofs + n == data->stat.m_uncomp_size) ? 1 : 0) || data->importer.object_parse_error()) {
+                if (!data->filter.feed((const char*)pBuf, n, file_ofs + n == data->stat.m_uncomp_size)) {
                     char error_buf[1024];
                     ::snprintf(error_buf, 1024, "Error (%s) while parsing '%s' at line %d", data->importer.object_parse_error_message(), data->stat.m_filename, (int)XML_GetCurrentLineNumber(data->parser));
                     throw Slic3r::FileIOError(error_buf);
@@ -5717,6 +5836,14 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             int export_plate_idx = -1);
 
         bool _add_file_to_archive(mz_zip_archive& archive, const std::string & path_in_zip, const std::string & file_path);
+        // Calls add_entries(i, heap_archive) for the items [0, count) in parallel, each into its own in-memory archive, which are copied
+        // into the archive in the order of the items. The small items are processed in batches capped by their estimated size not to hold
+        // the entries of all of them in memory. The items estimated larger than StreamEntrySize are not buffered, add_entries(i, archive)
+        // streams them into the archive directly, deflating them block by block in parallel.
+        static constexpr const size_t StreamEntrySize = 4 * MZ_ParallelDeflateWriter::BlockSize;
+        static constexpr const size_t MaxBatchSize    = 16 * MZ_ParallelDeflateWriter::BlockSize;
+        bool _add_entries_in_parallel(mz_zip_archive& archive, size_t count, const std::function<size_t(size_t)>& estimate_size,
+                                      const std::function<bool(size_t, mz_zip_archive&)>& add_entries) const;
 
         bool _add_content_types_file_to_archive(mz_zip_archive& archive);
 
@@ -5730,7 +5857,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                                                 PackingTemporaryData            data    = PackingTemporaryData(),
                                                 int export_plate_idx = -1) const;
         bool _add_model_file_to_archive(const std::string& filename, mz_zip_archive& archive, const Model& model, ObjectToObjectDataMap& objects_data, Export3mfProgressFn proFn = nullptr, BBLProject* project = nullptr) const;
-        bool _add_object_to_model_stream(mz_zip_writer_staged_context &context, ObjectData const &object_data) const;
+        bool _add_object_to_model_stream(MZ_ParallelDeflateWriter &writer, ObjectData const &object_data) const;
         void _add_object_components_to_stream(std::stringstream &stream, ObjectData const &object_data) const;
         //BBS: change volume to seperate objects
         bool _add_mesh_to_object_stream(std::function<bool(std::string &, bool)> const &flush, ObjectData const &object_data) const;
@@ -5974,49 +6101,39 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     return false;
             }
 
-            for (unsigned int index = 0; index < thumbnail_data.size(); index++)
+            // The PNGs are encoded in parallel, they are written in the order of the plates.
+            struct ThumbnailToAdd
             {
+                const ThumbnailData *data;
+                const char          *local_path;
+                unsigned int         index;
+                bool                 generate_small_thumbnail;
+                std::vector<bool>   *status;
+            };
+            std::vector<ThumbnailToAdd> thumbnails_to_add;
+            for (unsigned int index = 0; index < thumbnail_data.size(); index++)
                 if (thumbnail_data[index]->is_valid())
-                {
-                    if (!_add_thumbnail_file_to_archive(archive, *thumbnail_data[index], "Metadata/plate", index, true)) {
-                        return false;
-                    }
-
-                    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" <<__LINE__ << boost::format(",add thumbnail %1%'s data into 3mf")%(index+1);
-                    thumbnail_status[index] = true;
-                }
-            }
-
-            for (unsigned int index = 0; index < no_light_thumbnail_data.size(); index++) {
-                if (no_light_thumbnail_data[index]->is_valid()) {
-                    if (!_add_thumbnail_file_to_archive(archive, *no_light_thumbnail_data[index], "Metadata/plate_no_light", index)) {
-                        return false;
-                    }
-
-                    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" << __LINE__ << boost::format(",add no light thumbnail %1%'s data into 3mf") % (index + 1);
-                    no_light_thumbnail_status[index] = true;
-                }
-            }
+                    thumbnails_to_add.push_back({ thumbnail_data[index], "Metadata/plate", index, true, &thumbnail_status });
+            for (unsigned int index = 0; index < no_light_thumbnail_data.size(); index++)
+                if (no_light_thumbnail_data[index]->is_valid())
+                    thumbnails_to_add.push_back({ no_light_thumbnail_data[index], "Metadata/plate_no_light", index, false, &no_light_thumbnail_status });
             // Adds the file Metadata/top_i.png and Metadata/pick_i.png
-            for (unsigned int index = 0; index < top_thumbnail_data.size(); index++)
-            {
+            for (unsigned int index = 0; index < top_thumbnail_data.size(); index++) {
                 if (top_thumbnail_data[index]->is_valid())
-                {
-                    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" <<__LINE__ << boost::format(",add top thumbnail %1%'s data into 3mf")%(index+1);
-                    if (!_add_thumbnail_file_to_archive(archive, *top_thumbnail_data[index], "Metadata/top", index)) {
-                        return false;
-                    }
-                    top_thumbnail_status[index] = true;
-                }
-
+                    thumbnails_to_add.push_back({ top_thumbnail_data[index], "Metadata/top", index, false, &top_thumbnail_status });
                 if (pick_thumbnail_data[index]->is_valid())
-                {
-                    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" <<__LINE__ << boost::format(",add pick thumbnail %1%'s data into 3mf")%(index+1);
-                    if (!_add_thumbnail_file_to_archive(archive, *pick_thumbnail_data[index], "Metadata/pick", index)) {
-                        return false;
-                    }
-                    pick_thumbnail_status[index] = true;
-                }
+                    thumbnails_to_add.push_back({ pick_thumbnail_data[index], "Metadata/pick", index, false, &pick_thumbnail_status });
+            }
+            if (!_add_entries_in_parallel(archive, thumbnails_to_add.size(),
+                    [&thumbnails_to_add](size_t i) { return thumbnails_to_add[i].data->pixels.size(); },
+                    [this, &thumbnails_to_add](size_t i, mz_zip_archive& thumbnail_archive) {
+                    const ThumbnailToAdd &thumbnail = thumbnails_to_add[i];
+                    return _add_thumbnail_file_to_archive(thumbnail_archive, *thumbnail.data, thumbnail.local_path, thumbnail.index, thumbnail.generate_small_thumbnail);
+                }))
+                return false;
+            for (const ThumbnailToAdd &thumbnail : thumbnails_to_add) {
+                BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" <<__LINE__ << boost::format(",add thumbnail %1% %2%'s data into 3mf") % thumbnail.local_path % (thumbnail.index + 1);
+                (*thumbnail.status)[thumbnail.index] = true;
             }
 
             for (int i = 0; i < plate_data_list.size(); i++) {
@@ -6384,6 +6501,48 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         return true;
     }
 
+    bool _BBS_3MF_Exporter::_add_entries_in_parallel(mz_zip_archive& archive, size_t count, const std::function<size_t(size_t)>& estimate_size,
+                                                     const std::function<bool(size_t, mz_zip_archive&)>& add_entries) const
+    {
+        const size_t batch_size = size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+        for (size_t batch_begin = 0; batch_begin < count;) {
+            if (estimate_size(batch_begin) > StreamEntrySize) {
+                // A large entry is streamed into the archive, the errors of add_entries() were reported already.
+                if (!add_entries(batch_begin, archive))
+                    return false;
+                ++ batch_begin;
+                continue;
+            }
+            // Collect the following small entries up to the batch size or the size cap.
+            size_t batch_end   = batch_begin + 1;
+            size_t batch_bytes = estimate_size(batch_begin);
+            for (; batch_end < count && batch_end - batch_begin < batch_size; ++ batch_end) {
+                size_t bytes = estimate_size(batch_end);
+                if (bytes > StreamEntrySize || batch_bytes + bytes > MaxBatchSize)
+                    break;
+                batch_bytes += bytes;
+            }
+            std::vector<MZ_HeapArchive> heap_archives(batch_end - batch_begin);
+            std::vector<char>           results(batch_end - batch_begin, false);
+            tbb::parallel_for(tbb::blocked_range<size_t>(batch_begin, batch_end, 1), [&](const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i < range.end(); ++i)
+                    results[i - batch_begin] = add_entries(i, heap_archives[i - batch_begin].archive());
+            });
+            for (size_t i = batch_begin; i < batch_end; ++i) {
+                // The errors of add_entries() were reported already.
+                if (!results[i - batch_begin])
+                    return false;
+                if (!heap_archives[i - batch_begin].copy_to(archive)) {
+                    add_error("Unable to copy the compressed entries into the archive");
+                    BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to copy the compressed entries into the archive\n");
+                    return false;
+                }
+            }
+            batch_begin = batch_end;
+        }
+        return true;
+    }
+
     bool _BBS_3MF_Exporter::_add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data, const char* local_path, int index, bool generate_small_thumbnail)
     {
         bool res = false;
@@ -6435,7 +6594,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             }
             size_t small_png_size = 0;
             void* small_png_data = tdefl_write_image_to_png_file_in_memory_ex((const void*)small_pixels.data(), PLATE_THUMBNAIL_SMALL_WIDTH, PLATE_THUMBNAIL_SMALL_HEIGHT, 4, &small_png_size, MZ_DEFAULT_COMPRESSION, 1);
-            if (png_data != nullptr) {
+            res = false;
+            if (small_png_data != nullptr) {
                 std::string thumbnail_name = (boost::format("%1%_%2%_small.png") % local_path % (index + 1)).str();
                 res = mz_zip_writer_add_mem(&archive, thumbnail_name.c_str(), (const void*)small_png_data, small_png_size, MZ_NO_COMPRESSION);
                 mz_free(small_png_data);
@@ -6590,8 +6750,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         std::string zip_filename = encode_path(filename.c_str());
         std::string extra = sub_model ? ZipUnicodePathExtraField::encode(filename, zip_filename) : "";
 #endif
-        mz_zip_writer_staged_context context;
-        if (!mz_zip_writer_add_staged_open(&archive, &context, sub_model ? zip_filename.c_str() : MODEL_FILE.c_str(),
+        // The XML is generated by this thread, while it is being deflated by TBB tasks in blocks of a fixed size.
+        MZ_ParallelDeflateWriter writer(archive);
+        if (!writer.open(sub_model ? zip_filename.c_str() : MODEL_FILE.c_str(),
             m_zip64 ?
                 // Maximum expected and allowed 3MF file size is 16GiB.
                 // This switches the ZIP file to a 64bit mode, which adds a tiny bit of overhead to file records.
@@ -6600,9 +6761,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 // GH issue #6193.
                 (uint64_t(1) << 32) - 1,
 #if WRITE_ZIP_LANGUAGE_ENCODING
-            nullptr, nullptr, 0, MZ_DEFAULT_LEVEL, nullptr, 0, nullptr, 0)) {
+            MZ_DEFAULT_LEVEL)) {
 #else
-            nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
+            MZ_DEFAULT_COMPRESSION, extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
 #endif
             add_error("Unable to add model file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add model file to archive\n");
@@ -6728,8 +6889,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             }
 
             stream << " <" << RESOURCES_TAG << ">\n";
-            std::string buf = stream.str();
-            if (! buf.empty() && ! mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) {
+            if (! writer.write(stream.str())) {
                 add_error("Unable to add model file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add model file to archive\n");
                 return false;
@@ -6817,7 +6977,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     // Store geometry of all ModelVolumes contained in a single ModelObject into a single 3MF indexed triangle set object.
                     // object_it->second.volumes_objectID will contain the offsets of the ModelVolumes in that single indexed triangle set.
                     // object_id will be increased to point to the 1st instance of the next ModelObject.
-                    if (!_add_object_to_model_stream(context, object_it->second)) {
+                    if (!_add_object_to_model_stream(writer, object_it->second)) {
                         add_error("Unable to add object to archive");
                         BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add object to archive\n");
                         return false;
@@ -6861,10 +7021,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
             stream << "</" << MODEL_TAG << ">\n";
 
-            std::string buf = stream.str();
-
-            if ((! buf.empty() && ! mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) ||
-                ! mz_zip_writer_add_staged_finish(&context)) {
+            if (! writer.write(stream.str()) || ! writer.finish()) {
                 add_error("Unable to add model file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add model file to archive\n");
                 return false;
@@ -6877,42 +7034,37 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         _add_relationships_file_to_archive(archive, MODEL_RELS_FILE, object_paths, {"http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel"});
 
         if (!m_from_backup_save) {
-            boost::mutex mutex;
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, objects_data.size(), 1), [this, &mutex, &model, objects = model.objects, &objects_data, &object_paths, main = &archive, project](const tbb::blocked_range<size_t>& range) {
-                for (size_t i = range.begin(); i < range.end(); ++i) {
-                    auto iter = objects_data.find(objects[i]);
+            // The object files are generated and compressed in parallel, they are written in the order of the objects.
+            if (!_add_entries_in_parallel(archive, objects_data.size(),
+                    [&model](size_t i) {
+                        // Rough size of the XML of the meshes of the object.
+                        size_t bytes = 0;
+                        for (const ModelVolume *volume : model.objects[i]->volumes)
+                            bytes += volume->mesh().its.vertices.size() * 60 + volume->mesh().its.indices.size() * 50;
+                        return bytes;
+                    },
+                    [this, &model, &objects_data, &object_paths, project](size_t i, mz_zip_archive& object_archive) {
+                    CNumericLocalesSetter locales_setter;
+                    auto iter = objects_data.find(model.objects[i]);
                     ObjectToObjectDataMap objects_data2;
                     objects_data2.insert(*iter);
-                    auto & object = *iter->second.object;
-                    mz_zip_archive archive;
-                    mz_zip_zero_struct(&archive);
-                    mz_zip_writer_init_heap(&archive, 0, 1024 * 1024);
-                    CNumericLocalesSetter locales_setter;
-                    _add_model_file_to_archive(object_paths[i], archive, model, objects_data2, nullptr, project);
+                    if (!_add_model_file_to_archive(object_paths[i], object_archive, model, objects_data2, nullptr, project))
+                        return false;
                     iter->second = objects_data2.begin()->second;
-                    void *ppBuf; size_t pSize;
-                    mz_zip_writer_finalize_heap_archive(&archive, &ppBuf, &pSize);
-                    mz_zip_writer_end(&archive);
-                    mz_zip_zero_struct(&archive);
-                    mz_zip_reader_init_mem(&archive, ppBuf, pSize, 0);
-                    {
-                        boost::unique_lock l(mutex);
-                        mz_zip_writer_add_from_zip_reader(main, &archive, 0);
-                    }
-                    mz_zip_reader_end(&archive);
-                }
-            });
+                    return true;
+                }))
+                return false;
         }
 
         return true;
     }
 
-    bool _BBS_3MF_Exporter::_add_object_to_model_stream(mz_zip_writer_staged_context &context, ObjectData const &object_data) const
+    bool _BBS_3MF_Exporter::_add_object_to_model_stream(MZ_ParallelDeflateWriter &writer, ObjectData const &object_data) const
     {
         // backup: make _add_mesh_to_object_stream() reusable
-        auto flush = [this, &context](std::string & buf, bool force = false) {
-            if ((force && !buf.empty()) || buf.size() >= 65536 * 16) {
-                if (!mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) {
+        auto flush = [this, &writer](std::string & buf, bool force = false) {
+            if ((force && !buf.empty()) || buf.size() >= MZ_ParallelDeflateWriter::BlockSize) {
+                if (!writer.write(buf)) {
                     add_error("Error during writing or compression");
                     BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Error during writing or compression\n");
                     return false;
@@ -8205,47 +8357,53 @@ bool _BBS_3MF_Exporter::_add_gcode_file_to_archive(mz_zip_archive& archive, cons
         }
     }
 
-    boost::mutex mutex;
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, plate_data_list2.size(), 1), [this, &plate_data_list2, &root_archive = archive, &mutex, &result](const tbb::blocked_range<size_t>& range) {
-        for (int i = range.begin(); i < range.end(); ++i) {
-            PlateData* plate_data = plate_data_list2[i];
+    // The G-codes are compressed in parallel through fixed size buffers, they are written in the order of the plates.
+    // The large G-codes are streamed into the archive, only the small ones are compressed into memory next to each other.
+    std::vector<size_t> gcode_sizes(plate_data_list2.size(), 0);
+    for (size_t i = 0; i < plate_data_list2.size(); ++ i) {
+        boost::system::error_code ec;
+        gcode_sizes[i] = size_t(boost::filesystem::file_size(plate_data_list2[i]->gcode_file, ec));
+        if (ec)
+            gcode_sizes[i] = 0;
+    }
+    std::vector<char> gcode_missing(plate_data_list2.size(), false);
+    if (!_add_entries_in_parallel(archive, plate_data_list2.size(),
+            [&gcode_sizes](size_t i) { return gcode_sizes[i]; },
+            [this, &plate_data_list2, &gcode_missing](size_t i, mz_zip_archive& gcode_archive) {
+            PlateData *plate_data = plate_data_list2[i];
             auto src_gcode_file = plate_data->gcode_file;
             std::string gcode_in_3mf = (boost::format(GCODE_FILE_FORMAT) % (plate_data->plate_index + 1)).str();
 
             plate_data->gcode_file = gcode_in_3mf;
-            mz_zip_archive archive;
-            mz_zip_writer_staged_context context;
-            mz_zip_zero_struct(&archive);
-            mz_zip_writer_init_heap(&archive, 0, 1024 * 1024);
-            {
-                mz_zip_writer_add_staged_open(&archive, &context, gcode_in_3mf.c_str(), m_zip64 ? (uint64_t(1) << 30) * 16 : (uint64_t(1) << 32) - 1, nullptr, nullptr, 0,
-                    MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0);
-                boost::filesystem::path src_gcode_path(src_gcode_file);
-                if (!boost::filesystem::exists(src_gcode_path)) {
-                    BOOST_LOG_TRIVIAL(error) << "Gcode is missing, filename = " << PathSanitizer::sanitize(src_gcode_file);
-                    result = false;
-                }
-                boost::filesystem::ifstream ifs(src_gcode_file, std::ios::binary);
-                std::string buf(64 * 1024, 0);
-                while (ifs) {
-                    ifs.read(buf.data(), buf.size());
-                    mz_zip_writer_add_staged_data(&context, buf.data(), ifs.gcount());
-                }
-                mz_zip_writer_add_staged_finish(&context);
-            }
-            void *ppBuf; size_t pSize;
-            mz_zip_writer_finalize_heap_archive(&archive, &ppBuf, &pSize);
-            mz_zip_writer_end(&archive);
-            mz_zip_zero_struct(&archive);
-            mz_zip_reader_init_mem(&archive, ppBuf, pSize, 0);
-            {
-                boost::unique_lock l(mutex);
-                mz_zip_writer_add_from_zip_reader(&root_archive, &archive, 0);
+            boost::filesystem::path src_gcode_path(src_gcode_file);
+            if (!boost::filesystem::exists(src_gcode_path)) {
+                BOOST_LOG_TRIVIAL(error) << "Gcode is missing, filename = " << PathSanitizer::sanitize(src_gcode_file);
+                gcode_missing[i] = true;
+            }
+            MZ_ParallelDeflateWriter writer(gcode_archive);
+            if (!writer.open(gcode_in_3mf.c_str(), m_zip64 ? (uint64_t(1) << 30) * 16 : (uint64_t(1) << 32) - 1, MZ_DEFAULT_COMPRESSION)) {
+                add_error("Unable to add gcode file to archive");
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add %1% to archive\n") % PathSanitizer::sanitize(gcode_in_3mf);
+                return false;
+            }
+            boost::filesystem::ifstream ifs(src_gcode_file, std::ios::binary);
+            std::string buf(MZ_ParallelDeflateWriter::BlockSize, 0);
+            bool ok = true;
+            while (ok && ifs) {
+                ifs.read(buf.data(), buf.size());
+                ok = writer.write(buf.data(), ifs.gcount());
+            }
+            if (!ok || !writer.finish()) {
+                add_error("Unable to add gcode file to archive");
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add %1% to archive\n") % PathSanitizer::sanitize(gcode_in_3mf);
+                return false;
             }
-            mz_zip_reader_end(&archive);
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" << __LINE__ << boost::format(", store  %1% to 3mf %2%\n") % PathSanitizer::sanitize(src_gcode_file) % PathSanitizer::sanitize(gcode_in_3mf);
-        }
-    });
+            return true;
+        }))
+        return false;
+    if (std::find(gcode_missing.begin(), gcode_missing.end(), true) != gcode_missing.end())
+        result = false;
     return result;
 }
 
@@ -8832,6 +8990,33 @@ void release_PlateData_list(PlateDataPtrs& plate_data_list)
     return;
 }
 
+bool copy_PlateData_auxiliary_files(PlateData& plate_data, const std::string& dir)
+{
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(dir, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << boost::format(": failed to create %1%, %2%") % dir % ec.message();
+        return false;
+    }
+    std::string* paths[] = { &plate_data.gcode_file, &plate_data.thumbnail_file, &plate_data.no_light_thumbnail_file,
+                             &plate_data.top_file, &plate_data.pick_file, &plate_data.pattern_bbox_file };
+    for (size_t index = 0; index < std::size(paths); ++index) {
+        std::string* path = paths[index];
+        if (path->empty())
+            continue;
+        // the files of different kinds share their names, e.g. Metadata/plate_1.png and Auxiliaries/.thumbnails/plate_1.png
+        boost::filesystem::path src(*path);
+        boost::filesystem::path dst = boost::filesystem::path(dir) / (std::to_string(plate_data.plate_index) + "_" + std::to_string(index) + "_" + src.filename().string());
+        boost::filesystem::copy_file(src, dst, boost::filesystem::copy_option::overwrite_if_exists, ec);
+        if (ec) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << boost::format(": failed to copy %1% to %2%, %3%") % *path % dst.string() % ec.message();
+            return false;
+        }
+        *path = dst.string();
+    }
+    return true;
+}
+
 // backup interface
 
 void save_object_mesh(ModelObject& object)
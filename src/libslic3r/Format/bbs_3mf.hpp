@@ -278,6 +278,10 @@ extern bool store_bbs_3mf(StoreParams& store_params);
 
 extern void release_PlateData_list(PlateDataPtrs& plate_data_list);
 
+//BBS: copy the auxiliary files of a plate (G-code, thumbnails, top, pick and pattern bbox images) extracted from a 3mf into dir
+//and point the plate to the copies, so that they outlive the backup directory of the 3mf. Returns false if a file failed to copy.
+extern bool copy_PlateData_auxiliary_files(PlateData& plate_data, const std::string& dir);
+
 // backup & restore project
 
 extern void save_object_mesh(ModelObject& object);
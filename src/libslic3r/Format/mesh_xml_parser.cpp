@@ -0,0 +1,350 @@
+#include "mesh_xml_parser.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
+#include <fast_float/fast_float.h>
+
+namespace Slic3r {
+
+namespace {
+
+inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+inline const char* skip_space(const char *p, const char *end)
+{
+    while (p != end && is_space(*p))
+        ++ p;
+    return p;
+}
+
+inline bool starts_with(const char *p, size_t size, const char *prefix)
+{
+    size_t len = strlen(prefix);
+    return size >= len && memcmp(p, prefix, len) == 0;
+}
+
+// p points to '<', which is followed by the tag name and either white space, '>' or '/'.
+inline bool matches_tag(const char *p, size_t size, const char *tag)
+{
+    size_t len = strlen(tag);
+    return size > len + 1 && memcmp(p + 1, tag, len) == 0 && (is_space(p[len + 1]) || p[len + 1] == '>' || p[len + 1] == '/');
+}
+
+// The number has to span the complete attribute value, otherwise expat will handle the chunk.
+inline bool parse_number(const char *begin, const char *end, float &out)
+{
+    auto [ptr, ec] = fast_float::from_chars(begin, end, out);
+    return ptr == end && ec == std::errc();
+}
+
+inline bool parse_number(const char *begin, const char *end, int &out)
+{
+    auto [ptr, ec] = std::from_chars(begin, end, out);
+    return ptr == end && ec == std::errc();
+}
+
+// Parses the attributes of an element following the element name up to the closing "/>", calls attribute(name, name_end, value, value_end)
+// for each attribute. Returns the end of the element or nullptr if the element is not a well formed empty element, if attribute() returned false
+// or if an attribute value needs to be processed by expat (entity references, white space normalized to spaces).
+template<typename AttributeFn>
+const char* parse_empty_element(const char *p, const char *end, AttributeFn attribute)
+{
+    for (;;) {
+        const char *q = skip_space(p, end);
+        if (q == end)
+            return nullptr;
+        if (*q == '/')
+            return q + 1 != end && q[1] == '>' ? q + 2 : nullptr;
+        if (q == p)
+            // The attributes have to be separated from the element name and from each other by white space.
+            return nullptr;
+        const char *name = q;
+        while (q != end && ! is_space(*q) && *q != '=' && *q != '/' && *q != '>' && *q != '<')
+            ++ q;
+        const char *name_end = q;
+        q = skip_space(q, end);
+        if (name == name_end || q == end || *q != '=')
+            return nullptr;
+        q = skip_space(q + 1, end);
+        if (q == end || (*q != '"' && *q != '\''))
+            return nullptr;
+        const char  quote = *q ++;
+        const char *value = q;
+        for (; q != end && *q != quote; ++ q)
+            if (*q == '<' || *q == '&' || *q == '\t' || *q == '\n' || *q == '\r')
+                return nullptr;
+        if (q == end || ! attribute(name, name_end, value, q))
+            return nullptr;
+        p = q + 1;
+    }
+}
+
+// Parses a sequence of empty elements with the given tag separated by white space, element(p, end) parses the element after its name.
+template<typename ElementFn>
+bool parse_elements(const char *p, const char *end, const char *tag, ElementFn element)
+{
+    const size_t len = strlen(tag);
+    for (;;) {
+        p = skip_space(p, end);
+        if (p == end)
+            return true;
+        if (size_t(end - p) < len + 2 || *p != '<' || memcmp(p + 1, tag, len) != 0)
+            return false;
+        if (p = element(p + 1 + len, end); p == nullptr)
+            return false;
+    }
+}
+
+} // namespace
+
+bool parse_mesh_xml_vertices(const char *begin, const char *end, MeshXmlChunk &out)
+{
+    // A vertex takes about 60 bytes.
+    out.vertices.reserve(out.vertices.size() + (end - begin) / 48);
+    return parse_elements(begin, end, "vertex", [&out](const char *p, const char *end) {
+        Vec3f v    = Vec3f::Zero();
+        int   seen = 0;
+        p = parse_empty_element(p, end, [&v, &seen](const char *name, const char *name_end, const char *value, const char *value_end) {
+            if (name_end - name == 1 && *name >= 'x' && *name <= 'z') {
+                int axis = *name - 'x';
+                if (seen & (1 << axis))
+                    // Duplicate attribute, let expat report the error.
+                    return false;
+                seen |= 1 << axis;
+                return parse_number(value, value_end, v[axis]);
+            }
+            return true;
+        });
+        if (p != nullptr)
+            out.vertices.emplace_back(v);
+        return p;
+    });
+}
+
+bool parse_mesh_xml_triangles(const char *begin, const char *end, const std::vector<std::string> &attributes, MeshXmlChunk &out)
+{
+    // A triangle takes about 45 bytes.
+    out.triangles.reserve(out.triangles.size() + (end - begin) / 40);
+    out.triangle_attributes.resize(attributes.size());
+    return parse_elements(begin, end, "triangle", [&out, &attributes](const char *p, const char *end) {
+        Vec3i    idx  = Vec3i::Zero();
+        uint32_t seen = 0;
+        for (std::vector<std::string> &values : out.triangle_attributes)
+            values.emplace_back();
+        p = parse_empty_element(p, end, [&out, &attributes, &idx, &seen](const char *name, const char *name_end, const char *value, const char *value_end) {
+            if (name_end - name == 2 && name[0] == 'v' && name[1] >= '1' && name[1] <= '3') {
+                int i = name[1] - '1';
+                if (seen & (1 << i))
+                    return false;
+                seen |= 1 << i;
+                return parse_number(value, value_end, idx[i]);
+            }
+            for (size_t i = 0; i < attributes.size(); ++ i)
+                if (size_t(name_end - name) == attributes[i].size() && memcmp(name, attributes[i].data(), attributes[i].size()) == 0) {
+                    if (seen & (8 << i))
+                        return false;
+                    seen |= 8 << i;
+                    out.triangle_attributes[i].back().assign(value, value_end);
+                    break;
+                }
+            return true;
+        });
+        if (p != nullptr)
+            out.triangles.emplace_back(idx);
+        return p;
+    });
+}
+
+struct MeshXmlFilter::Chunk
+{
+    // Kept until the chunk is passed to mesh_sink, to be passed to expat if the scanner refuses it.
+    std::string       text;
+    bool              triangles { false };
+    bool              ok { false };
+    std::atomic<bool> done { false };
+    MeshXmlChunk      result;
+    tbb::task_group   task;
+};
+
+MeshXmlFilter::MeshXmlFilter(std::vector<std::string> triangle_attributes, XmlSink xml_sink, MeshSink mesh_sink) :
+    m_triangle_attributes(std::move(triangle_attributes)), m_xml_sink(std::move(xml_sink)), m_mesh_sink(std::move(mesh_sink))
+{
+    // The bits above 3 of the mask of seen triangle attributes.
+    assert(m_triangle_attributes.size() < 29);
+}
+
+MeshXmlFilter::~MeshXmlFilter()
+{
+    for (std::unique_ptr<Chunk> &chunk : m_chunks)
+        chunk->task.wait();
+}
+
+size_t MeshXmlFilter::max_chunks_in_flight()
+{
+    return 2 * size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+}
+
+bool MeshXmlFilter::feed(const char *data, size_t size, bool is_final)
+{
+    m_pending.append(data, size);
+    switch (m_state) {
+    case State::Xml:
+        return this->process_xml(is_final);
+    case State::Vertices:
+    case State::Triangles:
+        return this->process_mesh(is_final);
+    default:
+    {
+        bool ok = this->flush_chunks(0) && m_xml_sink(m_pending.data(), m_pending.size(), is_final);
+        m_pending.clear();
+        return ok;
+    }
+    }
+}
+
+bool MeshXmlFilter::process_xml(bool is_final)
+{
+    // Length of "<triangles" followed by a delimiter.
+    static constexpr const size_t max_tag_len = 11;
+    // Pass the text to expat up to the first <vertices> or <triangles> start tag, hold back a tag, which may be incomplete.
+    size_t safe = m_pending.size();
+    for (size_t pos = 0;;) {
+        size_t lt = m_pending.find('<', pos);
+        if (lt == std::string::npos)
+            break;
+        const char *p    = m_pending.data() + lt;
+        size_t      left = m_pending.size() - lt;
+        if (left < max_tag_len) {
+            safe = lt;
+            break;
+        }
+        // Comments, CDATA sections and processing instructions may contain a '<'.
+        const char *skip_to = starts_with(p, left, "<!--") ? "-->" : starts_with(p, left, "<![CDATA[") ? "]]>" : starts_with(p, left, "<?") ? "?>" : nullptr;
+        if (skip_to != nullptr) {
+            if (size_t skip_end = m_pending.find(skip_to, lt + 2); skip_end == std::string::npos) {
+                safe = lt;
+                break;
+            } else
+                pos = skip_end + strlen(skip_to);
+            continue;
+        }
+        State state = matches_tag(p, left, "vertices") ? State::Vertices : matches_tag(p, left, "triangles") ? State::Triangles : State::Xml;
+        if (state == State::Xml) {
+            pos = lt + 1;
+            continue;
+        }
+        // Find the end of the start tag, the attribute values may contain '>'.
+        size_t gt    = lt + 1;
+        char   quote = 0;
+        for (; gt < m_pending.size(); ++ gt)
+            if (char c = m_pending[gt]; quote != 0) {
+                if (c == quote)
+                    quote = 0;
+            } else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '>')
+                break;
+        if (gt == m_pending.size()) {
+            safe = lt;
+            break;
+        }
+        if (m_pending[gt - 1] == '/') {
+            // Empty <vertices/> or <triangles/>.
+            pos = gt + 1;
+            continue;
+        }
+        // Let expat process the start tag, which resets the vertices resp. triangles of the current object.
+        if (! m_xml_sink(m_pending.data(), gt + 1, false))
+            return false;
+        m_pending.erase(0, gt + 1);
+        m_state       = state;
+        m_search_from = 0;
+        return this->process_mesh(is_final);
+    }
+    if (is_final)
+        // Whatever is held back, it is not a valid start of the mesh data.
+        safe = m_pending.size();
+    bool ok = m_xml_sink(m_pending.data(), safe, is_final && safe == m_pending.size());
+    m_pending.erase(0, safe);
+    return ok;
+}
+
+bool MeshXmlFilter::process_mesh(bool is_final)
+{
+    const std::string end_tag = m_state == State::Vertices ? "</vertices" : "</triangles";
+    size_t            end     = m_pending.find(end_tag, m_search_from);
+    if (end == std::string::npos) {
+        m_search_from = m_pending.size() >= end_tag.size() ? m_pending.size() - end_tag.size() + 1 : 0;
+        if (! is_final) {
+            // Cut the mesh data into chunks at a start of an element, '<' is neither allowed in the attribute values nor in text.
+            while (m_pending.size() >= ChunkSize) {
+                size_t cut = m_pending.rfind('<');
+                if (cut == 0 || cut == std::string::npos)
+                    break;
+                this->submit(cut);
+                if (! this->flush_chunks(max_chunks_in_flight()))
+                    return false;
+                if (m_state == State::Verbatim)
+                    return this->feed(nullptr, 0, false);
+            }
+            return true;
+        }
+        // Unterminated element, leave it to expat to report the error.
+        end = m_pending.size();
+    }
+    this->submit(end);
+    // The mesh data has to be passed to mesh_sink before expat processes the end tag.
+    if (! this->flush_chunks(0))
+        return false;
+    if (m_state != State::Verbatim)
+        m_state = State::Xml;
+    return this->feed(nullptr, 0, is_final);
+}
+
+void MeshXmlFilter::submit(size_t size)
+{
+    m_chunks.emplace_back(std::make_unique<Chunk>());
+    Chunk &chunk    = *m_chunks.back();
+    chunk.text.assign(m_pending, 0, size);
+    chunk.triangles = m_state == State::Triangles;
+    m_pending.erase(0, size);
+    m_search_from   = m_search_from > size ? m_search_from - size : 0;
+    chunk.task.run([&chunk, &attributes = m_triangle_attributes]() {
+        const char *begin = chunk.text.data();
+        const char *end   = begin + chunk.text.size();
+        chunk.ok   = chunk.triangles ? parse_mesh_xml_triangles(begin, end, attributes, chunk.result) : parse_mesh_xml_vertices(begin, end, chunk.result);
+        chunk.done = true;
+    });
+}
+
+bool MeshXmlFilter::flush_chunks(size_t wait_for)
+{
+    while (! m_chunks.empty()) {
+        Chunk &chunk = *m_chunks.front();
+        if (m_chunks.size() < wait_for && ! chunk.done)
+            break;
+        // Either done already, or waiting bounds the memory footprint. This thread helps with the parsing while waiting.
+        chunk.task.wait();
+        if (m_state != State::Verbatim && chunk.ok) {
+            m_num_vertices  += chunk.result.vertices.size();
+            m_num_triangles += chunk.result.triangles.size();
+            m_mesh_sink(std::move(chunk.result));
+        } else {
+            // The scanner refused the chunk, pass the rest of the file to expat verbatim.
+            m_state = State::Verbatim;
+            if (! m_xml_sink(chunk.text.data(), chunk.text.size(), false))
+                return false;
+        }
+        m_chunks.pop_front();
+    }
+    return true;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,91 @@
+#ifndef slic3r_Format_mesh_xml_parser_hpp_
+#define slic3r_Format_mesh_xml_parser_hpp_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Point.hpp"
+
+namespace Slic3r {
+
+// Parsed content of a piece of a <vertices> or <triangles> element of a 3MF model file.
+struct MeshXmlChunk
+{
+    std::vector<Vec3f>                    vertices;
+    std::vector<Vec3i>                    triangles;
+    // Values of the string attributes of the triangles requested from MeshXmlFilter, one vector per attribute,
+    // an empty string if the attribute is missing.
+    std::vector<std::vector<std::string>> triangle_attributes;
+};
+
+// Parse a sequence of <vertex x= y= z=/> resp. <triangle v1= v2= v3= .../> elements separated by white space.
+// Missing coordinates and indices are set to zero. Returns false if the text contains anything else than the plain
+// elements (comments, other elements, entity references, numbers not parsed completely...), which is left to expat.
+bool parse_mesh_xml_vertices(const char *begin, const char *end, MeshXmlChunk &out);
+bool parse_mesh_xml_triangles(const char *begin, const char *end, const std::vector<std::string> &attributes, MeshXmlChunk &out);
+
+// Sits in front of the expat parser of a 3MF model file. The content of the <vertices> and <triangles> elements,
+// which makes up the bulk of a 3MF model file, is cut into chunks of ChunkSize bytes, which are parsed in parallel
+// by parse_mesh_xml_vertices() / parse_mesh_xml_triangles() and passed to mesh_sink in order. The rest of the file
+// including the <vertices> and <triangles> tags is passed to xml_sink, thus expat still sees a valid document
+// and handles the metadata. If the scanner refuses a chunk, the text starting with that chunk is passed to xml_sink verbatim.
+// All calls, including the calls of the sinks, are made from the thread calling feed().
+class MeshXmlFilter
+{
+public:
+    // Returns false to stop parsing.
+    using XmlSink  = std::function<bool(const char *data, size_t size, bool is_final)>;
+    using MeshSink = std::function<void(MeshXmlChunk &&chunk)>;
+
+    MeshXmlFilter(std::vector<std::string> triangle_attributes, XmlSink xml_sink, MeshSink mesh_sink);
+    // Waits for the parsing tasks.
+    ~MeshXmlFilter();
+
+    // Feed the next piece of the file. Returns false if xml_sink returned false.
+    bool feed(const char *data, size_t size, bool is_final);
+
+    // Number of vertices and triangles parsed by the scanner, for statistics.
+    size_t num_vertices()  const { return m_num_vertices; }
+    size_t num_triangles() const { return m_num_triangles; }
+
+    static constexpr const size_t ChunkSize = 1024 * 1024;
+    static size_t max_chunks_in_flight();
+
+private:
+    enum class State {
+        // Looking for the start of a <vertices> or <triangles> element.
+        Xml,
+        // Collecting the content of a <vertices> resp. <triangles> element.
+        Vertices,
+        Triangles,
+        // The scanner refused a chunk, the rest of the file is passed to expat.
+        Verbatim,
+    };
+    struct Chunk;
+
+    bool process_xml(bool is_final);
+    bool process_mesh(bool is_final);
+    // Queue m_pending[0, size) for parsing.
+    void submit(size_t size);
+    // Pass the parsed chunks to mesh_sink in order, wait for the oldest chunk if wait_for is not smaller than the number of chunks in flight.
+    bool flush_chunks(size_t wait_for);
+
+    std::vector<std::string>           m_triangle_attributes;
+    XmlSink                            m_xml_sink;
+    MeshSink                           m_mesh_sink;
+    State                              m_state { State::Xml };
+    // Input not processed yet.
+    std::string                        m_pending;
+    // Position in m_pending, from which to look for the end of the <vertices> resp. <triangles> element.
+    size_t                             m_search_from { 0 };
+    std::deque<std::unique_ptr<Chunk>> m_chunks;
+    size_t                             m_num_vertices { 0 };
+    size_t                             m_num_triangles { 0 };
+};
+
+} // namespace Slic3r
+
+#endif /* slic3r_Format_mesh_xml_parser_hpp_ */
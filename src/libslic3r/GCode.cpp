@@ -5,6 +5,7 @@
 #include "ExtrusionEntity.hpp"
 #include "EdgeGrid.hpp"
 #include "Geometry/ConvexHull.hpp"
+#include "GCode/LayerGCodeSpool.hpp"
 #include "GCode/PrintExtents.hpp"
 #include "GCode/WipeTower.hpp"
 #include "ShortestPath.hpp"
@@ -14,6 +15,7 @@
 #include "libslic3r.h"
 #include "LocalesUtils.hpp"
 #include "libslic3r/format.hpp"
+#include "Trace.hpp"
 
 #include <algorithm>
 #include <cstdlib>
@@ -1562,7 +1564,7 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
 
     BOOST_LOG_TRIVIAL(info) << boost::format("Will export G-code to %1% soon") % PathSanitizer::sanitize(path);
 
-    GCodeProcessor::s_IsBBLPrinter = print->is_BBL_Printer();
+    m_processor.set_is_bbl_printer(print->is_BBL_Printer());
     m_writer.set_is_bbl_printer(print->is_BBL_Printer());
     print->set_started(psGCodeExport);
 
@@ -1691,6 +1693,8 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
 //    DoExport::update_print_estimated_times_stats(m_processor, print->m_print_statistics);
     DoExport::update_print_estimated_stats(m_processor, m_writer.extruders(), print->m_print_statistics);
     if (result != nullptr) {
+        // The G-code preview may be building the toolpaths of the previous result in the background.
+        std::lock_guard<std::mutex> lock(result->result_mutex);
         *result = std::move(m_processor.extract_result());
         // set the filename to the correct value
         result->filename = path;
@@ -2002,6 +2006,7 @@ static BambuBedType to_bambu_bed_type(BedType type)
 void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb)
 {
     PROFILE_FUNC();
+    SLIC3R_TRACE_SCOPE("GCode::_do_export", "GCode");
 
     m_print = &print;
     m_timelapse_pos_picker.init(&print,m_writer.get_xy_offset().cast<coord_t>());
@@ -3160,6 +3165,7 @@ void GCode::process_layers(
                 fc.stop();
                 return {};
             } else {
+                SLIC3R_TRACE_SCOPE_ARG("process_layer", "GCode", layer_to_print_idx);
                 const std::pair<coordf_t, std::vector<LayerToPrint>>& layer = layers_to_print[layer_to_print_idx++];
                 const LayerTools& layer_tools = tool_ordering.tools_for_layer(layer.first);
                 print.set_status(80, Slic3r::format(_(L("Generating G-code: layer %1%")), std::to_string(layer_to_print_idx)));
@@ -3180,6 +3186,7 @@ void GCode::process_layers(
     }
     const auto spiral_mode = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(
         slic3r_tbb_filtermode::serial_in_order, [&spiral_mode = *this->m_spiral_vase.get(), & layers_to_print](GCode::LayerResult in) -> GCode::LayerResult {
+            SLIC3R_TRACE_SCOPE_ARG("spiral_vase", "GCode", in.gcode_store_pos);
             spiral_mode.enable(in.spiral_vase_enable);
             bool last_layer = in.layer_id == layers_to_print.size() - 1;
             return {spiral_mode.process_layer(std::move(in.gcode), last_layer), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush, in.gcode_store_pos};
@@ -3189,6 +3196,7 @@ void GCode::process_layers(
 
     const auto parsing = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
     [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments, object_label](GCode::LayerResult in) -> GCode::LayerResult{
+        SLIC3R_TRACE_SCOPE_ARG("parse_layer", "GCode", in.gcode_store_pos);
         //record gcode
         in.gcode = gcode_editer.process_layer(std::move(in.gcode), in.not_set_additional_fan, in.layer_id, layers_extruder_adjustments[in.gcode_store_pos], object_label, in.cooling_buffer_flush, false);
          return std::move(in);
@@ -3199,9 +3207,17 @@ void GCode::process_layers(
 
     CoolingBuffer cooling_processor;
 
+    // The G-code of a layer is held from the cooling until it is written, possibly spilled into a temporary file.
+    // These are the layers in flight, or all the layers until the smoothing is done.
+    // Only the layers flushing the cooling buffer carry G-code, the others are neither spooled nor written by the smoothing.
+    LayerGCodeSpool gcode_spool(layers_to_print.size(), gcode_export_memory_limit());
+
     const auto cooling = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-    [&cooling_processor, &layers_extruder_adjustments](GCode::LayerResult in) -> GCode::LayerResult {
+    [&cooling_processor, &layers_extruder_adjustments, &gcode_spool](GCode::LayerResult in) -> GCode::LayerResult {
+        SLIC3R_TRACE_SCOPE_ARG("cooling", "GCode", in.gcode_store_pos);
         in.layer_time = cooling_processor.calculate_layer_slowdown(layers_extruder_adjustments[in.gcode_store_pos]);
+        if (in.cooling_buffer_flush)
+            gcode_spool.put(in.gcode_store_pos, std::move(in.gcode));
          return std::move(in);
     });
 
@@ -3210,6 +3226,7 @@ void GCode::process_layers(
 
     const auto build_node = tbb::make_filter<GCode::LayerResult, void>(slic3r_tbb_filtermode::serial_in_order,
     [&smooth_calculator, &layers_wall_collection, &layers_extruder_adjustments, object_label, &layers_results](GCode::LayerResult in){
+         SLIC3R_TRACE_SCOPE_ARG("build_node", "GCode", in.gcode_store_pos);
          smooth_calculator.build_node(layers_wall_collection[in.gcode_store_pos], object_label, layers_extruder_adjustments[in.gcode_store_pos]);
          layers_results[in.gcode_store_pos] = std::move(in);
          return;
@@ -3217,8 +3234,12 @@ void GCode::process_layers(
 
     // step 5: rewite
     const auto write_gocde= tbb::make_filter<GCode::LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments](GCode::LayerResult in) -> std::string {
-         return gcode_editer.write_layer_gcode(std::move(in.gcode), in.not_set_additional_fan, in.layer_id, in.layer_time, layers_extruder_adjustments[in.gcode_store_pos]);
+    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments, &gcode_spool](GCode::LayerResult in) -> std::string {
+         SLIC3R_TRACE_SCOPE_ARG("write_layer", "GCode", in.gcode_store_pos);
+         std::string out = gcode_editer.write_layer_gcode(in.cooling_buffer_flush ? gcode_spool.take(in.gcode_store_pos) : std::string(), in.not_set_additional_fan, in.layer_id, in.layer_time, layers_extruder_adjustments[in.gcode_store_pos]);
+         // The cooling lines of a layer are not needed anymore, release them not to hold all the layers until the end of the export.
+         std::vector<PerExtruderAdjustments>().swap(layers_extruder_adjustments[in.gcode_store_pos]);
+         return out;
     });
 
     std::vector<GCode::LayerResult> gcode_res;
@@ -3233,13 +3254,16 @@ void GCode::process_layers(
              if (layer_idx > 0){
                 gcode_res[layer_idx].layer_time = smooth_calculator.recaculate_layer_time(layer_idx, layers_extruder_adjustments[gcode_res[layer_idx].gcode_store_pos]);
              }
-             return gcode_res[layer_idx++];
+             return std::move(gcode_res[layer_idx++]);
         }
         });
 
 
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-    [&output_stream](std::string s) { output_stream.write(s); });
+    [&output_stream](std::string s) {
+        SLIC3R_TRACE_SCOPE("output", "GCode");
+        output_stream.write(s);
+    });
 
     // BBS: apply cooling
     // The pipeline elements are joined using const references, thus no copying is performed.
@@ -3253,13 +3277,14 @@ void GCode::process_layers(
         message = _L("Smoothing z direction speed");
         m_print->set_status(85, message);
         //append data
-        for (const LayerResult &res : layers_results) {
+        for (LayerResult &res : layers_results) {
             //remove empty gcode layer caused by support independent layers
             if (res.cooling_buffer_flush) {
-                smooth_calculator.append_data(layers_wall_collection[res.gcode_store_pos]);
+                smooth_calculator.append_data(std::move(layers_wall_collection[res.gcode_store_pos]));
                 gcode_res.push_back(std::move(res));
             }
         }
+        layers_results.clear();
 
         smooth_calculator.smooth_layer_speed();
         message = _L("Exporting G-code");
@@ -3302,6 +3327,7 @@ void GCode::process_layers(
                 fc.stop();
                 return {};
             } else {
+                SLIC3R_TRACE_SCOPE_ARG("process_layer", "GCode", layer_to_print_idx);
                 LayerToPrint &layer = layers_to_print[layer_to_print_idx ++];
                 print.set_status(80, Slic3r::format(_(L("Generating G-code: layer %1%")), std::to_string(layer_to_print_idx)));
                 //BBS
@@ -3319,6 +3345,7 @@ void GCode::process_layers(
     }
     const auto spiral_mode = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(
         slic3r_tbb_filtermode::serial_in_order, [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](GCode::LayerResult in) -> GCode::LayerResult {
+            SLIC3R_TRACE_SCOPE_ARG("spiral_vase", "GCode", in.gcode_store_pos);
             spiral_mode.enable(in.spiral_vase_enable);
             bool last_layer = in.layer_id == layers_to_print.size() - 1;
             return {spiral_mode.process_layer(std::move(in.gcode), last_layer), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush, in.gcode_store_pos};
@@ -3332,6 +3359,7 @@ void GCode::process_layers(
 
     const auto parsing = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
     [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments, object_label](GCode::LayerResult in) -> GCode::LayerResult{
+        SLIC3R_TRACE_SCOPE_ARG("parse_layer", "GCode", in.gcode_store_pos);
         //record gcode
         in.gcode = gcode_editer.process_layer(std::move(in.gcode), in.not_set_additional_fan, in.layer_id, layers_extruder_adjustments[in.gcode_store_pos], object_label, in.cooling_buffer_flush, false);
          return std::move(in);
@@ -3341,9 +3369,17 @@ void GCode::process_layers(
     std::vector<std::vector<OutwallCollection>> layers_wall_collection(layers_to_print.size());
     CoolingBuffer cooling_processor;
 
+    // The G-code of a layer is held from the cooling until it is written, possibly spilled into a temporary file.
+    // These are the layers in flight, or all the layers until the smoothing is done.
+    // Only the layers flushing the cooling buffer carry G-code, the others are neither spooled nor written by the smoothing.
+    LayerGCodeSpool gcode_spool(layers_to_print.size(), gcode_export_memory_limit());
+
     const auto cooling = tbb::make_filter<GCode::LayerResult, GCode::LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-    [&cooling_processor, &layers_extruder_adjustments](GCode::LayerResult in) -> GCode::LayerResult {
+    [&cooling_processor, &layers_extruder_adjustments, &gcode_spool](GCode::LayerResult in) -> GCode::LayerResult {
+        SLIC3R_TRACE_SCOPE_ARG("cooling", "GCode", in.gcode_store_pos);
         in.layer_time = cooling_processor.calculate_layer_slowdown(layers_extruder_adjustments[in.gcode_store_pos]);
+        if (in.cooling_buffer_flush)
+            gcode_spool.put(in.gcode_store_pos, std::move(in.gcode));
          return std::move(in);
     });
 
@@ -3352,6 +3388,7 @@ void GCode::process_layers(
 
     const auto build_node = tbb::make_filter<GCode::LayerResult, void>(slic3r_tbb_filtermode::serial_in_order,
     [&smooth_calculator, &layers_wall_collection, &layers_extruder_adjustments, object_label, &layers_results](GCode::LayerResult in){
+         SLIC3R_TRACE_SCOPE_ARG("build_node", "GCode", in.gcode_store_pos);
          smooth_calculator.build_node(layers_wall_collection[in.gcode_store_pos], object_label, layers_extruder_adjustments[in.gcode_store_pos]);
          layers_results[in.gcode_store_pos] = std::move(in);
          return;
@@ -3359,8 +3396,12 @@ void GCode::process_layers(
 
     // step 5: rewite
     const auto write_gocde= tbb::make_filter<GCode::LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments](GCode::LayerResult in) -> std::string {
-         return gcode_editer.write_layer_gcode(std::move(in.gcode), in.not_set_additional_fan, in.layer_id, in.layer_time, layers_extruder_adjustments[in.gcode_store_pos]);
+    [&gcode_editer = *this->m_gcode_editer.get(), &layers_extruder_adjustments, &gcode_spool](GCode::LayerResult in) -> std::string {
+         SLIC3R_TRACE_SCOPE_ARG("write_layer", "GCode", in.gcode_store_pos);
+         std::string out = gcode_editer.write_layer_gcode(in.cooling_buffer_flush ? gcode_spool.take(in.gcode_store_pos) : std::string(), in.not_set_additional_fan, in.layer_id, in.layer_time, layers_extruder_adjustments[in.gcode_store_pos]);
+         // The cooling lines of a layer are not needed anymore, release them not to hold all the layers until the end of the export.
+         std::vector<PerExtruderAdjustments>().swap(layers_extruder_adjustments[in.gcode_store_pos]);
+         return out;
     });
 
     std::vector<GCode::LayerResult> gcode_res;
@@ -3376,13 +3417,16 @@ void GCode::process_layers(
              if (layer_idx > 0) {
                 gcode_res[layer_idx].layer_time = smooth_calculator.recaculate_layer_time(layer_idx, layers_extruder_adjustments[gcode_res[layer_idx].gcode_store_pos]);
              }
-             return gcode_res[layer_idx++];
+             return std::move(gcode_res[layer_idx++]);
         }
         });
 
 
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-    [&output_stream](std::string s) { output_stream.write(s); });
+    [&output_stream](std::string s) {
+        SLIC3R_TRACE_SCOPE("output", "GCode");
+        output_stream.write(s);
+    });
 
     // BBS: apply cooling
     // The pipeline elements are joined using const references, thus no copying is performed.
@@ -3395,13 +3439,14 @@ void GCode::process_layers(
         // step 4.2: smoothing
         // break pipeline and do z smoothing
         // append data
-        for (const LayerResult &res : layers_results) {
+        for (LayerResult &res : layers_results) {
             // remove empty gcode layer caused by support independent layers
             if (res.cooling_buffer_flush) {
-                smooth_calculator.append_data(layers_wall_collection[res.gcode_store_pos]);
-                gcode_res.push_back(res);
+                smooth_calculator.append_data(std::move(layers_wall_collection[res.gcode_store_pos]));
+                gcode_res.push_back(std::move(res));
             }
         }
+        layers_results.clear();
 
         smooth_calculator.smooth_layer_speed();
 
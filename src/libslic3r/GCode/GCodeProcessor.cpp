@@ -3,6 +3,7 @@
 #include "libslic3r/Print.hpp"
 #include "libslic3r/LocalesUtils.hpp"
 #include "libslic3r/format.hpp"
+#include "libslic3r/Trace.hpp"
 #include "GCodeProcessor.hpp"
 
 #include <boost/log/trivial.hpp>
@@ -85,7 +86,6 @@ const std::vector<std::string> GCodeProcessor::CustomTags = {
 const float GCodeProcessor::Wipe_Width = 0.05f;
 const float GCodeProcessor::Wipe_Height = 0.05f;
 
-bool GCodeProcessor::s_IsBBLPrinter = true;
 
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
 const std::string GCodeProcessor::Mm3_Per_Mm_Tag = "MM3_PER_MM:";
@@ -680,7 +680,7 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
                     PrintEstimatedStatistics::ETimeMode mode = static_cast<PrintEstimatedStatistics::ETimeMode>(i);
                     if (mode == PrintEstimatedStatistics::ETimeMode::Normal || machine.enabled) {
                         char buf[128];
-                        if (!s_IsBBLPrinter) {
+                        if (!context.is_bbl_printer) {
                             // Klipper estimator
                             sprintf(buf, "; estimated printing time (normal mode) = %s\n",
                                 get_time_dhms(machine.time).c_str());
@@ -1486,6 +1486,15 @@ void GCodeProcessorResult::reset() {
 }
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
+void GCodeProcessorResult::release_moves()
+{
+    lock();
+    // Swap with empty vectors to release the memory, clear() would keep the capacity.
+    std::vector<MoveVertex>().swap(moves);
+    std::vector<size_t>().swap(lines_ends);
+    unlock();
+}
+
 const std::vector<std::pair<GCodeProcessor::EProducer, std::string>> GCodeProcessor::Producers = {
     //BBS: BambuStudio is also "bambu". Otherwise the time estimation didn't work.
     //FIXME: Workaround and should be handled when do removing-bambu
@@ -1501,7 +1510,7 @@ const std::vector<std::pair<GCodeProcessor::EProducer, std::string>> GCodeProces
     //{ EProducer::KissSlicer,  "KISSlicer" }
 };
 
-unsigned int GCodeProcessor::s_result_id = 0;
+std::atomic<unsigned int> GCodeProcessor::s_result_id { 0 };
 
 bool GCodeProcessor::contains_reserved_tag(const std::string& gcode, std::string& found_tag)
 {
@@ -2411,6 +2420,7 @@ DynamicConfig GCodeProcessor::export_config_for_render() const
 // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
 void GCodeProcessor::process_file(const std::string& filename, std::function<void()> cancel_callback)
 {
+    SLIC3R_TRACE_SCOPE("GCodeProcessor::process_file", "GCodeProcessor");
     CNumericLocalesSetter locales_setter;
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -2508,6 +2518,7 @@ void GCodeProcessor::initialize_from_context(const MultiNozzleUtils::MultiNozzle
 
 void GCodeProcessor::process_buffer(const std::string &buffer)
 {
+    SLIC3R_TRACE_SCOPE("GCodeProcessor::process_buffer", "GCodeProcessor");
     //FIXME maybe cache GCodeLine gline to be over multiple parse_buffer() invocations.
     m_parser.parse_buffer(buffer, [this](GCodeReader&, const GCodeReader::GCodeLine& line) {
         this->process_gcode_line(line, false);
@@ -2516,6 +2527,7 @@ void GCodeProcessor::process_buffer(const std::string &buffer)
 
 void GCodeProcessor::finalize(bool post_process)
 {
+    SLIC3R_TRACE_SCOPE("GCodeProcessor::finalize", "GCodeProcessor");
     // update width/height of wipe moves
     for (GCodeProcessorResult::MoveVertex& move : m_result.moves) {
         if (move.type == EMoveType::Wipe) {
@@ -2580,6 +2592,7 @@ void GCodeProcessor::finalize(bool post_process)
             m_extruder_max_nozzle_count,
             m_filament_cooling_before_tower
         );
+        context.is_bbl_printer = m_is_bbl_printer;
         m_time_processor.post_process(m_result.filename, m_result.moves, m_result.lines_ends, context);
     }
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -4991,7 +5004,7 @@ void GCodeProcessor::process_G4(const GCodeReader::GCodeLine& line)
 //BBS
 void GCodeProcessor::process_G29(const GCodeReader::GCodeLine& line)
 {
-    if (s_IsBBLPrinter){
+    if (m_is_bbl_printer){
         if(m_measure_g29_time)
             simulate_st_synchronize(m_time_processor.prepare_compensation_time);
     }
@@ -9,6 +9,7 @@
 #include "libslic3r/Extruder.hpp"
 #include "libslic3r/MultiNozzleUtils.hpp"
 
+#include <atomic>
 #include <cstdint>
 #include <array>
 #include <vector>
@@ -291,9 +292,12 @@ namespace Slic3r {
         int64_t time{ 0 };
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
         void reset();
+        // Releases the moves and the line ends, which are only read by the preview once the G-code was finalized.
+        void release_moves();
 
         //BBS: add mutex for protection of gcode result
         mutable std::mutex result_mutex;
+        // The caller holds result_mutex, the moves may be read by the toolpath builder of the G-code preview.
         GCodeProcessorResult& operator=(const GCodeProcessorResult &other)
         {
             filename = other.filename;
@@ -471,8 +475,6 @@ namespace Slic3r {
         static const float Wipe_Width;
         static const float Wipe_Height;
 
-        static bool s_IsBBLPrinter;
-
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
         static const std::string Mm3_Per_Mm_Tag;
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
@@ -734,6 +736,8 @@ namespace Slic3r {
             float inject_time_threshold{ 30.f }; // only active pre cooling & heating if time gap is bigger than threshold
             bool enable_pre_heating{ false };
             std::vector<int> extruder_max_nozzle_count { 1 };
+            // BBS and Klipper printers report the estimated printing time differently.
+            bool is_bbl_printer{ true };
 
             TimeProcessContext(
                 const UsedFilaments& used_filaments_,
@@ -1121,6 +1125,7 @@ namespace Slic3r {
         bool m_detect_layer_based_on_tag {false};
         int m_seams_count;
         bool m_measure_g29_time {false};
+        bool m_is_bbl_printer {true};
 #if ENABLE_GCODE_VIEWER_STATISTICS
         std::chrono::time_point<std::chrono::high_resolution_clock> m_start_time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
@@ -1146,7 +1151,8 @@ namespace Slic3r {
         UsedFilaments m_used_filaments;
 
         GCodeProcessorResult m_result;
-        static unsigned int s_result_id;
+        // Shared by the processors of the plates exported in parallel.
+        static std::atomic<unsigned int> s_result_id;
 
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
         DataChecker m_mm3_per_mm_compare{ "mm3_per_mm", 0.01f };
@@ -1176,6 +1182,7 @@ namespace Slic3r {
             return m_time_processor.machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Stealth)].enabled;
         }
         void enable_machine_envelope_processing(bool enabled) { m_time_processor.machine_envelope_processing_enabled = enabled; }
+        void set_is_bbl_printer(bool is_bbl_printer) { m_is_bbl_printer = is_bbl_printer; }
         void reset();
 
         const GCodeProcessorResult& get_result() const { return m_result; }
@@ -0,0 +1,104 @@
+#include "LayerGCodeSpool.hpp"
+#include "../Exception.hpp"
+
+#include <atomic>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+namespace Slic3r {
+
+static std::atomic<size_t>& gcode_export_memory_limit_state()
+{
+    static std::atomic<size_t> limit { [] {
+        size_t out = 0;
+        if (const char *env = ::getenv("SLIC3R_GCODE_MEMORY_LIMIT_MB"); env != nullptr) {
+            char *end = nullptr;
+            unsigned long long mb = std::strtoull(env, &end, 10);
+            if (end != env && *end == 0)
+                out = size_t(mb) << 20;
+            else
+                BOOST_LOG_TRIVIAL(error) << "Invalid SLIC3R_GCODE_MEMORY_LIMIT_MB \"" << env << "\", the G-code export memory is not limited.";
+        }
+        return out;
+    }() };
+    return limit;
+}
+
+size_t gcode_export_memory_limit() { return gcode_export_memory_limit_state().load(std::memory_order_relaxed); }
+void   set_gcode_export_memory_limit(size_t bytes) { gcode_export_memory_limit_state().store(bytes, std::memory_order_relaxed); }
+
+static bool seek_file(FILE *file, long long offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+}
+
+LayerGCodeSpool::LayerGCodeSpool(size_t num_layers, size_t memory_limit) :
+    m_entries(num_layers), m_memory_limit(memory_limit)
+{}
+
+LayerGCodeSpool::~LayerGCodeSpool()
+{
+    if (m_file != nullptr) {
+        fclose(m_file);
+        boost::system::error_code ec;
+        boost::filesystem::remove(m_path, ec);
+        BOOST_LOG_TRIVIAL(debug) << "Layer G-code spool: " << m_spilled_bytes << " bytes were spilled to " << m_path;
+    }
+}
+
+void LayerGCodeSpool::open_file()
+{
+    m_path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slic3r_gcode_%%%%-%%%%-%%%%.tmp")).string();
+    m_file = boost::nowide::fopen(m_path.c_str(), "w+b");
+    if (m_file == nullptr)
+        throw Slic3r::RuntimeError(std::string("G-code export failed.\nCannot open the temporary file ") + m_path + " for writing.\n");
+}
+
+void LayerGCodeSpool::put(size_t layer_idx, std::string &&gcode)
+{
+    std::scoped_lock lock(m_mutex);
+    Entry &entry = m_entries[layer_idx];
+    assert(entry.gcode.empty() && ! entry.spilled);
+    if (m_memory_limit == 0 || m_held_bytes + gcode.size() <= m_memory_limit) {
+        m_held_bytes += gcode.size();
+        entry.gcode = std::move(gcode);
+        return;
+    }
+    if (m_file == nullptr)
+        this->open_file();
+    entry.spilled = true;
+    entry.offset  = (long long)m_spilled_bytes;
+    entry.size    = gcode.size();
+    if (! seek_file(m_file, entry.offset) || fwrite(gcode.data(), 1, gcode.size(), m_file) != gcode.size())
+        throw Slic3r::RuntimeError(std::string("G-code export failed.\nCannot write the temporary file ") + m_path + ".\n");
+    m_spilled_bytes += gcode.size();
+    // Release the memory.
+    std::string().swap(gcode);
+}
+
+std::string LayerGCodeSpool::take(size_t layer_idx)
+{
+    std::scoped_lock lock(m_mutex);
+    Entry &entry = m_entries[layer_idx];
+    std::string out;
+    if (entry.spilled) {
+        out.resize(entry.size);
+        if (! seek_file(m_file, entry.offset) || fread(out.data(), 1, entry.size, m_file) != entry.size)
+            throw Slic3r::RuntimeError(std::string("G-code export failed.\nCannot read the temporary file ") + m_path + ".\n");
+        entry.spilled = false;
+    } else {
+        m_held_bytes -= entry.gcode.size();
+        out = std::move(entry.gcode);
+        entry.gcode = std::string();
+    }
+    return out;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,68 @@
+// G-code of the layers held back by the G-code export, until it may be written.
+// Above a memory limit, the G-code is spilled into a temporary file.
+
+#ifndef slic3r_LayerGCodeSpool_hpp_
+#define slic3r_LayerGCodeSpool_hpp_
+
+#include "../libslic3r.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+// Limit of the layer G-code held in memory by the G-code export in bytes, zero for no limit.
+// Initialized from the SLIC3R_GCODE_MEMORY_LIMIT_MB environment variable.
+size_t gcode_export_memory_limit();
+void   set_gcode_export_memory_limit(size_t bytes);
+
+// Holds the G-code of the layers between the cooling and the writing stage of the export pipeline, that is all the layers
+// with the Z smoothing of the outer wall speed, or the layers in flight otherwise.
+// The spool keeps the G-code of the layers in memory up to memory_limit bytes, the G-code of the following layers
+// is appended to a temporary file, which is removed when the spool is destroyed.
+// A layer may be put by one pipeline filter while another one is taken by another filter.
+class LayerGCodeSpool
+{
+public:
+    LayerGCodeSpool(size_t num_layers, size_t memory_limit);
+    ~LayerGCodeSpool();
+
+    LayerGCodeSpool(const LayerGCodeSpool &) = delete;
+    LayerGCodeSpool &operator=(const LayerGCodeSpool &) = delete;
+
+    // Stores the G-code of a layer, each layer may be put once.
+    void        put(size_t layer_idx, std::string &&gcode);
+    // Returns the G-code of a layer and releases it, each layer may be taken once.
+    std::string take(size_t layer_idx);
+
+    // G-code currently held in memory.
+    size_t      held_bytes()    const { std::scoped_lock lock(m_mutex); return m_held_bytes; }
+    // G-code written into the temporary file so far.
+    size_t      spilled_bytes() const { std::scoped_lock lock(m_mutex); return m_spilled_bytes; }
+
+private:
+    struct Entry
+    {
+        std::string gcode;
+        // Position in the temporary file if spilled.
+        bool        spilled { false };
+        long long   offset  { 0 };
+        size_t      size    { 0 };
+    };
+
+    void        open_file();
+
+    std::vector<Entry> m_entries;
+    size_t             m_memory_limit;
+    size_t             m_held_bytes    { 0 };
+    size_t             m_spilled_bytes { 0 };
+    std::string        m_path;
+    FILE              *m_file { nullptr };
+    mutable std::mutex m_mutex;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_LayerGCodeSpool_hpp_
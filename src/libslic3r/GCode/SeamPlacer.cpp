@@ -9,6 +9,7 @@
 #include <queue>
 
 #include "libslic3r/AABBTreeLines.hpp"
+#include "libslic3r/AABBTreeWide.hpp"
 #include "libslic3r/KDTreeIndirect.hpp"
 #include "libslic3r/ExtrusionEntity.hpp"
 #include "libslic3r/Print.hpp"
@@ -152,12 +153,17 @@ std::vector<float> raycast_visibility(const AABBTreeIndirect::Tree<3, float> &ra
     }
 
     bool model_contains_negative_parts = negative_volumes_start_index < triangles.indices.size();
+    // The rays of a sample share their origin, thus without the negative volumes they are traced in packets over a BVH4 tree.
+    AABBTreeIndirect::Tree3fBVH4 wide_tree;
+    if (!model_contains_negative_parts)
+        wide_tree.build(raycasting_tree);
 
     std::vector<float> result(samples.positions.size());
     tbb::parallel_for(tbb::blocked_range<size_t>(0, result.size()), [&triangles, &precomputed_sample_directions, model_contains_negative_parts, negative_volumes_start_index,
-                                                                     &raycasting_tree, &result, &samples](tbb::blocked_range<size_t> r) {
+                                                                     &raycasting_tree, &wide_tree, &result, &samples](tbb::blocked_range<size_t> r) {
         // Maintaining hits memory outside of the loop, so it does not have to be reallocated for each query.
         std::vector<igl::Hit> hits;
+        std::vector<Vec3d>    ray_dirs;
         for (size_t s_idx = r.begin(); s_idx < r.end(); ++s_idx) {
             result[s_idx]                 = 1.0f;
             constexpr float decrease_step = 1.0f / (SeamPlacer::sqr_rays_per_sample_point * SeamPlacer::sqr_rays_per_sample_point);
@@ -168,17 +174,21 @@ std::vector<float> raycast_visibility(const AABBTreeIndirect::Tree<3, float> &ra
             Frame f;
             f.set_from_z(normal);
 
-            for (const auto &dir : precomputed_sample_directions) {
-                Vec3f final_ray_dir = (f.to_world(dir));
-                if (!model_contains_negative_parts) {
-                    igl::Hit hitpoint;
-                    // FIXME: This AABBTTreeIndirect query will not compile for float ray origin and
-                    // direction.
-                    Vec3d final_ray_dir_d = final_ray_dir.cast<double>();
-                    Vec3d ray_origin_d    = (center + normal * 0.01f).cast<double>(); // start above surface.
-                    bool  hit = AABBTreeIndirect::intersect_ray_first_hit(triangles.vertices, triangles.indices, raycasting_tree, ray_origin_d, final_ray_dir_d, hitpoint);
-                    if (hit && its_face_normal(triangles, hitpoint.id).dot(final_ray_dir) <= 0) { result[s_idx] -= decrease_step; }
-                } else { // TODO improve logic for order based boolean operations - consider order of volumes
+            if (!model_contains_negative_parts) {
+                // FIXME: This AABBTTreeIndirect query will not compile for float ray origin and
+                // direction.
+                ray_dirs.clear();
+                for (const auto &dir : precomputed_sample_directions)
+                    ray_dirs.emplace_back(f.to_world(dir).cast<double>());
+                Vec3d ray_origin_d = (center + normal * 0.01f).cast<double>(); // start above surface.
+                AABBTreeIndirect::intersect_ray_fan_first_hits<4>(triangles.vertices, triangles.indices, wide_tree, ray_origin_d, ray_dirs,
+                    [&](size_t ray_idx, const igl::Hit &hitpoint) {
+                        if (its_face_normal(triangles, hitpoint.id).dot(ray_dirs[ray_idx].cast<float>()) <= 0) { result[s_idx] -= decrease_step; }
+                    });
+            } else {
+                for (const auto &dir : precomputed_sample_directions) {
+                    Vec3f final_ray_dir = (f.to_world(dir));
+                    // TODO improve logic for order based boolean operations - consider order of volumes
                     bool casting_from_negative_volume = samples.triangle_indices[s_idx] >= negative_volumes_start_index;
 
                     Vec3d ray_origin_d = (center + normal * 0.01f).cast<double>(); // start above surface.
@@ -58,6 +58,11 @@ public:
         layers_wall_collection.push_back(wall_collection);
     }
 
+    void append_data(std::vector<OutwallCollection> &&wall_collection)
+    {
+        layers_wall_collection.push_back(std::move(wall_collection));
+    }
+
     void build_node(std::vector<OutwallCollection> &wall_collection, const std::vector<int> &object_label, const std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
 
     float recaculate_layer_time(int layer_id, std::vector<PerExtruderAdjustments> &extruder_adjustments);
@@ -24,6 +24,9 @@
 #include <libslic3r.h>
 #include <boost/log/trivial.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 namespace Slic3r {
 
     //! macro used to mark string used at localization,
@@ -645,17 +648,26 @@ void ToolOrdering::collect_extruders(const PrintObject &object, const std::vecto
     unsigned int extruder_override = 0;
 
     // BBS: collect first layer extruders of an object's wall, which will be used by brim generator
-    int layerCount = 0;
     std::vector<int> firstLayerExtruders;
     firstLayerExtruders.clear();
 
-    // Collect the object extruders.
-    for (auto layer : object.layers()) {
-        LayerTools &layer_tools = this->tools_for_layer(layer->print_z);
-
+    // Resolve the LayerTools and the extruder override of the object layers first, then the layers are processed in parallel.
+    std::vector<LayerTools*>  layers_tools(object.layer_count(), nullptr);
+    std::vector<unsigned int> layers_extruder_override(object.layer_count(), 0);
+    for (size_t layer_idx = 0; layer_idx < object.layer_count(); ++ layer_idx) {
+        const Layer *layer = object.get_layer(int(layer_idx));
+        layers_tools[layer_idx] = &this->tools_for_layer(layer->print_z);
         // Override extruder with the next
     	for (; it_per_layer_extruder_override != per_layer_extruder_switches.end() && it_per_layer_extruder_override->first < layer->print_z + EPSILON; ++ it_per_layer_extruder_override)
     		extruder_override = (int)it_per_layer_extruder_override->second;
+        layers_extruder_override[layer_idx] = extruder_override;
+    }
+
+    // Collect the object extruders.
+    auto collect_layer_extruders = [this, &object, &layers_tools, &layers_extruder_override, &firstLayerExtruders](size_t layer_idx) {
+        const Layer  *layer             = object.get_layer(int(layer_idx));
+        LayerTools   &layer_tools       = *layers_tools[layer_idx];
+        unsigned int  extruder_override = layers_extruder_override[layer_idx];
 
         // Store the current extruder override (set to zero if no overriden), so that layer_tools.wiping_extrusions().is_overridable_and_mark() will use it.
         layer_tools.extruder_override = extruder_override;
@@ -681,7 +693,7 @@ void ToolOrdering::collect_extruders(const PrintObject &object, const std::vecto
 
                 if (something_nonoverriddable){
                		layer_tools.extruders.emplace_back((extruder_override == 0) ? region.config().wall_filament.value : extruder_override);
-                    if (layerCount == 0) {
+                    if (layer_idx == 0) {
                         firstLayerExtruders.emplace_back((extruder_override == 0) ? region.config().wall_filament.value : extruder_override);
                     }
                 }
@@ -722,13 +734,23 @@ void ToolOrdering::collect_extruders(const PrintObject &object, const std::vecto
             if (has_solid_infill || has_infill)
                 layer_tools.has_object = true;
         }
-        layerCount++;
-    }
+    };
+    // The layers of an object map to distinct LayerTools, unless their print_z differ by less than EPSILON.
+    if (std::adjacent_find(layers_tools.begin(), layers_tools.end()) == layers_tools.end())
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, layers_tools.size()), [&collect_layer_extruders](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                collect_layer_extruders(layer_idx);
+        });
+    else
+        for (size_t layer_idx = 0; layer_idx < layers_tools.size(); ++ layer_idx)
+            collect_layer_extruders(layer_idx);
 
     sort_remove_duplicates(firstLayerExtruders);
     const_cast<PrintObject&>(object).object_first_layer_wall_extruders = firstLayerExtruders;
 
     // Collect the support extruders.
+    std::vector<unsigned int>       all_extruders;
+    std::vector<std::vector<float>> wipe_volumes;
     for (auto support_layer : object.support_layers()) {
         LayerTools   &layer_tools   = this->tools_for_layer(support_layer->print_z);
         ExtrusionRole role          = support_layer->support_fills.role();
@@ -746,15 +768,17 @@ void ToolOrdering::collect_extruders(const PrintObject &object, const std::vecto
             if (extruder_support > 0 || !has_interface || extruder_interface == 0 || layer_tools.has_object)
                 layer_tools.extruders.push_back(extruder_support);
             else {
-                auto all_extruders     = object.print()->extruders();
-                auto get_next_extruder = [&](int current_extruder, const std::vector<unsigned int> &extruders) {
+                if (all_extruders.empty()) {
+                    // Computed once for all the support layers.
+                    all_extruders = object.print()->extruders();
                     std::vector<float> flush_matrix(
                         cast<float>(get_flush_volumes_matrix(object.print()->config().flush_volumes_matrix.values, 0, object.print()->config().nozzle_diameter.values.size())));
                     const unsigned int number_of_extruders = (unsigned int) (sqrt(flush_matrix.size()) + EPSILON);
                     // Extract purging volumes for each extruder pair:
-                    std::vector<std::vector<float>> wipe_volumes;
                     for (unsigned int i = 0; i < number_of_extruders; ++i)
                         wipe_volumes.push_back(std::vector<float>(flush_matrix.begin() + i * number_of_extruders, flush_matrix.begin() + (i + 1) * number_of_extruders));
+                }
+                auto get_next_extruder = [&](int current_extruder, const std::vector<unsigned int> &extruders) {
                     int   next_extruder = current_extruder;
                     float min_flush     = std::numeric_limits<float>::max();
                     for (auto extruder_id : extruders) {
@@ -1541,13 +1565,15 @@ void ToolOrdering::mark_skirt_layers(const PrintConfig &config, coordf_t max_lay
 // If multiple events are planned over a span of a single layer, use the last one.
 
 // BBS: replace model custom gcode with current plate custom gcode
-static CustomGCode::Info custom_gcode_per_print_z;
 void ToolOrdering::assign_custom_gcodes(const Print& print)
 {
     // Only valid for non-sequential print.
     assert(print.config().print_sequence == PrintSequence::ByLayer);
 
-    custom_gcode_per_print_z = print.model().get_curr_plate_custom_gcodes();
+    // Owned by the ToolOrdering, the plates sliced in parallel have their own.
+    auto custom_gcodes = std::make_shared<CustomGCode::Info>(print.model().get_curr_plate_custom_gcodes());
+    m_custom_gcodes = custom_gcodes;
+    const CustomGCode::Info &custom_gcode_per_print_z = *custom_gcodes;
     if (custom_gcode_per_print_z.gcodes.empty())
         return;
 
@@ -5,6 +5,7 @@
 
 #include "../libslic3r.h"
 
+#include <memory>
 #include <utility>
 
 #include <boost/container/small_vector.hpp>
@@ -17,7 +18,7 @@ namespace Slic3r {
 class Print;
 class PrintObject;
 class LayerTools;
-namespace CustomGCode { struct Item; }
+namespace CustomGCode { struct Item; struct Info; }
 class PrintRegion;
 
 // Object of this class holds information about whether an extrusion is printed immediately
@@ -286,6 +287,8 @@ private:
     const PrintObject*         m_print_object_ptr = nullptr;
     Print*                     m_print;
     bool                       m_sorted = false;
+    // Custom G-codes of the plate, LayerTools::custom_gcode points into them. Shared by the copies of the ToolOrdering.
+    std::shared_ptr<const CustomGCode::Info> m_custom_gcodes;
 
     FilamentChangeStats        m_stats_by_single_extruder;
     FilamentChangeStats        m_stats_by_multi_extruder_curr;
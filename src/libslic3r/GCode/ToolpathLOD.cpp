@@ -0,0 +1,35 @@
+#include "ToolpathLOD.hpp"
+
+namespace Slic3r {
+namespace ToolpathLOD {
+
+size_t select_level(float pixel_size, float max_error_pixels)
+{
+    const float max_error = max_error_pixels * pixel_size;
+    for (size_t level = LevelsCount - 1; level > 0; -- level)
+        if (level_tolerance(level) <= max_error)
+            return level;
+    return 0;
+}
+
+float pixel_size(const Transform3d &view_matrix, const Transform3d &projection_matrix, int viewport_height, const BoundingBoxf3 &box)
+{
+    const double scale = projection_matrix.matrix()(1, 1) * double(viewport_height);
+    if (! box.defined || scale <= 0.)
+        return 0.f;
+    // The clip space w is the depth for the perspective projection and one for the orthographic projection,
+    // being an affine function of the position its minimum over the box is found at one of the corners.
+    const Eigen::Matrix<double, 1, 4> w_row = projection_matrix.matrix().row(3) * view_matrix.matrix();
+    double min_w = std::numeric_limits<double>::max();
+    for (int i = 0; i < 8; ++ i) {
+        const Vec3d corner((i & 1) ? box.max.x() : box.min.x(), (i & 2) ? box.max.y() : box.min.y(), (i & 4) ? box.max.z() : box.min.z());
+        min_w = std::min(min_w, w_row.head<3>().dot(corner) + w_row(3));
+    }
+    // Box crossing the camera plane, render it in full detail.
+    if (min_w <= EPSILON)
+        return 0.f;
+    return float(2. * min_w / scale);
+}
+
+} // namespace ToolpathLOD
+} // namespace Slic3r
@@ -0,0 +1,141 @@
+// Levels of detail of the toolpaths rendered by the G-code preview.
+// Kept in libslic3r, so that the simplification is testable without an OpenGL context.
+
+#ifndef slic3r_ToolpathLOD_hpp_
+#define slic3r_ToolpathLOD_hpp_
+
+#include "../libslic3r.h"
+#include "../Point.hpp"
+#include "../BoundingBox.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Slic3r {
+namespace ToolpathLOD {
+
+// Number of the levels of detail including the full resolution level 0.
+static constexpr size_t LevelsCount = 4;
+
+// Geometric error allowed for a level of detail in millimeters, zero for the full resolution.
+inline float level_tolerance(size_t level) { return level == 0 ? 0.f : 0.05f * float(1 << (2 * (level - 1))); }
+
+// Returns the coarsest level of detail, which error does not exceed max_error_pixels on the screen.
+size_t select_level(float pixel_size, float max_error_pixels = 0.5f);
+
+// Size of a screen pixel in world units at the point of the box closest to the camera,
+// thus the level of detail selected for the whole box is conservative.
+// Works for both the perspective and the orthographic projections.
+float pixel_size(const Transform3d &view_matrix, const Transform3d &projection_matrix, int viewport_height, const BoundingBoxf3 &box);
+
+// Number of the steps, to which the attribute colored by the preview (speed, width, fan speed...) is quantized
+// to tell the instances apart, which are not to be merged by a level of detail.
+static constexpr uint32_t AttributeSteps = 64;
+
+// Step of value in the range [min_value, max_value], zero for an empty range.
+inline uint32_t quantize_attribute(float value, float min_value, float max_value)
+{
+    if (! (max_value > min_value))
+        return 0;
+    const float t = std::clamp((value - min_value) / (max_value - min_value), 0.f, 1.f);
+    return std::min(uint32_t(t * float(AttributeSteps)), AttributeSteps - 1);
+}
+
+// The preview renders a toolpath as instances of 4 floats: the index of the first vertex, the index of the second vertex,
+// a flag whether the instance continues a previous one and the index of the first vertex of that previous instance.
+// Consecutive instances sharing a vertex form a chain, the chains of vertices with the same key (move type, extrusion role, extruder, attribute of the view)
+// are simplified by Douglas-Peucker with the given tolerance, chains shorter than the tolerance are dropped as sub-pixel details.
+//
+// position(vertex_index) returns the position of a vertex, key(vertex_index) returns an integral key of the attributes of the instance
+// ending at the vertex. Returns the number of the instances written into out.
+template<typename PositionFn, typename KeyFn>
+size_t simplify_instances(const std::vector<float> &instances, float tolerance, PositionFn &&position, KeyFn &&key, std::vector<float> &out)
+{
+    out.clear();
+    const size_t instances_count = instances.size() / 4;
+    auto first_of  = [&instances](size_t i) { return uint32_t(instances[4 * i]); };
+    auto second_of = [&instances](size_t i) { return uint32_t(instances[4 * i + 1]); };
+
+    const float          tolerance_sqr = tolerance * tolerance;
+    std::vector<uint32_t> chain;
+    std::vector<Vec3f>    points;
+    std::vector<bool>     keep;
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t begin = 0; begin < instances_count;) {
+        const auto chain_key = key(second_of(begin));
+        size_t end = begin + 1;
+        while (end < instances_count && first_of(end) == second_of(end - 1) && key(second_of(end)) == chain_key)
+            ++ end;
+
+        chain.clear();
+        points.clear();
+        chain.emplace_back(first_of(begin));
+        for (size_t i = begin; i < end; ++ i)
+            chain.emplace_back(second_of(i));
+        float length = 0.f;
+        for (uint32_t vertex : chain) {
+            points.emplace_back(position(vertex));
+            if (points.size() > 1)
+                length += (points.back() - points[points.size() - 2]).norm();
+        }
+
+        if (length >= tolerance) {
+            keep.assign(chain.size(), tolerance <= 0.f);
+            keep.front() = true;
+            keep.back()  = true;
+            stack.clear();
+            if (chain.size() > 2 && tolerance > 0.f)
+                stack.emplace_back(0, chain.size() - 1);
+            while (! stack.empty()) {
+                const auto [i0, i1] = stack.back();
+                stack.pop_back();
+                const Vec3f  a       = points[i0];
+                const Vec3f  ab      = points[i1] - a;
+                const float  ab_sqr  = ab.squaredNorm();
+                float        max_sqr = -1.f;
+                size_t       max_idx = i0;
+                for (size_t i = i0 + 1; i < i1; ++ i) {
+                    const Vec3f ap = points[i] - a;
+                    // Distance to the segment, a closed loop degenerates to the distance to a point.
+                    const float t = ab_sqr > 0.f ? std::clamp(ap.dot(ab) / ab_sqr, 0.f, 1.f) : 0.f;
+                    const float d = (ap - t * ab).squaredNorm();
+                    if (d > max_sqr) {
+                        max_sqr = d;
+                        max_idx = i;
+                    }
+                }
+                if (max_sqr > tolerance_sqr) {
+                    keep[max_idx] = true;
+                    if (max_idx - i0 > 1)
+                        stack.emplace_back(i0, max_idx);
+                    if (i1 - max_idx > 1)
+                        stack.emplace_back(max_idx, i1);
+                }
+            }
+
+            // The first instance keeps its link to the instance preceding the chain, the others link to the previous kept instance.
+            float    has_prev   = instances[4 * begin + 2];
+            float    prev_first = instances[4 * begin + 3];
+            if (has_prev != 0.f && ! out.empty() && uint32_t(out[out.size() - 3]) == chain.front())
+                prev_first = out[out.size() - 4];
+            uint32_t last_kept  = chain.front();
+            for (size_t i = 1; i < chain.size(); ++ i)
+                if (keep[i]) {
+                    out.emplace_back(float(last_kept));
+                    out.emplace_back(float(chain[i]));
+                    out.emplace_back(has_prev);
+                    out.emplace_back(prev_first);
+                    has_prev   = 1.f;
+                    prev_first = float(last_kept);
+                    last_kept  = chain[i];
+                }
+        }
+        begin = end;
+    }
+    return out.size() / 4;
+}
+
+} // namespace ToolpathLOD
+} // namespace Slic3r
+
+#endif // slic3r_ToolpathLOD_hpp_
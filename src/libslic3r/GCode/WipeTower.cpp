@@ -538,18 +538,14 @@ public:
         m_filpar(filament_parameters)
         {
             // adds tag for analyzer:
-            std::ostringstream str;
-            str << ";" << GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Height) << std::to_string(m_layer_height) << "\n"; // don't rely on GCodeAnalyzer knowing the layer height - it knows nothing at priming
-            str << ";" << GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role) << ExtrusionEntity::role_to_string(erWipeTower) << "\n";
-            m_gcode += str.str();
+            m_gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Height) + std::to_string(m_layer_height) + "\n"; // don't rely on GCodeAnalyzer knowing the layer height - it knows nothing at priming
+            m_gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role) + ExtrusionEntity::role_to_string(erWipeTower) + "\n";
             change_analyzer_line_width(line_width);
     }
 
     WipeTowerWriter& change_analyzer_line_width(float line_width) {
         // adds tag for analyzer:
-        std::stringstream str;
-        str << ";" << GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Width) << std::to_string(line_width) << "\n";
-        m_gcode += str.str();
+        m_gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Width) + std::to_string(line_width) + "\n";
         return *this;
     }
 
@@ -1315,20 +1311,20 @@ private:
 	std::string   set_format_X(float x)
     {
         m_current_pos.x() = x;
-        return " X" + Slic3r::float_to_string_decimal_point(x, 3);
+        return format_axis('X', x, 3);
 	}
 
 	std::string   set_format_Y(float y) {
         m_current_pos.y() = y;
-        return " Y" + Slic3r::float_to_string_decimal_point(y, 3);
+        return format_axis('Y', y, 3);
 	}
 
 	std::string   set_format_Z(float z) {
-        return " Z" + Slic3r::float_to_string_decimal_point(z, 3);
+        return format_axis('Z', z, 3);
 	}
 
 	std::string   set_format_E(float e) {
-        return " E" + Slic3r::float_to_string_decimal_point(e, 4);
+        return format_axis('E', e, 4);
 	}
 
 	std::string   set_format_F(float f) {
@@ -1337,8 +1333,13 @@ private:
         m_current_feedrate = f;
         return buf;
 	}
-    std::string set_format_I(float i) { return " I" + Slic3r::float_to_string_decimal_point(i, 3); }
-    std::string set_format_J(float j) { return " J" + Slic3r::float_to_string_decimal_point(j, 3); }
+    std::string set_format_I(float i) { return format_axis('I', i, 3); }
+    std::string set_format_J(float j) { return format_axis('J', j, 3); }
+
+    static std::string format_axis(char axis, float value, int digits)
+    {
+        return std::string(" ") + axis + Slic3r::float_to_string_decimal_point_fixed(value, digits);
+    }
 
 	WipeTowerWriter& operator=(const WipeTowerWriter &rhs);
 
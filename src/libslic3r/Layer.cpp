@@ -21,6 +21,58 @@ Layer::~Layer()
     m_regions.clear();
 }
 
+void InterlayerDelta::build(const ExPolygons &lslices, const ExPolygons *lower_lslices)
+{
+    this->clear();
+    m_lower_lslices = lower_lslices;
+    m_unsupported   = lower_lslices == nullptr ? lslices : diff_ex(lslices, *lower_lslices);
+    m_unsupported_bboxes.reserve(m_unsupported.size());
+    for (const ExPolygon &expoly : m_unsupported) {
+        m_unsupported_bboxes.emplace_back(get_extents(expoly.contour));
+        m_unsupported_bbox.merge(m_unsupported_bboxes.back());
+    }
+    m_valid = true;
+}
+
+void InterlayerDelta::clear()
+{
+    m_valid         = false;
+    m_lower_lslices = nullptr;
+    m_unsupported.clear();
+    m_unsupported_bboxes.clear();
+    m_unsupported_bbox = BoundingBox();
+    this->release_offsets();
+}
+
+bool InterlayerDelta::unsupported_overlaps(const BoundingBox &bbox) const
+{
+    assert(m_valid);
+    if (m_unsupported.empty() || ! m_unsupported_bbox.overlap(bbox))
+        return false;
+    for (const BoundingBox &unsupported_bbox : m_unsupported_bboxes)
+        if (unsupported_bbox.overlap(bbox))
+            return true;
+    return false;
+}
+
+const Polygons& InterlayerDelta::lower_slices_offset(float delta) const
+{
+    assert(m_valid);
+    std::lock_guard<std::mutex> lock(m_offsets_mutex);
+    for (const auto &[offset_delta, polygons] : m_lower_offsets)
+        if (offset_delta == delta)
+            return *polygons;
+    // Offsetting under the lock does not block anyone, the regions of a layer are processed serially.
+    m_lower_offsets.emplace_back(delta, std::make_unique<Polygons>(m_lower_lslices == nullptr ? Polygons() : offset(*m_lower_lslices, delta)));
+    return *m_lower_offsets.back().second;
+}
+
+void InterlayerDelta::release_offsets()
+{
+    std::lock_guard<std::mutex> lock(m_offsets_mutex);
+    m_lower_offsets.clear();
+}
+
 // Test whether whether there are any slices assigned to this layer.
 bool Layer::empty() const
 {
@@ -569,6 +621,9 @@ coordf_t Layer::get_sparse_infill_max_void_area()
             case ipRectilinear:
             case ipLine:
             case ipGyroid:
+            case ipSchwarzP:
+            case ipSchwarzD:
+            case ipNeovius:
             case ipAlignedRectilinear:
             case ipOctagramSpiral:
             case ipHilbertCurve:
@@ -9,6 +9,9 @@
 #include "RegionExpansion.hpp"
 #include <libslic3r/Print.hpp>
 
+#include <memory>
+#include <mutex>
+
 namespace Slic3r {
 
 class ExPolygon;
@@ -126,6 +129,38 @@ private:
     const PrintRegion *m_region;
 };
 
+// Difference of the islands of a layer against the islands of the layer below, built once after posSlice.
+// Queried by the detection of the bottom surfaces, of the overhanging perimeters and of the overhangs for lift,
+// so that these do not clip the same pair of layers again for each region.
+class InterlayerDelta
+{
+public:
+    void                            build(const ExPolygons &lslices, const ExPolygons *lower_lslices);
+    void                            clear();
+    // Not built for the layers loaded from a cache, then the consumers clip the layers themselves.
+    bool                            valid() const { return m_valid; }
+
+    // Parts of lslices not resting on the lslices of the layer below, all of lslices for the first layer.
+    const ExPolygons&               unsupported() const { return m_unsupported; }
+    const std::vector<BoundingBox>& unsupported_bboxes() const { return m_unsupported_bboxes; }
+    // Whether bbox overlaps an unsupported island. If not, any part of the layer's slices inside bbox rests on the layer below.
+    bool                            unsupported_overlaps(const BoundingBox &bbox) const;
+
+    // lslices of the layer below offset by a scaled delta. Computed once per delta and shared by all the regions
+    // of the layer, empty for the first layer. Thread safe, the returned reference is valid until release_offsets().
+    const Polygons&                 lower_slices_offset(float delta) const;
+    void                            release_offsets();
+
+private:
+    bool                                                      m_valid { false };
+    const ExPolygons                                         *m_lower_lslices { nullptr };
+    ExPolygons                                                m_unsupported;
+    std::vector<BoundingBox>                                  m_unsupported_bboxes;
+    BoundingBox                                               m_unsupported_bbox;
+    mutable std::mutex                                        m_offsets_mutex;
+    mutable std::vector<std::pair<float, std::unique_ptr<Polygons>>> m_lower_offsets;
+};
+
 class Layer
 {
 public:
@@ -159,6 +194,8 @@ public:
     ExPolygons 				 lslices;
     ExPolygons 				 lslices_extrudable;  // BBS: the extrudable part of lslices used for tree support
     std::vector<BoundingBox> lslices_bboxes;
+    // lslices against the lslices of lower_layer.
+    InterlayerDelta          interlayer_delta;
 
     // BBS
     ExPolygons              loverhangs;
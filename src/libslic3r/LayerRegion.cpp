@@ -160,9 +160,13 @@ void LayerRegion::make_perimeters(const SurfaceCollection &slices, const Perimet
         &loop_nodes
     );
 
-    if (this->layer()->lower_layer != nullptr)
+    if (this->layer()->lower_layer != nullptr) {
         // Cummulative sum of polygons over all the regions.
         g.lower_slices = &this->layer()->lower_layer->lslices;
+        // The circle compensation grows the region slices out of lslices, then the index can't tell what is supported.
+        if (this->layer()->interlayer_delta.valid() && ! object_config.enable_circle_compensation)
+            g.lower_slices_delta = &this->layer()->interlayer_delta;
+    }
     if (this->layer()->upper_layer != NULL)
         g.upper_slices = &this->layer()->upper_layer->lslices;
 
@@ -3,6 +3,8 @@
 #ifdef _WIN32
     #include <charconv>
 #endif
+#include <cmath>
+#include <cstdint>
 #include <stdexcept>
 
 #include <fast_float/fast_float.h>
@@ -84,6 +86,34 @@ std::string float_to_string_decimal_point(double value, int precision/* = -1*/)
 #endif
 }
 
+std::string float_to_string_decimal_point_fixed(float value, int precision)
+{
+    static constexpr const double   pow_10_double[] = { 1., 10., 100., 1000., 10000. };
+    static constexpr const uint64_t pow_10[]        = { 1, 10, 100, 1000, 10000 };
+    assert(precision >= 0 && precision <= 4);
+    // A float scaled by up to 10^4 is exact in double, thus rounding half to even reproduces the rounding of printf.
+    double scaled = std::nearbyint(std::abs(double(value)) * pow_10_double[precision]);
+    if (! (scaled < 1e15))
+        // NaN, infinity or too large to be a coordinate.
+        return float_to_string_decimal_point(value, precision);
+    char  buf[32];
+    char *end = buf + sizeof(buf);
+    char *p   = end;
+    uint64_t n = uint64_t(scaled);
+    for (int i = 0; i < precision; ++ i, n /= 10)
+        *-- p = char('0' + n % 10);
+    if (precision > 0)
+        *-- p = '.';
+    n = uint64_t(scaled) / pow_10[precision];
+    do {
+        *-- p = char('0' + n % 10);
+        n /= 10;
+    } while (n > 0);
+    if (std::signbit(value))
+        *-- p = '-';
+    return std::string(p, end);
+}
+
 
 } // namespace Slic3r
 
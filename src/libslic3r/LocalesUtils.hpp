@@ -41,6 +41,9 @@ bool is_decimal_separator_point();
 // (We use user C locales and "C" C++ locales in most of the code.)
 std::string float_to_string_decimal_point(double value, int precision = -1);
 //std::string float_to_string_decimal_point(float value,  int precision = -1);
+// Produces the same text as float_to_string_decimal_point(value, precision) for 0 <= precision <= 4,
+// formatted by fixed point integer arithmetic instead of a string stream. Used by the G-code writers.
+std::string float_to_string_decimal_point_fixed(float value, int precision);
 double string_to_double_decimal_point(const std::string_view str, size_t* pos = nullptr);
 
 } // namespace Slic3r
@@ -3915,22 +3915,26 @@ bool Model::obj_import_face_color_deal(const std::vector<unsigned char> &face_fi
 
 // update the maxSpeed of an object if it is different from the global configuration
 double Model::findMaxSpeed(const ModelObject* object) {
+    return Model::findMaxSpeed(object, Model::printSpeedMap);
+}
+
+double Model::findMaxSpeed(const ModelObject* object, const GlobalSpeedMap &speed_map) {
     auto objectKeys = object->config.keys();
     double objMaxSpeed = -1.;
     if (objectKeys.empty())
-        return Model::printSpeedMap.maxSpeed;
-    double perimeterSpeedObj = Model::printSpeedMap.perimeterSpeed;
-    double externalPerimeterSpeedObj = Model::printSpeedMap.externalPerimeterSpeed;
-    double infillSpeedObj = Model::printSpeedMap.infillSpeed;
-    double solidInfillSpeedObj = Model::printSpeedMap.solidInfillSpeed;
-    double topSolidInfillSpeedObj = Model::printSpeedMap.topSolidInfillSpeed;
-    double supportSpeedObj = Model::printSpeedMap.supportSpeed;
-    double smallPerimeterSpeedObj = Model::printSpeedMap.smallPerimeterSpeed;
+        return speed_map.maxSpeed;
+    double perimeterSpeedObj = speed_map.perimeterSpeed;
+    double externalPerimeterSpeedObj = speed_map.externalPerimeterSpeed;
+    double infillSpeedObj = speed_map.infillSpeed;
+    double solidInfillSpeedObj = speed_map.solidInfillSpeed;
+    double topSolidInfillSpeedObj = speed_map.topSolidInfillSpeed;
+    double supportSpeedObj = speed_map.supportSpeed;
+    double smallPerimeterSpeedObj = speed_map.smallPerimeterSpeed;
     for (std::string objectKey : objectKeys) {
         // todo multi_extruders:
         if (objectKey == "inner_wall_speed"){
             perimeterSpeedObj = object->config.get().opt_float_nullable(objectKey, 0);
-            externalPerimeterSpeedObj = Model::printSpeedMap.externalPerimeterSpeed / Model::printSpeedMap.perimeterSpeed * perimeterSpeedObj;
+            externalPerimeterSpeedObj = speed_map.externalPerimeterSpeed / speed_map.perimeterSpeed * perimeterSpeedObj;
         }
         if (objectKey == "sparse_infill_speed")
             infillSpeedObj = object->config.get().opt_float_nullable(objectKey, 0);
@@ -3952,18 +3956,22 @@ double Model::findMaxSpeed(const ModelObject* object) {
 
 // BBS: thermal length is calculated according to the material of a volume
 double Model::getThermalLength(const ModelVolume* modelVolumePtr) {
+    return Model::getThermalLength(modelVolumePtr, Model::extruderParamsMap);
+}
+
+double Model::getThermalLength(const ModelVolume* modelVolumePtr, const std::map<size_t, ExtruderParams> &extruder_params) {
     double thermalLength = 200.;
     auto aa = modelVolumePtr->extruder_id();
-    if (Model::extruderParamsMap.find(aa) != Model::extruderParamsMap.end()) {
-        if (Model::extruderParamsMap.at(aa).materialName == "ABS" ||
-            Model::extruderParamsMap.at(aa).materialName == "PA-CF" ||
-            Model::extruderParamsMap.at(aa).materialName == "PET-CF") {
+    if (extruder_params.find(aa) != extruder_params.end()) {
+        if (extruder_params.at(aa).materialName == "ABS" ||
+            extruder_params.at(aa).materialName == "PA-CF" ||
+            extruder_params.at(aa).materialName == "PET-CF") {
             thermalLength = 100;
         }
-        if (Model::extruderParamsMap.at(aa).materialName == "PC") {
+        if (extruder_params.at(aa).materialName == "PC") {
             thermalLength = 40;
         }
-        if (Model::extruderParamsMap.at(aa).materialName == "TPU" || Model::extruderParamsMap.at(aa).materialName == "TPU-AMS") {
+        if (extruder_params.at(aa).materialName == "TPU" || extruder_params.at(aa).materialName == "TPU-AMS") {
             thermalLength = 1000;
         }
 
@@ -3973,13 +3981,18 @@ double Model::getThermalLength(const ModelVolume* modelVolumePtr) {
 
 // BBS: thermal length calculation for a group of volumes
 double Model::getThermalLength(const std::vector<ModelVolume*> modelVolumePtrs)
+{
+    return Model::getThermalLength(modelVolumePtrs, Model::extruderParamsMap);
+}
+
+double Model::getThermalLength(const std::vector<ModelVolume*> modelVolumePtrs, const std::map<size_t, ExtruderParams> &extruder_params)
 {
     double thermalLength = 1250.;
 
     for (const auto& modelVolumePtr : modelVolumePtrs) {
         if (modelVolumePtr != nullptr) {
             // the thermal length of a group is decided by the volume with shortest thermal length
-            thermalLength = std::min(thermalLength, getThermalLength(modelVolumePtr));
+            thermalLength = std::min(thermalLength, getThermalLength(modelVolumePtr, extruder_params));
         }
     }
     return thermalLength;
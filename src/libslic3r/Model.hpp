@@ -1658,8 +1658,11 @@ public:
     static bool    obj_import_vertex_color_deal(const std::vector<unsigned char> &vertex_filament_ids, const unsigned char &first_extruder_id, Model *model);
     static bool    obj_import_face_color_deal(const std::vector<unsigned char> &face_filament_ids, const unsigned char &first_extruder_id, Model *model);
     static double findMaxSpeed(const ModelObject* object);
+    static double findMaxSpeed(const ModelObject* object, const GlobalSpeedMap &speed_map);
     static double getThermalLength(const ModelVolume* modelVolumePtr);
+    static double getThermalLength(const ModelVolume* modelVolumePtr, const std::map<size_t, ExtruderParams> &extruder_params);
     static double getThermalLength(const std::vector<ModelVolume*> modelVolumePtrs);
+    static double getThermalLength(const std::vector<ModelVolume*> modelVolumePtrs, const std::map<size_t, ExtruderParams> &extruder_params);
     static Polygon getBedPolygon() { return Model::printSpeedMap.bed_poly; }
     //BBS static functions that update extruder params and speed table
     static void setPrintSpeedTable(const DynamicPrintConfig& config, const PrintConfig& print_config);
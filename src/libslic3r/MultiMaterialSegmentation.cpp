@@ -8,9 +8,11 @@
 #include "MutablePolygon.hpp"
 #include "format.hpp"
 
+#include <tuple>
 #include <utility>
 #include <unordered_set>
 
+#include <boost/container/small_vector.hpp>
 #include <boost/log/trivial.hpp>
 #include <tbb/parallel_for.h>
 #include <mutex>
@@ -74,8 +76,9 @@ struct MMU_Graph
 
     struct Node
     {
-        Vec2d             point;
-        std::list<size_t> arc_idxs;
+        Vec2d point;
+        // Most nodes have at most three arcs, they are stored inline to not allocate per arc.
+        boost::container::small_vector<size_t, 4> arc_idxs;
 
         void remove_edge(const size_t to_idx, MMU_Graph &graph)
         {
@@ -512,14 +515,6 @@ static bool project_line_on_line(const Line &projection_l, const Line &projected
     return true;
 }
 
-struct PaintedLine
-{
-    size_t contour_idx;
-    size_t line_idx;
-    Line   projected_line;
-    int    color;
-};
-
 struct PaintedLineVisitor
 {
     PaintedLineVisitor(const EdgeGrid::Grid &grid, std::vector<PaintedLine> &painted_lines, std::mutex &painted_lines_mutex, size_t reserve) : grid(grid), painted_lines(painted_lines), painted_lines_mutex(painted_lines_mutex)
@@ -684,6 +679,98 @@ static std::vector<PaintedLine> filter_painted_lines(const Line &line_to_process
     return filtered_lines;
 }
 
+// The order of the painted lines depends on the scheduling of the parallel projection, sort them to make the segmentation
+// deterministic and the painted lines comparable with the ones stored in PaintingSegmentationCache.
+static void sort_painted_lines(std::vector<PaintedLine> &painted_lines)
+{
+    std::sort(painted_lines.begin(), painted_lines.end(), [](const PaintedLine &l, const PaintedLine &r) {
+        return std::tie(l.contour_idx, l.line_idx, l.projected_line.a.x(), l.projected_line.a.y(), l.projected_line.b.x(), l.projected_line.b.y(), l.color) <
+               std::tie(r.contour_idx, r.line_idx, r.projected_line.a.x(), r.projected_line.a.y(), r.projected_line.b.x(), r.projected_line.b.y(), r.color);
+    });
+}
+
+void PaintingSegmentationCache::reset(size_t num_layers, size_t num_extruders)
+{
+    if (m_layers.size() != num_layers || m_num_extruders != num_extruders) {
+        this->clear();
+        m_layers.resize(num_layers);
+        m_num_extruders = num_extruders;
+    }
+    m_hits   = 0;
+    m_misses = 0;
+}
+
+bool PaintingSegmentationCache::Budget::reserve(size_t memory_size)
+{
+    // Reserve the memory first, the layers are stored in parallel.
+    if (m_memory_size.fetch_add(memory_size, std::memory_order_relaxed) + memory_size > this->max_memory_size()) {
+        m_memory_size.fetch_sub(memory_size, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+PaintingSegmentationCache::Budget& PaintingSegmentationCache::default_budget()
+{
+    static Budget budget;
+    return budget;
+}
+
+void PaintingSegmentationCache::clear()
+{
+    m_budget.release(m_memory_size.exchange(0, std::memory_order_relaxed));
+    m_layers.clear();
+    m_layers.shrink_to_fit();
+}
+
+void PaintingSegmentationCache::swap(PaintingSegmentationCache &rhs)
+{
+    assert(&m_budget == &rhs.m_budget);
+    m_layers.swap(rhs.m_layers);
+    std::swap(m_num_extruders, rhs.m_num_extruders);
+    m_memory_size = rhs.m_memory_size.exchange(m_memory_size.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+const std::vector<ExPolygons>* PaintingSegmentationCache::find(size_t layer_idx, const ExPolygons &input_expolygons, const std::vector<PaintedLine> &painted_lines)
+{
+    assert(layer_idx < m_layers.size());
+    const Layer &layer = m_layers[layer_idx];
+    if (layer.valid && layer.painted_lines == painted_lines && layer.input_expolygons == input_expolygons) {
+        ++ m_hits;
+        return &layer.segmentation;
+    }
+    ++ m_misses;
+    return nullptr;
+}
+
+void PaintingSegmentationCache::store(size_t layer_idx, const ExPolygons &input_expolygons, std::vector<PaintedLine> &&painted_lines, const std::vector<ExPolygons> &segmentation)
+{
+    assert(layer_idx < m_layers.size());
+    this->erase(layer_idx);
+    size_t memory_size = count_points(input_expolygons) * sizeof(Point) + painted_lines.size() * sizeof(PaintedLine);
+    for (const ExPolygons &expolygons : segmentation)
+        memory_size += count_points(expolygons) * sizeof(Point);
+    if (! m_budget.reserve(memory_size))
+        return;
+    m_memory_size.fetch_add(memory_size, std::memory_order_relaxed);
+    Layer &layer           = m_layers[layer_idx];
+    layer.valid            = true;
+    layer.input_expolygons = input_expolygons;
+    layer.painted_lines    = std::move(painted_lines);
+    layer.segmentation     = segmentation;
+    layer.memory_size      = memory_size;
+}
+
+void PaintingSegmentationCache::erase(size_t layer_idx)
+{
+    assert(layer_idx < m_layers.size());
+    if (m_layers[layer_idx].valid) {
+        m_memory_size.fetch_sub(m_layers[layer_idx].memory_size, std::memory_order_relaxed);
+        m_budget.release(m_layers[layer_idx].memory_size);
+        m_layers[layer_idx] = Layer();
+    }
+}
+
 static std::vector<std::vector<PaintedLine>> post_process_painted_lines(const std::vector<EdgeGrid::Contour> &contours, std::vector<PaintedLine> &&painted_lines)
 {
     if (painted_lines.empty())
@@ -2091,7 +2178,8 @@ static bool has_layer_only_one_color(const std::vector<ColoredLines> &colored_po
     return true;
 }
 
-std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback,
+                                                                             PaintingSegmentationCache *cache)
 {
     const size_t                          num_extruders = print_object.print()->config().filament_colour.size();
     const size_t                          num_layers    = print_object.layers().size();
@@ -2104,6 +2192,11 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
     std::vector<ExPolygons>               input_expolygons(num_layers);
 
     throw_on_cancel_callback();
+    if (cache != nullptr && cache->max_memory_size() == 0)
+        // The cache is disabled, do not keep the painted lines as its keys.
+        cache = nullptr;
+    if (cache != nullptr)
+        cache->reset(num_layers, num_extruders);
 
 #ifdef MM_SEGMENTATION_DEBUG
     static int iRun = 0;
@@ -2267,7 +2360,7 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
                              << std::count_if(painted_lines.begin(), painted_lines.end(), [](const std::vector<PaintedLine> &pl) { return !pl.empty(); });
 
     BOOST_LOG_TRIVIAL(debug) << "MM segmentation - layers segmentation in parallel - begin";
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&edge_grids, &input_expolygons, &painted_lines, &segmented_regions, &num_extruders, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&edge_grids, &input_expolygons, &painted_lines, &segmented_regions, &num_extruders, cache, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
         for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
             throw_on_cancel_callback();
             if (!painted_lines[layer_idx].empty()) {
@@ -2275,7 +2368,17 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
                 export_painted_lines_to_svg(debug_out_path("0-mm-painted-lines-%d-%d.svg", layer_idx, iRun), {painted_lines[layer_idx]}, input_expolygons[layer_idx]);
 #endif // MM_SEGMENTATION_DEBUG_PAINTED_LINES
 
-                std::vector<std::vector<PaintedLine>> post_processed_painted_lines = post_process_painted_lines(edge_grids[layer_idx].contours(), std::move(painted_lines[layer_idx]));
+                sort_painted_lines(painted_lines[layer_idx]);
+                if (cache != nullptr) {
+                    if (const std::vector<ExPolygons> *cached = cache->find(layer_idx, input_expolygons[layer_idx], painted_lines[layer_idx]); cached != nullptr) {
+                        segmented_regions[layer_idx] = *cached;
+                        continue;
+                    }
+                }
+
+                // The painted lines are kept as the cache key if caching.
+                std::vector<std::vector<PaintedLine>> post_processed_painted_lines = post_process_painted_lines(edge_grids[layer_idx].contours(),
+                    cache != nullptr ? std::vector<PaintedLine>(painted_lines[layer_idx]) : std::move(painted_lines[layer_idx]));
 
 #ifdef MM_SEGMENTATION_DEBUG_PAINTED_LINES
                 export_painted_lines_to_svg(debug_out_path("1-mm-painted-lines-post-processed-%d-%d.svg", layer_idx, iRun), post_processed_painted_lines, input_expolygons[layer_idx]);
@@ -2300,13 +2403,20 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
                     //segmented_regions[layer_idx] = extract_colored_segments(color_poly, num_extruders, layer_idx);
                 }
 
+                if (cache != nullptr)
+                    cache->store(layer_idx, input_expolygons[layer_idx], std::move(painted_lines[layer_idx]), segmented_regions[layer_idx]);
+
 #ifdef MM_SEGMENTATION_DEBUG_REGIONS
                 export_regions_to_svg(debug_out_path("3-mm-regions-sides-%d-%d.svg", layer_idx, iRun), segmented_regions[layer_idx], input_expolygons[layer_idx]);
 #endif // MM_SEGMENTATION_DEBUG_REGIONS
+            } else if (cache != nullptr) {
+                cache->erase(layer_idx);
             }
         }
     }); // end of parallel_for
     BOOST_LOG_TRIVIAL(debug) << "MM segmentation - layers segmentation in parallel - end";
+    if (cache != nullptr)
+        BOOST_LOG_TRIVIAL(debug) << "MM segmentation - layers reused from the cache: " << cache->hits() << ", layers segmented: " << cache->misses();
     throw_on_cancel_callback();
 
     auto interlocking_beam = print_object.config().interlocking_beam;
@@ -2335,7 +2445,8 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
     return segmented_regions_merged;
 }
 
-std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback,
+                                                                         PaintingSegmentationCache *cache)
 {
     const size_t                         num_extruders = 1;
     const size_t                         num_layers    = print_object.layers().size();
@@ -2348,6 +2459,11 @@ std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const P
     std::vector<ExPolygons>               input_expolygons(num_layers);
 
     throw_on_cancel_callback();
+    if (cache != nullptr && cache->max_memory_size() == 0)
+        // The cache is disabled, do not keep the painted lines as its keys.
+        cache = nullptr;
+    if (cache != nullptr)
+        cache->reset(num_layers, num_extruders);
 
 #ifdef MM_SEGMENTATION_DEBUG
     static int iRun = 0;
@@ -2506,7 +2622,7 @@ std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const P
 
     BOOST_LOG_TRIVIAL(debug) << "MM segmentation - layers segmentation in parallel - begin";
     tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&edge_grids, &input_expolygons, &painted_lines, &segmented_regions, &num_extruders,
-                                                                  &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+                                                                  cache, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
         for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
             throw_on_cancel_callback();
             if (!painted_lines[layer_idx].empty()) {
@@ -2514,8 +2630,17 @@ std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const P
                 export_painted_lines_to_svg(debug_out_path("0-mm-painted-lines-%d-%d.svg", layer_idx, iRun), {painted_lines[layer_idx]}, input_expolygons[layer_idx]);
 #endif // MM_SEGMENTATION_DEBUG_PAINTED_LINES
 
+                sort_painted_lines(painted_lines[layer_idx]);
+                if (cache != nullptr) {
+                    if (const std::vector<ExPolygons> *cached = cache->find(layer_idx, input_expolygons[layer_idx], painted_lines[layer_idx]); cached != nullptr) {
+                        segmented_regions[layer_idx] = *cached;
+                        continue;
+                    }
+                }
+
+                // The painted lines are kept as the cache key if caching.
                 std::vector<std::vector<PaintedLine>> post_processed_painted_lines = post_process_painted_lines(edge_grids[layer_idx].contours(),
-                                                                                                                std::move(painted_lines[layer_idx]));
+                    cache != nullptr ? std::vector<PaintedLine>(painted_lines[layer_idx]) : std::move(painted_lines[layer_idx]));
 
 #ifdef MM_SEGMENTATION_DEBUG_PAINTED_LINES
                 export_painted_lines_to_svg(debug_out_path("1-mm-painted-lines-post-processed-%d-%d.svg", layer_idx, iRun), post_processed_painted_lines,
@@ -2541,13 +2666,20 @@ std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const P
                     // segmented_regions[layer_idx] = extract_colored_segments(color_poly, num_extruders, layer_idx);
                 }
 
+                if (cache != nullptr)
+                    cache->store(layer_idx, input_expolygons[layer_idx], std::move(painted_lines[layer_idx]), segmented_regions[layer_idx]);
+
 #ifdef MM_SEGMENTATION_DEBUG_REGIONS
                 export_regions_to_svg(debug_out_path("3-mm-regions-sides-%d-%d.svg", layer_idx, iRun), segmented_regions[layer_idx], input_expolygons[layer_idx]);
 #endif // MM_SEGMENTATION_DEBUG_REGIONS
+            } else if (cache != nullptr) {
+                cache->erase(layer_idx);
             }
         }
     }); // end of parallel_for
     BOOST_LOG_TRIVIAL(debug) << "MM segmentation - layers segmentation in parallel - end";
+    if (cache != nullptr)
+        BOOST_LOG_TRIVIAL(debug) << "MM segmentation - layers reused from the cache: " << cache->hits() << ", layers segmented: " << cache->misses();
     throw_on_cancel_callback();
 
     float max_width = 0.f;
@@ -1,14 +1,16 @@
 #ifndef slic3r_MultiMaterialSegmentation_hpp_
 #define slic3r_MultiMaterialSegmentation_hpp_
 
+#include "ExPolygon.hpp"
+
+#include <atomic>
+#include <functional>
 #include <utility>
 #include <vector>
 
 namespace Slic3r {
 
 class PrintObject;
-class ExPolygon;
-using ExPolygons = std::vector<ExPolygon>;
 
 struct ColoredLine
 {
@@ -20,11 +22,103 @@ struct ColoredLine
 
 using ColoredLines = std::vector<ColoredLine>;
 
-// Returns MMU segmentation based on painting in MMU segmentation gizmo
-std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
+// Painted triangle projected onto a line of a layer contour.
+struct PaintedLine
+{
+    size_t contour_idx;
+    size_t line_idx;
+    Line   projected_line;
+    int    color;
+
+    bool operator==(const PaintedLine &rhs) const
+    {
+        return contour_idx == rhs.contour_idx && line_idx == rhs.line_idx && projected_line == rhs.projected_line && color == rhs.color;
+    }
+};
+
+// Segmentation of the individual layers by painting, retained between the slicing runs of a PrintObject.
+// A layer is keyed on its merged slices and on the painted lines projected onto it at its slice_z,
+// thus after a paint stroke only the layers touched by the stroke are segmented again.
+// The cross-layer passes (top / bottom propagation, cutting and merging of the regions) are not cached.
+// The layers stored are bounded by a Budget shared by the caches of all the objects, by default the process wide one.
+// A layer exceeding the budget is segmented again by the next run.
+class PaintingSegmentationCache
+{
+public:
+    static constexpr size_t DefaultMaxMemorySize = size_t(256) * 1024 * 1024;
+
+    // Approximate size of the slices, painted lines and segmentations stored by a set of caches in bytes.
+    class Budget
+    {
+    public:
+        explicit Budget(size_t max_memory_size = DefaultMaxMemorySize) : m_max_memory_size(max_memory_size) {}
+
+        // Lowering the limit does not release the stored layers, it only refuses new ones. Zero disables the caches.
+        void    set_max_memory_size(size_t max_memory_size) { m_max_memory_size.store(max_memory_size, std::memory_order_relaxed); }
+        size_t  max_memory_size() const { return m_max_memory_size.load(std::memory_order_relaxed); }
+        size_t  memory_size()     const { return m_memory_size.load(std::memory_order_relaxed); }
+
+        // Thread safe.
+        bool    reserve(size_t memory_size);
+        void    release(size_t memory_size) { m_memory_size.fetch_sub(memory_size, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<size_t> m_max_memory_size;
+        std::atomic<size_t> m_memory_size { 0 };
+    };
+    // Budget of the caches of all the PrintObjects.
+    static Budget& default_budget();
+
+    explicit PaintingSegmentationCache(Budget &budget = default_budget()) : m_budget(budget) {}
+    ~PaintingSegmentationCache() { this->clear(); }
+
+    // Drops all layers if num_layers or num_extruders changed. To be called before the layers are looked up in parallel.
+    void    reset(size_t num_layers, size_t num_extruders);
+    // Releases all layers and their memory, for example when the object is no more painted.
+    void    clear();
+    // Exchanges the layers with a cache of the same budget.
+    void    swap(PaintingSegmentationCache &rhs);
+
+    // Approximate size of the layers stored by this cache in bytes.
+    size_t  memory_size() const { return m_memory_size.load(std::memory_order_relaxed); }
+
+    // Returns the segmentation cached for the same slices and painted lines, nullptr if there is none.
+    // painted_lines are expected to be sorted with the same order as when stored. Thread safe for distinct layers.
+    const std::vector<ExPolygons>* find(size_t layer_idx, const ExPolygons &input_expolygons, const std::vector<PaintedLine> &painted_lines);
+    void    store(size_t layer_idx, const ExPolygons &input_expolygons, std::vector<PaintedLine> &&painted_lines, const std::vector<ExPolygons> &segmentation);
+    // Releases a layer, which is no more painted.
+    void    erase(size_t layer_idx);
+
+    // Statistics of the last lookups, reset by reset().
+    size_t  hits()   const { return m_hits.load(std::memory_order_relaxed); }
+    size_t  misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+    struct Layer
+    {
+        bool                     valid { false };
+        ExPolygons               input_expolygons;
+        std::vector<PaintedLine> painted_lines;
+        std::vector<ExPolygons>  segmentation;
+        size_t                   memory_size { 0 };
+    };
+
+    Budget             &m_budget;
+    std::vector<Layer>  m_layers;
+    size_t              m_num_extruders { 0 };
+    std::atomic<size_t> m_memory_size { 0 };
+    std::atomic<size_t> m_hits { 0 };
+    std::atomic<size_t> m_misses { 0 };
+};
+
+// Returns MMU segmentation based on painting in MMU segmentation gizmo.
+// If cache is provided, only the layers with modified slices or painting are segmented.
+std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback,
+                                                                             PaintingSegmentationCache *cache = nullptr);
 
 // Returns fuzzy skin segmentation based on painting in fuzzy skin segmentation gizmo
-std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
+std::vector<std::vector<ExPolygons>> fuzzy_skin_segmentation_by_painting(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback,
+                                                                         PaintingSegmentationCache *cache = nullptr);
 
 } // namespace Slic3r
 
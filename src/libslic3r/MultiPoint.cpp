@@ -1,5 +1,6 @@
 #include "MultiPoint.hpp"
 #include "BoundingBox.hpp"
+#include "ScratchArena.hpp"
 
 namespace Slic3r {
 
@@ -189,7 +190,7 @@ std::vector<Point> MultiPoint::_douglas_peucker(const std::vector<Point>& pts, c
         result_pts.emplace_back(*anchor);
         if (anchor_idx != floater_idx) {
             assert(pts.size() > 1);
-            std::vector<size_t> dpStack;
+            ScratchVector<size_t> dpStack;
             dpStack.reserve(pts.size());
             dpStack.emplace_back(floater_idx);
             for (;;) {
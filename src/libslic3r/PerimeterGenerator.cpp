@@ -655,7 +655,7 @@ static ExtrusionEntityCollection traverse_extrusions(const PerimeterGenerator& p
             extrusion_path.reserve(extrusion->size());
 
             double nozzle_diameter = perimeter_generator.print_config->nozzle_diameter.get_at(perimeter_generator.config->wall_filament - 1);
-            Polygons lower_layer_polys = perimeter_generator.lower_slices_polygons();
+            const Polygons &lower_layer_polys = perimeter_generator.lower_slices_polygons();
 
             coord_t max_extrusion_width = 0;
             BoundingBox extrusion_path_bbox;
@@ -673,14 +673,12 @@ static ExtrusionEntityCollection traverse_extrusions(const PerimeterGenerator& p
                     new_lower_polys.emplace_back(new_poly);
             }
 
-            lower_layer_polys = new_lower_polys;
-
             ZPath subject_path;
             for (auto& ej : extrusion->junctions)
                 subject_path.emplace_back(ej.p.x(), ej.p.y(), ej.w);
 
             ZPaths clip_paths;
-            for (auto& poly : lower_layer_polys) {
+            for (auto& poly : new_lower_polys) {
                 clip_paths.emplace_back();
                 for (auto& p : poly)
                     clip_paths.back().emplace_back(p.x(), p.y(), 0);
@@ -1136,7 +1134,8 @@ void PerimeterGenerator::process_classic()
                                                         offset_ex(top_polygons, offset_top_surface + min_width_top_surface - double(ext_perimeter_spacing / 2)),
                                                         ApplySafetyOffset::Yes);
                     // BBS: check whether surface be bridge or not
-                    if (this->lower_slices != NULL) {
+                    // Nothing of the layer overhangs inside last_box if the index of the lower layer says so.
+                    if (this->lower_slices != NULL && (this->lower_slices_delta == nullptr || this->lower_slices_delta->unsupported_overlaps(last_box))) {
                         // BBS: get the Polygons below the polygon this layer
                         Polygons lower_polygons_series_clipped = ClipperUtils::clip_clipper_polygons_with_subject_bbox(*this->lower_slices, last_box);
 
@@ -1480,7 +1479,7 @@ void PerimeterGenerator::process_arachne()
         // lower layer, so we take lower slices and offset them by half the nozzle diameter used
         // in the current layer
         double nozzle_diameter = this->print_config->nozzle_diameter.get_at(this->config->wall_filament - 1);
-        m_lower_slices_polygons = offset(*this->lower_slices, float(scale_(+nozzle_diameter / 2)));
+        m_lower_slices_polygons = this->lower_slices_offset(float(scale_(+nozzle_diameter / 2)));
     }
 
 
@@ -1566,12 +1565,15 @@ void PerimeterGenerator::process_arachne()
                     upper_polygons_clipped = ClipperUtils::clip_clipper_polygons_with_subject_bbox(*this->upper_slices, infill_bbox);
                 top_expolys_by_one_wall = diff_ex(infill_contour_by_one_wall, upper_polygons_clipped);
 
-                Polygons lower_polygons_clipped;
-                if (this->lower_slices)
-                    lower_polygons_clipped = ClipperUtils::clip_clipper_polygons_with_subject_bbox(*this->lower_slices, infill_bbox);
-                ExPolygons bottom_expolys = diff_ex(top_expolys_by_one_wall, lower_polygons_clipped);
+                // The bottom areas are only looked for if the layer overhangs inside infill_bbox.
+                if (this->lower_slices == nullptr || this->lower_slices_delta == nullptr || this->lower_slices_delta->unsupported_overlaps(infill_bbox)) {
+                    Polygons lower_polygons_clipped;
+                    if (this->lower_slices)
+                        lower_polygons_clipped = ClipperUtils::clip_clipper_polygons_with_subject_bbox(*this->lower_slices, infill_bbox);
+                    ExPolygons bottom_expolys = diff_ex(top_expolys_by_one_wall, lower_polygons_clipped);
 
-                top_expolys_by_one_wall = diff_ex(top_expolys_by_one_wall, bottom_expolys);
+                    top_expolys_by_one_wall = diff_ex(top_expolys_by_one_wall, bottom_expolys);
+                }
                 seperate_wall_generation = should_enable_top_one_wall(last, top_expolys_by_one_wall);
             }
 
@@ -1846,11 +1848,18 @@ std::vector<Polygons> PerimeterGenerator::generate_lower_polygons_series(float w
 
     // offset expolygon to generate series of polygons
     for (int i = 0; i < offset_series.size(); i++) {
-        lower_polygons_series.emplace_back(offset(*this->lower_slices, float(scale_(offset_series[i]))));
+        lower_polygons_series.emplace_back(this->lower_slices_offset(float(scale_(offset_series[i]))));
     }
     return lower_polygons_series;
 }
 
+Polygons PerimeterGenerator::lower_slices_offset(float delta) const
+{
+    assert(this->lower_slices != nullptr);
+    // The regions of a layer and the perimeter types share the same offsets, e.g. by half of the nozzle diameter.
+    return this->lower_slices_delta != nullptr ? this->lower_slices_delta->lower_slices_offset(delta) : offset(*this->lower_slices, delta);
+}
+
 PerimeterRegion::PerimeterRegion(const LayerRegion &layer_region) : region(&layer_region.region())
 {
     this->expolygons = to_expolygons(layer_region.slices.surfaces);
@@ -11,6 +11,7 @@
 namespace Slic3r {
 class LayerRegion;
 class PrintRegion;
+class InterlayerDelta;
 
 struct PerimeterRegion
 {
@@ -35,6 +36,9 @@ public:
     const SurfaceCollection     *slices;
     const ExPolygons            *upper_slices;
     const ExPolygons            *lower_slices;
+    // Optional index of the differences of the layer against lower_slices, sharing the offsets of lower_slices among the regions.
+    // Only set if the region slices are contained in the layer's lslices.
+    const InterlayerDelta       *lower_slices_delta { nullptr };
     double                       layer_height;
     int                          layer_id;
     Flow                         perimeter_flow;
@@ -107,9 +111,11 @@ public:
     double      mm3_per_mm_overhang()   const { return m_mm3_per_mm_overhang; }
     //BBS
     double      smaller_width_ext_mm3_per_mm()   const { return m_ext_mm3_per_mm_smaller_width; }
-    Polygons    lower_slices_polygons() const { return m_lower_slices_polygons; }
+    const Polygons& lower_slices_polygons() const { return m_lower_slices_polygons; }
 
 private:
+    // lower_slices offset by a scaled delta, taken from lower_slices_delta if available.
+    Polygons                  lower_slices_offset(float delta) const;
     std::vector<Polygons>     generate_lower_polygons_series(float width);
     std::pair<double, double> dist_boundary(double width);
 
@@ -36,6 +36,7 @@
 
 #include "GCode/ConflictChecker.hpp"
 #include "ParameterUtils.hpp"
+#include "Trace.hpp"
 
 #include <codecvt>
 
@@ -417,6 +418,33 @@ bool Print::is_step_done(PrintObjectStep step) const
     return true;
 }
 
+AllocationStats Print::step_allocation_stats(PrintObjectStep step) const
+{
+    AllocationStats out;
+    for (const PrintObject *object : m_objects)
+        out += object->step_allocation_stats(step);
+    return out;
+}
+
+const char* print_object_step_name(PrintObjectStep step)
+{
+    switch (step) {
+    case posSlice:                  return "posSlice";
+    case posPerimeters:             return "posPerimeters";
+    case posPrepareInfill:          return "posPrepareInfill";
+    case posInfill:                 return "posInfill";
+    case posIroning:                return "posIroning";
+    case posSupportMaterial:        return "posSupportMaterial";
+    case posDetectOverhangsForLift: return "posDetectOverhangsForLift";
+    case posSimplifyWall:           return "posSimplifyWall";
+    case posSimplifyInfill:         return "posSimplifyInfill";
+    case posSimplifySupportPath:    return "posSimplifySupportPath";
+    case posCount:                  break;
+    }
+    assert(false);
+    return "";
+}
+
 // returns 0-based indices of used extruders
 std::vector<unsigned int> Print::object_extruders() const
 {
@@ -1681,6 +1709,7 @@ void  PrintObject::clear_shared_object()
         m_shared_object = nullptr;
 
         invalidate_all_steps_without_cancel();
+        m_dirty_layers.fill({});
     }
 }
 
@@ -1765,9 +1794,19 @@ std::map<ObjectID, unsigned int> getObjectExtruderMap(const Print& print) {
     return objectExtruderMap;
 }
 
+void Print::capture_brim_model_params()
+{
+    m_brim_extruder_params       = Model::extruderParamsMap;
+    m_brim_speed_map             = Model::printSpeedMap;
+    m_brim_model_params_captured = true;
+}
+
 // Slicing process, running at a background thread.
 void Print::process(std::unordered_map<std::string, long long>* slice_time, bool use_cache)
 {
+    if (! m_brim_model_params_captured)
+        this->capture_brim_model_params();
+    SLIC3R_TRACE_SCOPE("Print::process", "Print");
     long long start_time = 0, end_time = 0;
     if (slice_time) {
         (*slice_time)[TIME_USING_CACHE] = 0;
@@ -2017,6 +2056,7 @@ void Print::process(std::unordered_map<std::string, long long>* slice_time, bool
 
 
     if (this->set_started(psWipeTower)) {
+        SLIC3R_TRACE_SCOPE("psWipeTower", "PrintStep");
         {
             std::vector<std::set<int>> geometric_unprintables(m_config.nozzle_diameter.size());
             for (PrintObject* obj : m_objects) {
@@ -2065,6 +2105,7 @@ void Print::process(std::unordered_map<std::string, long long>* slice_time, bool
     }
 
     if (this->set_started(psSkirtBrim)) {
+        SLIC3R_TRACE_SCOPE("psSkirtBrim", "PrintStep");
         this->set_status(70, L("Generating skirt & brim"));
 
         if (slice_time) {
@@ -2228,6 +2269,7 @@ void Print::process(std::unordered_map<std::string, long long>* slice_time, bool
     }
     if(!m_no_check /*&& !has_adaptive_layer_height*/)
     {
+        SLIC3R_TRACE_SCOPE("conflict_check", "Print");
         using Clock                 = std::chrono::high_resolution_clock;
         auto            startTime   = Clock::now();
         std::optional<const FakeWipeTower *> wipe_tower_opt = {};
@@ -2268,6 +2310,7 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
         message = L("Generating G-code");
     this->set_status(80, message);
 
+    SLIC3R_TRACE_SCOPE("psGCodeExport", "PrintStep");
     // The following line may die for multiple reasons.
     GCode gcode;
     //BBS: compute plate offset for gcode-generator
@@ -3158,6 +3201,8 @@ void Print::export_gcode_from_previous_file(const std::string& file, GCodeProces
         processor.process_file(file);
 
         // filament seq is loaded from file, processor result will override the value
+        // The G-code preview may be building the toolpaths of the previous result in the background.
+        std::lock_guard<std::mutex> lock(result->result_mutex);
         auto seq_loaded = result->filament_change_sequence;
         *result = std::move(processor.extract_result());
         result->filament_change_sequence = seq_loaded;
@@ -23,6 +23,7 @@
 
 #include <Eigen/Geometry>
 
+#include <array>
 #include <functional>
 #include <set>
 #include "Calib.hpp"
@@ -106,6 +107,9 @@ enum PrintObjectStep {
     posCount,
 };
 
+// Name of the step as spelled in the code, used by the telemetry.
+const char* print_object_step_name(PrintObjectStep step);
+
 // A PrintRegion object represents a group of volumes to print
 // sharing the same config (including the same assigned extruder(s))
 class PrintRegion
@@ -447,6 +451,14 @@ public:
     SupportLayer* add_tree_support_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z);
     std::shared_ptr<TreeSupportData> alloc_tree_support_preview_cache();
     void clear_tree_support_preview_cache() { m_tree_support_preview_cache.reset(); }
+    // Per layer painting segmentations retained between the slicing runs, so that a paint stroke re-segments only the layers it touches.
+    PaintingSegmentationCache&  mm_segmentation_cache()         { return m_mm_segmentation_cache; }
+    PaintingSegmentationCache&  fuzzy_skin_segmentation_cache() { return m_fuzzy_skin_segmentation_cache; }
+    // Print::apply() re-creates a PrintObject after its painting changed, the new one takes over the segmentations of the old one.
+    void                        take_painting_segmentation_caches(PrintObject &other) {
+        m_mm_segmentation_cache.swap(other.m_mm_segmentation_cache);
+        m_fuzzy_skin_segmentation_cache.swap(other.m_fuzzy_skin_segmentation_cache);
+    }
 
     size_t          support_layer_count() const { return m_support_layers.size(); }
     void            clear_support_layers();
@@ -537,6 +549,12 @@ private:
     // It may be called for both the PrintObjectConfig and PrintRegionConfig.
     bool                    invalidate_state_by_config_options(
         const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
+    // Invalidate steps based on a set of PrintRegionConfig parameters changed for a region living inside z_range only
+    // (a layer range or a height range modifier). posPerimeters, posInfill, posIroning and the path simplification steps
+    // are then only redone for the layers of z_range and their neighbors, see m_dirty_layers.
+    bool                    invalidate_state_by_config_options(
+        const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys,
+        const t_layer_height_range &z_range);
     // If ! m_slicing_params.valid, recalculate.
     void                    update_slicing_parameters();
 
@@ -581,6 +599,14 @@ private:
     void discover_horizontal_shells();
     void merge_infill_types();
     void combine_infill();
+
+    // Track the layers to be regenerated by the steps depending on step, which is being invalidated.
+    void                       mark_dirty_layers(PrintObjectStep step);
+    void                       clear_dirty_layers(PrintObjectStep step) { m_dirty_layers[step] = { false, {} }; }
+    // Layers to be regenerated by step, grown by num_neighbors layers up and down.
+    std::vector<unsigned char> dirty_layers_mask(PrintObjectStep step, size_t num_neighbors) const;
+    // Layers to be regenerated by posInfill, posIroning and posSimplifyInfill, grown by the top / bottom shells.
+    std::vector<unsigned char> dirty_infill_layers_mask(PrintObjectStep step) const;
     void _generate_support_material();
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> prepare_adaptive_infill_data(
         const std::vector<std::pair<const Surface*, float>>& surfaces_w_bottom_z) const;
@@ -611,11 +637,24 @@ private:
     SupportLayerPtrs                        m_support_layers;
     // BBS
     std::shared_ptr<TreeSupportData>        m_tree_support_preview_cache;
+    PaintingSegmentationCache               m_mm_segmentation_cache;
+    PaintingSegmentationCache               m_fuzzy_skin_segmentation_cache;
 
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
     // so that next call to make_perimeters() performs a union() before computing loops
     bool                    				m_typed_slices = false;
 
+    // Layers, whose results of a step are stale. Only a subset of layers is marked stale if a layer range
+    // or a height range modifier was edited and the step was done before, otherwise all layers are stale.
+    // The Z ranges are in unscaled object coordinates, matched against Layer::slice_z.
+    struct DirtyLayers {
+        bool                                all { true };
+        std::vector<t_layer_height_range>   ranges;
+    };
+    std::array<DirtyLayers, posCount>       m_dirty_layers;
+    // Set while invalidating the steps for a single layer range, see invalidate_state_by_config_options().
+    const t_layer_height_range             *m_invalidated_z_range { nullptr };
+
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> m_adaptive_fill_octrees;
     FillLightning::GeneratorPtr m_lightning_generator;
 
@@ -856,6 +895,8 @@ public:
     bool                is_step_done(PrintStep step) const { return Inherited::is_step_done(step); }
     // Returns true if an object step is done on all objects and there's at least one object.
     bool                is_step_done(PrintObjectStep step) const;
+    // Allocations of an object step summed over the objects, the peak RSS is the highest one.
+    AllocationStats     step_allocation_stats(PrintObjectStep step) const;
     // Returns true if the last step was finished with success.
     bool                finished() const override { return this->is_step_done(psGCodeExport); }
 
@@ -994,6 +1035,12 @@ public:
     bool is_support_used() const {return m_support_used;}
     bool is_BBL_Printer() const { return m_isBBLPrinter;}
     void set_BBL_Printer(const bool isBBL) { m_isBBLPrinter = isBBL;}
+    // BBS: filament parameters, speed table and bed polygon of the brim generator, copied from Model::extruderParamsMap
+    // and Model::printSpeedMap. Copied by process() unless the caller copied them after the last apply(), so that the prints
+    // processed in parallel do not read the process wide tables while they are updated for the next print.
+    void capture_brim_model_params();
+    const std::map<size_t, ExtruderParams>& brim_extruder_params() const { return m_brim_extruder_params; }
+    const GlobalSpeedMap&                   brim_speed_map() const { return m_brim_speed_map; }
     std::string get_conflict_string() const
     {
         std::string result;
@@ -1067,6 +1114,9 @@ private:
     PrintRegionPtrs                         m_print_regions;
     //BBS.
     bool m_isBBLPrinter = false;
+    std::map<size_t, ExtruderParams>        m_brim_extruder_params;
+    GlobalSpeedMap                          m_brim_speed_map {};
+    bool                                    m_brim_model_params_captured { false };
     // Ordered collections of extrusion paths to build skirt loops and brim.
     ExtrusionEntityCollection               m_skirt;
     // BBS: collecting extrusion paths to build brim by objs
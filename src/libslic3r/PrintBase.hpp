@@ -9,6 +9,7 @@
 #include <atomic>
 #include <mutex>
 
+#include "AllocationStats.hpp"
 #include "ObjectID.hpp"
 #include "Model.hpp"
 #include "PlaceholderParser.hpp"
@@ -632,32 +633,57 @@ public:
 
     typedef PrintState<PrintObjectStepEnum, COUNT> PrintObjectState;
     bool            is_step_done(PrintObjectStepEnum step) const { return m_state.is_done(step, PrintObjectBase::state_mutex(m_print)); }
+    // Allocations of the process between set_started() and set_done() of the last run of the step,
+    // empty if the step is not done, for example if it was canceled or invalidated.
+    // Steps running concurrently, for example the support generation of several objects, count each other's allocations.
+    const AllocationStats& step_allocation_stats(PrintObjectStepEnum step) const { return m_step_allocation_stats[step]; }
     PrintStateBase::StateWithTimeStamp step_state_with_timestamp(PrintObjectStepEnum step) const { return m_state.state_with_timestamp(step, PrintObjectBase::state_mutex(m_print)); }
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintObjectStepEnum step) const { return m_state.state_with_warnings(step, PrintObjectBase::state_mutex(m_print)); }
 
 protected:
 	PrintObjectBaseWithState(PrintType *print, ModelObject *model_object) : PrintObjectBase(model_object), m_print(print) {}
 
-    bool            set_started(PrintObjectStepEnum step)
-        { return m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); }); }
+    bool            set_started(PrintObjectStepEnum step) {
+        bool started = m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
+        if (started) {
+            m_step_allocation_stats[step] = AllocationStats();
+            m_step_allocation_start[step] = allocation_stats();
+        }
+        return started;
+    }
 	PrintStateBase::TimeStamp set_done(PrintObjectStepEnum step) {
 		std::pair<PrintStateBase::TimeStamp, bool> status = m_state.set_done(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
+        // Not reached if the step was canceled, thus the stats of a canceled step stay empty.
+        m_step_allocation_stats[step] = allocation_stats() - m_step_allocation_start[step];
         if (status.second)
             this->status_update_warnings(m_print, static_cast<int>(step), PrintStateBase::WarningLevel::NON_CRITICAL, std::string());
         return status.first;
 	}
 
-    bool            invalidate_step(PrintObjectStepEnum step)
-        { return m_state.invalidate(step, PrintObjectBase::cancel_callback(m_print)); }
+    bool            invalidate_step(PrintObjectStepEnum step) {
+        bool invalidated = m_state.invalidate(step, PrintObjectBase::cancel_callback(m_print));
+        m_step_allocation_stats[step] = AllocationStats();
+        return invalidated;
+    }
     template<typename StepTypeIterator>
-    bool            invalidate_steps(StepTypeIterator step_begin, StepTypeIterator step_end)
-        { return m_state.invalidate_multiple(step_begin, step_end, PrintObjectBase::cancel_callback(m_print)); }
+    bool            invalidate_steps(StepTypeIterator step_begin, StepTypeIterator step_end) {
+        bool invalidated = m_state.invalidate_multiple(step_begin, step_end, PrintObjectBase::cancel_callback(m_print));
+        for (StepTypeIterator it = step_begin; it != step_end; ++ it)
+            m_step_allocation_stats[*it] = AllocationStats();
+        return invalidated;
+    }
     bool            invalidate_steps(std::initializer_list<PrintObjectStepEnum> il)
-        { return m_state.invalidate_multiple(il.begin(), il.end(), PrintObjectBase::cancel_callback(m_print)); }
-    bool            invalidate_all_steps()
-        { return m_state.invalidate_all(PrintObjectBase::cancel_callback(m_print)); }
-    bool            invalidate_all_steps_without_cancel()
-        { return m_state.invalidate_all([](){}); }
+        { return this->invalidate_steps(il.begin(), il.end()); }
+    bool            invalidate_all_steps() {
+        bool invalidated = m_state.invalidate_all(PrintObjectBase::cancel_callback(m_print));
+        m_step_allocation_stats.fill(AllocationStats());
+        return invalidated;
+    }
+    bool            invalidate_all_steps_without_cancel() {
+        bool invalidated = m_state.invalidate_all([](){});
+        m_step_allocation_stats.fill(AllocationStats());
+        return invalidated;
+    }
 
     bool            is_step_started_unguarded(PrintObjectStepEnum step) const { return m_state.is_started_unguarded(step); }
     bool            is_step_done_unguarded(PrintObjectStepEnum step) const { return m_state.is_done_unguarded(step); }
@@ -681,6 +707,10 @@ protected:
 
 private:
     PrintState<PrintObjectStepEnum, COUNT>   m_state;
+    // Allocations of the steps, filled in by set_done().
+    std::array<AllocationStats, COUNT>       m_step_allocation_stats;
+    // Snapshots of the allocation counters taken by set_started().
+    std::array<AllocationStats, COUNT>       m_step_allocation_start;
 };
 
 } // namespace Slic3r
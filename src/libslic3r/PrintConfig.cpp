@@ -190,7 +190,10 @@ static t_config_enum_values s_keys_map_InfillPattern {
     { "crosshatch",         ipCrossHatch},
     { "zigzag",             ipZigZag },
     { "crosszag",           ipCrossZag },
-    { "lockedzag",          ipLockedZag }
+    { "lockedzag",          ipLockedZag },
+    { "schwarzp",           ipSchwarzP },
+    { "schwarzd",           ipSchwarzD },
+    { "neovius",            ipNeovius }
 };
 CONFIG_OPTION_ENUM_DEFINE_STATIC_MAPS(InfillPattern)
 
@@ -2399,6 +2402,9 @@ void PrintConfigDef::init_fff_params()
     def->enum_values.push_back("zigzag");
     def->enum_values.push_back("crosszag");
     def->enum_values.push_back("lockedzag");
+    def->enum_values.push_back("schwarzp");
+    def->enum_values.push_back("schwarzd");
+    def->enum_values.push_back("neovius");
     def->enum_labels.push_back(L("Concentric"));
     def->enum_labels.push_back(L("Rectilinear"));
     def->enum_labels.push_back(L("Grid"));
@@ -2420,6 +2426,9 @@ void PrintConfigDef::init_fff_params()
     def->enum_labels.push_back(L("Zig Zag"));
     def->enum_labels.push_back(L("Cross Zag"));
     def->enum_labels.push_back(L("Locked Zag"));
+    def->enum_labels.push_back(L("Schwarz P"));
+    def->enum_labels.push_back(L("Schwarz D"));
+    def->enum_labels.push_back(L("Neovius"));
     def->set_default_value(new ConfigOptionEnum<InfillPattern>(ipCubic));
 
     def                = this->add("locked_skin_infill_pattern", coEnum);
@@ -8879,6 +8888,31 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = "Camera view angle for exporting png: 0-Iso, 1-Top_Front, 2-Left, 3-Right, 10-Iso_1, 11-Iso_2, 12-Iso_3";
     def->cli_params = "angle";
     def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("parallel_plates", coInt);
+    def->label = "Plates sliced in parallel";
+    def->tooltip = "Number of plates sliced and exported concurrently when slicing all plates, each plate with its own print. 0 uses the number of hardware threads.";
+    def->cli_params = "count";
+    def->set_default_value(new ConfigOptionInt(1));
+
+    def = this->add("trace_output", coString);
+    def->label = "Trace output file";
+    def->tooltip = "Record the timing of the slicing steps, the per layer tasks and the G-code export on every thread, and save it as a Chrome trace event JSON, which can be opened by chrome://tracing or the Perfetto UI.";
+    def->cli_params = "trace.json";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("gcode_memory_limit", coInt);
+    def->label = "G-code export memory limit";
+    def->tooltip = "Memory in MB the G-code export may hold the G-code of the processed layers in, the G-code of further layers is spilled into a temporary file. 0 does not limit the memory.";
+    def->cli_params = "MB";
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("daemon", coString);
+    def->label = "Run as slicing daemon";
+    def->tooltip = "Keep running and slice the jobs sent to this unix socket, reusing the loaded models and slicing results between the jobs.";
+    def->cli_params = "socket";
+    def->set_default_value(new ConfigOptionString());
 }
 
 const CLIActionsConfigDef    cli_actions_config_def;
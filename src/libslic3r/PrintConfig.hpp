@@ -56,7 +56,7 @@ enum AuthorizationType {
 enum InfillPattern : int {
     ipConcentric, ipRectilinear, ipGrid, ipLine, ipCubic, ipTriangles, ipStars, ipGyroid, ipHoneycomb, ipAdaptiveCubic, ipMonotonic, ipMonotonicLine, ipAlignedRectilinear, ip3DHoneycomb,
     ipHilbertCurve, ipArchimedeanChords, ipOctagramSpiral, ipSupportCubic, ipSupportBase, ipConcentricInternal,
-    ipLightning, ipCrossHatch, ipZigZag, ipCrossZag,ipFloatingConcentric, ipLockedZag,
+    ipLightning, ipCrossHatch, ipZigZag, ipCrossZag,ipFloatingConcentric, ipLockedZag, ipSchwarzP, ipSchwarzD, ipNeovius,
     ipCount,
 };
 
@@ -623,14 +623,20 @@ protected:
 
         ConfigOption*       optptr(const std::string &name, T *owner) const
         {
+            if (t_config_option_key_id id = ConfigOptionKeyTable::find(name); id < m_offset_by_id.size())
+                return this->optptr_by_id(id, owner);
             const auto it = m_map_name_to_offset.find(name);
             return (it == m_map_name_to_offset.end()) ? nullptr : reinterpret_cast<ConfigOption*>((char*)owner + it->second);
         }
 
         const ConfigOption* optptr(const std::string &name, const T *owner) const
         {
-            const auto it = m_map_name_to_offset.find(name);
-            return (it == m_map_name_to_offset.end()) ? nullptr : reinterpret_cast<const ConfigOption*>((const char*)owner + it->second);
+            return this->optptr(name, const_cast<T*>(owner));
+        }
+
+        ConfigOption*       optptr_by_id(t_config_option_key_id id, T *owner) const
+        {
+            return (id >= m_offset_by_id.size() || m_offset_by_id[id] < 0) ? nullptr : reinterpret_cast<ConfigOption*>((char*)owner + m_offset_by_id[id]);
         }
 
         const std::vector<std::string>& keys()      const { return m_keys; }
@@ -645,6 +651,11 @@ protected:
             m_defaults = defaults;
             m_keys.clear();
             m_keys.reserve(m_map_name_to_offset.size());
+            // Offsets indexed by the interned option keys, -1 for the options not held by T.
+            m_offset_by_id.assign(ConfigOptionKeyTable::size(), -1);
+            for (const auto &kvp : m_map_name_to_offset)
+                if (t_config_option_key_id id = ConfigOptionKeyTable::find(kvp.first); id != CONFIG_OPTION_KEY_ID_INVALID)
+                    m_offset_by_id[id] = kvp.second;
             for (const auto &kvp : defs->options) {
                 // Find the option given the option name kvp.first by an offset from (char*)m_defaults.
                 ConfigOption *opt = this->optptr(kvp.first, m_defaults);
@@ -662,6 +673,7 @@ protected:
     private:
         T                                  *m_defaults;
         std::vector<std::string>            m_keys;
+        std::vector<ptrdiff_t>              m_offset_by_id;
     };
 };
 
@@ -673,6 +685,9 @@ public: \
     /* Overrides ConfigBase::optptr(). Find ando/or create a ConfigOption instance for a given name. */ \
     ConfigOption*            optptr(const t_config_option_key &opt_key, bool create = false) override \
         { return s_cache_##CLASS_NAME.optptr(opt_key, this); } \
+    /* Overrides ConfigOptionResolver::optptr_by_id(). Constant time lookup of an option by its interned key. */ \
+    const ConfigOption*      optptr_by_id(t_config_option_key_id opt_key_id) const override \
+        { return s_cache_##CLASS_NAME.optptr_by_id(opt_key_id, const_cast<CLASS_NAME*>(this)); } \
     /* Overrides ConfigBase::keys(). Collect names of all configuration values maintained by this configuration store. */ \
     t_config_option_keys     keys() const override { return s_cache_##CLASS_NAME.keys(); } \
     const t_config_option_keys& keys_ref() const override { return s_cache_##CLASS_NAME.keys(); } \
@@ -7,6 +7,7 @@
 #include "I18N.hpp"
 #include "Layer.hpp"
 #include "MutablePolygon.hpp"
+#include "ScratchArena.hpp"
 #include "Support/SupportMaterial.hpp"
 #include "Support/TreeSupport.hpp"
 #include "Surface.hpp"
@@ -19,6 +20,7 @@
 #include "Format/STL.hpp"
 #include "InternalBridgeDetector.hpp"
 #include "AABBTreeLines.hpp"
+#include "Trace.hpp"
 
 #include <float.h>
 #include <string_view>
@@ -380,6 +382,7 @@ void PrintObject::make_perimeters()
 
     if (! this->set_started(posPerimeters))
         return;
+    SLIC3R_TRACE_SCOPE_ARG("posPerimeters", "PrintObjectStep", this->id().id);
 
     m_print->set_status(15, L("Generating walls"));
     BOOST_LOG_TRIVIAL(info) << "Generating walls..." << log_memory_info();
@@ -481,14 +484,27 @@ void PrintObject::make_perimeters()
     }
 #endif
 
-    BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
+    // If only some layer ranges were edited, keep the perimeters of the other layers. The perimeter continuity
+    // is chained through all the layers, thus everything is regenerated then.
+    const std::vector<unsigned char> dirty_layers = this->m_print->m_config.z_direction_outwall_speed_continuous ?
+        std::vector<unsigned char>(m_layers.size(), true) : this->dirty_layers_mask(posPerimeters, 1);
+    BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start, layers to regenerate: "
+                             << std::count(dirty_layers.begin(), dirty_layers.end(), true) << " of " << m_layers.size();
+    const ScratchArena::Stats scratch_stats_start = ScratchArena::stats();
 #if 1
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
-        [this](const tbb::blocked_range<size_t>& range) {
+        [this, &dirty_layers](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                if (! dirty_layers[layer_idx])
+                    continue;
+                SLIC3R_TRACE_SCOPE_ARG("make_perimeters", "layer", layer_idx);
+                // The scratch containers of the perimeter generator are released at the end of each layer.
+                ScratchArenaScope scratch;
                 m_print->throw_if_canceled();
                 m_layers[layer_idx]->make_perimeters();
+                // The offsets of the lower layer were only shared by the perimeter generators of this layer.
+                m_layers[layer_idx]->interlayer_delta.release_offsets();
             }
         }
     );
@@ -500,6 +516,8 @@ void PrintObject::make_perimeters()
 #endif
     m_print->throw_if_canceled();
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - end";
+    BOOST_LOG_TRIVIAL(debug) << "Generating perimeters: " << ScratchArena::stats().allocations - scratch_stats_start.allocations
+                             << " heap allocations served by the scratch arenas";
 
     if (this->m_print->m_config.z_direction_outwall_speed_continuous) {
         // BBS: get continuity of nodes
@@ -544,6 +562,7 @@ void PrintObject::make_perimeters()
         m_print->throw_if_canceled();
         BOOST_LOG_TRIVIAL(debug) << "Recrod cooling_node id for each extrusion in parallel - end";
     }
+    this->clear_dirty_layers(posPerimeters);
     this->set_done(posPerimeters);
 }
 
@@ -551,6 +570,7 @@ void PrintObject::prepare_infill()
 {
     if (! this->set_started(posPrepareInfill))
         return;
+    SLIC3R_TRACE_SCOPE_ARG("posPrepareInfill", "PrintObjectStep", this->id().id);
     m_print->set_status(25, L("Generating infill regions"));
     if (m_typed_slices) {
         // To improve robustness of detect_surfaces_type() when reslicing (working with typed slices), see GH issue #7442.
@@ -681,16 +701,24 @@ void PrintObject::infill()
     this->prepare_infill();
 
     if (this->set_started(posInfill)) {
+        SLIC3R_TRACE_SCOPE_ARG("posInfill", "PrintObjectStep", this->id().id);
         m_print->set_status(35, L("Generating infill toolpath"));
 
         const auto& adaptive_fill_octree = this->m_adaptive_fill_octrees.first;
         const auto& support_fill_octree = this->m_adaptive_fill_octrees.second;
+        // If only some layer ranges were edited, keep the infill of the layers not reached by their shells.
+        const std::vector<unsigned char> dirty_layers = this->dirty_infill_layers_mask(posInfill);
 
         //BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - start";
+        const ScratchArena::Stats scratch_stats_start = ScratchArena::stats();
         tbb::parallel_for(
            tbb::blocked_range<size_t>(0, m_layers.size()),
-           [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree](const tbb::blocked_range<size_t>& range) {
+           [this, &dirty_layers, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree](const tbb::blocked_range<size_t>& range) {
                for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                   if (! dirty_layers[layer_idx])
+                       continue;
+                   SLIC3R_TRACE_SCOPE_ARG("make_fills", "layer", layer_idx);
+                   ScratchArenaScope scratch;
                    m_print->throw_if_canceled();
                    m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), this->m_lightning_generator.get());
                 }
@@ -698,9 +726,12 @@ void PrintObject::infill()
         );
         m_print->throw_if_canceled();
         BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - end";
+        BOOST_LOG_TRIVIAL(debug) << "Filling layers: " << ScratchArena::stats().allocations - scratch_stats_start.allocations
+                                 << " heap allocations served by the scratch arenas";
         /*  we could free memory now, but this would make this step not idempotent
         ### $_->fill_surfaces->clear for map @{$_->regions}, @{$object->layers};
         */
+        this->clear_dirty_layers(posInfill);
         this->set_done(posInfill);
     }
 }
@@ -708,12 +739,18 @@ void PrintObject::infill()
 void PrintObject::ironing()
 {
     if (this->set_started(posIroning)) {
+        SLIC3R_TRACE_SCOPE_ARG("posIroning", "PrintObjectStep", this->id().id);
         BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - start";
+        // Ironing is appended to the infill, thus only the layers with regenerated infill are ironed again.
+        const std::vector<unsigned char> dirty_layers = this->dirty_infill_layers_mask(posIroning);
         tbb::parallel_for(
             // Ironing starting with layer 0 to support ironing all surfaces.
             tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this](const tbb::blocked_range<size_t>& range) {
+            [this, &dirty_layers](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                    if (! dirty_layers[layer_idx])
+                        continue;
+                    SLIC3R_TRACE_SCOPE_ARG("make_ironing", "layer", layer_idx);
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->make_ironing();
                 }
@@ -721,6 +758,7 @@ void PrintObject::ironing()
         );
         m_print->throw_if_canceled();
         BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - end";
+        this->clear_dirty_layers(posIroning);
         this->set_done(posIroning);
     }
 }
@@ -741,6 +779,7 @@ static const float g_min_overhang_percent_for_lift = 0.3f;
 void PrintObject::detect_overhangs_for_lift()
 {
     if (this->set_started(posDetectOverhangsForLift)) {
+        SLIC3R_TRACE_SCOPE_ARG("posDetectOverhangsForLift", "PrintObjectStep", this->id().id);
         const float min_overlap = m_config.line_width * g_min_overhang_percent_for_lift;
         size_t num_layers = this->layer_count();
         size_t num_raft_layers = m_slicing_params.raft_layers();
@@ -752,10 +791,21 @@ void PrintObject::detect_overhangs_for_lift()
         tbb::spin_mutex layer_storage_mutex;
         tbb::parallel_for(tbb::blocked_range<size_t>(num_raft_layers + 1, num_layers), [this, min_overlap](const tbb::blocked_range<size_t> &range) {
             for (size_t layer_id = range.begin(); layer_id < range.end(); ++layer_id) {
+                SLIC3R_TRACE_SCOPE_ARG("detect_overhangs_for_lift", "layer", layer_id);
                 Layer &layer       = *m_layers[layer_id];
                 Layer &lower_layer = *layer.lower_layer;
 
-                ExPolygons overhangs = diff_ex(layer.lslices, offset_ex(lower_layer.lslices, scale_(min_overlap)));
+                ExPolygons overhangs;
+                if (! layer.interlayer_delta.valid()) {
+                    overhangs = diff_ex(layer.lslices, offset_ex(lower_layer.lslices, scale_(min_overlap)));
+                } else if (! layer.interlayer_delta.unsupported().empty()) {
+                    // The lower layer grown by min_overlap covers the supported part of the layer, thus only the unsupported islands are clipped,
+                    // and only by the lower layer around them.
+                    const ExPolygons &unsupported = layer.interlayer_delta.unsupported();
+                    BoundingBox       bbox        = get_extents(unsupported);
+                    bbox.offset(2. * scale_(min_overlap) + SCALED_EPSILON);
+                    overhangs = diff_ex(unsupported, offset(ClipperUtils::clip_clipper_polygons_with_subject_bbox(lower_layer.lslices, bbox), scale_(min_overlap)));
+                }
                 layer.loverhangs     = std::move(offset2_ex(overhangs, -0.1f * scale_(m_config.line_width), 0.1f * scale_(m_config.line_width)));
 
 #ifdef REGISTER_SUPPORTS_FOR_LIFT
@@ -783,6 +833,7 @@ void PrintObject::detect_overhangs_for_lift()
 void PrintObject::generate_support_material()
 {
     if (this->set_started(posSupportMaterial)) {
+        SLIC3R_TRACE_SCOPE_ARG("posSupportMaterial", "PrintObjectStep", this->id().id);
         this->clear_support_layers();
 
         if (!has_support() && !m_print->get_no_check_flag()) {
@@ -829,13 +880,17 @@ void PrintObject::generate_support_material()
 void PrintObject::simplify_extrusion_path()
 {
     if (this->set_started(posSimplifyWall)) {
+        SLIC3R_TRACE_SCOPE_ARG("posSimplifyWall", "PrintObjectStep", this->id().id);
         m_print->set_status(75, L("Optimizing toolpath"));
         BOOST_LOG_TRIVIAL(debug) << "Simplify wall extrusion path of object in parallel - start";
         //BBS: walls
+        const std::vector<unsigned char> dirty_layers = this->dirty_layers_mask(posSimplifyWall, 1);
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this](const tbb::blocked_range<size_t>& range) {
+            [this, &dirty_layers](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                    if (! dirty_layers[layer_idx])
+                        continue;
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->simplify_wall_extrusion_path();
                 }
@@ -843,17 +898,22 @@ void PrintObject::simplify_extrusion_path()
         );
         m_print->throw_if_canceled();
         BOOST_LOG_TRIVIAL(debug) << "Simplify wall extrusion path of object in parallel - end";
+        this->clear_dirty_layers(posSimplifyWall);
         this->set_done(posSimplifyWall);
     }
 
     if (this->set_started(posSimplifyInfill)) {
+        SLIC3R_TRACE_SCOPE_ARG("posSimplifyInfill", "PrintObjectStep", this->id().id);
         m_print->set_status(75, L("Optimizing toolpath"));
         BOOST_LOG_TRIVIAL(debug) << "Simplify infill extrusion path of object in parallel - start";
         //BBS: infills
+        const std::vector<unsigned char> dirty_layers = this->dirty_infill_layers_mask(posSimplifyInfill);
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this](const tbb::blocked_range<size_t>& range) {
+            [this, &dirty_layers](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
+                    if (! dirty_layers[layer_idx])
+                        continue;
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->simplify_infill_extrusion_path();
                 }
@@ -861,10 +921,12 @@ void PrintObject::simplify_extrusion_path()
         );
         m_print->throw_if_canceled();
         BOOST_LOG_TRIVIAL(debug) << "Simplify infill extrusion path of object in parallel - end";
+        this->clear_dirty_layers(posSimplifyInfill);
         this->set_done(posSimplifyInfill);
     }
 
     if (this->set_started(posSimplifySupportPath)) {
+        SLIC3R_TRACE_SCOPE_ARG("posSimplifySupportPath", "PrintObjectStep", this->id().id);
         m_print->set_status(75, L("Optimizing toolpath"));
         BOOST_LOG_TRIVIAL(debug) << "Simplify extrusion path of support in parallel - start";
         tbb::parallel_for(
@@ -1293,8 +1355,21 @@ bool PrintObject::invalidate_state_by_config_options(
     return invalidated;
 }
 
+bool PrintObject::invalidate_state_by_config_options(
+    const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys,
+    const t_layer_height_range &z_range)
+{
+    m_invalidated_z_range = &z_range;
+    bool invalidated = this->invalidate_state_by_config_options(old_config, new_config, opt_keys);
+    m_invalidated_z_range = nullptr;
+    return invalidated;
+}
+
 bool PrintObject::invalidate_step(PrintObjectStep step)
 {
+    // Needs to be called before the steps are invalidated to know which of them were done.
+    this->mark_dirty_layers(step);
+
 	bool invalidated = Inherited::invalidate_step(step);
 
     // propagate to dependent steps
@@ -1331,9 +1406,95 @@ bool PrintObject::invalidate_all_steps()
     bool result = Inherited::invalidate_all_steps() | m_print->invalidate_all_steps();
 	// Then reset some of the depending values.
 	m_slicing_params.valid = false;
+    m_dirty_layers.fill({});
 	return result;
 }
 
+void PrintObject::mark_dirty_layers(PrintObjectStep step)
+{
+    auto mark = [this](PrintObjectStep dependent_step) {
+        DirtyLayers &dirty = m_dirty_layers[dependent_step];
+        if (m_invalidated_z_range == nullptr)
+            dirty = {};
+        else if (this->is_step_done_unguarded(dependent_step))
+            // All layers are valid, only the edited layer range becomes stale.
+            dirty = { false, { *m_invalidated_z_range } };
+        else if (! dirty.all)
+            // Invalidated before by another layer range edit only.
+            dirty.ranges.emplace_back(*m_invalidated_z_range);
+    };
+    switch (step) {
+    case posSlice:
+        // New layers, nothing to reuse.
+        for (PrintObjectStep dependent_step : { posPerimeters, posInfill, posIroning, posSimplifyWall, posSimplifyInfill })
+            m_dirty_layers[dependent_step] = {};
+        break;
+    case posPerimeters:
+        mark(posPerimeters);
+        [[fallthrough]];
+    case posPrepareInfill:
+        mark(posSimplifyWall);
+        [[fallthrough]];
+    case posInfill:
+        mark(posInfill);
+        mark(posIroning);
+        mark(posSimplifyInfill);
+        break;
+    case posIroning:
+    case posSimplifyWall:
+    case posSimplifyInfill:
+        // Invalidated directly, not through an edited layer range, thus all of their layers are redone.
+        m_dirty_layers[step] = {};
+        break;
+    default:
+        break;
+    }
+}
+
+std::vector<unsigned char> PrintObject::dirty_layers_mask(PrintObjectStep step, size_t num_neighbors) const
+{
+    const DirtyLayers &dirty = m_dirty_layers[step];
+    if (dirty.all)
+        return std::vector<unsigned char>(m_layers.size(), true);
+    std::vector<unsigned char> mask(m_layers.size(), false);
+    for (const t_layer_height_range &range : dirty.ranges) {
+        // Layers are sorted by slice_z.
+        auto it_begin = std::lower_bound(m_layers.begin(), m_layers.end(), range.first - EPSILON,
+            [](const Layer *layer, double z) { return layer->slice_z < z; });
+        auto it_end   = std::upper_bound(it_begin, m_layers.end(), range.second + EPSILON,
+            [](double z, const Layer *layer) { return z < layer->slice_z; });
+        size_t begin  = size_t(it_begin - m_layers.begin());
+        size_t end    = size_t(it_end - m_layers.begin());
+        if (begin == end)
+            continue;
+        begin = begin > num_neighbors ? begin - num_neighbors : 0;
+        end   = std::min(end + num_neighbors, m_layers.size());
+        std::fill(mask.begin() + begin, mask.begin() + end, true);
+    }
+    return mask;
+}
+
+std::vector<unsigned char> PrintObject::dirty_infill_layers_mask(PrintObjectStep step) const
+{
+    // The lightning trees, the combined infill and the infill only where needed are grown over many layers.
+    // The adaptive and support cubic octrees are built for the whole object from the densities of all the regions.
+    bool   all_layers = m_lightning_generator || PrintObject::infill_only_where_needed ||
+                        m_adaptive_fill_octrees.first || m_adaptive_fill_octrees.second;
+    double min_layer_height = std::numeric_limits<double>::max();
+    for (const Layer *layer : m_layers)
+        min_layer_height = std::min(min_layer_height, layer->height);
+    size_t num_shell_layers = 0;
+    for (size_t region_id = 0; region_id < this->num_printing_regions() && ! all_layers; ++ region_id) {
+        const PrintRegionConfig &config = this->printing_region(region_id).config();
+        all_layers |= config.infill_combination.value;
+        num_shell_layers = std::max({ num_shell_layers, size_t(config.top_shell_layers.value), size_t(config.bottom_shell_layers.value),
+            size_t(std::ceil(std::max(config.top_shell_thickness.value, config.bottom_shell_thickness.value) / min_layer_height)) });
+    }
+    // The top / bottom shells of the stale layers are propagated to that many layers by discover_vertical_shells()
+    // and discover_horizontal_shells(), bridge_over_infill() looks one more layer down.
+    return all_layers ? std::vector<unsigned char>(m_layers.size(), true) : this->dirty_layers_mask(step, num_shell_layers + 2);
+}
+
 void PrintObject::reset_slice_surfaces(const std::vector<std::vector<SurfaceCollection>> &slice_surfaces_cpy){
     //reset infill surface and slice data back
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id) {
@@ -1372,6 +1533,10 @@ void PrintObject::detect_surfaces_type(std::vector<std::vector<SurfaceCollection
     bool spiral_mode      = this->print()->config().spiral_mode.value;
     bool interface_shells = ! spiral_mode && m_config.interface_shells.value;
     size_t num_layers     = spiral_mode ? std::min(size_t(this->printing_region(0).config().bottom_shell_layers), m_layers.size()) : m_layers.size();
+    // The index of the overhangs built by posSlice is only valid for the region slices contained in lslices,
+    // the circle compensation may grow them.
+    bool use_interlayer_delta = ! m_config.enable_circle_compensation &&
+        std::all_of(m_layers.begin(), m_layers.end(), [](const Layer *layer) { return layer->interlayer_delta.valid(); });
 
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id) {
         BOOST_LOG_TRIVIAL(debug) << "Detecting solid surfaces for region " << region_id << " in parallel - start";
@@ -1395,7 +1560,7 @@ void PrintObject::detect_surfaces_type(std::vector<std::vector<SurfaceCollection
             		((num_layers > 1) ? num_layers - 1 : num_layers) :
             		// In non-spiral vase mode, go over all layers.
             		m_layers.size()),
-                [this, spiral_mode, region_id, interface_shells, &surfaces_new, &slice_surfaces_cpy](const tbb::blocked_range<size_t> &range) {
+                [this, spiral_mode, region_id, interface_shells, use_interlayer_delta, &surfaces_new, &slice_surfaces_cpy](const tbb::blocked_range<size_t> &range) {
                 // BBS coconut: can't set to stBottom when soluable support is used, as the support may not be actaully generated, e.g. when "on build plate only" option is enabled. See github #3507.
                 SurfaceType surface_type_bottom_other = stBottomBridge;
                 for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++ idx_layer) {
@@ -1452,12 +1617,18 @@ void PrintObject::detect_surfaces_type(std::vector<std::vector<SurfaceCollection
                                 surface_type_bottom_other);
 #else
                             // Any surface lying on the void is a true bottom bridge (an overhang)
-                            surfaces_append(
-                                bottom,
-                                opening_ex(
-                                    diff_ex(layerm->slices.surfaces, lower_layer->lslices, ApplySafetyOffset::Yes),//完全悬空
-                                    offset),
-                                surface_type_bottom_other);
+                            // Only the surfaces overlapping the islands of the layer not resting on the lower layer are clipped.
+                            SurfacesPtr overhanging;
+                            for (Surface &surface : layerm->slices.surfaces)
+                                if (! use_interlayer_delta || layer->interlayer_delta.unsupported_overlaps(get_extents(surface.expolygon.contour)))
+                                    overhanging.emplace_back(&surface);
+                            if (! overhanging.empty())
+                                surfaces_append(
+                                    bottom,
+                                    opening_ex(
+                                        diff_ex(overhanging, lower_layer->lslices, ApplySafetyOffset::Yes),//完全悬空
+                                        offset),
+                                    surface_type_bottom_other);
                             // if user requested internal shells, we need to identify surfaces
                             // lying on other slices not belonging to this region
                             if (interface_shells) {
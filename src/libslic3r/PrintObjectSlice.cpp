@@ -7,6 +7,7 @@
 #include "Interlocking/InterlockingGenerator.hpp"
 //BBS
 #include "ShortestPath.hpp"
+#include "Trace.hpp"
 
 #include <boost/log/trivial.hpp>
 
@@ -792,6 +793,7 @@ void PrintObject::slice()
 {
     if (! this->set_started(posSlice))
         return;
+    SLIC3R_TRACE_SCOPE_ARG("posSlice", "PrintObjectStep", this->id().id);
     //BBS: add flag to reload scene for shell rendering
     m_print->set_status(5, L("Slicing mesh"), PrintBase::SlicingStatus::RELOAD_SCENE);
     std::vector<coordf_t> layer_height_profile;
@@ -820,17 +822,20 @@ void PrintObject::slice()
     // BBS: the actual first layer slices stored in layers are re-sorted by volume group and will be used to generate brim
     groupingVolumesForBrim(this, m_layers, firstLayerReplacedBy);
 
-    // Update bounding boxes, back up raw slices of complex models.
+    // Update bounding boxes, index the differences against the lower layers, back up raw slices of complex models.
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
         [this](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                SLIC3R_TRACE_SCOPE_ARG("backup_untyped_slices", "layer", layer_idx);
                 m_print->throw_if_canceled();
                 Layer &layer = *m_layers[layer_idx];
                 layer.lslices_bboxes.clear();
                 layer.lslices_bboxes.reserve(layer.lslices.size());
                 for (const ExPolygon &expoly : layer.lslices)
                 	layer.lslices_bboxes.emplace_back(get_extents(expoly));
+                // The lslices of all layers are final at this point.
+                layer.interlayer_delta.build(layer.lslices, layer.lower_layer ? &layer.lower_layer->lslices : nullptr);
                 layer.backup_untyped_slices();
             }
         });
@@ -845,7 +850,7 @@ template<typename ThrowOnCancel>
 static inline void apply_mm_segmentation(PrintObject &print_object, ThrowOnCancel throw_on_cancel)
 {
     // Returns MMU segmentation based on painting in MMU segmentation gizmo
-    std::vector<std::vector<ExPolygons>> segmentation = multi_material_segmentation_by_painting(print_object, throw_on_cancel);
+    std::vector<std::vector<ExPolygons>> segmentation = multi_material_segmentation_by_painting(print_object, throw_on_cancel, &print_object.mm_segmentation_cache());
     assert(segmentation.size() == print_object.layer_count());
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, segmentation.size(), std::max(segmentation.size() / 128, size_t(1))),
@@ -971,7 +976,7 @@ static inline void apply_mm_segmentation(PrintObject &print_object, ThrowOnCance
 template<typename ThrowOnCancel> void apply_fuzzy_skin_segmentation(PrintObject &print_object, ThrowOnCancel throw_on_cancel)
 {
     // Returns fuzzy skin segmentation based on painting in the fuzzy skin painting gizmo.
-    std::vector<std::vector<ExPolygons>> segmentation = fuzzy_skin_segmentation_by_painting(print_object, throw_on_cancel);
+    std::vector<std::vector<ExPolygons>> segmentation = fuzzy_skin_segmentation_by_painting(print_object, throw_on_cancel, &print_object.fuzzy_skin_segmentation_cache());
     assert(segmentation.size() == print_object.layer_count());
 
     struct ByRegion
@@ -1086,6 +1091,7 @@ template<typename ThrowOnCancel> void apply_fuzzy_skin_segmentation(PrintObject
 // this should be idempotent
 void PrintObject::slice_volumes()
 {
+    SLIC3R_TRACE_SCOPE_ARG("slice_volumes", "PrintObject", this->id().id);
     BOOST_LOG_TRIVIAL(info) << "Slicing volumes..." << log_memory_info();
     const Print *print                      = this->print();
     const auto   throw_on_cancel_callback   = std::function<void()>([print](){ print->throw_if_canceled(); });
@@ -1159,6 +1165,9 @@ void PrintObject::slice_volumes()
 
         BOOST_LOG_TRIVIAL(debug) << "Slicing volumes - MMU segmentation";
         apply_mm_segmentation(*this, [print]() { print->throw_if_canceled(); });
+    } else {
+        // Release the layers of a removed painting.
+        m_mm_segmentation_cache.clear();
     }
 
      // Is any ModelVolume fuzzy skin painted?
@@ -1175,6 +1184,8 @@ void PrintObject::slice_volumes()
 
         BOOST_LOG_TRIVIAL(debug) << "Slicing volumes - Fuzzy skin segmentation";
         apply_fuzzy_skin_segmentation(*this, [print]() { print->throw_if_canceled(); });
+    } else {
+        m_fuzzy_skin_segmentation_cache.clear();
     }
 
     InterlockingGenerator::generate_interlocking_structure(this);
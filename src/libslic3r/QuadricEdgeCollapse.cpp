@@ -2,6 +2,9 @@
 #include <tuple>
 #include <optional>
 #include "MutablePriorityQueue.hpp"
+#include <atomic>
+#include <mutex>
+#include <numeric>
 #include <tbb/parallel_for.h>
 
 using namespace Slic3r;
@@ -133,7 +136,17 @@ namespace QuadricEdgeCollapse {
     void change_neighbors(EdgeInfos &e_infos, VertexInfos &v_infos, uint32_t ti0, uint32_t ti1,
                           uint32_t vi0, uint32_t vi1, uint32_t vi_top0,
                           const Triangle &t1, CopyEdgeInfos& infos, EdgeInfos &e_infos1);
-    void compact(const VertexInfos &v_infos, const TriangleInfos &t_infos, const EdgeInfos &e_infos, indexed_triangle_set &its);
+    void compact(const VertexInfos &v_infos, const TriangleInfos &t_infos, const EdgeInfos &e_infos, indexed_triangle_set &its,
+                 std::vector<uint32_t> *vertex_map = nullptr);
+    // Collapse edges until triangle_count or maximal_error is reached. Vertices marked as locked are not moved,
+    // they are removed only together with the last of their triangles.
+    // vertex_map (optional) is filled with the new index of each input vertex, or -1 for a removed one.
+    // Returns error of the last collapsed edge.
+    float collapse_edges(indexed_triangle_set &its, uint32_t triangle_count, float maximal_error,
+                         const std::vector<bool> *locked, std::vector<uint32_t> *vertex_map,
+                         ThrowOnCancel &throw_on_cancel, StatusFn &status_fn);
+    // Split triangles into spatially coherent cells of at most max_cell_size triangles by recursive median split.
+    std::vector<std::vector<uint32_t>> partition(const indexed_triangle_set &its, size_t max_cell_size);
 
 #ifdef EXPENSIVE_DEBUG_CHECKS
     void store_surround(const char *obj_filename, size_t triangle_index, int depth, const indexed_triangle_set &its,
@@ -153,6 +166,10 @@ namespace QuadricEdgeCollapse {
     const int status_set_offsets = 10;
     const int status_calc_errors = 30;
     const int status_create_refs = 10;
+    // partitioned simplification
+    const size_t min_triangle_count_for_partition = 200000;
+    const size_t partition_cell_size = 50000;
+    const int status_partition_size = 80; // in percents, the rest is for the border pass
     } // namespace QuadricEdgeCollapse
 
 using namespace QuadricEdgeCollapse;
@@ -171,6 +188,139 @@ void Slic3r::its_quadric_edge_collapse(
     if (throw_on_cancel == nullptr) throw_on_cancel = []() {};
     if (status_fn == nullptr) status_fn = [](int) {};
 
+    float last_collapsed_error = collapse_edges(its, triangle_count, maximal_error, nullptr, nullptr, throw_on_cancel, status_fn);
+    if (max_error != nullptr) *max_error = last_collapsed_error;
+}
+
+void Slic3r::its_quadric_edge_collapse_partitioned(
+    indexed_triangle_set &    its,
+    uint32_t                  triangle_count,
+    float *                   max_error,
+    std::function<void(void)> throw_on_cancel,
+    std::function<void(int)>  status_fn)
+{
+    // check input
+    if (triangle_count >= its.indices.size()) return;
+    if (its.indices.size() < min_triangle_count_for_partition) {
+        // Not worth the partitioning overhead.
+        its_quadric_edge_collapse(its, triangle_count, max_error, throw_on_cancel, status_fn);
+        return;
+    }
+    float maximal_error = (max_error == nullptr)? std::numeric_limits<float>::max() : *max_error;
+    if (maximal_error <= 0.f) return;
+    if (throw_on_cancel == nullptr) throw_on_cancel = []() {};
+    if (status_fn == nullptr) status_fn = [](int) {};
+
+    std::vector<std::vector<uint32_t>> cells = partition(its, partition_cell_size);
+    throw_on_cancel();
+
+    // Vertices shared by triangles of more than one cell are locked, so that the cells may be collapsed independently.
+    static constexpr const int border = -2;
+    std::vector<int> vertex_cell(its.vertices.size(), -1);
+    for (size_t cell_id = 0; cell_id < cells.size(); ++ cell_id)
+        for (uint32_t ti : cells[cell_id])
+            for (int vi : its.indices[ti])
+                if (int &c = vertex_cell[vi]; c == -1)
+                    c = int(cell_id);
+                else if (c != int(cell_id))
+                    c = border;
+
+    std::vector<ItsSimplifiedCell> results(cells.size());
+    std::vector<float>             last_collapsed_errors(cells.size(), 0.f);
+    const double      ratio = double(triangle_count) / double(its.indices.size());
+    std::atomic<size_t> cells_done { 0 };
+    std::mutex          status_mutex;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, cells.size(), 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t cell_id = range.begin(); cell_id < range.end(); ++ cell_id) {
+            const std::vector<uint32_t> &cell = cells[cell_id];
+            ItsSimplifiedCell           &out  = results[cell_id];
+            // Local copy of the cell with compacted vertex indices.
+            std::vector<uint32_t> vertices;
+            vertices.reserve(cell.size());
+            for (uint32_t ti : cell)
+                for (int vi : its.indices[ti])
+                    vertices.emplace_back(uint32_t(vi));
+            sort_remove_duplicates(vertices);
+            auto local_index = [&vertices](int vi) { return int(std::lower_bound(vertices.begin(), vertices.end(), uint32_t(vi)) - vertices.begin()); };
+            out.its.vertices.reserve(vertices.size());
+            for (uint32_t vi : vertices)
+                out.its.vertices.emplace_back(its.vertices[vi]);
+            out.its.indices.reserve(cell.size());
+            for (uint32_t ti : cell) {
+                const Triangle &t = its.indices[ti];
+                out.its.indices.emplace_back(local_index(t[0]), local_index(t[1]), local_index(t[2]));
+            }
+            std::vector<bool> locked(vertices.size(), false);
+            for (size_t i = 0; i < vertices.size(); ++ i)
+                locked[i] = vertex_cell[vertices[i]] == border;
+
+            std::vector<uint32_t> vertex_map;
+            StatusFn              cell_status_fn = [](int) {};
+            last_collapsed_errors[cell_id] = collapse_edges(out.its, uint32_t(std::round(cell.size() * ratio)), maximal_error,
+                &locked, &vertex_map, throw_on_cancel, cell_status_fn);
+            its_map_locked_vertices(out, vertices, locked, vertex_map);
+
+            std::lock_guard<std::mutex> lk(status_mutex);
+            status_fn(int(status_partition_size * (++ cells_done) / cells.size()));
+        }
+    });
+    throw_on_cancel();
+
+    // Stitch the cells together, the locked vertices were not moved, thus they are shared by index.
+    its = its_stitch_cells(its, results);
+    float last_collapsed_error = *std::max_element(last_collapsed_errors.begin(), last_collapsed_errors.end());
+
+    // Final pass over the whole mesh collapses the edges around the formerly locked cell borders.
+    StatusFn border_status_fn = [&status_fn](int percent) {
+        status_fn(status_partition_size + static_cast<int>(std::round(percent * (100 - status_partition_size) / 100.f)));
+    };
+    if (triangle_count < its.indices.size())
+        last_collapsed_error = std::max(last_collapsed_error,
+            collapse_edges(its, triangle_count, maximal_error, nullptr, nullptr, throw_on_cancel, border_status_fn));
+    if (max_error != nullptr) *max_error = last_collapsed_error;
+}
+
+void Slic3r::its_map_locked_vertices(ItsSimplifiedCell &cell, const std::vector<uint32_t> &vertices,
+                                     const std::vector<bool> &locked, const std::vector<uint32_t> &vertex_map)
+{
+    assert(vertices.size() == locked.size() && vertices.size() == vertex_map.size());
+    cell.global_vertex.assign(cell.its.vertices.size(), uint32_t(-1));
+    for (size_t i = 0; i < vertices.size(); ++ i)
+        // A locked vertex is not moved, though it is removed with its last triangle, then there is nothing to stitch.
+        if (locked[i] && vertex_map[i] != uint32_t(-1))
+            cell.global_vertex[vertex_map[i]] = vertices[i];
+}
+
+indexed_triangle_set Slic3r::its_stitch_cells(const indexed_triangle_set &its, const std::vector<ItsSimplifiedCell> &cells)
+{
+    indexed_triangle_set  merged;
+    std::vector<uint32_t> border_vertex_map(its.vertices.size(), uint32_t(-1));
+    for (const ItsSimplifiedCell &cell : cells) {
+        std::vector<int> map(cell.its.vertices.size());
+        for (size_t i = 0; i < cell.its.vertices.size(); ++ i) {
+            uint32_t global = cell.global_vertex[i];
+            if (global == uint32_t(-1)) {
+                map[i] = int(merged.vertices.size());
+                merged.vertices.emplace_back(cell.its.vertices[i]);
+            } else {
+                uint32_t &new_index = border_vertex_map[global];
+                if (new_index == uint32_t(-1)) {
+                    new_index = uint32_t(merged.vertices.size());
+                    merged.vertices.emplace_back(its.vertices[global]);
+                }
+                map[i] = int(new_index);
+            }
+        }
+        for (const Triangle &t : cell.its.indices)
+            merged.indices.emplace_back(map[t[0]], map[t[1]], map[t[2]]);
+    }
+    return merged;
+}
+
+float QuadricEdgeCollapse::collapse_edges(indexed_triangle_set &its, uint32_t triangle_count, float maximal_error,
+                                          const std::vector<bool> *locked, std::vector<uint32_t> *vertex_map,
+                                          ThrowOnCancel &throw_on_cancel, StatusFn &status_fn)
+{
     StatusFn init_status_fn = [&](int percent) {
         float n_percent = percent * status_init_size / 100.f;
         status_fn(static_cast<int>(std::round(n_percent)));
@@ -255,7 +405,8 @@ void Slic3r::its_quadric_edge_collapse(
             reorder_edges(e_infos, v_info0, ti0, ti1);
             reorder_edges(e_infos, v_info1, ti0, ti1);
         }
-        if (!ti1_opt.has_value() || // edge has only one triangle
+        if ((locked != nullptr && ((*locked)[vi0] || (*locked)[vi1])) ||
+            !ti1_opt.has_value() || // edge has only one triangle
             degenerate(vi0, ti0, ti1, v_info1, e_infos, its.indices) ||
             degenerate(vi1, ti0, ti1, v_info0, e_infos, its.indices) ||
             create_no_volume(vi0, vi1, ti0, ti1, v_info0, v_info1, e_infos, its.indices) ||
@@ -342,8 +493,45 @@ void Slic3r::its_quadric_edge_collapse(
     }
 
     // compact triangle
-    compact(v_infos, t_infos, e_infos, its);
-    if (max_error != nullptr) *max_error = last_collapsed_error;
+    compact(v_infos, t_infos, e_infos, its, vertex_map);
+    return last_collapsed_error;
+}
+
+std::vector<std::vector<uint32_t>> QuadricEdgeCollapse::partition(const indexed_triangle_set &its, size_t max_cell_size)
+{
+    std::vector<Vec3f> centroids(its.indices.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, its.indices.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t ti = range.begin(); ti < range.end(); ++ ti) {
+            const Triangle &t = its.indices[ti];
+            centroids[ti] = (its.vertices[t[0]] + its.vertices[t[1]] + its.vertices[t[2]]) / 3.f;
+        }
+    });
+    std::vector<uint32_t> order(its.indices.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::vector<std::vector<uint32_t>> cells;
+    // Split the range of order by a median of centroids along the longest axis of their bounding box.
+    std::function<void(std::vector<uint32_t>::iterator, std::vector<uint32_t>::iterator)> split =
+        [&](std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator end) {
+        if (size_t(end - begin) <= max_cell_size) {
+            cells.emplace_back(begin, end);
+            return;
+        }
+        Vec3f min = centroids[*begin];
+        Vec3f max = min;
+        for (auto it = begin; it != end; ++ it) {
+            min = min.cwiseMin(centroids[*it]);
+            max = max.cwiseMax(centroids[*it]);
+        }
+        int axis;
+        (max - min).maxCoeff(&axis);
+        auto mid = begin + (end - begin) / 2;
+        std::nth_element(begin, mid, end, [&centroids, axis](uint32_t l, uint32_t r) { return centroids[l][axis] < centroids[r][axis]; });
+        split(begin, mid);
+        split(mid, end);
+    };
+    split(order.begin(), order.end());
+    return cells;
 }
 
 Vec3d QuadricEdgeCollapse::create_normal(const Triangle &triangle,
@@ -825,15 +1013,20 @@ void QuadricEdgeCollapse::change_neighbors(EdgeInfos &     e_infos,
     }
 }
 
-void QuadricEdgeCollapse::compact(const VertexInfos &   v_infos,
-                                  const TriangleInfos & t_infos,
-                                  const EdgeInfos &     e_infos,
-                                  indexed_triangle_set &its)
+void QuadricEdgeCollapse::compact(const VertexInfos &    v_infos,
+                                  const TriangleInfos &  t_infos,
+                                  const EdgeInfos &      e_infos,
+                                  indexed_triangle_set & its,
+                                  std::vector<uint32_t> *vertex_map)
 {
+    if (vertex_map != nullptr)
+        vertex_map->assign(v_infos.size(), uint32_t(-1));
     uint32_t vi_new = 0;
     for (uint32_t vi = 0; vi < v_infos.size(); ++vi) {
         const VertexInfo &v_info = v_infos[vi];
         if (v_info.is_deleted()) continue; // deleted
+        if (vertex_map != nullptr)
+            (*vertex_map)[vi] = vi_new;
         uint32_t e_info_end = v_info.start + v_info.count;
         for (uint32_t ei = v_info.start; ei < e_info_end; ++ei) { 
             const EdgeInfo &e_info = e_infos[ei];
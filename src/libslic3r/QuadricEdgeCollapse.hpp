@@ -25,4 +25,40 @@ void its_quadric_edge_collapse(
     std::function<void(void)> throw_on_cancel = nullptr,
     std::function<void(int)>  statusfn        = nullptr);
 
+/// <summary>
+/// Simplify mesh by Quadric metric, collapsing spatially separated parts of a large mesh in parallel.
+/// The mesh is split into cells, edges inside each cell are collapsed concurrently
+/// while the vertices shared by the cells are locked, then a serial pass collapses the cell borders.
+/// Meshes too small to benefit from the partitioning are simplified by its_quadric_edge_collapse().
+/// </summary>
+/// <param name="its">IN/OUT triangle mesh to be simplified.</param>
+/// <param name="triangle_count">Wanted triangle count.</param>
+/// <param name="max_error">Maximal Quadric for reduce.
+/// When nullptr then max float is used
+/// Output: Maximal last used ErrorValue to collapse edge over all the cells</param>
+/// <param name="throw_on_cancel">Could stop process of calculation, may be called from worker threads.</param>
+/// <param name="statusfn">Give a feed back to user about progress. Values 1 - 100, may be called from worker threads.</param>
+void its_quadric_edge_collapse_partitioned(
+    indexed_triangle_set &    its,
+    uint32_t                  triangle_count  = 0,
+    float *                   max_error       = nullptr,
+    std::function<void(void)> throw_on_cancel = nullptr,
+    std::function<void(int)>  statusfn        = nullptr);
+
+// Cell of its_quadric_edge_collapse_partitioned(), simplified independently of the other cells.
+struct ItsSimplifiedCell {
+    indexed_triangle_set  its;
+    // Index into the source its.vertices for each locked vertex of the simplified cell, -1 for the interior ones.
+    std::vector<uint32_t> global_vertex;
+};
+
+// Fill cell.global_vertex from the source indices of the cell vertices before the simplification,
+// their locked flags and the vertex_map of the simplification (-1 for a removed vertex).
+// A locked vertex is removed when the last of its triangles in the cell collapses, such a vertex is skipped.
+void its_map_locked_vertices(ItsSimplifiedCell &cell, const std::vector<uint32_t> &vertices,
+                             const std::vector<bool> &locked, const std::vector<uint32_t> &vertex_map);
+
+// Merge the simplified cells of its into a single mesh, the locked vertices are shared by their source index.
+indexed_triangle_set its_stitch_cells(const indexed_triangle_set &its, const std::vector<ItsSimplifiedCell> &cells);
+
 } // namespace Slic3r
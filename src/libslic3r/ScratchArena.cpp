@@ -0,0 +1,174 @@
+#include "ScratchArena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+
+namespace Slic3r {
+
+static std::atomic<bool>& scratch_arena_enabled_state()
+{
+    static std::atomic<bool> enabled { [] {
+        const char *env = ::getenv("SLIC3R_SCRATCH_ARENA");
+        return env == nullptr || std::atoi(env) != 0;
+    }() };
+    return enabled;
+}
+
+bool scratch_arena_enabled() { return scratch_arena_enabled_state().load(std::memory_order_relaxed); }
+void set_scratch_arena_enabled(bool enabled) { scratch_arena_enabled_state().store(enabled, std::memory_order_relaxed); }
+
+static thread_local ScratchArena  s_thread_arena;
+static thread_local ScratchArena *s_current_arena = nullptr;
+
+static std::atomic<size_t> s_stats_allocations { 0 };
+static std::atomic<size_t> s_stats_bytes       { 0 };
+static std::atomic<size_t> s_stats_chunks      { 0 };
+
+ScratchArena* ScratchArena::current() { return s_current_arena; }
+
+void* ScratchArena::allocate(size_t bytes, size_t alignment)
+{
+    ++ m_stats.allocations;
+    m_stats.bytes += bytes;
+    // The chunks are aligned for any fundamental type.
+    assert(alignment <= alignof(std::max_align_t));
+    if (bytes > ChunkSize) {
+        // An oversized allocation gets a chunk of its own, the chunk being allocated from is left as it is,
+        // so that its free memory is not lost to the following allocations.
+        m_large_chunks.push_back({ std::unique_ptr<std::byte[]>(new std::byte[bytes]), bytes });
+        ++ m_stats.chunks;
+        return m_large_chunks.back().data.get();
+    }
+    for (; m_chunk < m_chunks.size(); ++ m_chunk, m_offset = 0) {
+        Chunk &chunk  = m_chunks[m_chunk];
+        size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + bytes <= chunk.size) {
+            m_offset = offset + bytes;
+            return chunk.data.get() + offset;
+        }
+    }
+    // Not enough space in the retained chunks, allocate a new one.
+    m_chunks.push_back({ std::unique_ptr<std::byte[]>(new std::byte[ChunkSize]), ChunkSize });
+    ++ m_stats.chunks;
+    m_chunk  = m_chunks.size() - 1;
+    m_offset = bytes;
+    return m_chunks.back().data.get();
+}
+
+void ScratchArena::deallocate(void *ptr, size_t bytes)
+{
+    if (bytes > ChunkSize) {
+        // Return the chunk of an oversized allocation to the heap at once. Its slot is kept until release(),
+        // so that the number of the large chunks saved by a ScratchArenaFrame stays valid.
+        auto it = std::find_if(m_large_chunks.rbegin(), m_large_chunks.rend(), [ptr](const Chunk &chunk) { return chunk.data.get() == ptr; });
+        if (it != m_large_chunks.rend()) {
+            it->data.reset();
+            it->size = 0;
+        }
+    } else if (m_chunk < m_chunks.size() && static_cast<std::byte*>(ptr) + bytes == m_chunks[m_chunk].data.get() + m_offset &&
+               (m_chunk > m_frame_chunk || m_offset - bytes >= m_frame_offset))
+        // Containers growing at the top of the arena reuse the memory they released, but not below the innermost frame,
+        // so that the top of the arena stays at or above the mark the frame rewinds to.
+        m_offset -= bytes;
+}
+
+void ScratchArena::release()
+{
+    // Return the chunks of the oversized allocations and the chunks over the limit to the heap.
+    m_large_chunks.clear();
+    if (m_chunks.size() > MaxRetainedChunks)
+        m_chunks.resize(MaxRetainedChunks);
+    m_chunk  = 0;
+    m_offset = 0;
+    assert(m_frame_depth == 0);
+    m_frame_chunk  = 0;
+    m_frame_offset = 0;
+    m_pinned_depth = std::numeric_limits<size_t>::max();
+    ++ m_generation;
+}
+
+void ScratchArena::flush_stats()
+{
+    s_stats_allocations.fetch_add(m_stats.allocations, std::memory_order_relaxed);
+    s_stats_bytes      .fetch_add(m_stats.bytes,       std::memory_order_relaxed);
+    s_stats_chunks     .fetch_add(m_stats.chunks,      std::memory_order_relaxed);
+    m_stats = Stats();
+}
+
+ScratchArena::Stats ScratchArena::stats()
+{
+    Stats out;
+    out.allocations = s_stats_allocations.load(std::memory_order_relaxed);
+    out.bytes       = s_stats_bytes      .load(std::memory_order_relaxed);
+    out.chunks      = s_stats_chunks     .load(std::memory_order_relaxed);
+    return out;
+}
+
+void ScratchArena::reset_stats()
+{
+    s_stats_allocations.store(0, std::memory_order_relaxed);
+    s_stats_bytes      .store(0, std::memory_order_relaxed);
+    s_stats_chunks     .store(0, std::memory_order_relaxed);
+}
+
+ScratchArenaScope::ScratchArenaScope() : m_arena(nullptr)
+{
+    // A scope nested on the same thread, for example by a TBB worker stealing a task while waiting, shares the arena.
+    if (s_current_arena != nullptr || scratch_arena_enabled()) {
+        m_arena = &s_thread_arena;
+        s_current_arena = m_arena;
+        ++ m_arena->m_depth;
+    }
+}
+
+ScratchArenaScope::~ScratchArenaScope()
+{
+    if (m_arena != nullptr && -- m_arena->m_depth == 0) {
+        m_arena->release();
+        m_arena->flush_stats();
+        s_current_arena = nullptr;
+    }
+}
+
+ScratchArenaFrame::ScratchArenaFrame() : m_arena(ScratchArena::current())
+{
+    if (m_arena != nullptr) {
+        m_chunk            = m_arena->m_chunk;
+        m_offset           = m_arena->m_offset;
+        m_num_large_chunks = m_arena->m_large_chunks.size();
+        m_parent_chunk     = m_arena->m_frame_chunk;
+        m_parent_offset    = m_arena->m_frame_offset;
+        m_arena->m_frame_chunk  = m_chunk;
+        m_arena->m_frame_offset = m_offset;
+        ++ m_arena->m_frame_depth;
+    }
+}
+
+ScratchArenaFrame::~ScratchArenaFrame()
+{
+    if (m_arena != nullptr) {
+        assert(m_arena->m_frame_depth > 0);
+        // The frames end in the reverse order of their construction and deallocate() does not go below the innermost one.
+        assert(m_arena->m_frame_chunk == m_chunk && m_arena->m_frame_offset == m_offset);
+        assert(m_arena->m_chunk > m_chunk || (m_arena->m_chunk == m_chunk && m_arena->m_offset >= m_offset));
+        assert(m_arena->m_large_chunks.size() >= m_num_large_chunks);
+        size_t depth = m_arena->m_frame_depth --;
+        if (m_arena->m_pinned_depth < depth) {
+            // A container created before this frame grew inside of it and its memory lies above the mark.
+            // Keep the memory, it is reclaimed once the frame or the scope the container was created in ends.
+            if (m_arena->m_pinned_depth == m_arena->m_frame_depth)
+                m_arena->m_pinned_depth = std::numeric_limits<size_t>::max();
+        } else if (m_arena->m_chunk > m_chunk || (m_arena->m_chunk == m_chunk && m_arena->m_offset >= m_offset)) {
+            // The chunks allocated inside of the frame are kept for reuse, except for the oversized ones.
+            m_arena->m_large_chunks.resize(m_num_large_chunks);
+            m_arena->m_chunk  = m_chunk;
+            m_arena->m_offset = m_offset;
+        }
+        m_arena->m_frame_chunk  = m_parent_chunk;
+        m_arena->m_frame_offset = m_parent_offset;
+    }
+}
+
+} // namespace Slic3r
@@ -0,0 +1,207 @@
+#ifndef slic3r_ScratchArena_hpp_
+#define slic3r_ScratchArena_hpp_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Point.hpp"
+
+namespace Slic3r {
+
+// Per thread bump allocator for the short lived scratch geometry of the layer algorithms.
+//
+// The arena of a thread is active while a ScratchArenaScope lives on that thread. The containers using ScratchAllocator,
+// which are constructed while the arena is active, take their memory from the arena instead of the global heap,
+// so that the TBB workers do not contend inside the global allocator. The memory is released at once when the outermost
+// scope of the thread ends, and the chunks of the arena are kept for the next scope of the thread.
+// A scratch container must therefore never outlive the scope it was created in.
+// The memory of the temporaries of an operation repeated many times inside of a scope is released when the operation
+// is done by a ScratchArenaFrame. ClipperLib::Clipper and ClipperLib::ClipperOffset allocate their intermediate data
+// from the arena and hold a frame for their life time, see libslic3r/clipper.hpp.
+//
+// Usage:
+//     ScratchArenaScope scratch;
+//     ScratchVector<size_t> stack;
+//     ScratchPoints         points;
+//     {
+//         ScratchArenaFrame frame;
+//         ScratchVector<Vec2d> normals;
+//         ...
+//     }
+class ScratchArena
+{
+public:
+    // Size of the chunks allocated from the heap, larger allocations get a chunk of their own.
+    static constexpr const size_t ChunkSize         = 256 * 1024;
+    // Number of the chunks kept by a thread between its scopes, the other chunks are returned to the heap.
+    static constexpr const size_t MaxRetainedChunks = 16;
+
+    // Arena of the calling thread if a ScratchArenaScope is active on it, otherwise nullptr.
+    static ScratchArena* current();
+
+    void*           allocate(size_t bytes, size_t alignment);
+    // The memory is only reclaimed if it was the last allocation, the rest is reclaimed by release().
+    void            deallocate(void *ptr, size_t bytes);
+    // Releases all the allocations and rewinds to the first chunk.
+    void            release();
+
+    // Incremented by release(), debug builds check that a scratch container does not outlive its scope.
+    uint64_t        generation() const { return m_generation; }
+    // Number of the active ScratchArenaFrames of the thread.
+    size_t          frame_depth() const { return m_frame_depth; }
+    // Called when a container created at the frame depth "depth" grows inside a deeper frame. Its memory lies above
+    // the marks of the deeper frames, thus those frames keep it when they end and the memory is reclaimed later.
+    void            pin(size_t depth) { m_pinned_depth = std::min(m_pinned_depth, depth); }
+
+    struct Stats {
+        // Allocations served by the arenas, each of them would otherwise be a heap allocation.
+        size_t allocations { 0 };
+        size_t bytes       { 0 };
+        // Chunks allocated from the heap by the arenas.
+        size_t chunks      { 0 };
+    };
+    // Totals of all the threads, updated whenever the outermost scope of a thread ends.
+    static Stats    stats();
+    static void     reset_stats();
+
+private:
+    friend class ScratchArenaScope;
+    friend class ScratchArenaFrame;
+
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t                       size;
+    };
+
+    void            flush_stats();
+
+    // Chunks of ChunkSize bytes.
+    std::vector<Chunk>  m_chunks;
+    // Chunks of the allocations larger than ChunkSize, one chunk per allocation.
+    std::vector<Chunk>  m_large_chunks;
+    // Chunk being allocated from and the offset of its free memory.
+    size_t              m_chunk  { 0 };
+    size_t              m_offset { 0 };
+    // Depth of the nested ScratchArenaScopes of the thread.
+    size_t              m_depth  { 0 };
+    uint64_t            m_generation { 0 };
+    // Depth of the nested ScratchArenaFrames and the mark of the innermost one, deallocate() never goes below the mark.
+    size_t              m_frame_depth  { 0 };
+    size_t              m_frame_chunk  { 0 };
+    size_t              m_frame_offset { 0 };
+    // The frames deeper than this depth must not rewind, see pin().
+    size_t              m_pinned_depth { std::numeric_limits<size_t>::max() };
+    Stats               m_stats;
+};
+
+// The scratch arena may be disabled for comparison by the SLIC3R_SCRATCH_ARENA=0 environment variable,
+// then the scopes do not activate the arena and the scratch containers allocate from the heap.
+bool scratch_arena_enabled();
+void set_scratch_arena_enabled(bool enabled);
+
+// Activates the scratch arena of the calling thread, the arena is released when the outermost scope ends.
+class ScratchArenaScope
+{
+public:
+    ScratchArenaScope();
+    ~ScratchArenaScope();
+
+    ScratchArenaScope(const ScratchArenaScope &) = delete;
+    ScratchArenaScope &operator=(const ScratchArenaScope &) = delete;
+
+private:
+    ScratchArena *m_arena;
+};
+
+// Rewinds the arena of the calling thread to the state it had when the frame was constructed, once the frame ends.
+// The scratch containers constructed inside of the frame must not outlive it. A scratch container constructed before
+// the frame may grow inside of it, then the frame does not rewind and its memory is reclaimed by an outer frame or scope.
+// The frame does nothing if no ScratchArenaScope is active.
+class ScratchArenaFrame
+{
+public:
+    ScratchArenaFrame();
+    ~ScratchArenaFrame();
+
+    ScratchArenaFrame(const ScratchArenaFrame &) = delete;
+    ScratchArenaFrame &operator=(const ScratchArenaFrame &) = delete;
+
+private:
+    ScratchArena *m_arena;
+    size_t        m_chunk;
+    size_t        m_offset;
+    size_t        m_num_large_chunks;
+    // Mark of the enclosing frame.
+    size_t        m_parent_chunk;
+    size_t        m_parent_offset;
+};
+
+// Allocates from the arena, which was active when the allocator was constructed, or from the heap if there was none.
+template<typename T>
+class ScratchAllocator
+{
+public:
+    using value_type = T;
+    // The scratch memory is tied to the allocator, thus it travels with the memory when the container is moved or swapped.
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    ScratchAllocator() noexcept : ScratchAllocator(ScratchArena::current()) {}
+    explicit ScratchAllocator(ScratchArena *arena) noexcept : m_arena(arena), m_frame_depth(arena ? arena->frame_depth() : 0)
+#ifndef NDEBUG
+        , m_generation(arena ? arena->generation() : 0)
+#endif // NDEBUG
+    {}
+    template<typename U>
+    ScratchAllocator(const ScratchAllocator<U> &rhs) noexcept : m_arena(rhs.m_arena), m_frame_depth(rhs.m_frame_depth)
+#ifndef NDEBUG
+        , m_generation(rhs.m_generation)
+#endif // NDEBUG
+    {}
+
+    T* allocate(size_t n) {
+        if (m_arena == nullptr)
+            return std::allocator<T>().allocate(n);
+        assert(m_arena->generation() == m_generation);
+        if (m_frame_depth < m_arena->frame_depth())
+            m_arena->pin(m_frame_depth);
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *ptr, size_t n) noexcept {
+        if (m_arena == nullptr)
+            std::allocator<T>().deallocate(ptr, n);
+        else {
+            assert(m_arena->generation() == m_generation);
+            m_arena->deallocate(ptr, n * sizeof(T));
+        }
+    }
+
+    ScratchArena* arena() const noexcept { return m_arena; }
+
+    template<typename U> bool operator==(const ScratchAllocator<U> &rhs) const noexcept { return m_arena == rhs.m_arena; }
+    template<typename U> bool operator!=(const ScratchAllocator<U> &rhs) const noexcept { return m_arena != rhs.m_arena; }
+
+private:
+    template<typename U> friend class ScratchAllocator;
+
+    ScratchArena *m_arena;
+    // Depth of the frames active when the allocator was constructed.
+    size_t        m_frame_depth;
+#ifndef NDEBUG
+    uint64_t      m_generation;
+#endif // NDEBUG
+};
+
+template<typename T>
+using ScratchVector   = std::vector<T, ScratchAllocator<T>>;
+using ScratchPoints   = ScratchVector<Point>;
+
+} // namespace Slic3r
+
+#endif // slic3r_ScratchArena_hpp_
@@ -9,6 +9,7 @@
 #include "KDTreeIndirect.hpp"
 #include "MutablePriorityQueue.hpp"
 #include "Print.hpp"
+#include "ScratchArena.hpp"
 
 #include <cmath>
 #include <cassert>
@@ -17,8 +18,8 @@ namespace Slic3r {
 
 // Naive implementation of the Traveling Salesman Problem, it works by always taking the next closest neighbor.
 // This implementation will always produce valid result even if some segments cannot reverse.
-template<typename EndPointType, typename KDTreeType, typename CouldReverseFunc>
-std::vector<std::pair<size_t, bool>> chain_segments_closest_point(std::vector<EndPointType> &end_points, KDTreeType &kdtree, CouldReverseFunc &could_reverse_func, EndPointType &first_point)
+template<typename EndPointType, typename KDTreeType, typename CouldReverseFunc, typename EndPoints = std::vector<EndPointType>>
+std::vector<std::pair<size_t, bool>> chain_segments_closest_point(EndPoints &end_points, KDTreeType &kdtree, CouldReverseFunc &could_reverse_func, EndPointType &first_point)
 {
 	assert((end_points.size() & 1) == 0);
     size_t num_segments = end_points.size() / 2;
@@ -93,7 +94,8 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals
 			double    distance_out = std::numeric_limits<double>::max();
 			size_t    heap_idx = std::numeric_limits<size_t>::max();
 		};
-	    std::vector<EndPoint> end_points;
+	    // Taken from the scratch arena if the caller opened a ScratchArenaScope.
+	    ScratchVector<EndPoint> end_points;
 	    end_points.reserve(num_segments * 2);
 	    for (size_t i = 0; i < num_segments; ++ i) {
             end_points.emplace_back(end_point_func(i, true ).template cast<double>());
@@ -159,7 +161,7 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals
 		private:
 			// Unique chain ID assigned to chains of end points of segments.
 			size_t              m_last_chain_id = 0;
-			std::vector<size_t> m_equivalent_with;
+			ScratchVector<size_t> m_equivalent_with;
 		} equivalent_chain(num_segments);
 
 		// Find the first end point closest to start_near.
@@ -1061,7 +1063,8 @@ void chain_and_reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_pat
 }
 
 std::vector<size_t> chain_expolygons(const ExPolygons &input_exploy) {
-	Points points;
+	ScratchPoints points;
+	points.reserve(input_exploy.size());
 	for (const ExPolygon &exploy : input_exploy) {
 		BoundingBox bbox;
 		bbox = get_extents(exploy);
@@ -1070,7 +1073,8 @@ std::vector<size_t> chain_expolygons(const ExPolygons &input_exploy) {
 	return chain_points(points);
 }
 
-std::vector<size_t> chain_points(const Points &points, Point *start_near)
+template<typename PointsType>
+static std::vector<size_t> chain_points_impl(const PointsType &points, Point *start_near)
 {
 	auto segment_end_point = [&points](size_t idx, bool /* first_point */) -> const Point& { return points[idx]; };
 	std::vector<std::pair<size_t, bool>> ordered = chain_segments_greedy<Point, decltype(segment_end_point)>(segment_end_point, points.size(), start_near);
@@ -1081,6 +1085,9 @@ std::vector<size_t> chain_points(const Points &points, Point *start_near)
 	return out;
 }
 
+std::vector<size_t> chain_points(const Points &points, Point *start_near) { return chain_points_impl(points, start_near); }
+std::vector<size_t> chain_points(const ScratchPoints &points, Point *start_near) { return chain_points_impl(points, start_near); }
+
 #ifndef NDEBUG
 	// #define DEBUG_SVG_OUTPUT
 #endif /* NDEBUG */
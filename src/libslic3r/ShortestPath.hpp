@@ -4,6 +4,7 @@
 #include "libslic3r.h"
 #include "ExtrusionEntity.hpp"
 #include "Point.hpp"
+#include "ScratchArena.hpp"
 
 #include <utility>
 #include <vector>
@@ -13,6 +14,7 @@ namespace ClipperLib { class PolyNode; }
 namespace Slic3r {
 
 std::vector<size_t> 				 chain_points(const Points &points, Point *start_near = nullptr);
+std::vector<size_t> 				 chain_points(const ScratchPoints &points, Point *start_near = nullptr);
 std::vector<size_t> 				 chain_expolygons(const ExPolygons &input_exploy);
 
 std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near = nullptr);
@@ -11,6 +11,7 @@
 #include "../MutablePolygon.hpp"
 #include "../Geometry.hpp"
 #include "../Point.hpp"
+#include "../ScratchArena.hpp"
 #include "clipper/clipper_z.hpp"
 
 #include <cmath>
@@ -1506,6 +1507,7 @@ void generate_support_toolpaths(
             (const tbb::blocked_range<size_t>& range) {
         for (size_t support_layer_id = range.begin(); support_layer_id < range.end(); ++ support_layer_id)
         {
+            ScratchArenaScope scratch;
             assert(support_layer_id < raft_layers.size());
             SupportLayer               &support_layer = *support_layers[support_layer_id];
             assert(support_layer.support_fills.entities.empty());
@@ -1643,6 +1645,8 @@ void generate_support_toolpaths(
         filler_support->set_bounding_box(bbox_object);
         for (size_t support_layer_id = range.begin(); support_layer_id < range.end(); ++ support_layer_id)
         {
+            // The temporaries of the clipping, filling and chaining of the layer are taken from the scratch arena.
+            ScratchArenaScope scratch;
             SupportLayer &support_layer = *support_layers[support_layer_id];
             LayerCache   &layer_cache   = layer_caches[support_layer_id];
 
@@ -8,6 +8,7 @@
 #include "Geometry.hpp"
 #include "Point.hpp"
 #include "MutablePolygon.hpp"
+#include "ScratchArena.hpp"
 
 #include <cmath>
 #include <memory>
@@ -2125,6 +2126,7 @@ SupportGeneratorLayersPtr PrintObjectSupportMaterial::top_contact_layers(
     tbb::parallel_for(tbb::blocked_range<size_t>(layer_id_start, num_layers),
         [&](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_id = range.begin(); layer_id < range.end(); layer_id++) {
+                ScratchArenaScope   scratch;
                 const Layer& layer = *object.layers()[layer_id];
                 Polygons            lower_layer_polygons = (layer_id == 0) ? Polygons() : to_polygons(object.layers()[layer_id - 1]->lslices);
 
@@ -0,0 +1,313 @@
+#include "Trace.hpp"
+#include "Thread.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+namespace Slic3r {
+namespace Trace {
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    const char *category;
+    uint64_t    start;
+    uint64_t    end;
+    int64_t     arg;
+};
+
+// Events are appended into chunks, which are never moved, thus the exporter may walk them
+// while the owning thread keeps appending: the count and the next pointer are published with release semantics.
+struct Chunk
+{
+    static constexpr size_t size = 4096;
+    Event                   events[size];
+    std::atomic<size_t>     count { 0 };
+    std::atomic<Chunk*>     next { nullptr };
+};
+
+// Guards g_buffers and the chunks of the previous sessions, which are walked by the exporters and freed by reset().
+std::mutex g_buffers_mutex;
+
+// A buffer of an exited thread is reused by a new thread, thus the number of the buffers is bounded
+// by the number of the threads running at the same time, not by the number of the threads ever started.
+struct ThreadBuffer
+{
+    ThreadBuffer(int tid, std::string thread_name, std::string name) :
+        tid(tid), thread_name(std::move(thread_name)), name(std::move(name)), head(new Chunk), tail(head) {}
+    ~ThreadBuffer() { this->free_chunks(head->next.load()); delete head; }
+
+    void free_chunks(Chunk *chunk)
+    {
+        while (chunk != nullptr) {
+            Chunk *next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    // Only called by the owning thread.
+    void reset(uint64_t new_session)
+    {
+        // An exporter may be walking the chunks of the previous session.
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        this->clear();
+        session.store(new_session, std::memory_order_release);
+    }
+
+    // Called with g_buffers_mutex locked.
+    void clear()
+    {
+        this->free_chunks(head->next.exchange(nullptr));
+        head->count.store(0, std::memory_order_release);
+        tail = head;
+    }
+
+    void push(const Event &event)
+    {
+        size_t count = tail->count.load(std::memory_order_relaxed);
+        if (count == Chunk::size) {
+            Chunk *chunk = new Chunk;
+            tail->next.store(chunk, std::memory_order_release);
+            tail  = chunk;
+            count = 0;
+        }
+        tail->events[count] = event;
+        tail->count.store(count + 1, std::memory_order_release);
+    }
+
+    const int             tid;
+    // Name of the thread as reported by the system, the buffer keeps its name when reused by a thread of the same name.
+    std::string           thread_name;
+    // Exported name.
+    std::string           name;
+    Chunk                *head;
+    Chunk                *tail;
+    std::atomic<uint64_t> session { 0 };
+    // The owning thread exited, the buffer may be reused. Guarded by g_buffers_mutex.
+    bool                  exited { false };
+};
+
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+std::atomic<uint64_t>                      g_session { 0 };
+std::atomic<int64_t>                       g_session_start { 0 };
+
+// Hands the buffer over to the next thread when the owning thread exits.
+struct ThreadBufferOwner
+{
+    ~ThreadBufferOwner()
+    {
+        if (buffer != nullptr) {
+            std::lock_guard<std::mutex> lock(g_buffers_mutex);
+            buffer->exited = true;
+        }
+    }
+    ThreadBuffer *buffer { nullptr };
+};
+thread_local ThreadBufferOwner             t_buffer;
+
+int64_t steady_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ThreadBuffer* thread_buffer()
+{
+    if (t_buffer.buffer == nullptr) {
+        std::optional<std::string> thread_name_opt = get_current_thread_name();
+        std::string thread_name = thread_name_opt ? *thread_name_opt : std::string();
+        uint64_t    session     = g_session.load(std::memory_order_acquire);
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        // The events of an exited thread continue on the same track of the trace by a thread of the same name.
+        // A buffer of a thread of another name is only reused once its events were dropped by a new session.
+        auto it = std::find_if(g_buffers.begin(), g_buffers.end(), [&thread_name](const std::unique_ptr<ThreadBuffer> &buffer)
+            { return buffer->exited && buffer->thread_name == thread_name; });
+        if (it == g_buffers.end())
+            it = std::find_if(g_buffers.begin(), g_buffers.end(), [session](const std::unique_ptr<ThreadBuffer> &buffer)
+                { return buffer->exited && buffer->session.load(std::memory_order_relaxed) != session; });
+        auto default_name = [&thread_name](int tid) { return thread_name.empty() ? "thread " + std::to_string(tid) : thread_name; };
+        if (it == g_buffers.end()) {
+            int tid = int(g_buffers.size()) + 1;
+            g_buffers.emplace_back(new ThreadBuffer(tid, thread_name, default_name(tid)));
+            it = std::prev(g_buffers.end());
+        } else if ((*it)->thread_name != thread_name) {
+            (*it)->thread_name = thread_name;
+            (*it)->name        = default_name((*it)->tid);
+        }
+        (*it)->exited   = false;
+        t_buffer.buffer = it->get();
+    }
+    return t_buffer.buffer;
+}
+
+void write_escaped(std::ostream &os, const char *str)
+{
+    for (; *str != 0; ++ str) {
+        char c = *str;
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            os << ' ';
+        else
+            os << c;
+    }
+}
+
+// Chrome trace timestamps are in microseconds.
+void write_microseconds(std::ostream &os, uint64_t ns)
+{
+    os << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+}
+
+} // namespace
+
+namespace detail {
+
+std::atomic<bool> g_enabled { false };
+
+uint64_t now()
+{
+    int64_t ns = steady_now() - g_session_start.load(std::memory_order_relaxed);
+    return ns > 0 ? uint64_t(ns) : 0;
+}
+
+void record(const char *name, const char *category, uint64_t start, uint64_t end, int64_t arg)
+{
+    ThreadBuffer *buffer  = thread_buffer();
+    uint64_t      session = g_session.load(std::memory_order_acquire);
+    if (buffer->session.load(std::memory_order_relaxed) != session)
+        buffer->reset(session);
+    buffer->push({ name, category, start, std::max(start, end), arg });
+}
+
+} // namespace detail
+
+void start()
+{
+    g_session_start.store(steady_now(), std::memory_order_relaxed);
+    g_session.fetch_add(1, std::memory_order_release);
+    {
+        // Nobody records into the buffers of the exited threads, release their events of the previous session.
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        for (const std::unique_ptr<ThreadBuffer> &buffer : g_buffers)
+            if (buffer->exited)
+                buffer->clear();
+    }
+    detail::g_enabled.store(true, std::memory_order_release);
+    BOOST_LOG_TRIVIAL(info) << "Tracing started";
+}
+
+void stop()
+{
+    detail::g_enabled.store(false, std::memory_order_release);
+    BOOST_LOG_TRIVIAL(info) << "Tracing stopped, " << event_count() << " events recorded";
+}
+
+size_t event_count()
+{
+    uint64_t session = g_session.load(std::memory_order_acquire);
+    size_t   count   = 0;
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : g_buffers)
+        if (buffer->session.load(std::memory_order_acquire) == session)
+            for (const Chunk *chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire))
+                count += chunk->count.load(std::memory_order_acquire);
+    return count;
+}
+
+std::vector<Total> totals()
+{
+    uint64_t session = g_session.load(std::memory_order_acquire);
+    std::map<std::pair<std::string, std::string>, Total> map;
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : g_buffers)
+        if (buffer->session.load(std::memory_order_acquire) == session)
+            for (const Chunk *chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)) {
+                size_t count = chunk->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++ i) {
+                    const Event &event = chunk->events[i];
+                    Total       &total = map[{ event.category, event.name }];
+                    ++ total.count;
+                    total.duration_ns += event.end - event.start;
+                }
+            }
+    std::vector<Total> out;
+    out.reserve(map.size());
+    for (auto &[key, total] : map) {
+        total.category = key.first;
+        total.name     = key.second;
+        out.emplace_back(std::move(total));
+    }
+    return out;
+}
+
+void export_chrome_json(std::ostream &os)
+{
+    uint64_t session = g_session.load(std::memory_order_acquire);
+    bool     first   = true;
+    auto     separator = [&os, &first]() {
+        os << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    os << "{\"traceEvents\":[";
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : g_buffers) {
+        if (buffer->session.load(std::memory_order_acquire) != session)
+            continue;
+        separator();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":\"";
+        write_escaped(os, buffer->name.c_str());
+        os << "\"}}";
+        for (const Chunk *chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)) {
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++ i) {
+                const Event &event = chunk->events[i];
+                separator();
+                os << "{\"name\":\"";
+                write_escaped(os, event.name);
+                os << "\",\"cat\":\"";
+                write_escaped(os, event.category);
+                os << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":";
+                write_microseconds(os, event.start);
+                os << ",\"dur\":";
+                write_microseconds(os, event.end - event.start);
+                if (event.arg >= 0)
+                    os << ",\"args\":{\"id\":" << event.arg << "}";
+                os << "}";
+            }
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+bool export_chrome_json(const std::string &path)
+{
+    boost::nowide::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to open the trace file " << path;
+        return false;
+    }
+    export_chrome_json(file);
+    file.close();
+    if (file.fail()) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to write the trace file " << path;
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << "Trace exported to " << path;
+    return true;
+}
+
+} // namespace Trace
+} // namespace Slic3r
@@ -0,0 +1,102 @@
+#ifndef slic3r_Trace_hpp_
+#define slic3r_Trace_hpp_
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+// Low overhead recorder of timed events of the slicing pipeline, exported in the Chrome trace event format,
+// which is loaded by chrome://tracing and by the Perfetto UI.
+//
+// Every thread appends its events into its own buffer without any locking, a mutex is only taken
+// when a thread records its first event and when it exits. The buffers of the exited threads are reused.
+// When tracing is not started, a trace scope costs a single relaxed atomic load.
+//
+// Usage:
+//     Trace::start();
+//     {
+//         SLIC3R_TRACE_SCOPE("make_perimeters", "PrintObjectStep");
+//         ...
+//     }
+//     Trace::stop();
+//     Trace::export_chrome_json("trace.json");
+namespace Trace {
+
+namespace detail {
+    extern std::atomic<bool> g_enabled;
+    // Nanoseconds since the start of the tracing session.
+    uint64_t now();
+    void     record(const char *name, const char *category, uint64_t start, uint64_t end, int64_t arg);
+} // namespace detail
+
+// Starts a new tracing session, the events of the previous session are dropped.
+void start();
+// Stops recording, the recorded events are kept until the next start().
+void stop();
+inline bool enabled() { return detail::g_enabled.load(std::memory_order_relaxed); }
+
+// Number of the events recorded in the current session.
+size_t event_count();
+
+// Number of the events and their summed duration for a single name and category.
+struct Total
+{
+    std::string name;
+    std::string category;
+    size_t      count { 0 };
+    uint64_t    duration_ns { 0 };
+};
+// Events of the current session summed up by their name and category, sorted by category and name.
+// Events of the same name running in parallel are summed up, thus their total may exceed the wall clock time.
+std::vector<Total> totals();
+
+// Writes the events of the current session as a Chrome trace event JSON.
+// It may be called while the other threads record, the events recorded meanwhile may be missing.
+void export_chrome_json(std::ostream &os);
+bool export_chrome_json(const std::string &path);
+
+// Records a complete event spanning the life time of the scope.
+// The name and the category are not copied, they have to be string literals.
+class Scope
+{
+public:
+    Scope(const char *name, const char *category, int64_t arg = -1)
+    {
+        if (enabled()) {
+            m_name     = name;
+            m_category = category;
+            m_arg      = arg;
+            m_start    = detail::now();
+        }
+    }
+    ~Scope()
+    {
+        if (m_name != nullptr)
+            detail::record(m_name, m_category, m_start, detail::now(), m_arg);
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_name { nullptr };
+    const char *m_category { nullptr };
+    int64_t     m_arg { -1 };
+    uint64_t    m_start { 0 };
+};
+
+} // namespace Trace
+} // namespace Slic3r
+
+#define SLIC3R_TRACE_CONCAT_IMPL(a, b) a##b
+#define SLIC3R_TRACE_CONCAT(a, b) SLIC3R_TRACE_CONCAT_IMPL(a, b)
+// Trace the rest of the enclosing scope.
+#define SLIC3R_TRACE_SCOPE(name, category) ::Slic3r::Trace::Scope SLIC3R_TRACE_CONCAT(slic3r_trace_scope_, __LINE__)(name, category)
+// Trace the rest of the enclosing scope, arg is exported as "id", usually a layer or an object index.
+#define SLIC3R_TRACE_SCOPE_ARG(name, category, arg) ::Slic3r::Trace::Scope SLIC3R_TRACE_CONCAT(slic3r_trace_scope_, __LINE__)(name, category, int64_t(arg))
+
+#endif // slic3r_Trace_hpp_
@@ -13,14 +13,21 @@
 #define slic3r_clipper_hpp
 
 #include "Point.hpp"
+#include "ScratchArena.hpp"
 
 #define CLIPPERLIB_NAMESPACE_PREFIX		Slic3r
 #define CLIPPERLIB_INTPOINT_TYPE    	Slic3r::Point
+// The intermediate data of the clipping is taken from the scratch arena if a ScratchArenaScope is active
+// and it is released at once when the clipper is destroyed.
+#define CLIPPERLIB_ALLOCATOR            Slic3r::ScratchAllocator
+#define CLIPPERLIB_TEMP_FRAME           Slic3r::ScratchArenaFrame
 
 #include <clipper/clipper.hpp>
 
 #undef clipper_hpp
 #undef CLIPPERLIB_NAMESPACE_PREFIX
 #undef CLIPPERLIB_INTPOINT_TYPE
+#undef CLIPPERLIB_ALLOCATOR
+#undef CLIPPERLIB_TEMP_FRAME
 
 #endif // slic3r_clipper_hpp
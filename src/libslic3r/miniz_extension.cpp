@@ -1,4 +1,9 @@
 #include <exception>
+#include <atomic>
+#include <cstring>
+
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
 
 #include "miniz_extension.hpp"
 
@@ -156,4 +161,159 @@ std::string MZ_Archive::get_errorstr(mz_zip_error mz_err)
     return "unknown error";
 }
 
+struct MZ_ParallelDeflateWriter::Block
+{
+    std::string       data;
+    std::string       compressed;
+    size_t            data_size { 0 };
+    mz_uint32         checksum { MZ_CRC32_INIT };
+    bool              last { false };
+    bool              failed { false };
+    std::atomic<bool> done { false };
+    tbb::task_group   task;
+
+    void compress_block(int level)
+    {
+        checksum = mz_uint32(mz_crc32(MZ_CRC32_INIT, (const unsigned char*)data.data(), data.size()));
+        compressed.reserve(data.size() / 4);
+        // tdefl_compressor is about 300kB large, don't allocate it on the stack.
+        std::unique_ptr<tdefl_compressor, decltype(&free)> compressor((tdefl_compressor*)malloc(sizeof(tdefl_compressor)), &free);
+        auto put_buf = [](const void *buf, int len, void *user) -> mz_bool {
+            static_cast<std::string*>(user)->append(static_cast<const char*>(buf), len);
+            return MZ_TRUE;
+        };
+        tdefl_status status = TDEFL_STATUS_BAD_PARAM;
+        if (compressor &&
+            tdefl_init(compressor.get(), put_buf, &compressed, tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY)) == TDEFL_STATUS_OKAY)
+            // A sync flush terminates the block with an empty stored block aligned to a byte boundary, the next block may follow.
+            status = tdefl_compress_buffer(compressor.get(), data.data(), data.size(), last ? TDEFL_FINISH : TDEFL_SYNC_FLUSH);
+        failed = status != (last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+        // Release the input as soon as possible to keep the memory footprint low.
+        std::string().swap(data);
+        done = true;
+    }
+};
+
+MZ_ParallelDeflateWriter::MZ_ParallelDeflateWriter(mz_zip_archive &archive) : m_archive(archive)
+{
+    memset(&m_context, 0, sizeof(m_context));
+}
+
+MZ_ParallelDeflateWriter::~MZ_ParallelDeflateWriter()
+{
+    for (std::unique_ptr<Block> &block : m_blocks)
+        block->task.wait();
+}
+
+size_t MZ_ParallelDeflateWriter::max_blocks_in_flight()
+{
+    return 2 * size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+}
+
+bool MZ_ParallelDeflateWriter::open(const char *archive_name, mz_uint64 max_size, mz_uint level_and_flags,
+                                    const char *user_extra_data, mz_uint user_extra_data_len,
+                                    const char *user_extra_data_central, mz_uint user_extra_data_central_len)
+{
+    assert(! m_open);
+    if (int(level_and_flags) < 0)
+        level_and_flags = MZ_DEFAULT_LEVEL;
+    // Level 0 produces stored deflate blocks.
+    m_level = int(level_and_flags & 0xF);
+    m_size  = 0;
+    m_open  = mz_zip_writer_add_staged_open(&m_archive, &m_context, archive_name, max_size, nullptr, nullptr, 0, level_and_flags | MZ_ZIP_FLAG_COMPRESSED_DATA,
+                                            user_extra_data, user_extra_data_len, user_extra_data_central, user_extra_data_central_len);
+    if (m_open)
+        m_buffer.reserve(BlockSize);
+    return m_open;
+}
+
+bool MZ_ParallelDeflateWriter::write(const char *data, size_t size)
+{
+    if (! m_open)
+        return false;
+    m_size += size;
+    while (size > 0) {
+        size_t n = std::min(size, BlockSize - m_buffer.size());
+        m_buffer.append(data, n);
+        data += n;
+        size -= n;
+        if (m_buffer.size() == BlockSize) {
+            this->submit(false);
+            if (! this->write_compressed(max_blocks_in_flight()))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool MZ_ParallelDeflateWriter::finish()
+{
+    if (! m_open)
+        return false;
+    this->submit(true);
+    bool ok = this->write_compressed(0) && mz_zip_writer_add_staged_finish(&m_context);
+    m_open = false;
+    return ok;
+}
+
+void MZ_ParallelDeflateWriter::submit(bool last)
+{
+    m_blocks.emplace_back(std::make_unique<Block>());
+    Block &block = *m_blocks.back();
+    block.data.swap(m_buffer);
+    block.data_size = block.data.size();
+    block.last = last;
+    if (! last)
+        m_buffer.reserve(BlockSize);
+    block.task.run([&block, level = m_level]() { block.compress_block(level); });
+}
+
+bool MZ_ParallelDeflateWriter::write_compressed(size_t wait_for)
+{
+    while (! m_blocks.empty()) {
+        Block &block = *m_blocks.front();
+        if (m_blocks.size() < wait_for && ! block.done)
+            break;
+        // Either done already, or waiting bounds the memory footprint. This thread helps with the compression while waiting.
+        block.task.wait();
+        if (block.failed ||
+            ! mz_zip_writer_add_staged_compressed_data(&m_context, block.compressed.data(), block.compressed.size(), block.data_size, block.checksum)) {
+            m_open = false;
+            return false;
+        }
+        m_blocks.pop_front();
+    }
+    return true;
+}
+
+MZ_HeapArchive::MZ_HeapArchive()
+{
+    mz_zip_zero_struct(&m_archive);
+    // If it fails, then the writes into the archive fail.
+    mz_zip_writer_init_heap(&m_archive, 0, 1024 * 1024);
+}
+
+MZ_HeapArchive::~MZ_HeapArchive()
+{
+    if (m_reading)
+        mz_zip_reader_end(&m_archive);
+    else
+        mz_zip_writer_end(&m_archive);
+    mz_free(m_buffer);
+}
+
+bool MZ_HeapArchive::copy_to(mz_zip_archive &dst)
+{
+    assert(! m_reading && m_buffer == nullptr);
+    size_t size = 0;
+    bool   ok   = mz_zip_writer_finalize_heap_archive(&m_archive, &m_buffer, &size);
+    mz_zip_writer_end(&m_archive);
+    mz_zip_zero_struct(&m_archive);
+    m_reading = ok && mz_zip_reader_init_mem(&m_archive, m_buffer, size, 0);
+    ok = m_reading;
+    for (mz_uint i = 0; ok && i < mz_zip_reader_get_num_files(&m_archive); ++ i)
+        ok = mz_zip_writer_add_from_zip_reader(&dst, &m_archive, i);
+    return ok;
+}
+
 } // namespace Slic3r
@@ -1,6 +1,8 @@
 #ifndef MINIZ_EXTENSION_HPP
 #define MINIZ_EXTENSION_HPP
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <miniz.h>
 
@@ -30,6 +32,75 @@ public:
     }
 };
 
+// Streams a single entry into a ZIP archive opened for writing, deflating the entry in parallel.
+// The data is cut into blocks of BlockSize bytes, which are compressed independently by TBB tasks into raw deflate
+// streams terminated by a sync flush, thus the compressed blocks concatenate into a single valid deflate stream.
+// The compressed blocks are written into the archive in order as soon as they are ready. No more than
+// max_blocks_in_flight() blocks are kept in memory, thus the memory footprint does not depend on the size of the entry.
+// All calls are to be made from a single thread and nothing else may be written into the archive until finish() returns.
+class MZ_ParallelDeflateWriter
+{
+public:
+    MZ_ParallelDeflateWriter(mz_zip_archive &archive);
+    MZ_ParallelDeflateWriter(const MZ_ParallelDeflateWriter &) = delete;
+    MZ_ParallelDeflateWriter& operator=(const MZ_ParallelDeflateWriter &) = delete;
+    // Waits for the compression tasks, does not finish the entry.
+    ~MZ_ParallelDeflateWriter();
+
+    // Same parameters as mz_zip_writer_add_staged_open(), the extra data must be valid until finish() returns.
+    bool open(const char *archive_name, mz_uint64 max_size, mz_uint level_and_flags,
+              const char *user_extra_data = nullptr, mz_uint user_extra_data_len = 0,
+              const char *user_extra_data_central = nullptr, mz_uint user_extra_data_central_len = 0);
+    bool write(const char *data, size_t size);
+    bool write(const std::string &data) { return this->write(data.data(), data.size()); }
+    // Compresses the rest of the data and writes the data descriptor of the entry.
+    bool finish();
+
+    // Size of the uncompressed data passed to write().
+    mz_uint64 size() const { return m_size; }
+
+    // Sized so that the deflate window lost at the block boundaries costs well under 1% of the compression ratio.
+    static constexpr const size_t BlockSize = 1024 * 1024;
+    static size_t max_blocks_in_flight();
+
+private:
+    struct Block;
+
+    // Queue the buffered data for compression.
+    void submit(bool last);
+    // Write the compressed blocks in order, wait for the oldest block if wait_for is not smaller than the number of blocks in flight.
+    bool write_compressed(size_t wait_for);
+
+    mz_zip_archive                     &m_archive;
+    mz_zip_writer_staged_context        m_context;
+    int                                 m_level { 0 };
+    bool                                m_open { false };
+    mz_uint64                           m_size { 0 };
+    std::string                         m_buffer;
+    std::deque<std::unique_ptr<Block>>  m_blocks;
+};
+
+// An in-memory ZIP archive, into which a worker thread compresses a few entries. The entries are then copied into the output
+// archive by the thread writing it, thus the entries may be compressed in parallel, while they are written in a deterministic order.
+class MZ_HeapArchive
+{
+public:
+    MZ_HeapArchive();
+    MZ_HeapArchive(const MZ_HeapArchive &) = delete;
+    MZ_HeapArchive& operator=(const MZ_HeapArchive &) = delete;
+    ~MZ_HeapArchive();
+
+    // Archive to write the entries into.
+    mz_zip_archive& archive() { return m_archive; }
+    // Finalizes the in-memory archive and copies all its entries into dst, may be called once.
+    bool copy_to(mz_zip_archive &dst);
+
+private:
+    mz_zip_archive m_archive;
+    void          *m_buffer { nullptr };
+    bool           m_reading { false };
+};
+
 } // namespace Slic3r
 
 #endif // MINIZ_EXTENSION_HPP
@@ -152,6 +152,68 @@ mz_ulong mz_crc32(mz_ulong crc, const mz_uint8 *ptr, size_t buf_len)
 }
 #endif
 
+/* BBS: GF(2) matrix helpers of mz_crc32_combine(), following zlib's crc32_combine(). */
+static mz_uint32 mz_gf2_matrix_times(const mz_uint32 *mat, mz_uint32 vec)
+{
+    mz_uint32 sum = 0;
+    while (vec)
+    {
+        if (vec & 1)
+            sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+static void mz_gf2_matrix_square(mz_uint32 *square, const mz_uint32 *mat)
+{
+    int n;
+    for (n = 0; n < 32; n++)
+        square[n] = mz_gf2_matrix_times(mat, mat[n]);
+}
+
+mz_ulong mz_crc32_combine(mz_ulong crc1, mz_ulong crc2, mz_uint64 len2)
+{
+    int n;
+    mz_uint32 row;
+    mz_uint32 even[32]; /* even-power-of-two zeros operator */
+    mz_uint32 odd[32];  /* odd-power-of-two zeros operator */
+    mz_uint32 crc = (mz_uint32)crc1;
+
+    if (len2 == 0)
+        return crc1;
+
+    /* Operator for one zero bit in odd. */
+    odd[0] = 0xEDB88320UL;
+    row = 1;
+    for (n = 1; n < 32; n++)
+    {
+        odd[n] = row;
+        row <<= 1;
+    }
+    /* Operator for two zero bits in even, four zero bits in odd. */
+    mz_gf2_matrix_square(even, odd);
+    mz_gf2_matrix_square(odd, even);
+
+    /* Apply len2 zeros to crc1 (the first square puts the operator for one zero byte, eight zero bits, in even). */
+    do
+    {
+        mz_gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc = mz_gf2_matrix_times(even, crc);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+        mz_gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc = mz_gf2_matrix_times(odd, crc);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc ^ (mz_uint32)crc2;
+}
+
 void mz_free(void *p)
 {
     MZ_FREE(p);
@@ -6759,17 +6821,15 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     if ((int)level_and_flags < 0)
         level_and_flags = MZ_DEFAULT_LEVEL;
     level = level_and_flags & 0xF;
+    /* BBS: The data will be deflated by the caller and passed to mz_zip_writer_add_staged_compressed_data(). */
+    pContext->compressed_data = (level_and_flags & MZ_ZIP_FLAG_COMPRESSED_DATA) != 0;
 
     /* Sanity checks */
-    if ((!pZip) || (!pZip->m_pState) || (pZip->m_zip_mode != MZ_ZIP_MODE_WRITING) || (!pArchive_name) || ((comment_size) && (!pComment)) || (level == 0) || (level > MZ_UBER_COMPRESSION) || (max_size < 4))
+    if ((!pZip) || (!pZip->m_pState) || (pZip->m_zip_mode != MZ_ZIP_MODE_WRITING) || (!pArchive_name) || ((comment_size) && (!pComment)) || (!pContext->compressed_data && level == 0) || (level > MZ_UBER_COMPRESSION) || (max_size < 4))
         return mz_zip_set_error(pZip, MZ_ZIP_INVALID_PARAMETER);
 
     pState = pZip->m_pState;
 
-    /* We could support this, but why? */
-    if (level_and_flags & MZ_ZIP_FLAG_COMPRESSED_DATA)
-        return mz_zip_set_error(pZip, MZ_ZIP_INVALID_PARAMETER);
-
     if (!mz_zip_writer_validate_archive_name(pArchive_name))
         return mz_zip_set_error(pZip, MZ_ZIP_INVALID_FILENAME);
 
@@ -6878,6 +6938,14 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     }
 
     assert(max_size);
+
+    pContext->add_state.m_pZip = pZip;
+    pContext->add_state.m_cur_archive_file_ofs = pContext->cur_archive_file_ofs;
+    pContext->add_state.m_comp_size = 0;
+
+    if (pContext->compressed_data)
+        return MZ_TRUE;
+
     assert(level);
 
     pContext->pCompressor = (tdefl_compressor*)pZip->m_pAlloc(pZip->m_pAlloc_opaque, 1, sizeof(tdefl_compressor));
@@ -6886,10 +6954,6 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
         return mz_zip_set_error(pZip, MZ_ZIP_ALLOC_FAILED);
     }
 
-    pContext->add_state.m_pZip = pZip;
-    pContext->add_state.m_cur_archive_file_ofs = pContext->cur_archive_file_ofs;
-    pContext->add_state.m_comp_size = 0;
-
     if (tdefl_init(pContext->pCompressor, mz_zip_writer_add_put_buf_callback, &pContext->add_state, tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY)) != TDEFL_STATUS_OKAY)
     {
         pZip->m_pFree(pZip->m_pAlloc_opaque, pContext->pCompressor);
@@ -6903,6 +6967,9 @@ mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context *pContext, co
 {
     tdefl_flush  flush = TDEFL_NO_FLUSH;
 
+    if (pContext->compressed_data || !pContext->pCompressor)
+        return mz_zip_set_error(pContext->pZip, MZ_ZIP_INVALID_PARAMETER);
+
     if (pContext->file_ofs + n > pContext->max_size)
     {
         mz_zip_set_error(pContext->pZip, MZ_ZIP_FILE_READ_FAILED);
@@ -6929,15 +6996,37 @@ mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context *pContext, co
     return MZ_FALSE;
 }
 
+mz_bool mz_zip_writer_add_staged_compressed_data(mz_zip_writer_staged_context *pContext, const void *pComp_buf, size_t comp_size, mz_uint64 uncomp_size, mz_uint32 uncomp_crc32)
+{
+    mz_zip_archive *pZip = pContext->pZip;
+
+    if (!pContext->compressed_data)
+        return mz_zip_set_error(pZip, MZ_ZIP_INVALID_PARAMETER);
+
+    if (pContext->file_ofs + uncomp_size > pContext->max_size)
+        return mz_zip_set_error(pZip, MZ_ZIP_FILE_READ_FAILED);
+
+    if (comp_size > 0 && pZip->m_pWrite(pZip->m_pIO_opaque, pContext->add_state.m_cur_archive_file_ofs, pComp_buf, comp_size) != comp_size)
+        return mz_zip_set_error(pZip, MZ_ZIP_FILE_WRITE_FAILED);
+
+    pContext->add_state.m_cur_archive_file_ofs += comp_size;
+    pContext->add_state.m_comp_size += comp_size;
+    pContext->uncomp_crc32 = (mz_uint32)mz_crc32_combine(pContext->uncomp_crc32, uncomp_crc32, uncomp_size);
+    pContext->file_ofs += uncomp_size;
+    return MZ_TRUE;
+}
+
 mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context *pContext)
 {
-    if (! mz_zip_writer_add_staged_data(pContext, NULL, 0) ||
-        // Either never opened, or already finished.
-        ! pContext->pCompressor)
-        return MZ_FALSE;
+    if (! pContext->compressed_data) {
+        if (! mz_zip_writer_add_staged_data(pContext, NULL, 0) ||
+            // Either never opened, or already finished.
+            ! pContext->pCompressor)
+            return MZ_FALSE;
 
-    pContext->pZip->m_pFree(pContext->pZip->m_pAlloc_opaque, pContext->pCompressor);
-    pContext->pCompressor = NULL;
+        pContext->pZip->m_pFree(pContext->pZip->m_pAlloc_opaque, pContext->pCompressor);
+        pContext->pCompressor = NULL;
+    }
 
     // Rewrite preallocated phony custom block in local dir header by ZIP64 extension. Also, other values are adjusted in the header.
     if (pContext->file_ofs >= MZ_UINT32_MAX || pContext->add_state.m_comp_size >= MZ_UINT32_MAX) {
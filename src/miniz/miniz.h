@@ -1336,6 +1336,8 @@ typedef struct mz_zip_writer_staged_context
     mz_uint8  *pExtra_data;
     mz_uint32  extra_size;
     mz_uint8   extra_data[MZ_ZIP64_MAX_CENTRAL_EXTRA_FIELD_SIZE];
+    /* BBS: Opened with MZ_ZIP_FLAG_COMPRESSED_DATA, raw deflate data is passed to mz_zip_writer_add_staged_compressed_data(). */
+    mz_bool    compressed_data;
 
     /*
      * Compressor context
@@ -1360,6 +1362,11 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     mz_uint64 max_size, const MZ_TIME_T* pFile_time, const void* pComment, mz_uint16 comment_size, mz_uint level_and_flags,
     const char* user_extra_data, mz_uint user_extra_data_len, const char* user_extra_data_central, mz_uint user_extra_data_central_len);
 mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context* pContext, const char* pRead_buf, size_t n);
+/* BBS: mz_crc32_combine() returns the CRC-32 of the concatenation of two blocks, given the CRC-32 of both blocks and the length of the second one. */
+mz_ulong mz_crc32_combine(mz_ulong crc1, mz_ulong crc2, mz_uint64 len2);
+/* BBS: If opened with MZ_ZIP_FLAG_COMPRESSED_DATA, adds a piece of raw deflate stream compressed by the caller, */
+/* together with the size and CRC-32 of the uncompressed data it was produced from. The pieces are written in the order of the calls. */
+mz_bool mz_zip_writer_add_staged_compressed_data(mz_zip_writer_staged_context* pContext, const void* pComp_buf, size_t comp_size, mz_uint64 uncomp_size, mz_uint32 uncomp_crc32);
 mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context* pContext);
 
 /* Adds a file to an archive by fully cloning the data from another archive. */
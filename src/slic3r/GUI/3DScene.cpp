@@ -706,8 +706,8 @@ bool GLVolume::simplify_mesh(const indexed_triangle_set &_its, std::shared_ptr<G
             }
             int          init_face_count = its->indices.size();
             TriangleMesh origin_mesh(*its);
-            try { // Start the actual calculation.
-                its_quadric_edge_collapse(*its, triangle_count, &max_error, throw_on_cancel, statusfn);
+            try { // Start the actual calculation, a large mesh is collapsed by parts in parallel.
+                its_quadric_edge_collapse_partitioned(*its, triangle_count, &max_error, throw_on_cancel, statusfn);
             } catch (std::exception&) {
                 state->status = State::idle;
             }
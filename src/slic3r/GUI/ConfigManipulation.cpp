@@ -702,7 +702,8 @@ void ConfigManipulation::toggle_print_fff_options(DynamicPrintConfig *config, in
 
     bool support_multiline_infill = pattern == ipCubic || pattern == ipGrid || pattern == ipRectilinear || pattern == ipStars || pattern == ipAlignedRectilinear ||
                                     pattern == ipGyroid || pattern == ipHoneycomb || pattern == ipLightning || pattern == ip3DHoneycomb ||
-                                    pattern == ipAdaptiveCubic || pattern == ipSupportCubic;
+                                    pattern == ipAdaptiveCubic || pattern == ipSupportCubic || pattern == ipSchwarzP || pattern == ipSchwarzD ||
+                                    pattern == ipNeovius;
 
     toggle_line("fill_multiline", have_infill && support_multiline_infill);
     if (support_multiline_infill == false) {
@@ -6,10 +6,18 @@
 #include "slic3r/GUI/OpenGLManager.hpp"
 #include "slic3r/GUI/IMSlider.hpp"
 #include "slic3r/GUI/MainFrame.hpp"
+#include "slic3r/GUI/Plater.hpp"
+#include "slic3r/GUI/GLCanvas3D.hpp"
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Geometry/ConvexHull.hpp"
+#include "libslic3r/Thread.hpp"
 #include <GL/glew.h>
+#include <atomic>
+#include <limits>
 #include <boost/nowide/cstdio.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 #include <wx/numformatter.h>
 namespace
 {
@@ -140,6 +148,27 @@ namespace
         }
     }
 
+    // the views coloring the toolpaths by a value from a range rather than by a discrete id
+    bool is_view_type_continuous(const Slic3r::GUI::gcode::EViewType type)
+    {
+        switch (type)
+        {
+        case Slic3r::GUI::gcode::EViewType::Height:
+        case Slic3r::GUI::gcode::EViewType::Width:
+        case Slic3r::GUI::gcode::EViewType::Feedrate:
+        case Slic3r::GUI::gcode::EViewType::FanSpeed:
+        case Slic3r::GUI::gcode::EViewType::Temperature:
+        case Slic3r::GUI::gcode::EViewType::LayerTime:
+        case Slic3r::GUI::gcode::EViewType::VolumetricRate:
+        case Slic3r::GUI::gcode::EViewType::ThermalIndexMin:
+        case Slic3r::GUI::gcode::EViewType::ThermalIndexMax:
+        case Slic3r::GUI::gcode::EViewType::ThermalIndexMean:
+            return true;
+        default:
+            return false;
+        }
+    }
+
     void export_image(const std::shared_ptr<Slic3r::GUI::GLTexture>& p_texture, const wxString& path)
     {
         if (!p_texture) {
@@ -216,6 +245,126 @@ namespace Slic3r
     {
         namespace gcode
         {
+            // Builds the segments of the layers on a background thread, which drives a parallel loop over batches of layers,
+            // so the preview shows up and the sliders stay interactive while the rest of the toolpaths streams in.
+            // The layers of the current slider range are built first, the top one first as it feeds the moves slider.
+            // The render thread moves the finished layers into the layer manager, their textures are uploaded lazily as before.
+            struct AdvancedRenderer::LayerBuilder
+            {
+                static constexpr size_t npos = size_t(-1);
+
+                std::vector<Layer> layers;
+                std::vector<size_t> sid_to_mid;
+                std::vector<std::vector<size_t>> sid_to_seam_move_ids;
+                const GCodeProcessorResult* p_gcode_result{ nullptr };
+                unsigned int result_id{ 0 };
+                size_t move_count{ 0 };
+
+                std::unique_ptr<std::atomic<bool>[]> built;
+                std::atomic<bool> cancel{ false };
+                // first layer of the slider range in the high 32 bits, last one in the low 32 bits, set by the render thread
+                std::atomic<uint64_t> focus{ 0 };
+                boost::thread thread;
+
+                // only accessed by the render thread
+                std::vector<bool> collected;
+                size_t collected_count{ 0 };
+
+                // only accessed by the builder thread
+                std::vector<bool> claimed;
+                uint64_t last_focus{ uint64_t(-1) };
+                size_t focus_top{ npos };
+                size_t focus_next{ 0 };
+                size_t focus_end{ 0 };
+                size_t sweep_next{ 0 };
+
+                void set_focus(uint32_t first, uint32_t last)
+                {
+                    focus.store((uint64_t(first) << 32) | uint64_t(last), std::memory_order_relaxed);
+                }
+
+                bool try_claim(size_t index)
+                {
+                    if (index >= layers.size() || claimed[index]) {
+                        return false;
+                    }
+                    claimed[index] = true;
+                    return true;
+                }
+
+                size_t take_layer()
+                {
+                    const uint64_t t_focus = focus.load(std::memory_order_relaxed);
+                    if (t_focus != last_focus) {
+                        last_focus = t_focus;
+                        focus_top = size_t(t_focus & 0xFFFFFFFFull);
+                        focus_next = size_t(t_focus >> 32);
+                        focus_end = std::min(focus_top + 1, layers.size());
+                    }
+                    if (focus_top != npos) {
+                        const size_t index = focus_top;
+                        focus_top = npos;
+                        if (try_claim(index)) {
+                            return index;
+                        }
+                    }
+                    while (focus_next < focus_end) {
+                        const size_t index = focus_next++;
+                        if (try_claim(index)) {
+                            return index;
+                        }
+                    }
+                    while (sweep_next < layers.size()) {
+                        const size_t index = sweep_next++;
+                        if (try_claim(index)) {
+                            return index;
+                        }
+                    }
+                    return npos;
+                }
+
+                void run()
+                {
+                    const size_t t_batch_size = 4 * size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+                    std::vector<size_t> t_batch;
+                    t_batch.reserve(t_batch_size);
+                    while (!cancel.load(std::memory_order_relaxed)) {
+                        // The render thread holds the result while loading it, don't block it if it waits for this builder to stop.
+                        while (!p_gcode_result->result_mutex.try_lock()) {
+                            if (cancel.load(std::memory_order_relaxed)) {
+                                return;
+                            }
+                            boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+                        }
+                        // The result is released between the batches, so a refresh of the preview waits for one batch at most.
+                        std::lock_guard<std::mutex> lock(p_gcode_result->result_mutex, std::adopt_lock);
+                        // The result is reset and processed again when the plate is re-sliced, the remaining layers are stale.
+                        if (p_gcode_result->id != result_id || p_gcode_result->moves.size() != move_count) {
+                            BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": gcode result %1% changed while loading the layers, stop") % result_id;
+                            cancel.store(true, std::memory_order_relaxed);
+                            return;
+                        }
+                        t_batch.clear();
+                        for (size_t index = take_layer(); index != npos; index = take_layer()) {
+                            t_batch.emplace_back(index);
+                            if (t_batch.size() == t_batch_size) {
+                                break;
+                            }
+                        }
+                        if (t_batch.empty()) {
+                            return;
+                        }
+                        tbb::parallel_for(tbb::blocked_range<size_t>(0, t_batch.size(), 1), [this, &t_batch](const tbb::blocked_range<size_t>& range) {
+                            for (size_t i = range.begin(); i < range.end(); ++i) {
+                                const size_t index = t_batch[i];
+                                layers[index].init_sgments(sid_to_mid, sid_to_seam_move_ids, *p_gcode_result);
+                                built[index].store(true, std::memory_order_release);
+                            }
+                        });
+                    }
+                }
+            };
+
             AdvancedRenderer::AdvancedRenderer()
                 :BaseRenderer()
             {
@@ -223,6 +372,7 @@ namespace Slic3r
 
             AdvancedRenderer::~AdvancedRenderer()
             {
+                stop_layer_builder();
             }
 
             void AdvancedRenderer::init(ConfigOptionMode mode, Slic3r::PresetBundle* preset_bundle)
@@ -300,6 +450,8 @@ namespace Slic3r
                     return;
                 }
                 wxBusyCursor busy;
+                // all the layers are exported, not only the ones loaded so far
+                wait_for_layer_builder();
 
                 // save materials file
                 boost::filesystem::path mat_filename(filename);
@@ -667,6 +819,9 @@ namespace Slic3r
                 }
                 m_p_layer_manager->set_current_layer_start(layers_z_range[0]);
                 m_p_layer_manager->set_current_layer_end(layers_z_range[1]);
+                if (m_p_layer_builder) {
+                    m_p_layer_builder->set_focus(m_p_layer_manager->get_current_layer_start(), m_p_layer_manager->get_current_layer_end());
+                }
             }
 
             void AdvancedRenderer::render(int canvas_width, int canvas_height, int right_margin)
@@ -689,6 +844,13 @@ namespace Slic3r
                 }
 
                 m_p_layer_manager->set_view_type(m_view_type);
+                // the levels of detail of the visible segments depend on the per move data of the view
+                m_p_layer_manager->update_per_move_data(m_view_type, *m_gcode_result);
+
+                // keep rendering while the layers stream in from the builder
+                if (collect_built_layers()) {
+                    wxGetApp().plater()->get_current_canvas3D()->schedule_extra_frame(50);
+                }
 
                 bool b_needs_to_update_move_slider = m_p_layer_manager->update_visibile_segment_list(false, m_tools.m_tool_visibles);
 
@@ -703,8 +865,6 @@ namespace Slic3r
 
                 m_p_layer_manager->update_transient_segment_list(b_needs_to_update_move_slider);
 
-                m_p_layer_manager->update_per_move_data(m_view_type, *m_gcode_result);
-
                 render_toolpaths();
                 //render_shells();
                 render_legend(m_legend_height, canvas_width, canvas_height, right_margin);
@@ -735,6 +895,7 @@ namespace Slic3r
 
             void AdvancedRenderer::reset()
             {
+                stop_layer_builder();
                 BaseRenderer::reset();
                 m_b_tool_colors_dirty = true;
 
@@ -1068,33 +1229,103 @@ namespace Slic3r
                     return;
                 }
 
-                last_progress = 0;
-                const auto t_layer_count = p_layer_manager->size();
-                for (size_t i = 0; i < t_layer_count; ++i) {
-                    auto& t_layer = (*p_layer_manager)[i];
-                    t_layer.init_sgments(m_ssid_to_moveid_map, t_sid_to_seamMoveIds, gcode_result);
-                    if (progress_dialog != nullptr) {
-                        float progress_value = 100.0f * float(i + 1) / float(t_layer_count);
-                        if (int(progress_value) != last_progress && int(progress_value) % 10 == 0) {
-                            progress_dialog->Update(int(progress_value),
-                                                    _L("Loading segments") + ": " + wxNumberFormatter::ToString(progress_value, 0, wxNumberFormatter::Style_None) + "%");
-                            progress_dialog->Fit();
-                            last_progress = int(progress_value);
-                        }
-                    }
-                }
-
                 if (progress_dialog != nullptr) {
                     progress_dialog->Update(100, "");
                     progress_dialog->Fit();
                     delete progress_dialog;
                 }
 
+                // the segments are built in the background and show up layer by layer
+                start_layer_builder(gcode_result, std::move(t_sid_to_seamMoveIds));
                 m_ssid_to_moveid_map.clear();
 
                 set_layers_z_range({ 0, static_cast<unsigned int>(p_layer_manager->size()) - 1 });
             }
 
+            void AdvancedRenderer::start_layer_builder(const GCodeProcessorResult& gcode_result, std::vector<std::vector<size_t>>&& sid_to_seam_move_ids)
+            {
+                stop_layer_builder();
+                const auto& p_layer_manager = get_layer_manager();
+                const auto t_layer_count = p_layer_manager->size();
+                if (0 == t_layer_count) {
+                    return;
+                }
+
+                const auto p_builder = std::make_shared<LayerBuilder>();
+                p_builder->layers.reserve(t_layer_count);
+                for (size_t i = 0; i < t_layer_count; ++i) {
+                    p_builder->layers.emplace_back((*p_layer_manager)[i]);
+                }
+                p_builder->sid_to_mid = std::move(m_ssid_to_moveid_map);
+                p_builder->sid_to_seam_move_ids = std::move(sid_to_seam_move_ids);
+                p_builder->p_gcode_result = &gcode_result;
+                p_builder->result_id = gcode_result.id;
+                p_builder->move_count = gcode_result.moves.size();
+                p_builder->built.reset(new std::atomic<bool>[t_layer_count]);
+                for (size_t i = 0; i < t_layer_count; ++i) {
+                    p_builder->built[i].store(false, std::memory_order_relaxed);
+                }
+                p_builder->collected.assign(t_layer_count, false);
+                p_builder->claimed.assign(t_layer_count, false);
+                p_builder->set_focus(0, static_cast<uint32_t>(t_layer_count - 1));
+
+                m_p_layer_builder = p_builder;
+                LayerBuilder* p_raw_builder = p_builder.get();
+                p_builder->thread = create_thread([p_raw_builder]() {
+                    set_current_thread_name("bbl_GCodePreview");
+                    p_raw_builder->run();
+                });
+            }
+
+            void AdvancedRenderer::stop_layer_builder() const
+            {
+                if (!m_p_layer_builder) {
+                    return;
+                }
+                m_p_layer_builder->cancel.store(true, std::memory_order_relaxed);
+                if (m_p_layer_builder->thread.joinable()) {
+                    m_p_layer_builder->thread.join();
+                }
+                m_p_layer_builder.reset();
+            }
+
+            void AdvancedRenderer::wait_for_layer_builder() const
+            {
+                if (!m_p_layer_builder) {
+                    return;
+                }
+                if (m_p_layer_builder->thread.joinable()) {
+                    m_p_layer_builder->thread.join();
+                }
+                collect_built_layers();
+            }
+
+            bool AdvancedRenderer::collect_built_layers() const
+            {
+                if (!m_p_layer_builder) {
+                    return false;
+                }
+                if (!m_p_layer_manager || !m_gcode_result) {
+                    stop_layer_builder();
+                    return false;
+                }
+                auto& t_builder = *m_p_layer_builder;
+                const auto t_layer_count = t_builder.layers.size();
+                for (size_t i = 0; i < t_layer_count; ++i) {
+                    if (t_builder.collected[i] || !t_builder.built[i].load(std::memory_order_acquire)) {
+                        continue;
+                    }
+                    m_p_layer_manager->replace_layer(i, std::move(t_builder.layers[i]), m_tools.m_tool_visibles, *m_gcode_result);
+                    t_builder.collected[i] = true;
+                    ++t_builder.collected_count;
+                }
+                if (t_builder.collected_count < t_layer_count && !t_builder.cancel.load(std::memory_order_relaxed)) {
+                    return true;
+                }
+                stop_layer_builder();
+                return false;
+            }
+
             const std::shared_ptr<LayerManager>& AdvancedRenderer::get_layer_manager() const
             {
                 if (!m_p_layer_manager) {
@@ -1188,6 +1419,10 @@ namespace Slic3r
                 bool b_unlit = false;
                 p_shader->set_uniform("u_rangeType_isUnlit_topLayerIndex", Vec3f(float(range_type), float(b_unlit), float(p_layer_manager->get_current_layer_end())));
 
+                // the layers below the top one are rendered at the level of detail matching the screen size of a pixel,
+                // the top layer always in full detail as it is traversed by the moves slider
+                const size_t t_lod_level = ToolpathLOD::select_level(ToolpathLOD::pixel_size(view_matrix, camera.get_projection_matrix(), camera.get_viewport()[3], m_paths_bounding_box));
+
                 uint8_t texture_stage = 0;
                 int tool_colos_count = -1;
                 switch (m_view_type) {
@@ -1247,7 +1482,7 @@ namespace Slic3r
                         m_p_layer_manager->update_transient_other_texture();
                     }
                     else {
-                        t_layer.update_other_segment_texture();
+                        t_layer.update_other_segment_texture(t_lod_level);
                     }
 
                     p_shader->set_uniform("u_isTopLayer_hasCustomOptins", Vec2f(float(i == 0), 0.0f));
@@ -1271,8 +1506,8 @@ namespace Slic3r
                         seg_count = p_layer_manager->get_transient_other_segment_count();
                     }
                     else {
-                        t_layer.bind_other_segment_texture(segment_texture_stage);
-                        seg_count = t_layer.get_other_segment_count();
+                        t_layer.bind_other_segment_texture(segment_texture_stage, t_lod_level);
+                        seg_count = t_layer.get_other_segment_count(t_lod_level);
                     }
                     p_shader->set_uniform("s_segment_texture", segment_texture_stage);
                     m_triangular_prism.render_geometry_instance(0, seg_count);
@@ -1967,6 +2202,13 @@ namespace Slic3r
                 m_other_segment_list.clear();
                 m_other_segment_count = 0;
 
+                for (auto& t_lod : m_other_segment_lods) {
+                    t_lod.m_b_same_as_finer = false;
+                    t_lod.m_segment_list.clear();
+                    t_lod.m_b_dirty = true;
+                    t_lod.m_count = 0;
+                }
+
                 uint32_t seg_count = m_segments.size();
                 if (!seg_count) {
                     return;
@@ -1987,6 +2229,8 @@ namespace Slic3r
                 }
 
                 const auto t_view_type = t_layer_manager.get_view_type();
+                // segments ending in vertices of different keys are not merged by the levels of detail
+                std::vector<uint64_t> t_vertex_keys(m_segment_vertices.size(), 0);
                 for (int i_seg = t_start_seg_index; i_seg <= t_end_seg_index; ++i_seg) {
                     const auto& t_seg = m_segments[i_seg];
                     if (!t_layer_manager.is_move_type_visible(t_seg.m_type)) {
@@ -2020,10 +2264,46 @@ namespace Slic3r
                     case EMoveType::Wipe:
                     {
                         add_segment(t_seg, m_segment_vertices, m_other_segment_list, prev_seg_index, true);
+                        const uint64_t t_view_key = t_seg.m_second_mid < m_view_keys.size() ? m_view_keys[t_seg.m_second_mid] : 0;
+                        t_vertex_keys[t_seg.m_second_mid] = (t_view_key << 32) | (uint32_t(t_seg.m_type) << 24) | (uint32_t(t_seg.m_role) << 16) | uint32_t(t_seg.m_extruder_id);
                         break;
                     }
                     }
                 }
+
+                build_other_segment_lods(t_vertex_keys);
+            }
+
+            void Layer::build_other_segment_lods(const std::vector<uint64_t>& vertex_keys)
+            {
+                const auto position = [this](uint32_t pos_index) {
+                    return m_position_data[pos_index].m_position;
+                    };
+                const auto key = [this, &vertex_keys](uint32_t pos_index) {
+                    return vertex_keys[m_position_data[pos_index].m_segment_vertex_index];
+                    };
+                size_t t_finer_count = m_other_segment_list.size() / 4;
+                for (size_t i = 0; i < m_other_segment_lods.size(); ++i) {
+                    auto& t_lod = m_other_segment_lods[i];
+                    // every level is simplified from the full resolution, so its error stays within its tolerance
+                    const size_t t_count = ToolpathLOD::simplify_instances(m_other_segment_list, ToolpathLOD::level_tolerance(i + 1), position, key, t_lod.m_segment_list);
+                    if (4 * t_count > 3 * t_finer_count) {
+                        t_lod.m_b_same_as_finer = true;
+                        t_lod.m_segment_list.clear();
+                        t_lod.m_segment_list.shrink_to_fit();
+                        continue;
+                    }
+                    t_finer_count = t_count;
+                }
+            }
+
+            size_t Layer::resolve_lod_level(size_t lod_level) const
+            {
+                lod_level = std::min(lod_level, m_other_segment_lods.size());
+                while (lod_level > 0 && m_other_segment_lods[lod_level - 1].m_b_same_as_finer) {
+                    --lod_level;
+                }
+                return lod_level;
             }
 
             const std::vector<uint32_t>& Layer::get_visible_segment_list() const
@@ -2132,6 +2412,8 @@ namespace Slic3r
             {
                 m_per_move_data_list.clear();
                 m_per_move_data_list.reserve(4 * m_segment_vertices.size());
+                float t_min_value = std::numeric_limits<float>::max();
+                float t_max_value = std::numeric_limits<float>::lowest();
                 for (auto iter = m_segment_vertices.begin(); iter != m_segment_vertices.end(); ++iter)
                 {
                     const auto& t_move = gcode_result.moves[iter->m_move_id];
@@ -2140,8 +2422,19 @@ namespace Slic3r
                     m_per_move_data_list.emplace_back(t_move_range_data);
                     m_per_move_data_list.emplace_back(t_move.delta_extruder);
                     m_per_move_data_list.emplace_back(0.0f);
+                    t_min_value = std::min(t_min_value, t_move_range_data);
+                    t_max_value = std::max(t_max_value, t_move_range_data);
                 }
                 m_b_per_move_data_dirty = true;
+
+                // the levels of detail do not merge segments of visibly different colors. A continuous value is quantized over the range of the layer,
+                // which is not wider than the range of the legend, a discrete one is kept as is
+                const bool t_continuous = is_view_type_continuous(t_view_type);
+                m_view_keys.resize(m_segment_vertices.size());
+                for (size_t i = 0; i < m_segment_vertices.size(); ++i) {
+                    const float t_value = m_per_move_data_list[4 * i + 1];
+                    m_view_keys[i] = t_continuous ? ToolpathLOD::quantize_attribute(t_value, t_min_value, t_max_value) : uint32_t(std::max(t_value, 0.0f));
+                }
             }
 
             void Layer::update_per_move_data_texture()
@@ -2177,13 +2470,13 @@ namespace Slic3r
                 }
             }
 
-            void Layer::update_other_segment_texture()
+            static void update_segment_texture(std::shared_ptr<GLTexture>& p_texture, std::vector<float>& segment_list, bool& b_dirty, uint32_t& segment_count)
             {
                 const uint32_t width = 1;
                 const uint32_t height = 1;
-                if (!m_p_other_segment_texture) {
-                    m_p_other_segment_texture = std::make_shared<GLTexture>();
-                    m_p_other_segment_texture->set_width(width)
+                if (!p_texture) {
+                    p_texture = std::make_shared<GLTexture>();
+                    p_texture->set_width(width)
                         .set_height(height)
                         .set_internal_format(Slic3r::GUI::ETextureFormat::RGBA32F)
                         .set_sampler(Slic3r::GUI::ESamplerType::SamplerBuffer)
@@ -2194,30 +2487,47 @@ namespace Slic3r
                         .build();
                 }
 
-                if (m_p_other_segment_texture) {
-                    if (m_b_other_segment_dirty) {
-                        const auto& rt = m_p_other_segment_texture->set_buffer(m_other_segment_list);
+                if (p_texture) {
+                    if (b_dirty) {
+                        const auto& rt = p_texture->set_buffer(segment_list);
                         if (rt) {
-                            m_other_segment_count = m_other_segment_list.size() / 4;
-                            m_b_other_segment_dirty = false;
-                            m_other_segment_list.clear();
+                            segment_count = segment_list.size() / 4;
+                            b_dirty = false;
+                            segment_list.clear();
                         }
                         else {
-                            m_other_segment_count = 0;
+                            segment_count = 0;
                         }
                     }
                 }
             }
 
-            uint32_t Layer::get_other_segment_count() const
+            void Layer::update_other_segment_texture(size_t lod_level)
             {
+                const size_t t_lod_level = resolve_lod_level(lod_level);
+                if (t_lod_level > 0) {
+                    auto& t_lod = m_other_segment_lods[t_lod_level - 1];
+                    update_segment_texture(t_lod.m_p_texture, t_lod.m_segment_list, t_lod.m_b_dirty, t_lod.m_count);
+                    return;
+                }
+                update_segment_texture(m_p_other_segment_texture, m_other_segment_list, m_b_other_segment_dirty, m_other_segment_count);
+            }
+
+            uint32_t Layer::get_other_segment_count(size_t lod_level) const
+            {
+                const size_t t_lod_level = resolve_lod_level(lod_level);
+                if (t_lod_level > 0) {
+                    return m_other_segment_lods[t_lod_level - 1].m_count;
+                }
                 return m_other_segment_count;
             }
 
-            void Layer::bind_other_segment_texture(uint8_t stage) const
+            void Layer::bind_other_segment_texture(uint8_t stage, size_t lod_level) const
             {
-                if (m_p_other_segment_texture) {
-                    m_p_other_segment_texture->bind(stage);
+                const size_t t_lod_level = resolve_lod_level(lod_level);
+                const auto& p_texture = t_lod_level > 0 ? m_other_segment_lods[t_lod_level - 1].m_p_texture : m_p_other_segment_texture;
+                if (p_texture) {
+                    p_texture->bind(stage);
                 }
             }
 
@@ -2343,6 +2653,22 @@ namespace Slic3r
                 m_layer_list.emplace_back(std::move(t_layer));
             }
 
+            void LayerManager::replace_layer(size_t index, Layer&& t_layer, const std::vector<bool>& filament_visible_flags, const GCodeProcessorResult& t_gcode_result)
+            {
+                if (index >= m_layer_list.size()) {
+                    return;
+                }
+                auto& t_target_layer = m_layer_list[index];
+                t_target_layer = std::move(t_layer);
+                t_target_layer.update_per_move_data(m_view_type, t_gcode_result);
+                t_target_layer.update_visible_segment_list(*this, filament_visible_flags);
+                // the top layer feeds the moves slider and the transient segments
+                if (index == m_current_layer_range.second) {
+                    mark_layer_dirty();
+                    mark_move_dirty();
+                }
+            }
+
             void LayerManager::clear()
             {
                 m_layer_list.clear();
@@ -2573,9 +2899,12 @@ namespace Slic3r
             bool LayerManager::update_visibile_segment_list(bool b_force_update, const std::vector<bool>& filament_visible_flags)
             {
                 if (is_visibility_dirty() || b_force_update) {
-                    for (size_t i_layer = 0; i_layer < m_layer_list.size(); ++i_layer) {
-                        m_layer_list[i_layer].update_visible_segment_list(*this, filament_visible_flags);
-                    }
+                    // the layers only touch their own data, their levels of detail are built in parallel
+                    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_layer_list.size()), [this, &filament_visible_flags](const tbb::blocked_range<size_t>& range) {
+                        for (size_t i_layer = range.begin(); i_layer < range.end(); ++i_layer) {
+                            m_layer_list[i_layer].update_visible_segment_list(*this, filament_visible_flags);
+                        }
+                    });
                     clear_visibility_dirty();
                     return true;
                 }
@@ -2659,6 +2988,8 @@ namespace Slic3r
                 for (size_t i_layer = 0; i_layer < m_layer_list.size(); ++i_layer) {
                     m_layer_list[i_layer].update_per_move_data(t_view_type, t_gcode_result);
                 }
+                // rebuilds the levels of detail with the keys of the new view
+                mark_visibility_dirty();
 
                 clear_view_type_dirty();
             }
@@ -1,6 +1,8 @@
 #pragma once
 #include "slic3r/GUI/GCodeRenderer/BaseRenderer.hpp"
 #include "slic3r/GUI/GLModel.hpp"
+#include "libslic3r/GCode/ToolpathLOD.hpp"
+#include <array>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -93,6 +95,12 @@ namespace Slic3r {
             private:
                 void load_layer_info(const GCodeProcessorResult& gcode_result, const BuildVolume& build_volume, const std::vector<BoundingBoxf3>& exclude_bounding_box);
                 const std::shared_ptr<LayerManager>& get_layer_manager() const;
+                // the segments of the layers are built in the background, see LayerBuilder
+                void start_layer_builder(const GCodeProcessorResult& gcode_result, std::vector<std::vector<size_t>>&& sid_to_seam_move_ids);
+                void stop_layer_builder() const;
+                void wait_for_layer_builder() const;
+                // moves the finished layers into the layer manager, returns true while there are layers left to build
+                bool collect_built_layers() const;
                 void render_toolpaths();
                 void do_render_others(const std::vector<uint32_t>& layer_index_list, bool top_layer_only);
                 void do_render_options(const std::vector<uint32_t>& layer_index_list, bool top_layer_only);
@@ -130,6 +138,9 @@ namespace Slic3r {
                 bool m_b_tool_colors_dirty{ true };
 
                 bool m_b_loading{false};
+
+                struct LayerBuilder;
+                mutable std::shared_ptr<LayerBuilder> m_p_layer_builder{ nullptr };
             };
 
             struct SegmentVertex
@@ -158,6 +169,10 @@ namespace Slic3r {
             public:
                 explicit Layer();
                 ~Layer();
+                Layer(const Layer&) = default;
+                Layer(Layer&&) = default;
+                Layer& operator=(const Layer&) = default;
+                Layer& operator=(Layer&&) = default;
 
                 Layer& set_start(uint32_t sid);
                 uint32_t get_start() const;
@@ -192,9 +207,10 @@ namespace Slic3r {
                 void update_per_move_data_texture();
                 void bind_per_move_data_texture(uint8_t stage) const;
 
-                void update_other_segment_texture();
-                uint32_t get_other_segment_count() const;
-                void bind_other_segment_texture(uint8_t stage) const;
+                // lod_level selects a coarser level of detail of the segments, see ToolpathLOD
+                void update_other_segment_texture(size_t lod_level = 0);
+                uint32_t get_other_segment_count(size_t lod_level = 0) const;
+                void bind_other_segment_texture(uint8_t stage, size_t lod_level = 0) const;
 
                 void update_options_segment_texture();
                 uint32_t get_options_segment_count() const;
@@ -206,6 +222,18 @@ namespace Slic3r {
 
             private:
                 uint32_t add_segment_vertex(uint32_t move_id, const GCodeProcessorResult::MoveVertex& t_move);
+                void build_other_segment_lods(const std::vector<uint64_t>& vertex_keys);
+                size_t resolve_lod_level(size_t lod_level) const;
+
+                struct SegmentLOD
+                {
+                    // a level simplifying the segments only a little is not stored, the finer one is rendered instead
+                    bool m_b_same_as_finer{ false };
+                    mutable std::vector<float> m_segment_list;
+                    mutable bool m_b_dirty{ false };
+                    mutable std::shared_ptr<GLTexture> m_p_texture{ nullptr };
+                    mutable uint32_t m_count{ 0 };
+                };
 
             private:
                 bool m_b_valid{ true };
@@ -228,11 +256,15 @@ namespace Slic3r {
 
                 mutable bool m_b_per_move_data_dirty{ true };
                 mutable std::vector<float> m_per_move_data_list;
+                // per segment vertex, the value colored by the view as keyed by the levels of detail
+                std::vector<uint32_t> m_view_keys;
                 mutable std::shared_ptr<GLTexture> m_p_per_move_data_texture{ nullptr };
 
                 mutable bool m_b_other_segment_dirty{ false };
                 mutable std::shared_ptr<GLTexture> m_p_other_segment_texture{ nullptr };
                 mutable uint32_t m_other_segment_count{ 0 };
+                // levels of detail 1 and coarser of the other segments, the level 0 being the segments above
+                std::array<SegmentLOD, ToolpathLOD::LevelsCount - 1> m_other_segment_lods;
 
                 mutable bool m_b_options_segment_dirty{ false };
                 mutable std::shared_ptr<GLTexture> m_p_options_segment_texture{ nullptr };
@@ -247,6 +279,8 @@ namespace Slic3r {
 
                 void add_layer(const Layer& t_layer);
                 void add_layer(Layer&& t_layer);
+                // replaces a layer built in the background and prepares it for rendering
+                void replace_layer(size_t index, Layer&& t_layer, const std::vector<bool>& filament_visible_flags, const GCodeProcessorResult& t_gcode_result);
 
                 void clear();
 
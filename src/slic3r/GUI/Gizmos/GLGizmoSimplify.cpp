@@ -522,9 +522,9 @@ void GLGizmoSimplify::process()
             m_state.status = State::Status::running;
         }
 
-        // Start the actual calculation.
+        // Start the actual calculation, a large mesh is collapsed by parts in parallel.
         try {
-            its_quadric_edge_collapse(*its, triangle_count, &max_error, throw_on_cancel, statusfn);
+            its_quadric_edge_collapse_partitioned(*its, triangle_count, &max_error, throw_on_cancel, statusfn);
         } catch (SimplifyCanceledException &) {
             std::lock_guard lk(m_state_mutex);
             m_state.status = State::idle;
@@ -4255,6 +4255,23 @@ void PartPlateList::clear(bool delete_plates, bool release_print_list, bool exce
 	unprintable_plate.clear();
 }
 
+//exchange the print and gcode result of each plate with the ones in prints, for keeping the slicing results between CLI jobs
+void PartPlateList::swap_prints(std::vector<std::pair<PrintBase*, GCodeResult*>>& prints)
+{
+	for (unsigned int i = 0; i < (unsigned int)m_plate_list.size() && i < prints.size(); ++i)
+	{
+		PartPlate* plate = m_plate_list[i];
+		std::map<int, PrintBase*>::iterator it = m_print_list.find(plate->m_print_index);
+		std::map<int, GCodeResult*>::iterator it2 = m_gcode_result_list.find(plate->m_print_index);
+		if ((it == m_print_list.end()) || (it2 == m_gcode_result_list.end()))
+			continue;
+		assert(prints[i].first != NULL && prints[i].second != NULL);
+		std::swap(it->second, prints[i].first);
+		std::swap(it2->second, prints[i].second);
+		plate->set_print(it->second, it2->second, plate->m_print_index);
+	}
+}
+
 //clear all the instances in the plate, and delete the plates, only keep the first default plate
 void PartPlateList::reset(bool do_init)
 {
@@ -749,6 +749,8 @@ public:
     void clear(bool delete_plates = false, bool release_print_list = false, bool except_locked = false, int plate_index = -1);
     //clear all the instances in the plate, and delete the plates, only keep the first default plate
     void reset(bool do_init);
+    //exchange the print and gcode result of each plate with the ones in prints, for keeping the slicing results between CLI jobs
+    void swap_prints(std::vector<std::pair<PrintBase*, GCodeResult*>>& prints);
     //compute the origin for printable plate with index i using new width
     Vec3d compute_origin_using_new_size(int i, int new_width, int new_depth);
 
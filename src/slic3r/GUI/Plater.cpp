@@ -13816,7 +13816,11 @@ void Plater::load_gcode(const wxString& filename)
         show_error(this, ex.what());
         return;
     }
-    *current_result = std::move(processor.extract_result());
+    {
+        // The G-code preview may be building the toolpaths of the previous result in the background.
+        std::lock_guard<std::mutex> lock(current_result->result_mutex);
+        *current_result = std::move(processor.extract_result());
+    }
     //current_result->filename = filename;
 
     BedType bed_type = current_result->bed_type;
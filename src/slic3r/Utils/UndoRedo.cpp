@@ -1,12 +1,15 @@
 #include "UndoRedo.hpp"
+#include "UndoRedoStorage.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <memory>
 #include <typeinfo>
 #include <cassert>
 #include <cstddef>
+#include <unordered_map>
 
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/map.hpp>
@@ -95,6 +98,8 @@ public:
 	virtual bool is_optional() const { return false; }
 	// If it is an immutable object, return its pointer. There is a map assigning a temporary ObjectID to the immutable object pointer.
 	virtual const void* immutable_object_ptr() const { return nullptr; }
+	// Hash of the content of an immutable object, zero if the object is not to be deduplicated by content.
+	virtual uint64_t    content_hash() const { return 0; }
 
 	// If the history is empty, the ObjectHistory object could be released.
 	virtual bool empty() = 0;
@@ -231,7 +236,8 @@ template<typename T>
 class ImmutableObjectHistory : public ObjectHistory<Interval>
 {
 public:
-	ImmutableObjectHistory(std::shared_ptr<const T>	shared_object, bool optional) : m_shared_object(shared_object), m_optional(optional) {}
+	ImmutableObjectHistory(std::shared_ptr<const T>	shared_object, bool optional, uint64_t content_hash) :
+		m_shared_object(shared_object), m_optional(optional), m_content_hash(content_hash) {}
 	~ImmutableObjectHistory() override {}
 
 	bool is_mutable() const override { return false; }
@@ -239,6 +245,7 @@ public:
 	bool is_optional() const override { return m_optional; }
 	// If it is an immutable object, return its pointer. There is a map assigning a temporary ObjectID to the immutable object pointer.
     const void* immutable_object_ptr() const override { return (const void*)m_shared_object.get(); }
+	uint64_t    content_hash() const override { return m_content_hash; }
 
 	// Estimated size in memory, to be used to drop least recently used snapshots.
 	size_t memsize() const override {
@@ -262,6 +269,12 @@ public:
 			m_history.back().extend_end(current_time + 1);
 	}
 
+	// Object referenced by the Undo / Redo stack only, thus it is not part of the scene anymore.
+	const T* 					orphaned_object() const { return m_shared_object.use_count() == 1 ? m_shared_object.get() : nullptr; }
+	// Replace an orphaned object with an equal object, so that the history continues with the new object
+	// and the memory of the orphaned object is released.
+	void 						replace_orphaned_object(std::shared_ptr<const T> &object) { assert(this->orphaned_object() != nullptr); m_shared_object = object; }
+
 	bool has_snapshot(size_t timestamp) {
 		if (m_history.empty())
 			return false;
@@ -332,50 +345,39 @@ private:
 	// If this object is optional, then it may be deleted from the Undo / Redo stack and recalculated from other data (for example mesh convex hull).
 	bool 						m_optional;
 	std::string 				m_serialized;
+	uint64_t 					m_content_hash;
 };
 
 struct MutableHistoryInterval
 {
 private:
-	struct Data
-	{
-		// Reference counter of this data chunk. We may have used shared_ptr, but the shared_ptr is thread safe
-		// with the associated cost of CPU cache invalidation on refcount change.
-		size_t		refcnt;
-		size_t		size;
-		char 		data[1];
-
-		// The serialized data matches the data stored here.
-		bool 		matches(const std::string& rhs) { return this->size == rhs.size() && memcmp(this->data, rhs.data(), this->size) == 0; }
-
-		// The timestamp matches the timestamp serialized in the data stored here.
-		bool 		matches_timestamp(uint64_t timestamp) { assert(timestamp > 0);  assert(this->size > 8); return memcmp(this->data, &timestamp, 8) == 0; }
-	};
-
-	Interval    m_interval;
-	Data	   *m_data;
+	Interval    				 m_interval;
+	// Serialized data, reference counted and possibly shared with other intervals of this or other objects.
+	SnapshotStorage::Blob		*m_data;
+	SnapshotStorage 			*m_storage;
 
 public:
-	MutableHistoryInterval(const Interval &interval, const std::string &input_data) : m_interval(interval), m_data(nullptr) {
-		m_data = (Data*)new char[offsetof(Data, data) + input_data.size()];
-		m_data->refcnt = 1;
-		m_data->size = input_data.size();
-		memcpy(m_data->data, input_data.data(), input_data.size());
-	}
+	// Takes over the reference to data.
+	MutableHistoryInterval(const Interval &interval, SnapshotStorage &storage, SnapshotStorage::Blob *data) : m_interval(interval), m_data(data), m_storage(&storage) {}
 
-	MutableHistoryInterval(const Interval &interval, MutableHistoryInterval &other) : m_interval(interval), m_data(other.m_data) {
-		++ m_data->refcnt;
+	MutableHistoryInterval(const Interval &interval, MutableHistoryInterval &other) : m_interval(interval), m_data(other.m_data), m_storage(other.m_storage) {
+		m_storage->add_ref(m_data);
 	}
 
 	// as a key for std::lower_bound
-	MutableHistoryInterval(const size_t begin, const size_t end) : m_interval(begin, end), m_data(nullptr) {}
-
-	MutableHistoryInterval(MutableHistoryInterval&& rhs) : m_interval(rhs.m_interval), m_data(rhs.m_data) { rhs.m_data = nullptr; }
-	MutableHistoryInterval& operator=(MutableHistoryInterval&& rhs) { m_interval = rhs.m_interval; m_data = rhs.m_data; rhs.m_data = nullptr; return *this; }
+	MutableHistoryInterval(const size_t begin, const size_t end) : m_interval(begin, end), m_data(nullptr), m_storage(nullptr) {}
+
+	MutableHistoryInterval(MutableHistoryInterval&& rhs) : m_interval(rhs.m_interval), m_data(rhs.m_data), m_storage(rhs.m_storage) { rhs.m_data = nullptr; }
+	MutableHistoryInterval& operator=(MutableHistoryInterval&& rhs) {
+		if (m_data != nullptr)
+			m_storage->release(m_data);
+		m_interval = rhs.m_interval; m_data = rhs.m_data; m_storage = rhs.m_storage; rhs.m_data = nullptr;
+		return *this;
+	}
 
 	~MutableHistoryInterval() {
-		if (m_data != nullptr && -- m_data->refcnt == 0)
-			delete[] (char*)m_data;
+		if (m_data != nullptr)
+			m_storage->release(m_data);
 	}
 
 	const Interval& interval() const { return m_interval; }
@@ -389,17 +391,17 @@ public:
 	bool		operator<(const MutableHistoryInterval& rhs) const { return m_interval < rhs.m_interval; }
 	bool 		operator==(const MutableHistoryInterval& rhs) const { return m_interval == rhs.m_interval; }
 
-	const char* data() const { return m_data->data; }
-	size_t  	size() const { return m_data->size; }
-	size_t		refcnt() const { return m_data->refcnt; }
-	bool		matches(const std::string& data) { return m_data->matches(data); }
+	const SnapshotStorage::Blob* data() const { return m_data; }
+	std::string load() const { return m_storage->load(m_data); }
+	size_t  	size() const { return m_data->size(); }
+	size_t		refcnt() const { return m_data->refcnt(); }
 	bool		matches_timestamp(uint64_t timestamp) { return m_data->matches_timestamp(timestamp); }
 	size_t 		memsize() const {
-		return m_data->refcnt == 1 ?
+		return m_data->refcnt() == 1 ?
 			// Count just the size of the snapshot data.
-			m_data->size :
+			m_data->memsize() :
 			// Count the size of the snapshot data divided by the number of references, rounded up.
-			(m_data->size + m_data->refcnt - 1) / m_data->refcnt;
+			(m_data->memsize() + m_data->refcnt() - 1) / m_data->refcnt();
 	}
 
 private:
@@ -411,7 +413,8 @@ private:
 // are mutable and there is not tracking of the changes, therefore a snapshot needs to be
 // taken every time and compared to the previous data at the Undo / Redo stack.
 // The serialized data is stored if it is different from the last value on the stack, otherwise
-// the serialized data is discarded.
+// the serialized data is discarded. The serialized data is stored into the SnapshotStorage, which shares
+// equal data of all objects and stores small changes as deltas.
 // The history of a single mutable object may not be continuous, as an mutable object may
 // be removed from the scene while being kept at the Copy / Paste stack, therefore an object snapshot
 // with the same serialized object data may be shared by multiple history intervals.
@@ -454,24 +457,23 @@ public:
 		return false;
 	}
 
-	void save(size_t active_snapshot_time, size_t current_time, const std::string &data) {
+	void save(SnapshotStorage &storage, size_t active_snapshot_time, size_t current_time, const std::string &data) {
 		assert(m_history.empty() || m_history.back().end() <= active_snapshot_time);
-		if (m_history.empty() || m_history.back().end() < active_snapshot_time) {
-			if (! m_history.empty() && m_history.back().matches(data))
-				// Share the previous data by reference counting.
-				m_history.emplace_back(Interval(current_time, current_time + 1), m_history.back());
-			else
-				// Allocate new data.
-				m_history.emplace_back(Interval(current_time, current_time + 1), data);
-		} else {
+		// Returns the previous data if it matches, or any other matching data stored, otherwise allocates new data,
+		// possibly as a delta against the previous data.
+		SnapshotStorage::Blob *blob = storage.insert(data, m_history.empty() ? nullptr : m_history.back().data());
+		if (m_history.empty() || m_history.back().end() < active_snapshot_time)
+			m_history.emplace_back(Interval(current_time, current_time + 1), storage, blob);
+		else {
 			assert(! m_history.empty());
 			assert(m_history.back().end() == active_snapshot_time);
-			if (m_history.back().matches(data))
+			if (m_history.back().data() == blob) {
 				// Just extend the last interval using the old data.
+				storage.release(blob);
 				m_history.back().extend_end(current_time + 1);
-			else
+			} else
 				// Allocate new data time continuous with the previous data.
-				m_history.emplace_back(Interval(active_snapshot_time, current_time + 1), data);
+				m_history.emplace_back(Interval(active_snapshot_time, current_time + 1), storage, blob);
 		}
 	}
 
@@ -484,7 +486,7 @@ public:
 				--it;
 		}
 		//assert(timestamp >= it->begin() && timestamp < it->end());
-		return std::string(it->data(), it->data() + it->size());
+		return it->load();
 	}
 
 	// Currently all mutable snapshots are mandatory.
@@ -496,7 +498,7 @@ public:
 	std::string format() override {
 		std::string out = typeid(T).name();
 		for (const MutableHistoryInterval &interval : m_history)
-			out += std::string(", ptr:") + ptr_to_string(interval.data()) + " len:" + std::to_string(interval.size()) + " <" + std::to_string(interval.begin()) + "," + std::to_string(interval.end()) + ")";
+			out += std::string(", ptr:") + ptr_to_string(interval.data()) + " len:" + std::to_string(interval.size()) + " mem:" + std::to_string(interval.data()->memsize()) + " <" + std::to_string(interval.begin()) + "," + std::to_string(interval.end()) + ")";
 		return out;
 	}
 #endif /* SLIC3R_UNDOREDO_DEBUG */
@@ -524,9 +526,9 @@ bool ImmutableObjectHistory<T>::valid()
 template<typename T>
 bool MutableObjectHistory<T>::valid()
 {
-	// Verify that the history intervals are sorted and do not overlap, and that the data reference counters are correct.
+	// Verify that the history intervals are sorted and do not overlap, and that the data reference counters are consistent.
 	if (! m_history.empty()) {
-		std::map<const char*, size_t> refcntrs;
+		std::map<const SnapshotStorage::Blob*, size_t> refcntrs;
 		assert(m_history.front().data() != nullptr);
 		++ refcntrs[m_history.front().data()];
 		for (size_t i = 1; i < m_history.size(); ++ i) {
@@ -535,7 +537,8 @@ bool MutableObjectHistory<T>::valid()
 		}
 		for (const auto &hi : m_history) {
 			assert(hi.data() != nullptr);
-			assert(refcntrs[hi.data()] == hi.refcnt());
+			// The data may be shared with other objects or referenced by deltas.
+			assert(refcntrs[hi.data()] <= hi.refcnt());
 		}
 	}
 	return true;
@@ -552,6 +555,7 @@ public:
 	void clear() {
 		m_objects.clear();
 		m_shared_ptr_to_object_id.clear();
+		m_immutable_objects_by_hash.clear();
 		m_snapshots.clear();
 		m_active_snapshot_time = 0;
 		m_current_time = 0;
@@ -670,6 +674,8 @@ private:
 		return it->second;
 	}
 	void 							collect_garbage();
+	// Release an immutable object from the ptr to ObjectID and content hash to ObjectID maps before its history is released.
+	void 							release_immutable_object(const ObjectID id, const void *ptr, uint64_t content_hash);
 
 	// Release snapshots between begin and end. Only erases data from m_snapshots, not from m_objects!
 	// Updates m_saved_snapshot_time.
@@ -678,11 +684,15 @@ private:
 	// Maximum memory allowed to be occupied by the Undo / Redo stack. If the limit is exceeded,
 	// least recently used snapshots will be released.
 	size_t 													m_memory_limit;
+	// Serialized data of the mutable objects. Declared before m_objects, as the object histories reference the storage.
+	SnapshotStorage 										m_storage;
 	// Each individual object (Model, ModelObject, ModelInstance, ModelVolume, Selection, TriangleMesh)
 	// is stored with its own history, referenced by the ObjectID. Immutable objects do not provide
 	// their own IDs, therefore there are temporary IDs generated for them and stored to m_shared_ptr_to_object_id.
 	std::map<ObjectID, std::unique_ptr<ObjectHistoryBase>> 	m_objects;
 	std::map<const void*, ObjectID>							m_shared_ptr_to_object_id;
+	// Immutable objects deduplicated by content (triangle meshes), indexed by their content hash.
+	std::unordered_multimap<uint64_t, ObjectID>				m_immutable_objects_by_hash;
 	// Snapshot history (names with timestamps).
 	std::vector<Snapshot>									m_snapshots;
 	// Timestamp of the active snapshot.
@@ -813,6 +823,25 @@ namespace cereal
 namespace Slic3r {
 namespace UndoRedo {
 
+// Immutable objects with a content hash are deduplicated by content. A mesh of an object deleted from the scene
+// is released from memory if an equal mesh is added to the scene later (for example by reloading it from disk or by cut / merge operations),
+// while the history of the deleted object still references it.
+template<typename T> static uint64_t immutable_content_hash(const T &) { return 0; }
+template<typename T> static bool     immutable_content_equal(const T &, const T &) { return false; }
+
+static uint64_t immutable_content_hash(const TriangleMesh &mesh)
+{
+	const indexed_triangle_set &its = mesh.its;
+	// Empty meshes are not worth deduplicating.
+	return its.indices.empty() ? 0 :
+		content_hash(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices),
+			content_hash(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex)));
+}
+static bool immutable_content_equal(const TriangleMesh &lhs, const TriangleMesh &rhs)
+{
+	return lhs.its.vertices == rhs.its.vertices && lhs.its.indices == rhs.its.indices;
+}
+
 template<typename T> std::shared_ptr<const T>& 	ImmutableObjectHistory<T>::shared_ptr(StackImpl &stack)
 {
 	if (m_shared_object.get() == nullptr && ! m_serialized.empty()) {
@@ -851,24 +880,45 @@ template<typename T> ObjectID StackImpl::save_mutable_object(const T &object)
 			Slic3r::UndoRedo::OutputArchive archive(*this, oss);
 			archive(object);
 		}
-		object_history->save(m_active_snapshot_time, m_current_time, oss.str());
+		object_history->save(m_storage, m_active_snapshot_time, m_current_time, oss.str());
 	}
 	return object.id();
 }
 
 template<typename T> ObjectID StackImpl::save_immutable_object(std::shared_ptr<const T> &object, bool optional)
 {
-	// First allocate a temporary ObjectID for this pointer.
-	ObjectID object_id = this->immutable_object_id(object);
-	// and find or allocate a history stack for the ObjectID associated to this shared_ptr.
-	auto it_object_history = m_objects.find(object_id);
-	if (it_object_history == m_objects.end())
-		it_object_history = m_objects.emplace_hint(it_object_history, object_id, std::unique_ptr<ImmutableObjectHistory<T>>(new ImmutableObjectHistory<T>(object, optional)));
-	else
+	// First find the history stack for the ObjectID associated to this shared_ptr.
+	auto     it_object_history = m_objects.end();
+	uint64_t hash              = 0;
+	if (auto it_ptr = m_shared_ptr_to_object_id.find((const void*)object.get()); it_ptr != m_shared_ptr_to_object_id.end()) {
+		it_object_history = m_objects.find(it_ptr->second);
+		assert(it_object_history != m_objects.end());
 		assert(it_object_history->second.get()->is_optional() == optional);
+	} else if (hash = immutable_content_hash(*object); hash != 0) {
+		// Continue the history of an equal object, which is not referenced by the scene anymore.
+		for (auto [it, it_end] = m_immutable_objects_by_hash.equal_range(hash); it != it_end; ++ it)
+			if (auto it_history = m_objects.find(it->second); it_history != m_objects.end() && it_history->second->is_optional() == optional) {
+				auto *history = static_cast<ImmutableObjectHistory<T>*>(it_history->second.get());
+				if (const T *orphaned = history->orphaned_object(); orphaned != nullptr && immutable_content_equal(*orphaned, *object)) {
+					m_shared_ptr_to_object_id.erase((const void*)orphaned);
+					history->replace_orphaned_object(object);
+					m_shared_ptr_to_object_id.emplace((const void*)object.get(), it->second);
+					it_object_history = it_history;
+					break;
+				}
+			}
+	}
+	if (it_object_history == m_objects.end()) {
+		// Allocate a temporary ObjectID for this pointer and a new history stack.
+		ObjectID object_id = this->immutable_object_id(object);
+		it_object_history = m_objects.emplace_hint(m_objects.find(object_id), object_id,
+			std::unique_ptr<ImmutableObjectHistory<T>>(new ImmutableObjectHistory<T>(object, optional, hash)));
+		if (hash != 0)
+			m_immutable_objects_by_hash.emplace(hash, object_id);
+	}
 	// Then save the interval.
 	static_cast<ImmutableObjectHistory<T>*>(it_object_history->second.get())->save(m_active_snapshot_time, m_current_time);
-	return object_id;
+	return it_object_history->first;
 }
 
 template<typename T> T* StackImpl::load_mutable_object(const Slic3r::ObjectID id)
@@ -925,6 +975,10 @@ void StackImpl::take_snapshot(const std::string& snapshot_name, const Slic3r::Mo
 // Store the current application state onto the Undo / Redo stack, remove all snapshots after m_active_snapshot_time.
 void StackImpl::take_snapshot(const std::string& snapshot_name, const Slic3r::Model& model, const Slic3r::GUI::Selection& selection, const Slic3r::GUI::GLGizmosManager& gizmos, const Slic3r::GUI::PartPlateList& plate_list, const SnapshotData& snapshot_data)
 {
+	auto time_start = std::chrono::steady_clock::now();
+	// Publish the results of the background compression of the previous snapshot.
+	m_storage.sync();
+	SnapshotStorage::Statistics stats_start = m_storage.statistics();
 	// Release old snapshot data.
 	assert(m_active_snapshot_time <= m_current_time);
 	for (auto &kvp : m_objects)
@@ -961,11 +1015,17 @@ void StackImpl::take_snapshot(const std::string& snapshot_name, const Slic3r::Mo
 	// Release empty objects from the history.
 	this->collect_garbage();
 	assert(this->valid());
+	// Compress the newly serialized data while the UI continues.
+	m_storage.compress_async();
 #ifdef SLIC3R_UNDOREDO_DEBUG
 	std::cout << "After snapshot" << std::endl;
 	this->print();
 #endif /* SLIC3R_UNDOREDO_DEBUG */
-	BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format("snapshot name %1%") % snapshot_name;
+	SnapshotStorage::Statistics stats = m_storage.statistics();
+	BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format("snapshot name %1%, %2% ms, serialized %3% bytes, %4% of %5% objects deduplicated, %6% stored as delta, %7% bytes stored in total")
+		% snapshot_name % std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count()
+		% (stats.inserted_bytes - stats_start.inserted_bytes) % (stats.num_deduplicated - stats_start.num_deduplicated) % (stats.num_inserted - stats_start.num_inserted)
+		% (stats.num_deltas - stats_start.num_deltas) % stats.stored_bytes;
 	plate_list.print();
 }
 
@@ -1171,18 +1231,31 @@ void StackImpl::collect_garbage()
 	// Purge objects with empty histories.
 	for (auto it = m_objects.begin(); it != m_objects.end();) {
 		if (it->second->empty()) {
-			if (it->second->immutable_object_ptr() != nullptr)
-				// Release the immutable object from the ptr to ObjectID map.
-				m_shared_ptr_to_object_id.erase(it->second->immutable_object_ptr());
+			this->release_immutable_object(it->first, it->second->immutable_object_ptr(), it->second->content_hash());
 			it = m_objects.erase(it);
 		} else
 			++ it;
 	}
 }
 
+void StackImpl::release_immutable_object(const ObjectID id, const void *ptr, uint64_t content_hash)
+{
+	if (ptr != nullptr)
+		// Release the immutable object from the ptr to ObjectID map.
+		m_shared_ptr_to_object_id.erase(ptr);
+	if (content_hash != 0)
+		for (auto [it, it_end] = m_immutable_objects_by_hash.equal_range(content_hash); it != it_end; ++ it)
+			if (it->second == id) {
+				m_immutable_objects_by_hash.erase(it);
+				break;
+			}
+}
+
 void StackImpl::release_least_recently_used()
 {
 	assert(this->valid());
+	// Publish the results of the background compression, so that the memory estimate is up to date.
+	m_storage.sync();
 	size_t current_memsize = this->memsize();
 #ifdef SLIC3R_UNDOREDO_DEBUG
 	bool released = false;
@@ -1193,9 +1266,7 @@ void StackImpl::release_least_recently_used()
 		const void *ptr = it->second->immutable_object_ptr();
 		size_t mem_released = it->second->release_optional();
 		if (it->second->empty()) {
-			if (ptr != nullptr)
-				// Release the immutable object from the ptr to ObjectID map.
-				m_shared_ptr_to_object_id.erase(ptr);
+			this->release_immutable_object(it->first, ptr, it->second->content_hash());
 			mem_released += it->second->memsize();
 			it = m_objects.erase(it);
 		} else
@@ -1216,9 +1287,7 @@ void StackImpl::release_least_recently_used()
 			for (auto it = m_objects.begin(); it != m_objects.end();) {
 				mem_released += it->second->release_after_timestamp(m_snapshots.back().timestamp);
 				if (it->second->empty()) {
-					if (it->second->immutable_object_ptr() != nullptr)
-						// Release the immutable object from the ptr to ObjectID map.
-						m_shared_ptr_to_object_id.erase(it->second->immutable_object_ptr());
+					this->release_immutable_object(it->first, it->second->immutable_object_ptr(), it->second->content_hash());
 					mem_released += it->second->memsize();
 					it = m_objects.erase(it);
 				} else
@@ -1258,9 +1327,7 @@ void StackImpl::release_least_recently_used()
 			for (auto it = m_objects.begin(); it != m_objects.end();) {
 				mem_released += it->second->release_before_timestamp(m_snapshots[1].timestamp);
 				if (it->second->empty()) {
-					if (it->second->immutable_object_ptr() != nullptr)
-						// Release the immutable object from the ptr to ObjectID map.
-						m_shared_ptr_to_object_id.erase(it->second->immutable_object_ptr());
+					this->release_immutable_object(it->first, it->second->immutable_object_ptr(), it->second->content_hash());
 					mem_released += it->second->memsize();
 					it = m_objects.erase(it);
 				} else
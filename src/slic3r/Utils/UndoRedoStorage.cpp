@@ -0,0 +1,224 @@
+#include "UndoRedoStorage.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <libslic3r/Exception.hpp>
+
+#include "minilzo/minilzo.h"
+
+namespace Slic3r {
+namespace UndoRedo {
+
+uint64_t content_hash(const void *data, size_t size, uint64_t seed)
+{
+	// Word wise variant of the MurmurHash64A mixing, fast enough to hash meshes and serialized objects
+	// with a low collision probability. Collisions are resolved by comparing the data.
+	static constexpr const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	static constexpr const int      r = 47;
+	uint64_t h = seed ^ (size * m);
+	const unsigned char *p   = static_cast<const unsigned char*>(data);
+	const unsigned char *end = p + (size & ~size_t(7));
+	for (; p != end; p += 8) {
+		uint64_t k;
+		memcpy(&k, p, 8);
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+	if (size_t rest = size & 7; rest > 0) {
+		uint64_t k = 0;
+		memcpy(&k, p, rest);
+		h ^= k;
+		h *= m;
+	}
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+	return h;
+}
+
+SnapshotStorage::Blob::Blob(const std::string &data, uint64_t hash) : m_size(data.size()), m_hash(hash)
+{
+	if (m_size >= 8)
+		memcpy(&m_header, data.data(), 8);
+}
+
+SnapshotStorage::~SnapshotStorage()
+{
+	m_compression_task.wait();
+	for (auto &kvp : m_blobs)
+		delete kvp.second;
+}
+
+SnapshotStorage::Blob* SnapshotStorage::insert(const std::string &data, const Blob *previous)
+{
+	uint64_t hash = content_hash(data.data(), data.size());
+	++ m_statistics.num_inserted;
+	m_statistics.inserted_bytes += data.size();
+
+	// Share equal data.
+	std::string tmp;
+	for (auto [it, it_end] = m_blobs.equal_range(hash); it != it_end; ++ it)
+		if (Blob *blob = it->second; blob->m_size == data.size() && this->raw_data(blob, tmp) == data) {
+			++ m_statistics.num_deduplicated;
+			this->add_ref(blob);
+			return blob;
+		}
+
+	Blob *blob = new Blob(data, hash);
+	if (previous != nullptr && data.size() >= MinDeltaSize && previous->m_size >= MinDeltaSize && previous->m_delta_depth < MaxDeltaDepth) {
+		// Store the span differing from the previous state of the object, if it is short enough.
+		const std::string &base    = this->raw_data(previous, tmp);
+		size_t             max_len = std::min(base.size(), data.size());
+		size_t             prefix  = std::mismatch(data.begin(), data.begin() + max_len, base.begin()).first - data.begin();
+		size_t             suffix  = std::mismatch(data.rbegin(), data.rbegin() + (max_len - prefix), base.rbegin()).first - data.rbegin();
+		if (size_t span = data.size() - prefix - suffix; 4 * span <= data.size()) {
+			blob->m_encoding    = Blob::Encoding::Delta;
+			blob->m_data        = data.substr(prefix, span);
+			blob->m_base        = const_cast<Blob*>(previous);
+			blob->m_prefix      = prefix;
+			blob->m_suffix      = suffix;
+			blob->m_delta_depth = previous->m_delta_depth + 1;
+			this->add_ref(blob->m_base);
+			++ m_statistics.num_deltas;
+		}
+	}
+	if (blob->m_encoding == Blob::Encoding::Raw) {
+		blob->m_data = data;
+		if (data.size() >= MinCompressSize)
+			m_to_compress.emplace_back(blob);
+	}
+	m_blobs.emplace(hash, blob);
+	++ m_statistics.num_blobs;
+	m_statistics.stored_bytes += blob->own_memsize();
+	this->add_ref(blob);
+	return blob;
+}
+
+void SnapshotStorage::release(Blob *blob)
+{
+	assert(blob->m_refcnt > 0);
+	if (-- blob->m_refcnt > 0)
+		return;
+	if (blob->m_compressing)
+		// The background task is reading the blob.
+		this->sync();
+	if (! m_to_compress.empty())
+		if (auto it = std::find(m_to_compress.begin(), m_to_compress.end(), blob); it != m_to_compress.end())
+			m_to_compress.erase(it);
+	for (auto [it, it_end] = m_blobs.equal_range(blob->m_hash); it != it_end; ++ it)
+		if (it->second == blob) {
+			m_blobs.erase(it);
+			break;
+		}
+	-- m_statistics.num_blobs;
+	m_statistics.stored_bytes -= blob->own_memsize();
+	Blob *base = blob->m_base;
+	delete blob;
+	if (base != nullptr)
+		this->release(base);
+}
+
+std::string SnapshotStorage::load(const Blob *blob) const
+{
+	std::string out;
+	this->decode(blob, out);
+	return out;
+}
+
+const std::string& SnapshotStorage::raw_data(const Blob *blob, std::string &tmp) const
+{
+	if (blob->m_encoding == Blob::Encoding::Raw)
+		return blob->m_data;
+	this->decode(blob, tmp);
+	return tmp;
+}
+
+void SnapshotStorage::decode(const Blob *blob, std::string &out) const
+{
+	switch (blob->m_encoding) {
+	case Blob::Encoding::Raw:
+		out = blob->m_data;
+		break;
+	case Blob::Encoding::LZO:
+	{
+		out.resize(blob->m_size);
+		lzo_uint out_len = blob->m_size;
+		if (lzo1x_decompress_safe((const unsigned char*)blob->m_data.data(), blob->m_data.size(), (unsigned char*)out.data(), &out_len, nullptr) != LZO_E_OK ||
+			out_len != blob->m_size)
+			throw Slic3r::RuntimeError("Undo / Redo stack: Failed to decompress a snapshot");
+		break;
+	}
+	case Blob::Encoding::Delta:
+	{
+		std::string tmp;
+		const std::string &base = this->raw_data(blob->m_base, tmp);
+		out.clear();
+		out.reserve(blob->m_size);
+		out.append(base, 0, blob->m_prefix);
+		out.append(blob->m_data);
+		out.append(base, base.size() - blob->m_suffix, blob->m_suffix);
+		assert(out.size() == blob->m_size);
+		break;
+	}
+	}
+}
+
+void SnapshotStorage::compress_async()
+{
+	if (m_to_compress.empty())
+		return;
+	this->sync();
+	m_compressing = std::move(m_to_compress);
+	m_to_compress.clear();
+	for (Blob *blob : m_compressing)
+		blob->m_compressing = true;
+	m_compression_task.run([this]() {
+		static std::once_flag lzo_initialized;
+		std::call_once(lzo_initialized, []() { lzo_init(); });
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, m_compressing.size(), 1), [this](const tbb::blocked_range<size_t> &range) {
+			std::vector<unsigned char> wrkmem(LZO1X_1_MEM_COMPRESS);
+			for (size_t i = range.begin(); i < range.end(); ++ i) {
+				Blob *blob = m_compressing[i];
+				// Worst case LZO expansion.
+				std::string compressed(blob->m_data.size() + blob->m_data.size() / 16 + 64 + 3, 0);
+				lzo_uint    compressed_len = 0;
+				if (lzo1x_1_compress((const unsigned char*)blob->m_data.data(), blob->m_data.size(), (unsigned char*)compressed.data(), &compressed_len, wrkmem.data()) == LZO_E_OK &&
+					// Only keep the compressed data if it saves at least 1/8 of the memory.
+					8 * compressed_len < 7 * blob->m_data.size()) {
+					compressed.resize(compressed_len);
+					compressed.shrink_to_fit();
+					blob->m_compressed = std::move(compressed);
+				}
+			}
+		});
+	});
+}
+
+void SnapshotStorage::sync()
+{
+	if (m_compressing.empty())
+		return;
+	m_compression_task.wait();
+	for (Blob *blob : m_compressing) {
+		blob->m_compressing = false;
+		if (! blob->m_compressed.empty()) {
+			m_statistics.stored_bytes -= blob->own_memsize();
+			blob->m_data     = std::move(blob->m_compressed);
+			blob->m_encoding = Blob::Encoding::LZO;
+			blob->m_compressed.clear();
+			m_statistics.stored_bytes += blob->own_memsize();
+			++ m_statistics.num_compressed;
+		}
+	}
+	m_compressing.clear();
+}
+
+} // namespace UndoRedo
+} // namespace Slic3r
@@ -0,0 +1,140 @@
+#ifndef slic3r_Utils_UndoRedoStorage_hpp_
+#define slic3r_Utils_UndoRedoStorage_hpp_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tbb/task_group.h>
+
+namespace Slic3r {
+namespace UndoRedo {
+
+// 64bit hash of a memory block, used to address the Undo / Redo snapshot data by content.
+uint64_t content_hash(const void *data, size_t size, uint64_t seed = 0);
+
+// Content addressed storage of the serialized objects captured by the Undo / Redo stack.
+// 1) Equal data is stored just once, even if it is serialized from different objects
+//    (for example the paint-on supports or color painting of copies of a volume, or equal configs).
+// 2) Data differing from the previous state of the same object in a short span only (typically a config
+//    with a single value changed) is stored as a delta against the previous state.
+// 3) Large data is compressed with LZO by a background task, so that taking a snapshot does not stall
+//    the UI thread by the compression.
+// The storage is not thread safe, it is only to be accessed from a single thread. The background
+// compression only reads the stored blobs, its results are published by sync().
+class SnapshotStorage
+{
+public:
+	class Blob
+	{
+	public:
+		// Size of the uncompressed data.
+		size_t 		size() const { return m_size; }
+		size_t 		refcnt() const { return m_refcnt; }
+		// Memory occupied by this blob. A delta is accounted with its share of its base.
+		size_t 		memsize() const {
+			size_t memsize = this->own_memsize();
+			if (m_base != nullptr)
+				memsize += (m_base->memsize() + m_base->m_refcnt - 1) / m_base->m_refcnt;
+			return memsize;
+		}
+		// The timestamp matches the timestamp serialized at the start of the data.
+		bool 		matches_timestamp(uint64_t timestamp) const { assert(timestamp > 0); assert(m_size > 8); return m_header == timestamp; }
+
+	private:
+		friend class SnapshotStorage;
+
+		enum class Encoding : unsigned char {
+			Raw,
+			LZO,
+			// m_data is the span of the data differing from m_base, m_prefix and m_suffix bytes are shared with m_base.
+			Delta,
+		};
+
+		Blob(const std::string &data, uint64_t hash);
+		size_t 		own_memsize() const { return sizeof(Blob) + m_data.size(); }
+
+		size_t 			m_refcnt { 0 };
+		size_t 			m_size;
+		uint64_t 		m_hash;
+		// First 8 bytes of the data for matches_timestamp().
+		uint64_t 		m_header { 0 };
+		Encoding 		m_encoding { Encoding::Raw };
+		// Length of the chain of deltas to reach a blob with the complete data.
+		unsigned char 	m_delta_depth { 0 };
+		// Queued for the background compression, thus it must not be released before sync().
+		bool 			m_compressing { false };
+		std::string 	m_data;
+		// Output of the background compression, to be published by sync().
+		std::string 	m_compressed;
+		Blob 		   *m_base { nullptr };
+		size_t 			m_prefix { 0 };
+		size_t 			m_suffix { 0 };
+	};
+
+	struct Statistics
+	{
+		// Number of blobs and the memory occupied by them.
+		size_t 		num_blobs { 0 };
+		size_t 		stored_bytes { 0 };
+		// Size of the data passed to insert() and how it was stored.
+		size_t 		inserted_bytes { 0 };
+		size_t 		num_inserted { 0 };
+		size_t 		num_deduplicated { 0 };
+		size_t 		num_deltas { 0 };
+		size_t 		num_compressed { 0 };
+	};
+
+	SnapshotStorage() = default;
+	SnapshotStorage(const SnapshotStorage &) = delete;
+	SnapshotStorage& operator=(const SnapshotStorage &) = delete;
+	~SnapshotStorage();
+
+	// Store the data, return a blob referencing the data with its reference counter incremented.
+	// If an equal data is stored already, its blob is returned. Otherwise if previous is provided
+	// (the last state of the same object), the data may be stored as a delta against previous.
+	Blob* 		insert(const std::string &data, const Blob *previous = nullptr);
+	void 		add_ref(Blob *blob) { ++ blob->m_refcnt; }
+	// Decrement the reference counter, release the blob if no more referenced.
+	void 		release(Blob *blob);
+	// Decode the data of a blob.
+	std::string load(const Blob *blob) const;
+
+	// Compress the blobs inserted since the last call in a background task.
+	void 		compress_async();
+	// Wait for the background compression to finish and publish its results.
+	void 		sync();
+
+	bool 		empty() const { return m_blobs.empty(); }
+	// The counters are updated by insert(), release() and sync(), thus they are cheap to query with every snapshot.
+	const Statistics& statistics() const { return m_statistics; }
+
+	// Data shorter than this is stored raw.
+	static constexpr const size_t MinCompressSize = 4096;
+	// Data shorter than this is not stored as a delta.
+	static constexpr const size_t MinDeltaSize    = 512;
+	// Maximum length of a chain of deltas, limiting the time to load a state.
+	static constexpr const size_t MaxDeltaDepth   = 8;
+
+private:
+	// Returns reference either to the raw data of the blob or to the data decoded into tmp.
+	const std::string& raw_data(const Blob *blob, std::string &tmp) const;
+	void 			   decode(const Blob *blob, std::string &out) const;
+
+	std::unordered_multimap<uint64_t, Blob*> m_blobs;
+	// Blobs inserted since the last compress_async() to be compressed.
+	std::vector<Blob*> 						 m_to_compress;
+	// Blobs being compressed by the background task.
+	std::vector<Blob*> 						 m_compressing;
+	tbb::task_group 						 m_compression_task;
+	Statistics 								 m_statistics;
+};
+
+} // namespace UndoRedo
+} // namespace Slic3r
+
+#endif /* slic3r_Utils_UndoRedoStorage_hpp_ */
@@ -0,0 +1,338 @@
+// End-to-end slicing benchmark of libslic3r.
+//
+// Slices a set of synthetic workloads and the models of tests/data, timing every PrintObjectStep, PrintStep,
+// the G-code export and the GCodeProcessor separately, together with the infill generation time per layer.
+// The timings are written as JSON, which may be stored and passed back as a baseline: the run fails if any timing
+// regresses over the configured threshold.
+//
+// Usage: slic3r_bench [--output <results.json>] [--baseline <baseline.json>] [--threshold <percent>]
+//                     [--min-delta <seconds>] [--repeat <n>] [--filter <substring>] [--data-dir <dir>] [--list]
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/ModelArrange.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/PrintConfig.hpp"
+#include "libslic3r/Trace.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/Utils.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <nlohmann/json.hpp>
+
+using namespace Slic3r;
+
+namespace {
+
+struct Workload
+{
+    std::string name;
+    // Fills in the model and adjusts the config of the workload.
+    std::function<void(Model &model, DynamicPrintConfig &config)> setup;
+};
+
+// Timings of a single workload in seconds, keyed by the name of the step.
+using Timings = std::map<std::string, double>;
+
+ModelObject* add_object(Model &model, const std::string &name, TriangleMesh &&mesh)
+{
+    ModelObject *object = model.add_object();
+    object->name = name;
+    object->add_volume(std::move(mesh));
+    object->add_instance();
+    return object;
+}
+
+std::vector<Workload> synthetic_workloads()
+{
+    std::vector<Workload> out;
+    // Finely tessellated curved surface, about 1M triangles.
+    out.push_back({ "dense_sphere", [](Model &model, DynamicPrintConfig &) {
+        add_object(model, "dense_sphere", make_sphere(40., PI / 720.));
+    }});
+    // Full plate of small parts.
+    out.push_back({ "many_objects", [](Model &model, DynamicPrintConfig &) {
+        for (int i = 0; i < 64; ++ i)
+            add_object(model, "part_" + std::to_string(i),
+                i % 3 == 0 ? make_cube(10., 10., 10.) : i % 3 == 1 ? make_cylinder(5., 12.) : make_sphere(6., PI / 60.));
+    }});
+    // A part per filament, with a prime tower.
+    out.push_back({ "filaments_16", [](Model &model, DynamicPrintConfig &config) {
+        config.set_num_filaments(16);
+        config.set_key_value("enable_prime_tower", new ConfigOptionBool(true));
+        for (int i = 0; i < 16; ++ i)
+            add_object(model, "filament_" + std::to_string(i + 1), make_cylinder(6., 20.))->config.set("extruder", i + 1);
+    }});
+    // Table top overhanging all around a thin leg, supported by tree supports.
+    out.push_back({ "tree_supports", [](Model &model, DynamicPrintConfig &config) {
+        config.set_key_value("enable_support", new ConfigOptionBool(true));
+        config.set_key_value("support_type", new ConfigOptionEnum<SupportType>(stTreeAuto));
+        TriangleMesh table = make_cylinder(4., 30.);
+        TriangleMesh top   = make_cube(60., 60., 5.);
+        top.translate(-30.f, -30.f, 30.f);
+        table.merge(top);
+        add_object(model, "tree_supports", std::move(table));
+    }});
+    // Tall prismatic parts with many layers of the same shape.
+    out.push_back({ "tall_prisms", [](Model &model, DynamicPrintConfig &) {
+        add_object(model, "tall_box", make_cube(20., 20., 200.));
+        add_object(model, "tall_hexagon", make_cylinder(12., 200., 2. * PI / 6.));
+    }});
+    // Tall part with Lightning infill supporting a dome and a ceiling of steps.
+    out.push_back({ "lightning_infill", [](Model &model, DynamicPrintConfig &config) {
+        config.set_key_value("sparse_infill_pattern", new ConfigOptionEnum<InfillPattern>(ipLightning));
+        config.set_key_value("sparse_infill_density", new ConfigOptionPercent(15));
+        TriangleMesh part = make_cylinder(25., 150.);
+        TriangleMesh dome = make_sphere(25., PI / 90.);
+        dome.translate(0.f, 0.f, 150.f);
+        part.merge(dome);
+        for (int i = 0; i < 4; ++ i) {
+            TriangleMesh step = make_cube(60. - 10. * i, 60. - 10. * i, 30.);
+            step.translate(-30.f + 5.f * i, -30.f + 5.f * i, 30.f * i);
+            part.merge(step);
+        }
+        add_object(model, "lightning_infill", std::move(part));
+    }});
+    // Sparse infill of the triply periodic minimal surfaces, the time per layer is reported as posInfill_per_layer.
+    for (const auto &[name, pattern] : std::initializer_list<std::pair<const char*, InfillPattern>> {
+            { "infill_gyroid", ipGyroid }, { "infill_schwarzp", ipSchwarzP }, { "infill_schwarzd", ipSchwarzD }, { "infill_neovius", ipNeovius } })
+        out.push_back({ name, [name = std::string(name), pattern = pattern](Model &model, DynamicPrintConfig &config) {
+            config.set_key_value("sparse_infill_pattern", new ConfigOptionEnum<InfillPattern>(pattern));
+            config.set_key_value("sparse_infill_density", new ConfigOptionPercent(15));
+            add_object(model, name, make_cylinder(60., 80.));
+        }});
+    return out;
+}
+
+// The models of tests/data, each sliced on its own.
+std::vector<Workload> data_workloads(const std::string &data_dir)
+{
+    std::vector<Workload> out;
+    boost::system::error_code ec;
+    if (data_dir.empty() || ! boost::filesystem::is_directory(data_dir, ec))
+        return out;
+    std::vector<boost::filesystem::path> paths;
+    for (const boost::filesystem::directory_entry &entry : boost::filesystem::directory_iterator(data_dir))
+        if (boost::filesystem::is_regular_file(entry.status()) && (entry.path().extension() == ".obj" || entry.path().extension() == ".stl"))
+            paths.emplace_back(entry.path());
+    std::sort(paths.begin(), paths.end());
+    for (const boost::filesystem::path &path : paths)
+        out.push_back({ "data/" + path.stem().string(), [path](Model &model, DynamicPrintConfig &) {
+            model = Model::read_from_file(path.string());
+        }});
+    return out;
+}
+
+Timings run_workload(const Workload &workload, const std::string &gcode_path)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    Model              model;
+    workload.setup(model, config);
+    arrange_objects(model, InfiniteBed{}, ArrangeParams{ scaled(min_object_distance(config)) });
+    for (ModelObject *object : model.objects)
+        object->ensure_on_bed();
+
+    Print print;
+    print.apply(model, config);
+    print.validate();
+    print.set_status_silent();
+
+    Timings timings;
+    auto    seconds_since = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    Trace::start();
+    auto start = std::chrono::steady_clock::now();
+    print.process();
+    timings["process"] = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    print.export_gcode(gcode_path, nullptr);
+    timings["export_gcode"] = seconds_since(start);
+    Trace::stop();
+    // Steps of all objects are summed up.
+    for (const Trace::Total &total : Trace::totals())
+        if (total.category == "PrintObjectStep" || total.category == "PrintStep")
+            timings[total.name] += double(total.duration_ns) * 1e-9;
+    size_t num_layers = 0;
+    for (const PrintObject *object : print.objects())
+        num_layers += object->layer_count();
+    if (num_layers > 0)
+        timings["posInfill_per_layer"] = timings["posInfill"] / double(num_layers);
+
+    // Processed again outside of the export to time the GCodeProcessor on its own.
+    start = std::chrono::steady_clock::now();
+    GCodeProcessor processor;
+    processor.process_file(gcode_path);
+    timings["gcode_processor"] = seconds_since(start);
+    timings["total"] = timings["process"] + timings["export_gcode"];
+    return timings;
+}
+
+nlohmann::json results_to_json(const std::map<std::string, Timings> &results)
+{
+    nlohmann::json workloads = nlohmann::json::object();
+    for (const auto &[name, timings] : results)
+        workloads[name] = timings;
+    return { { "version", 1 }, { "workloads", workloads } };
+}
+
+// Returns the number of the timings, which regressed over the baseline.
+size_t compare_with_baseline(const std::map<std::string, Timings> &results, const nlohmann::json &baseline, double threshold, double min_delta)
+{
+    size_t regressions = 0;
+    const nlohmann::json &workloads = baseline.at("workloads");
+    for (const auto &[name, timings] : results) {
+        auto it_workload = workloads.find(name);
+        if (it_workload == workloads.end()) {
+            std::cout << name << ": not in the baseline" << std::endl;
+            continue;
+        }
+        for (const auto &[step, time] : timings) {
+            auto it_step = it_workload->find(step);
+            if (it_step == it_workload->end())
+                continue;
+            double base  = it_step->get<double>();
+            double delta = time - base;
+            bool   regressed = delta > min_delta && delta > base * threshold;
+            if (regressed)
+                ++ regressions;
+            if (regressed || delta < - min_delta)
+                std::cout << (regressed ? "REGRESSION " : "improvement ") << name << " " << step << ": " << base << "s -> " << time << "s ("
+                          << std::showpos << std::fixed << std::setprecision(1) << (base > 0. ? 100. * delta / base : 0.) << "%)"
+                          << std::noshowpos << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+    }
+    return regressions;
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "Usage: " << argv0 << " [--output <results.json>] [--baseline <baseline.json>] [--threshold <percent>]" << std::endl
+              << "       [--min-delta <seconds>] [--repeat <n>] [--filter <substring>] [--data-dir <dir>] [--list]" << std::endl;
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string output_path;
+    std::string baseline_path;
+    std::string filter;
+#ifdef TEST_DATA_DIR
+    std::string data_dir = TEST_DATA_DIR;
+#else
+    std::string data_dir;
+#endif
+    // Relative regression allowed, and the regressions shorter than min_delta are ignored as noise.
+    double threshold = 0.1;
+    double min_delta = 0.05;
+    int    repeat    = 3;
+    bool   list      = false;
+    for (int i = 1; i < argc; ++ i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--list")
+            list = true;
+        else if (! has_value)
+            return usage(argv[0]);
+        else if (arg == "--output")
+            output_path = argv[++ i];
+        else if (arg == "--baseline")
+            baseline_path = argv[++ i];
+        else if (arg == "--threshold")
+            threshold = atof(argv[++ i]) * 0.01;
+        else if (arg == "--min-delta")
+            min_delta = atof(argv[++ i]);
+        else if (arg == "--repeat")
+            repeat = std::max(1, atoi(argv[++ i]));
+        else if (arg == "--filter")
+            filter = argv[++ i];
+        else if (arg == "--data-dir")
+            data_dir = argv[++ i];
+        else
+            return usage(argv[0]);
+    }
+
+    set_logging_level(1);
+
+    std::vector<Workload> workloads = synthetic_workloads();
+    for (Workload &workload : data_workloads(data_dir))
+        workloads.emplace_back(std::move(workload));
+    workloads.erase(std::remove_if(workloads.begin(), workloads.end(),
+        [&filter](const Workload &workload) { return workload.name.find(filter) == std::string::npos; }), workloads.end());
+    if (list) {
+        for (const Workload &workload : workloads)
+            std::cout << workload.name << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    std::map<std::string, Timings> results;
+    std::string gcode_path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slic3r_bench_%%%%-%%%%.gcode")).string();
+    for (const Workload &workload : workloads) {
+        Timings best;
+        try {
+            // The fastest of the repeated runs is kept for every step, it is the least disturbed by the other processes.
+            for (int i = 0; i < repeat; ++ i)
+                for (const auto &[step, time] : run_workload(workload, gcode_path)) {
+                    auto it = best.find(step);
+                    if (it == best.end())
+                        best.emplace(step, time);
+                    else
+                        it->second = std::min(it->second, time);
+                }
+        } catch (const std::exception &ex) {
+            std::cerr << workload.name << ": failed: " << ex.what() << std::endl;
+            boost::nowide::remove(gcode_path.c_str());
+            return EXIT_FAILURE;
+        }
+        std::cout << std::left << std::setw(40) << workload.name << std::right << std::fixed << std::setprecision(3)
+                  << " total " << best["total"] << "s, G-code processor " << best["gcode_processor"] << "s" << std::defaultfloat << std::endl;
+        results.emplace(workload.name, std::move(best));
+    }
+    boost::nowide::remove(gcode_path.c_str());
+
+    nlohmann::json json = results_to_json(results);
+    if (! output_path.empty()) {
+        boost::nowide::ofstream file(output_path);
+        file << json.dump(2) << std::endl;
+        if (! file) {
+            std::cerr << "Failed to write " << output_path << std::endl;
+            return EXIT_FAILURE;
+        }
+    } else
+        std::cout << json.dump(2) << std::endl;
+
+    if (! baseline_path.empty()) {
+        size_t regressions = 0;
+        try {
+            nlohmann::json baseline;
+            boost::nowide::ifstream file(baseline_path);
+            file >> baseline;
+            regressions = compare_with_baseline(results, baseline, threshold, min_delta);
+        } catch (const std::exception &ex) {
+            std::cerr << "Failed to read the baseline " << baseline_path << ": " << ex.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (regressions > 0) {
+            std::cout << regressions << " timings regressed over " << threshold * 100. << "% of the baseline" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "No regressions over " << threshold * 100. << "% of the baseline" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
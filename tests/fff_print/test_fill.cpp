@@ -5,6 +5,7 @@
 
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Fill/Fill.hpp"
+#include "libslic3r/Fill/FillTpms.hpp"
 #include "libslic3r/Flow.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/Print.hpp"
@@ -429,6 +430,51 @@ for my $pattern (qw(rectilinear honeycomb hilbertcurve concentric)) {
 }
 */
 
+TEST_CASE("Fill: triply periodic minimal surfaces", "[Fill]") {
+    auto tpms = [](TpmsSurface surface, double x, double y, double z) {
+        switch (surface) {
+        case TpmsSurface::Gyroid:   return sin(x) * cos(y) + sin(y) * cos(z) + sin(z) * cos(x);
+        case TpmsSurface::SchwarzP: return cos(x) + cos(y) + cos(z);
+        case TpmsSurface::SchwarzD: return sin(x) * sin(y) * sin(z) + sin(x) * cos(y) * cos(z) + cos(x) * sin(y) * cos(z) + cos(x) * cos(y) * sin(z);
+        case TpmsSurface::Neovius:  return 3. * (cos(x) + cos(y) + cos(z)) + 4. * cos(x) * cos(y) * cos(z);
+        }
+        return 0.;
+    };
+    const double scale = 1000.;
+    for (TpmsSurface surface : { TpmsSurface::Gyroid, TpmsSurface::SchwarzP, TpmsSurface::SchwarzD, TpmsSurface::Neovius })
+        for (double z : { 0.3, 1.1, 2.5 }) {
+            Polylines isolines = tpms_isolines(surface, z, 4. * PI, 4. * PI, 2. * PI / 32., scale);
+            REQUIRE(! isolines.empty());
+            double max_error = 0.;
+            for (const Polyline &pl : isolines)
+                for (const Point &pt : pl.points)
+                    max_error = std::max(max_error, std::abs(tpms(surface, pt.x() / scale, pt.y() / scale, z)));
+            // The isolines are interpolated linearly between the samples.
+            REQUIRE(max_error < 0.05);
+        }
+
+    // Sparse infill of the same density has about the same length with all the surfaces.
+    ExPolygon square(Polygon({ Point::new_scale(0, 0), Point::new_scale(50, 0), Point::new_scale(50, 50), Point::new_scale(0, 50) }));
+    FillParams fill_params;
+    fill_params.density     = 0.2f;
+    fill_params.dont_adjust = true;
+    auto fill_length = [&square, &fill_params](const char *pattern) {
+        std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(pattern));
+        filler->bounding_box = get_extents(square.contour);
+        filler->spacing      = 0.45;
+        filler->z            = 1.;
+        Surface   surface(stInternal, square);
+        Polylines paths = filler->fill_surface(&surface, fill_params);
+        REQUIRE(! paths.empty());
+        for (const Polyline &pl : paths)
+            REQUIRE(diff_pl(pl, offset(square, SCALED_EPSILON)).empty());
+        return total_length(paths);
+    };
+    const double gyroid_length = fill_length("gyroid");
+    for (const char *pattern : { "schwarzp", "schwarzd", "neovius" })
+        REQUIRE(fill_length(pattern) == Approx(gyroid_length).epsilon(0.25));
+}
+
 bool test_if_solid_surface_filled(const ExPolygon& expolygon, double flow_spacing, double angle, double density)
 {
     std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type("rectilinear"));
@@ -3,6 +3,7 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Trace.hpp"
 
 #include "test_data.hpp"
 
@@ -90,6 +91,47 @@ SCENARIO("Print: Changing number of solid surfaces does not cause all surfaces t
     }
 }
 
+SCENARIO("Print: Editing a layer range only regenerates the layers of that range.", "[Print]") {
+    GIVEN("sliced 20mm cube with 2 walls and a layer range from 5mm to 10mm") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "wall_loops",                 2 },
+            { "layer_height",               0.2 },
+            { "initial_layer_print_height", 0.2 }
+            });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        model.objects.front()->layer_config_ranges[{ 5., 10. }].set("wall_loops", 2);
+        print.apply(model, config);
+        print.process();
+        auto num_walls = [&print](size_t layer_id) {
+            return print.objects().front()->get_layer(int(layer_id))->regions().front()->perimeters.items_count();
+        };
+        WHEN("the layer range is changed to 4 walls") {
+            model.objects.front()->layer_config_ranges[{ 5., 10. }].set("wall_loops", 4);
+            Trace::start();
+            print.apply(model, config);
+            print.process();
+            Trace::stop();
+            const PrintObject &object = *print.objects().front();
+            THEN("only the layers of the range and their neighbors get new walls") {
+                size_t num_regenerated = 0;
+                for (const Trace::Total &total : Trace::totals())
+                    if (total.name == "make_perimeters")
+                        num_regenerated = total.count;
+                REQUIRE(num_regenerated >= 25);
+                REQUIRE(num_regenerated <= 27);
+                REQUIRE(num_regenerated < object.layers().size());
+            }
+            THEN("the layers of the range have 4 walls, the other layers keep 2 walls") {
+                for (const Layer *layer : object.layers())
+                    REQUIRE(num_walls(layer->id()) == (layer->slice_z > 5. && layer->slice_z < 10. ? 4 : 2));
+            }
+        }
+    }
+}
+
 SCENARIO("Print: Brim generation", "[Print]") {
     GIVEN("20mm cube and default config, 1mm first layer width") {
         WHEN("Brim is set to 3mm")  {
@@ -126,3 +168,39 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+SCENARIO("Print: allocation telemetry of the object steps", "[Print]") {
+    GIVEN("20mm cube and default config") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.process();
+        THEN("the slicing, perimeters and infill steps allocated memory") {
+            for (PrintObjectStep step : { posSlice, posPerimeters, posInfill }) {
+                if (! allocation_stats_available())
+                    break;
+                AllocationStats stats = print.step_allocation_stats(step);
+                INFO(print_object_step_name(step));
+                REQUIRE(stats.allocations > 0);
+                REQUIRE(stats.bytes > 0);
+            }
+        }
+        THEN("the peak RSS is reported at the end of the steps") {
+            REQUIRE(print.step_allocation_stats(posSlice).peak_rss <= print.step_allocation_stats(posInfill).peak_rss);
+            REQUIRE(print.step_allocation_stats(posInfill).peak_rss <= peak_rss());
+        }
+        WHEN("the infill density is changed") {
+            AllocationStats slice_stats = print.step_allocation_stats(posSlice);
+            config.set_deserialize_strict({ { "sparse_infill_density", "40%" } });
+            print.apply(model, config);
+            THEN("the stats of the invalidated infill step are reset, the stats of the slicing are kept") {
+                REQUIRE(print.step_allocation_stats(posInfill).allocations == 0);
+                REQUIRE(print.step_allocation_stats(posInfill).bytes == 0);
+                REQUIRE(print.step_allocation_stats(posInfill).peak_rss == 0);
+                REQUIRE(print.step_allocation_stats(posSlice).allocations == slice_stats.allocations);
+                REQUIRE(print.step_allocation_stats(posSlice).peak_rss == slice_stats.peak_rss);
+            }
+        }
+    }
+}
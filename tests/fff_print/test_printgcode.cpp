@@ -6,6 +6,7 @@
 #include "test_data.hpp"
 
 #include <algorithm>
+#include <thread>
 #include <boost/regex.hpp>
 
 using namespace Slic3r;
@@ -269,3 +270,33 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+SCENARIO("PrintGCode custom G-codes of plates sliced in parallel", "[PrintGCode]") {
+    GIVEN("Two plates with different custom G-codes") {
+        auto custom_gcodes = [](double print_z, const std::string &gcode) {
+            CustomGCode::Info info;
+            info.mode = CustomGCode::SingleExtruder;
+            info.gcodes.push_back({ print_z, CustomGCode::Custom, 1, "", gcode });
+            return info;
+        };
+        Slic3r::Model model_a, model_b;
+        model_a.plates_custom_gcodes[0] = custom_gcodes(5., "M117 custom gcode of plate A");
+        model_b.plates_custom_gcodes[0] = custom_gcodes(10., "M117 custom gcode of plate B");
+        Slic3r::Print print_a, print_b;
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20 }, print_a, model_a, { { "layer_height", 0.5 } });
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20 }, print_b, model_b, { { "layer_height", 0.5 } });
+        WHEN("both plates are exported at the same time") {
+            std::string gcode_a, gcode_b;
+            std::thread thread_a([&print_a, &gcode_a]() { gcode_a = Slic3r::Test::gcode(print_a); });
+            std::thread thread_b([&print_b, &gcode_b]() { gcode_b = Slic3r::Test::gcode(print_b); });
+            thread_a.join();
+            thread_b.join();
+            THEN("each plate contains its own custom G-code only") {
+                REQUIRE(gcode_a.find("M117 custom gcode of plate A") != std::string::npos);
+                REQUIRE(gcode_a.find("M117 custom gcode of plate B") == std::string::npos);
+                REQUIRE(gcode_b.find("M117 custom gcode of plate B") != std::string::npos);
+                REQUIRE(gcode_b.find("M117 custom gcode of plate A") == std::string::npos);
+            }
+        }
+    }
+}
@@ -3,6 +3,8 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/MultiMaterialSegmentation.hpp"
+#include "libslic3r/TriangleSelector.hpp"
 
 #include "test_data.hpp"
 
@@ -87,3 +89,122 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject]") {
 #endif
     }
 }
+
+SCENARIO("PrintObject: inter-layer delta index", "[PrintObject]") {
+    GIVEN("20mm cube") {
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print, {
+            { "layer_height", 0.5 }
+        });
+        ConstLayerPtrsAdaptor layers = print.objects().front()->layers();
+        THEN("The first layer is unsupported as a whole") {
+            const InterlayerDelta &delta = layers.front()->interlayer_delta;
+            REQUIRE(delta.valid());
+            REQUIRE(area(delta.unsupported()) == Approx(area(layers.front()->lslices)));
+        }
+        THEN("The other layers rest on the layer below") {
+            for (size_t i = 1; i < layers.size(); ++ i) {
+                const InterlayerDelta &delta = layers[i]->interlayer_delta;
+                REQUIRE(delta.valid());
+                REQUIRE(delta.unsupported().empty());
+                REQUIRE(! delta.unsupported_overlaps(get_extents(layers[i]->lslices)));
+            }
+        }
+        THEN("The offsets of the lower layer are shared") {
+            const InterlayerDelta &delta  = layers[1]->interlayer_delta;
+            const Polygons        &grown  = delta.lower_slices_offset(float(scale_(0.2)));
+            REQUIRE(&grown == &delta.lower_slices_offset(float(scale_(0.2))));
+            REQUIRE(area(grown) > area(layers.front()->lslices));
+        }
+    }
+    GIVEN("Bridge") {
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({TestMesh::bridge}, print, {
+            { "layer_height", 0.5 }
+        });
+        ConstLayerPtrsAdaptor layers = print.objects().front()->layers();
+        THEN("The bridge is indexed") {
+            bool overhang = false;
+            for (size_t i = 1; i < layers.size(); ++ i)
+                if (! layers[i]->interlayer_delta.unsupported().empty()) {
+                    REQUIRE(layers[i]->interlayer_delta.unsupported_overlaps(get_extents(layers[i]->interlayer_delta.unsupported())));
+                    overhang = true;
+                }
+            REQUIRE(overhang);
+        }
+    }
+}
+
+SCENARIO("PrintObject: cached painting segmentation", "[PrintObject]") {
+    GIVEN("20mm cube with a side painted by the second filament") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "filament_colour", "#FF0000;#00FF00" },
+            { "layer_height",    0.5 }
+        });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        ModelVolume     *volume = model.objects.front()->volumes.front();
+        TriangleSelector selector(volume->mesh());
+        const indexed_triangle_set &its = volume->mesh().its;
+        for (int facet_idx = 0; facet_idx < int(its.indices.size()); ++ facet_idx)
+            if (its_face_normal(its, facet_idx).x() > 0.5f)
+                selector.set_facet(facet_idx, EnforcerBlockerType::Extruder2);
+        volume->mmu_segmentation_facets.set(selector);
+        print.apply(model, config);
+        print.process();
+
+        const PrintObject &object = *print.objects().front();
+        auto throw_on_cancel = []() {};
+        const std::vector<std::vector<ExPolygons>> reference = multi_material_segmentation_by_painting(object, throw_on_cancel);
+        REQUIRE(std::any_of(reference.begin(), reference.end(), [](const std::vector<ExPolygons> &layer) { return layer.size() > 2 && ! layer[2].empty(); }));
+
+        WHEN("the segmentation is run twice with a cache") {
+            PaintingSegmentationCache cache;
+            const std::vector<std::vector<ExPolygons>> first = multi_material_segmentation_by_painting(object, throw_on_cancel, &cache);
+            const size_t segmented = cache.misses();
+            const std::vector<std::vector<ExPolygons>> second = multi_material_segmentation_by_painting(object, throw_on_cancel, &cache);
+            THEN("the second run reuses all the painted layers") {
+                REQUIRE(segmented > 0);
+                REQUIRE(cache.hits() == segmented);
+                REQUIRE(cache.misses() == 0);
+            }
+            THEN("the cached segmentation matches the one without the cache") {
+                REQUIRE(first == reference);
+                REQUIRE(second == reference);
+            }
+        }
+        WHEN("the bottom is painted too") {
+            REQUIRE(print.get_object(0)->mm_segmentation_cache().memory_size() > 0);
+            for (int facet_idx = 0; facet_idx < int(its.indices.size()); ++ facet_idx)
+                if (its_face_normal(its, facet_idx).z() < -0.5f)
+                    selector.set_facet(facet_idx, EnforcerBlockerType::Extruder2);
+            volume->mmu_segmentation_facets.set(selector);
+            print.apply(model, config);
+            print.process();
+            THEN("the PrintObject re-created by the paint stroke reuses the layers not touched by it") {
+                REQUIRE(print.get_object(0)->mm_segmentation_cache().hits() > 0);
+            }
+        }
+        WHEN("the painting is removed") {
+            REQUIRE(print.get_object(0)->mm_segmentation_cache().memory_size() > 0);
+            volume->mmu_segmentation_facets.reset();
+            print.apply(model, config);
+            print.process();
+            THEN("the cached layers are released") {
+                REQUIRE(print.get_object(0)->mm_segmentation_cache().memory_size() == 0);
+            }
+        }
+        WHEN("the cache is disabled") {
+            PaintingSegmentationCache::Budget budget(0);
+            PaintingSegmentationCache         cache(budget);
+            multi_material_segmentation_by_painting(object, throw_on_cancel, &cache);
+            const std::vector<std::vector<ExPolygons>> second = multi_material_segmentation_by_painting(object, throw_on_cancel, &cache);
+            THEN("nothing is stored") {
+                REQUIRE(cache.memory_size() == 0);
+                REQUIRE(second == reference);
+            }
+        }
+    }
+}
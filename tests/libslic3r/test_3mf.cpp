@@ -2,9 +2,13 @@
 
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/3mf.hpp"
+#include "libslic3r/Format/bbs_3mf.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/Semver.hpp"
+#include "libslic3r/Utils.hpp"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/nowide/fstream.hpp>
 
 using namespace Slic3r;
 
@@ -80,6 +84,107 @@ SCENARIO("Export+Import geometry to/from 3mf file cycle", "[3mf]") {
     }
 }
 
+SCENARIO("Loading a single plate of a multi plate 3mf project", "[3mf]") {
+    GIVEN("a project with an object on each of two plates and the G-code of the first plate") {
+        Model src_model;
+        std::string src_file = std::string(TEST_DATA_DIR) + "/test_3mf/Prusa.stl";
+        load_stl(src_file.c_str(), &src_model);
+        src_model.add_default_instances();
+        src_model.objects.front()->name = "plate_1_object";
+        src_model.add_object(*src_model.objects.front())->name = "plate_2_object";
+
+        std::string gcode_file = std::string(TEST_DATA_DIR) + "/test_3mf/plate_1.gcode";
+        const std::string gcode = "; plate 1\nG1 X10 Y10\n";
+        {
+            boost::nowide::ofstream ofs(gcode_file, std::ios::binary);
+            ofs << gcode;
+        }
+
+        PlateDataPtrs src_plates;
+        for (int i = 0; i < 2; ++ i) {
+            std::set<std::pair<int, int>> obj_to_inst_list { { i, 0 } };
+            src_plates.push_back(new PlateData(i, obj_to_inst_list, false));
+        }
+        src_plates.front()->gcode_file      = gcode_file;
+        src_plates.front()->is_sliced_valid = true;
+
+        std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/plates.3mf";
+        StoreParams store_params;
+        store_params.path            = test_file.c_str();
+        store_params.model           = &src_model;
+        store_params.plate_data_list = src_plates;
+        store_params.config          = nullptr;
+        store_params.strategy        = SaveStrategy::SplitModel | SaveStrategy::WithGcode | SaveStrategy::Zip64;
+        REQUIRE(store_bbs_3mf(store_params));
+        release_PlateData_list(src_plates);
+        boost::filesystem::remove(gcode_file);
+
+        WHEN("the second plate is loaded") {
+            Model                     dst_model;
+            DynamicPrintConfig        dst_config;
+            ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+            PlateDataPtrs             dst_plates;
+            std::vector<Preset*>      project_presets;
+            bool                      is_bbl_3mf = false;
+            Semver                    file_version;
+            bool ret = load_bbs_3mf(test_file.c_str(), &dst_config, &ctxt, &dst_model, &dst_plates, &project_presets, &is_bbl_3mf, &file_version,
+                nullptr, LoadStrategy::LoadModel | LoadStrategy::LoadConfig, nullptr, 2);
+            boost::filesystem::remove(test_file);
+
+            THEN("only the object of the second plate is loaded") {
+                REQUIRE(ret);
+                REQUIRE(dst_model.objects.size() == 1);
+                REQUIRE(dst_model.objects.front()->name == "plate_2_object");
+                REQUIRE(dst_model.objects.front()->mesh().its.vertices.size() == src_model.objects.back()->mesh().its.vertices.size());
+            }
+            THEN("the G-code of the first plate is kept for a re-export") {
+                REQUIRE(dst_plates.size() == 2);
+                REQUIRE(boost::filesystem::exists(dst_plates.front()->gcode_file));
+                std::string loaded_gcode;
+                load_string_file(dst_plates.front()->gcode_file, loaded_gcode);
+                REQUIRE(loaded_gcode == gcode);
+            }
+            release_PlateData_list(dst_plates);
+        }
+        WHEN("the plates of a warm cache outlive the backup directory of the 3mf") {
+            auto load = [&test_file](PlateDataPtrs &plates) {
+                Model                     model;
+                DynamicPrintConfig        config;
+                ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+                std::vector<Preset*>      project_presets;
+                bool                      is_bbl_3mf = false;
+                Semver                    file_version;
+                return load_bbs_3mf(test_file.c_str(), &config, &ctxt, &model, &plates, &project_presets, &is_bbl_3mf, &file_version,
+                    nullptr, LoadStrategy::LoadModel | LoadStrategy::LoadConfig, nullptr, 2);
+            };
+            PlateDataPtrs warm_plates;
+            REQUIRE(load(warm_plates));
+            const std::string cache_dir = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+            const std::string extracted = warm_plates.front()->gcode_file;
+            for (PlateData *plate : warm_plates)
+                REQUIRE(copy_PlateData_auxiliary_files(*plate, cache_dir));
+            // The backup directory is removed between the jobs of the daemon.
+            boost::filesystem::remove(extracted);
+
+            PlateDataPtrs cold_plates;
+            REQUIRE(load(cold_plates));
+            boost::filesystem::remove(test_file);
+            THEN("the warm plates carry the same files as the cold ones") {
+                REQUIRE(warm_plates.size() == cold_plates.size());
+                REQUIRE(warm_plates.front()->gcode_file != extracted);
+                std::string warm_gcode, cold_gcode;
+                load_string_file(warm_plates.front()->gcode_file, warm_gcode);
+                load_string_file(cold_plates.front()->gcode_file, cold_gcode);
+                REQUIRE(warm_gcode == gcode);
+                REQUIRE(warm_gcode == cold_gcode);
+            }
+            release_PlateData_list(warm_plates);
+            release_PlateData_list(cold_plates);
+            boost::filesystem::remove_all(cache_dir);
+        }
+    }
+}
+
 SCENARIO("2D convex hull of sinking object", "[3mf]") {
     GIVEN("model") {
         // load a model
@@ -3,6 +3,7 @@
 
 #include <libslic3r/TriangleMesh.hpp>
 #include <libslic3r/AABBTreeIndirect.hpp>
+#include <libslic3r/AABBTreeWide.hpp>
 
 using namespace Slic3r;
 
@@ -58,3 +59,122 @@ TEST_CASE("Building a tree over a box, ray caster and closest query", "[AABBIndi
     REQUIRE(closest_point.y() == Approx(0.5));
     REQUIRE(closest_point.z() == Approx(1.));
 }
+
+TEST_CASE("Wide trees and ray packets match the binary tree ray caster", "[AABBIndirect]")
+{
+    TriangleMesh tmesh = make_sphere(10., 2. * PI / 90.);
+    tmesh.translate(0.1f, 0.2f, 0.3f);
+
+    auto tree  = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(tmesh.its.vertices, tmesh.its.indices);
+    auto tree4 = AABBTreeIndirect::build_wide_tree<4>(tree);
+    auto tree8 = AABBTreeIndirect::build_wide_tree<8>(tree);
+    REQUIRE(! tree4.empty());
+    REQUIRE(! tree8.empty());
+
+    // Rays cast from the center and from outside of the sphere, including axis parallel rays and rays missing the sphere.
+    std::vector<Vec3d> origins;
+    std::vector<Vec3d> dirs;
+    for (int i = 0; i < 64; ++ i) {
+        double a = 2. * PI * i / 64.;
+        origins.emplace_back(Vec3d::Zero());
+        dirs.emplace_back(Vec3d(cos(a), sin(a), 0.3 * sin(3. * a)).normalized());
+        double r = (i % 2) ? 5. : 15.;
+        origins.emplace_back(Vec3d(r * cos(a), r * sin(a), -20.));
+        dirs.emplace_back(Vec3d(0., 0., 1.));
+    }
+
+    std::vector<igl::Hit> hits(origins.size());
+    std::vector<bool>     intersected(origins.size());
+    for (size_t i = 0; i < origins.size(); ++ i)
+        intersected[i] = AABBTreeIndirect::intersect_ray_first_hit(tmesh.its.vertices, tmesh.its.indices, tree, origins[i], dirs[i], hits[i]);
+    REQUIRE(std::count(intersected.begin(), intersected.end(), true) > 64);
+    REQUIRE(std::count(intersected.begin(), intersected.end(), false) > 0);
+
+    auto check = [&](size_t i, bool hit_found, const igl::Hit &hit) {
+        REQUIRE(hit_found == intersected[i]);
+        if (hit_found) {
+            REQUIRE(hit.id == hits[i].id);
+            REQUIRE(hit.t == Approx(hits[i].t));
+        }
+    };
+    auto check_packets = [&](const auto &tree, auto packet_size) {
+        static constexpr int N = decltype(packet_size)::value;
+        for (size_t i = 0; i < origins.size(); i += N) {
+            std::array<Vec3d, N>    packet_origins;
+            std::array<Vec3d, N>    packet_dirs;
+            std::array<igl::Hit, N> packet_hits;
+            for (int j = 0; j < N; ++ j) {
+                packet_origins[j] = origins[i + j];
+                packet_dirs[j]    = dirs[i + j];
+            }
+            uint32_t mask = AABBTreeIndirect::intersect_ray_packet_first_hit<N>(tmesh.its.vertices, tmesh.its.indices, tree, packet_origins, packet_dirs, packet_hits);
+            for (int j = 0; j < N; ++ j)
+                check(i + j, (mask >> j) & 1, packet_hits[j]);
+        }
+    };
+
+    SECTION("Single rays over BVH4 and BVH8") {
+        for (size_t i = 0; i < origins.size(); ++ i) {
+            igl::Hit hit;
+            check(i, AABBTreeIndirect::intersect_ray_first_hit(tmesh.its.vertices, tmesh.its.indices, tree4, origins[i], dirs[i], hit), hit);
+            check(i, AABBTreeIndirect::intersect_ray_first_hit(tmesh.its.vertices, tmesh.its.indices, tree8, origins[i], dirs[i], hit), hit);
+        }
+    }
+    SECTION("Ray packets over the binary tree") {
+        check_packets(tree, std::integral_constant<int, 4>());
+        check_packets(tree, std::integral_constant<int, 8>());
+    }
+    SECTION("Ray packets over BVH4 and BVH8") {
+        check_packets(tree4, std::integral_constant<int, 4>());
+        check_packets(tree8, std::integral_constant<int, 8>());
+        check_packets(tree8, std::integral_constant<int, 4>());
+    }
+}
+
+TEST_CASE("Ray fans over a wide tree match the binary tree ray caster", "[AABBIndirect]")
+{
+    // Two boxes shadowing each other, rays are cast from their faces to the outside as by the seam visibility.
+    TriangleMesh tmesh = make_cube(10., 10., 10.);
+    TriangleMesh other = make_cube(5., 20., 15.);
+    other.translate(12.f, -5.f, 0.f);
+    tmesh.merge(other);
+
+    auto tree  = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(tmesh.its.vertices, tmesh.its.indices);
+    auto tree4 = AABBTreeIndirect::build_wide_tree<4>(tree);
+
+    size_t num_hits = 0;
+    size_t num_rays = 0;
+    for (size_t face_idx = 0; face_idx < tmesh.its.indices.size(); ++ face_idx) {
+        const stl_triangle_vertex_indices &face   = tmesh.its.indices[face_idx];
+        Vec3d                              normal = its_face_normal(tmesh.its, int(face_idx)).cast<double>();
+        Vec3d origin = ((tmesh.its.vertices[face(0)] + tmesh.its.vertices[face(1)] + tmesh.its.vertices[face(2)]) / 3.f).cast<double>() + 0.01 * normal;
+        // 5x5 rays into the hemisphere above the face, a count not divisible by the packet size.
+        Vec3d              u = normal.unitOrthogonal();
+        Vec3d              v = normal.cross(u);
+        std::vector<Vec3d> dirs;
+        for (int i = 0; i < 5; ++ i)
+            for (int j = 0; j < 5; ++ j) {
+                double a = 2. * PI * (i + 0.5) / 5.;
+                double b = 0.5 * PI * (j + 0.5) / 5.;
+                dirs.emplace_back(normal * cos(b) + (u * cos(a) + v * sin(a)) * sin(b));
+            }
+        std::vector<bool> fan_hit(dirs.size(), false);
+        AABBTreeIndirect::intersect_ray_fan_first_hits<4>(tmesh.its.vertices, tmesh.its.indices, tree4, origin, dirs,
+            [&](size_t ray_idx, const igl::Hit &hit) {
+                igl::Hit expected;
+                REQUIRE(AABBTreeIndirect::intersect_ray_first_hit(tmesh.its.vertices, tmesh.its.indices, tree, origin, dirs[ray_idx], expected));
+                REQUIRE(hit.id == expected.id);
+                REQUIRE(hit.t == Approx(expected.t));
+                fan_hit[ray_idx] = true;
+            });
+        for (size_t ray_idx = 0; ray_idx < dirs.size(); ++ ray_idx)
+            if (! fan_hit[ray_idx]) {
+                igl::Hit expected;
+                REQUIRE(! AABBTreeIndirect::intersect_ray_first_hit(tmesh.its.vertices, tmesh.its.indices, tree, origin, dirs[ray_idx], expected));
+            }
+        num_hits += std::count(fan_hit.begin(), fan_hit.end(), true);
+        num_rays += dirs.size();
+    }
+    REQUIRE(num_hits > 0);
+    REQUIRE(num_hits < num_rays);
+}
@@ -0,0 +1,56 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/AllocationStats.hpp"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Slic3r;
+
+TEST_CASE("Allocation stats count operator new", "[AllocationStats]") {
+    REQUIRE(std::string(allocator_name()).size() > 0);
+    if (! allocation_stats_available()) {
+        // Built without SLIC3R_ALLOCATION_STATS.
+        REQUIRE(allocation_stats().allocations == 0);
+        REQUIRE(allocation_stats().bytes == 0);
+        return;
+    }
+    AllocationStats start = allocation_stats();
+    {
+        auto v = std::make_unique<std::vector<int>>(1000, 1);
+        REQUIRE(v->size() == 1000);
+    }
+    AllocationStats delta = allocation_stats() - start;
+    REQUIRE(delta.allocations >= 2);
+    REQUIRE(delta.bytes >= 1000 * sizeof(int));
+}
+
+TEST_CASE("Allocation stats sum the threads", "[AllocationStats]") {
+    if (! allocation_stats_available())
+        return;
+    AllocationStats start = allocation_stats();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++ i)
+        threads.emplace_back([] {
+            std::vector<std::unique_ptr<std::string>> strings;
+            for (int j = 0; j < 100; ++ j)
+                strings.emplace_back(std::make_unique<std::string>(100, 'x'));
+        });
+    for (std::thread &thread : threads)
+        thread.join();
+    REQUIRE((allocation_stats() - start).allocations >= 400);
+}
+
+TEST_CASE("Peak RSS is reported", "[AllocationStats]") {
+#if defined(WIN32) || defined(__linux__) || defined(__APPLE__)
+    REQUIRE(peak_rss() > 0);
+#endif
+    AllocationStats sum;
+    sum += AllocationStats{ 1, 10, 100 };
+    sum += AllocationStats{ 2, 20, 50 };
+    REQUIRE(sum.allocations == 3);
+    REQUIRE(sum.bytes == 30);
+    REQUIRE(sum.peak_rss == 100);
+}
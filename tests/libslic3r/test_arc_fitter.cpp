@@ -0,0 +1,142 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/ArcFitter.hpp"
+#include "libslic3r/Polyline.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace Slic3r;
+
+namespace {
+
+// ArcFitter::do_arc_fitting() fitting the whole segment from scratch at every point.
+std::vector<PathFittingData> reference_arc_fitting(const Points &points, double tolerance)
+{
+    std::vector<PathFittingData> result;
+    if (points.size() < 3)
+        return { PathFittingData{ 0, points.size() - 1, EMovePathType::Linear_move, ArcSegment() } };
+    size_t front_index = 0;
+    size_t back_index = 0;
+    ArcSegment last_arc;
+    Points current_segment;
+    ArcSegment target_arc;
+    for (size_t i = 0; i < points.size(); i++) {
+        back_index = i;
+        current_segment.push_back(points[i]);
+        if (back_index - front_index < 2)
+            continue;
+        if (ArcSegment::try_create_arc(current_segment, target_arc, Polyline(current_segment).length(), DEFAULT_SCALED_MAX_RADIUS, tolerance, DEFAULT_ARC_LENGTH_PERCENT_TOLERANCE)) {
+            last_arc = target_arc;
+            if (back_index == points.size() - 1) {
+                result.push_back({ front_index, back_index, last_arc.direction == ArcDirection::Arc_Dir_CCW ? EMovePathType::Arc_move_ccw : EMovePathType::Arc_move_cw, last_arc });
+                front_index = back_index;
+            }
+        } else {
+            if (back_index - front_index > 2)
+                result.push_back({ front_index, back_index - 1, last_arc.direction == ArcDirection::Arc_Dir_CCW ? EMovePathType::Arc_move_ccw : EMovePathType::Arc_move_cw, last_arc });
+            else if (result.empty() || result.back().path_type != EMovePathType::Linear_move)
+                result.push_back({ front_index, front_index + 1, EMovePathType::Linear_move, ArcSegment() });
+            else
+                result.back().end_point_index = front_index + 1;
+            front_index = back_index - 1;
+            current_segment = { points[front_index], points[front_index + 1] };
+        }
+    }
+    if (front_index != back_index) {
+        if (result.empty() || result.back().path_type != EMovePathType::Linear_move)
+            result.push_back({ front_index, back_index, EMovePathType::Linear_move, ArcSegment() });
+        else
+            result.back().end_point_index = back_index;
+    }
+    return result;
+}
+
+bool same_fitting(const PathFittingData &lhs, const PathFittingData &rhs)
+{
+    return lhs.start_point_index == rhs.start_point_index && lhs.end_point_index == rhs.end_point_index && lhs.path_type == rhs.path_type &&
+           lhs.arc_data.center == rhs.arc_data.center && lhs.arc_data.radius == rhs.arc_data.radius && lhs.arc_data.length == rhs.arc_data.length &&
+           lhs.arc_data.start_point == rhs.arc_data.start_point && lhs.arc_data.end_point == rhs.arc_data.end_point;
+}
+
+// Curve winding around the origin with the radius and the spacing of the points in millimeters, the points displaced randomly by up to noise.
+Points curve(double radius_start, double radius_end, double angle, double spacing, double noise, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> displacement(-noise, noise);
+    Points out;
+    size_t num_points = size_t(std::abs(angle) * std::max(radius_start, radius_end) / spacing) + 1;
+    for (size_t i = 0; i < num_points; ++ i) {
+        double t = double(i) / double(num_points - 1);
+        double r = radius_start + t * (radius_end - radius_start);
+        out.emplace_back(Point::new_scale(r * cos(t * angle) + displacement(rng), r * sin(t * angle) + displacement(rng)));
+    }
+    return out;
+}
+
+// Dense curves with corners: circles and spirals joined by straight lines.
+Points wavy_contour(size_t num_waves, double spacing, double noise, std::mt19937 &rng)
+{
+    Points out;
+    for (size_t i = 0; i < num_waves; ++ i) {
+        Points wave = curve(5. + i % 3, 5. + i % 3 + (i % 2) * 2., (i % 2 ? 1. : -1.) * (1. + 0.5 * (i % 4)), spacing, noise, rng);
+        Point  shift = Point::new_scale(30. * i, 0.);
+        for (const Point &pt : wave)
+            out.emplace_back(pt + shift);
+    }
+    return out;
+}
+
+} // namespace
+
+SCENARIO("Incremental arc fitting", "[ArcFitter]") {
+    std::mt19937 rng { 0 };
+    GIVEN("dense and noisy curves") {
+        for (double noise : { 0., 0.001, 0.01, 0.05 })
+            for (double tolerance : { 0.01, 0.05 }) {
+                Points points = wavy_contour(12, 0.2, noise, rng);
+                THEN("the arcs are identical to fitting every segment from scratch, noise " << noise << " tolerance " << tolerance) {
+                    std::vector<PathFittingData> result;
+                    ArcFitter::do_arc_fitting(points, result, scale_(tolerance));
+                    std::vector<PathFittingData> reference = reference_arc_fitting(points, scale_(tolerance));
+                    REQUIRE(result.size() == reference.size());
+                    for (size_t i = 0; i < result.size(); ++ i)
+                        REQUIRE(same_fitting(result[i], reference[i]));
+                    if (noise < tolerance)
+                        REQUIRE(std::count_if(result.begin(), result.end(), [](const PathFittingData &d) { return d.path_type != EMovePathType::Linear_move; }) >= 12);
+                }
+            }
+    }
+    GIVEN("a polygon with sharp corners") {
+        Points points;
+        for (int i = 0; i < 200; ++ i)
+            points.emplace_back(Point::new_scale(i * 0.5, (i % 2) * 0.5 + (i % 7) * 0.1));
+        THEN("only linear moves are produced") {
+            std::vector<PathFittingData> result;
+            ArcFitter::do_arc_fitting(points, result, scale_(0.05));
+            std::vector<PathFittingData> reference = reference_arc_fitting(points, scale_(0.05));
+            REQUIRE(result.size() == reference.size());
+            for (size_t i = 0; i < result.size(); ++ i)
+                REQUIRE(same_fitting(result[i], reference[i]));
+            REQUIRE(std::all_of(result.begin(), result.end(), [](const PathFittingData &d) { return d.path_type == EMovePathType::Linear_move; }));
+        }
+    }
+}
+
+// Incremental arc fitting against the fitting from scratch on 40 dense perimeters.
+TEST_CASE("Incremental arc fitting of dense perimeters", "[ArcFitter][Benchmark][.]") {
+    std::mt19937 rng { 0 };
+    // Perimeters of a finely tessellated large cylinder, slightly off round, and of a wavy curved model.
+    std::vector<Points> contours;
+    for (size_t i = 0; i < 20; ++ i)
+        contours.emplace_back(curve(40. + i * 0.4, 40.5 + i * 0.4, 5.5, 0.15, 0.0005, rng));
+    for (size_t i = 0; i < 20; ++ i)
+        contours.emplace_back(wavy_contour(10, 0.15, 0.0005, rng));
+    for (const Points &points : contours) {
+        std::vector<PathFittingData> result;
+        ArcFitter::do_arc_fitting(points, result, scale_(0.05));
+        std::vector<PathFittingData> reference = reference_arc_fitting(points, scale_(0.05));
+        REQUIRE(result.size() == reference.size());
+        for (size_t i = 0; i < result.size(); ++ i)
+            REQUIRE(same_fitting(result[i], reference[i]));
+    }
+}
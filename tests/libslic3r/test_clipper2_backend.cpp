@@ -0,0 +1,244 @@
+#include <catch2/catch.hpp>
+#include <test_utils.hpp>
+
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/TriangleMeshSlicer.hpp"
+
+#include <functional>
+
+using namespace Slic3r;
+
+// Differential test of the ClipperLib and Clipper2 backends of ClipperUtils.
+// The layers of the tests/data models are processed by the ClipperUtils operations the slicing pipeline spends most time in,
+// the results of both backends are compared by their geometric deltas.
+
+namespace {
+
+// Restores the backend active before the test.
+struct ClipperBackendGuard {
+    ClipperBackendGuard() : m_saved(clipper_backend()) {}
+    ~ClipperBackendGuard() { set_clipper_backend(m_saved); }
+    ClipperBackend m_saved;
+};
+
+struct Workload {
+    std::string             name;
+    std::vector<ExPolygons> layers;
+};
+
+std::vector<Workload> load_workloads(std::initializer_list<const char*> names)
+{
+    static constexpr const double layer_height = 0.2;
+    std::vector<Workload> out;
+    for (const char *name : names) {
+        TriangleMesh mesh = load_model(name);
+        if (mesh.empty())
+            continue;
+        // Scale the parts to a print bed sized workload.
+        mesh.scale(4.f);
+        mesh.translate(- mesh.bounding_box().min.cast<float>());
+        std::vector<float> zs;
+        for (double z = 0.5 * layer_height; z < mesh.bounding_box().max.z(); z += layer_height)
+            zs.emplace_back(float(z));
+        out.push_back({ name, slice_mesh_ex(mesh.its, zs) });
+    }
+    return out;
+}
+
+Polylines hatch_lines(const BoundingBox &bbox, coord_t spacing)
+{
+    Polylines out;
+    for (coord_t x = bbox.min.x(); x <= bbox.max.x(); x += spacing)
+        out.push_back(Polyline(Point(x, bbox.min.y()), Point(x, bbox.max.y())));
+    return out;
+}
+
+// Area of the symmetric difference of the results of both backends, evaluated by ClipperLib.
+double delta_area(const ExPolygons &expected, const ExPolygons &result)
+{
+    ClipperBackendGuard guard;
+    set_clipper_backend(ClipperBackend::ClipperLib);
+    double area = 0;
+    for (const ExPolygon &expoly : xor_ex(expected, result))
+        area += expoly.area();
+    return area;
+}
+
+double total_area(const ExPolygons &expolys)
+{
+    double area = 0;
+    for (const ExPolygon &expoly : expolys)
+        area += expoly.area();
+    return area;
+}
+
+struct Comparison {
+    double magnitude       { 0 };
+    double delta           { 0 };
+    double relative_delta() const { return magnitude > 0 ? delta / magnitude : 0; }
+};
+
+template<typename Result>
+std::vector<Result> run(ClipperBackend backend, const std::vector<Workload> &workloads, const std::function<Result(const std::vector<ExPolygons>&, size_t)> &op)
+{
+    ClipperBackendGuard guard;
+    set_clipper_backend(backend);
+    std::vector<Result> out;
+    for (const Workload &workload : workloads)
+        for (size_t layer_id = 0; layer_id < workload.layers.size(); ++ layer_id)
+            out.emplace_back(op(workload.layers, layer_id));
+    return out;
+}
+
+Comparison compare_ex(const std::vector<Workload> &workloads, const std::function<ExPolygons(const std::vector<ExPolygons>&, size_t)> &op)
+{
+    Comparison cmp;
+    std::vector<ExPolygons> expected = run(ClipperBackend::ClipperLib, workloads, op);
+    std::vector<ExPolygons> result   = run(ClipperBackend::Clipper2,   workloads, op);
+    REQUIRE(expected.size() == result.size());
+    for (size_t i = 0; i < expected.size(); ++ i) {
+        cmp.magnitude += total_area(expected[i]);
+        cmp.delta     += delta_area(expected[i], result[i]);
+    }
+    return cmp;
+}
+
+Comparison compare_pl(const std::vector<Workload> &workloads, const std::function<Polylines(const std::vector<ExPolygons>&, size_t)> &op)
+{
+    Comparison cmp;
+    std::vector<Polylines> expected = run(ClipperBackend::ClipperLib, workloads, op);
+    std::vector<Polylines> result   = run(ClipperBackend::Clipper2,   workloads, op);
+    REQUIRE(expected.size() == result.size());
+    for (size_t i = 0; i < expected.size(); ++ i) {
+        cmp.magnitude += total_length(expected[i]);
+        cmp.delta     += std::abs(total_length(expected[i]) - total_length(result[i]));
+    }
+    return cmp;
+}
+
+void differential_test(const std::vector<Workload> &workloads)
+{
+    REQUIRE(! workloads.empty());
+
+    const float line_width = float(scale_(0.45));
+    // Relative deltas are caused by the different approximation of the mitered corners and by the missing
+    // decimation of short edges of ClipperLib::ClipperOffset::ShortestEdgeLength in Clipper2.
+    const double max_relative_delta = 0.01;
+
+    Comparison perimeters = compare_ex(workloads, [line_width](const std::vector<ExPolygons> &layers, size_t layer_id) {
+        return offset2_ex(layers[layer_id], - 1.5f * line_width, 0.5f * line_width);
+    });
+    INFO("perimeters relative delta " << perimeters.relative_delta());
+    CHECK(perimeters.relative_delta() < max_relative_delta);
+
+    Comparison shrink = compare_ex(workloads, [line_width](const std::vector<ExPolygons> &layers, size_t layer_id) {
+        return shrink_ex(layers[layer_id], 2.f * line_width);
+    });
+    INFO("shrink relative delta " << shrink.relative_delta());
+    CHECK(shrink.relative_delta() < max_relative_delta);
+
+    Comparison merged = compare_ex(workloads, [](const std::vector<ExPolygons> &layers, size_t layer_id) {
+        ExPolygons expolys = layers[layer_id];
+        if (layer_id > 0)
+            append(expolys, layers[layer_id - 1]);
+        return union_ex(expolys);
+    });
+    INFO("merged relative delta " << merged.relative_delta());
+    CHECK(merged.relative_delta() < max_relative_delta);
+
+    Comparison overhangs = compare_ex(workloads, [line_width](const std::vector<ExPolygons> &layers, size_t layer_id) {
+        return layer_id == 0 ? ExPolygons() : diff_ex(layers[layer_id], offset(layers[layer_id - 1], 0.5f * line_width));
+    });
+    INFO("overhangs relative delta " << overhangs.relative_delta());
+    CHECK(overhangs.relative_delta() < max_relative_delta);
+
+    Comparison supported = compare_ex(workloads, [](const std::vector<ExPolygons> &layers, size_t layer_id) {
+        return layer_id == 0 ? ExPolygons() : intersection_ex(layers[layer_id], layers[layer_id - 1]);
+    });
+    INFO("supported relative delta " << supported.relative_delta());
+    CHECK(supported.relative_delta() < max_relative_delta);
+
+    Comparison brim = compare_ex(workloads, [line_width](const std::vector<ExPolygons> &layers, size_t layer_id) {
+        return layer_id == 0 ? offset_ex(layers.front(), 10.f * line_width, jtRound, scaled<double>(0.01)) : ExPolygons();
+    });
+    INFO("brim relative delta " << brim.relative_delta());
+    CHECK(brim.relative_delta() < max_relative_delta);
+
+    Comparison infill = compare_pl(workloads, [line_width](const std::vector<ExPolygons> &layers, size_t layer_id) {
+        return intersection_pl(hatch_lines(get_extents(layers[layer_id]), coord_t(2.f * line_width)), layers[layer_id]);
+    });
+    INFO("infill relative delta " << infill.relative_delta());
+    CHECK(infill.relative_delta() < max_relative_delta);
+}
+
+} // namespace
+
+TEST_CASE("Clipper2 backend selection", "[ClipperUtils][Clipper2]") {
+    ClipperBackendGuard guard;
+    set_clipper_backend(ClipperBackend::Clipper2);
+    REQUIRE(clipper_backend() == ClipperBackend::Clipper2);
+    set_clipper_backend(ClipperBackend::ClipperLib);
+    REQUIRE(clipper_backend() == ClipperBackend::ClipperLib);
+}
+
+SCENARIO("Clipper2 backend matches ClipperLib on simple shapes", "[ClipperUtils][Clipper2]") {
+    ClipperBackendGuard guard;
+    set_clipper_backend(ClipperBackend::Clipper2);
+    // CCW oriented contour
+    Slic3r::Polygon   square{ { 200, 100 }, {200, 200}, {100, 200}, {100, 100} };
+    // CW oriented contour
+    Slic3r::Polygon   hole_in_square{ { 160, 140 }, { 140, 140 }, { 140, 160 }, { 160, 160 } };
+    Slic3r::ExPolygon square_with_hole(square, hole_in_square);
+    GIVEN("square_with_hole") {
+        WHEN("offset_ex") {
+            ExPolygons result = offset_ex(square_with_hole, 5.f);
+            THEN("the contour grows and the hole shrinks") {
+                REQUIRE(result.size() == 1);
+                REQUIRE(result.front().contour.is_counter_clockwise());
+                REQUIRE(result.front().holes.size() == 1);
+                REQUIRE(result.front().holes.front().is_clockwise());
+                REQUIRE(result.front().area() == Approx(110. * 110. - 10. * 10.));
+            }
+        }
+        WHEN("shrunk until the hole eats the contour") {
+            THEN("the result is empty") {
+                REQUIRE(offset_ex(square_with_hole, -25.f).empty());
+                REQUIRE(shrink_ex(Polygons{ square }, 60.f).empty());
+            }
+        }
+        WHEN("opening") {
+            Polygons result = opening(Polygons{ square }, 10.f, 10.f);
+            THEN("the square is restored") {
+                REQUIRE(result.size() == 1);
+                REQUIRE(result.front().area() == Approx(square.area()));
+            }
+        }
+        WHEN("diff_ex with the hole") {
+            Polygon    hole = hole_in_square;
+            hole.reverse();
+            ExPolygons result = diff_ex(Polygons{ square }, Polygons{ hole });
+            THEN("the square with hole is produced") {
+                REQUIRE(result.size() == 1);
+                REQUIRE(result.front().holes.size() == 1);
+                REQUIRE(result.front().area() == Approx(square_with_hole.area()));
+            }
+        }
+        WHEN("intersection_pl of a line crossing the hole") {
+            Polylines result = intersection_pl(Polylines{ { { 50, 150 }, { 250, 150 } } }, square_with_hole);
+            THEN("two segments outside of the hole are produced") {
+                REQUIRE(result.size() == 2);
+                REQUIRE(total_length(result) == Approx(80.));
+            }
+        }
+    }
+}
+
+TEST_CASE("Clipper2 backend differential test on sliced models", "[ClipperUtils][Clipper2]") {
+    differential_test(load_workloads({ "20mm_cube.obj", "bridge.obj", "overhang.obj", "pyramid.obj" }));
+}
+
+// Perimeters, shrinking, merging and overhangs by the two backends on the slices of all the test models.
+TEST_CASE("Clipper2 backend differential test on all sliced models", "[ClipperUtils][Clipper2][Benchmark][.]") {
+    differential_test(load_workloads({ "20mm_cube.obj", "bridge.obj", "cube_with_concave_hole_enlarged.obj", "extruder_idler.obj",
+                                       "frog_legs.obj", "ipadstand.obj", "overhang.obj", "pyramid.obj", "sloping_hole.obj", "two_hollow_squares.obj" }));
+}
@@ -237,3 +237,41 @@ SCENARIO("DynamicPrintConfig serialization", "[Config]") {
         }
     }
 }
+
+SCENARIO("Interned option keys", "[Config]") {
+    GIVEN("A config generated from default options") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        const t_config_option_key_id id = ConfigOptionKeyTable::find("wall_loops");
+        THEN("The option key is interned by the ConfigDef.") {
+            REQUIRE(id != CONFIG_OPTION_KEY_ID_INVALID);
+            REQUIRE(ConfigOptionKeyTable::key(id) == "wall_loops");
+            REQUIRE(print_config_def.get("wall_loops")->opt_key_id == id);
+        }
+        WHEN("An option is modified through its name") {
+            config.set("wall_loops", 5);
+            THEN("The lookup by ID returns the same option.") {
+                REQUIRE(config.opt_by_id<ConfigOptionInt>(id) == config.opt<ConfigOptionInt>("wall_loops"));
+                REQUIRE(config.opt_by_id<ConfigOptionInt>(id)->value == 5);
+            }
+        }
+        WHEN("An option is erased") {
+            config.erase("wall_loops");
+            THEN("It is removed from the index as well.") {
+                REQUIRE(config.optptr_by_id(id) == nullptr);
+                REQUIRE(config.option("wall_loops") == nullptr);
+            }
+        }
+        WHEN("The config is copied and a static config is compared against it") {
+            DynamicPrintConfig copy = config;
+            copy.set("wall_loops", 7);
+            PrintRegionConfig region_config;
+            region_config.apply(config, true);
+            THEN("Diff reports the modified option only.") {
+                REQUIRE(copy.optptr_by_id(id) != config.optptr_by_id(id));
+                REQUIRE(copy.diff(config) == t_config_option_keys{ "wall_loops" });
+                REQUIRE(region_config.optptr_by_id(id) == region_config.option("wall_loops"));
+                REQUIRE(region_config.diff(copy) == t_config_option_keys{ "wall_loops" });
+            }
+        }
+    }
+}
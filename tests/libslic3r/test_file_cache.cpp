@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/FileCache.hpp"
+
+#include <boost/filesystem/fstream.hpp>
+
+using namespace Slic3r;
+
+namespace {
+
+void write_file(const boost::filesystem::path &path, const std::string &content)
+{
+    boost::filesystem::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+} // namespace
+
+SCENARIO("Values cached while their files are unchanged", "[FileCache]") {
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("file_cache_%%%%-%%%%");
+    boost::filesystem::create_directories(dir);
+    std::string a = (dir / "a.json").string();
+    std::string b = (dir / "b.json").string();
+    std::string c = (dir / "c.json").string();
+    write_file(a, "a");
+    write_file(b, "b");
+    write_file(c, "c");
+
+    GIVEN("a cache of two values") {
+        FileCache<std::string> cache(2);
+        *cache.insert("a|0", a) = "value of a";
+        WHEN("the file is unchanged") {
+            THEN("the value is found") {
+                REQUIRE(cache.find("a|0") != nullptr);
+                REQUIRE(*cache.find("a|0") == "value of a");
+                REQUIRE(cache.find("a|1") == nullptr);
+                REQUIRE(cache.hits() == 2);
+                REQUIRE(cache.misses() == 1);
+            }
+        }
+        WHEN("the file changes its size") {
+            write_file(a, "changed");
+            THEN("the value is dropped") {
+                REQUIRE(cache.find("a|0") == nullptr);
+                REQUIRE(cache.size() == 0);
+            }
+        }
+        WHEN("the file changes its time stamp") {
+            boost::filesystem::last_write_time(a, boost::filesystem::last_write_time(a) - 10);
+            THEN("the value is dropped") {
+                REQUIRE(cache.find("a|0") == nullptr);
+            }
+        }
+        WHEN("the file is removed") {
+            boost::filesystem::remove(a);
+            THEN("the value is dropped and a missing file is not cached") {
+                REQUIRE(cache.find("a|0") == nullptr);
+                REQUIRE(cache.insert("a|0", a) == nullptr);
+                REQUIRE(cache.size() == 0);
+            }
+        }
+        WHEN("more values are stored than the cache holds") {
+            *cache.insert("b|0", b) = "value of b";
+            REQUIRE(cache.find("a|0") != nullptr);
+            *cache.insert("c|0", c) = "value of c";
+            THEN("the least recently used value is dropped") {
+                REQUIRE(cache.size() == 2);
+                REQUIRE(cache.find("b|0") == nullptr);
+                REQUIRE(*cache.find("a|0") == "value of a");
+                REQUIRE(*cache.find("c|0") == "value of c");
+            }
+        }
+        WHEN("a value is stored again under the same key") {
+            *cache.insert("a|0", a) = "new value of a";
+            THEN("it replaces the previous one") {
+                REQUIRE(cache.size() == 1);
+                REQUIRE(*cache.find("a|0") == "new value of a");
+            }
+        }
+    }
+    boost::filesystem::remove_all(dir);
+}
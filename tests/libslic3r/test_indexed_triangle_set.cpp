@@ -309,3 +309,46 @@ TEST_CASE("Simplified cube should not be empty.", "[its]")
     its_quadric_edge_collapse(its, wanted_count, &max_error);
     CHECK(!its.indices.empty());
 }
+
+TEST_CASE("Partitioned simplification of a large mesh", "[its]")
+{
+    indexed_triangle_set its = its_make_sphere(10., 2. * PI / 640.);
+    REQUIRE(its.indices.size() > 200000);
+    double   original_volume = its_volume(its);
+    uint32_t wanted_count    = its.indices.size() * 0.05;
+    indexed_triangle_set simplified = its; // copy
+    float max_error = std::numeric_limits<float>::max();
+    its_quadric_edge_collapse_partitioned(simplified, wanted_count, &max_error);
+    CHECK(simplified.indices.size() <= wanted_count);
+    CHECK(!exist_triangle_with_twice_vertices(simplified.indices));
+    CHECK(its_num_open_edges(simplified) == 0);
+    CHECK(fabs(original_volume - its_volume(simplified)) < 0.01 * original_volume);
+
+    CompareConfig cfg;
+    cfg.max_average_distance = 0.05f;
+    cfg.max_distance         = 0.3f;
+    CHECK(is_similar(its, simplified, cfg));
+}
+
+TEST_CASE("Stitching simplified cells skips a removed locked vertex", "[its]")
+{
+    // Square of two triangles split into two cells, vertices 1 and 2 are on the cell border.
+    indexed_triangle_set its;
+    its.vertices = { Vec3f(0.f, 0.f, 0.f), Vec3f(1.f, 0.f, 0.f), Vec3f(0.f, 1.f, 0.f), Vec3f(1.f, 1.f, 0.f) };
+    its.indices  = { Vec3i(0, 1, 2), Vec3i(1, 3, 2) };
+
+    std::vector<ItsSimplifiedCell> cells(2);
+    // The first cell kept its triangle.
+    cells[0].its.vertices = { its.vertices[0], its.vertices[1], its.vertices[2] };
+    cells[0].its.indices  = { Vec3i(0, 1, 2) };
+    its_map_locked_vertices(cells[0], { 0, 1, 2 }, { false, true, true }, { 0, 1, 2 });
+    // The second cell lost the locked vertex 1 together with its last triangle of the cell.
+    cells[1].its.vertices = { its.vertices[2], its.vertices[3] };
+    its_map_locked_vertices(cells[1], { 1, 2, 3 }, { true, true, false }, { uint32_t(-1), 0, 1 });
+    CHECK(cells[1].global_vertex == std::vector<uint32_t>{ 2, uint32_t(-1) });
+
+    indexed_triangle_set merged = its_stitch_cells(its, cells);
+    CHECK(merged.vertices.size() == 4);
+    REQUIRE(merged.indices.size() == 1);
+    CHECK(merged.indices.front() == Vec3i(0, 1, 2));
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/GCode/LayerGCodeSpool.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace Slic3r;
+
+static std::string layer_gcode(size_t layer_idx)
+{
+    std::string out;
+    for (size_t i = 0; i < 100; ++ i)
+        out += "G1 X" + std::to_string(i) + " Y" + std::to_string(layer_idx) + " E0.1\n";
+    return out;
+}
+
+TEST_CASE("Layer G-code spool", "[GCode]") {
+    const size_t num_layers = 20;
+    SECTION("without a memory limit everything is held in memory") {
+        LayerGCodeSpool spool(num_layers, 0);
+        size_t total = 0;
+        for (size_t i = 0; i < num_layers; ++ i) {
+            total += layer_gcode(i).size();
+            spool.put(i, layer_gcode(i));
+        }
+        REQUIRE(spool.held_bytes() == total);
+        REQUIRE(spool.spilled_bytes() == 0);
+        for (size_t i = 0; i < num_layers; ++ i)
+            REQUIRE(spool.take(i) == layer_gcode(i));
+        REQUIRE(spool.held_bytes() == 0);
+    }
+    SECTION("above the memory limit the layers are spilled and read back") {
+        const size_t limit = 3 * layer_gcode(0).size() + 10;
+        LayerGCodeSpool spool(num_layers, limit);
+        for (size_t i = 0; i < num_layers; ++ i) {
+            spool.put(i, layer_gcode(i));
+            REQUIRE(spool.held_bytes() <= limit);
+        }
+        REQUIRE(spool.spilled_bytes() > 0);
+        for (size_t i = 0; i < num_layers; ++ i)
+            REQUIRE(spool.take(i) == layer_gcode(i));
+        REQUIRE(spool.held_bytes() == 0);
+    }
+    SECTION("layers may be put and taken interleaved") {
+        LayerGCodeSpool spool(num_layers, layer_gcode(0).size() + 10);
+        spool.put(0, layer_gcode(0));
+        spool.put(1, layer_gcode(1));
+        REQUIRE(spool.take(0) == layer_gcode(0));
+        spool.put(2, layer_gcode(2));
+        spool.put(3, layer_gcode(3));
+        REQUIRE(spool.take(1) == layer_gcode(1));
+        REQUIRE(spool.take(3) == layer_gcode(3));
+        REQUIRE(spool.take(2) == layer_gcode(2));
+    }
+    SECTION("layers may be put and taken by different threads") {
+        LayerGCodeSpool spool(num_layers, 2 * layer_gcode(0).size());
+        std::atomic<size_t> num_put { 0 };
+        std::thread producer([&spool, &num_put]() {
+            for (size_t i = 0; i < num_layers; ++ i) {
+                spool.put(i, layer_gcode(i));
+                ++ num_put;
+            }
+        });
+        bool all_equal = true;
+        for (size_t i = 0; i < num_layers; ++ i) {
+            while (num_put <= i)
+                std::this_thread::yield();
+            all_equal &= spool.take(i) == layer_gcode(i);
+        }
+        producer.join();
+        REQUIRE(all_equal);
+        REQUIRE(spool.held_bytes() == 0);
+    }
+}
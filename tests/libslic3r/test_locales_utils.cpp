@@ -0,0 +1,59 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "libslic3r/LocalesUtils.hpp"
+
+using namespace Slic3r;
+
+TEST_CASE("Fixed point float formatting matches float_to_string_decimal_point", "[LocalesUtils]") {
+    auto check = [](float value, int precision) {
+        INFO("value " << std::hexfloat << value << ", precision " << precision);
+        REQUIRE(float_to_string_decimal_point_fixed(value, precision) == float_to_string_decimal_point(value, precision));
+    };
+    SECTION("trailing zeros and the integer part") {
+        REQUIRE(float_to_string_decimal_point_fixed(1.5f, 3) == "1.500");
+        REQUIRE(float_to_string_decimal_point_fixed(250.f, 4) == "250.0000");
+        REQUIRE(float_to_string_decimal_point_fixed(7.f, 0) == "7");
+        for (float value : { 0.f, 0.1f, 1.f, 10.f, 100.5f, 1234.25f, 99999.f })
+            for (int precision = 0; precision <= 4; ++ precision)
+                check(value, precision);
+    }
+    SECTION("negative values and negative zero") {
+        REQUIRE(float_to_string_decimal_point_fixed(-0.f, 3) == "-0.000");
+        REQUIRE(float_to_string_decimal_point_fixed(-2.25f, 3) == "-2.250");
+        // Rounded to zero, the sign is kept.
+        REQUIRE(float_to_string_decimal_point_fixed(-0.0001f, 3) == "-0.000");
+        for (float value : { -0.f, -0.0001f, -0.0004f, -0.5f, -1.f, -12.3456f, -250.f })
+            for (int precision = 0; precision <= 4; ++ precision)
+                check(value, precision);
+    }
+    SECTION("rounding at the last digit") {
+        // Exact ties are rounded half to even.
+        REQUIRE(float_to_string_decimal_point_fixed(0.0625f, 3) == "0.062");
+        REQUIRE(float_to_string_decimal_point_fixed(0.1875f, 3) == "0.188");
+        REQUIRE(float_to_string_decimal_point_fixed(2.5f, 0) == "2");
+        for (float value : { 0.0625f, 0.1875f, -0.0625f, 0.5f, 1.5f, 2.5f, -2.5f, 0.00005f, 1.0005f, 0.9995f, 9.9995f, 99.99995f })
+            for (int precision = 0; precision <= 4; ++ precision) {
+                check(value, precision);
+                // The neighbors of a tie are rounded to the nearest.
+                check(std::nextafter(value, 0.f), precision);
+                check(std::nextafter(value, 2.f * value), precision);
+            }
+    }
+    SECTION("random coordinates and extrusions") {
+        std::mt19937                          rng(0);
+        std::uniform_real_distribution<float> coordinate(-500.f, 500.f);
+        std::uniform_real_distribution<float> extrusion(-2.f, 2.f);
+        for (int i = 0; i < 100000; ++ i) {
+            check(coordinate(rng), 3);
+            check(extrusion(rng), 4);
+        }
+    }
+    SECTION("out of range values fall back to the string stream") {
+        check(1e20f, 3);
+        check(- std::numeric_limits<float>::infinity(), 3);
+    }
+}
@@ -0,0 +1,223 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/Format/mesh_xml_parser.hpp"
+
+#include <expat.h>
+#include <fast_float/fast_float.h>
+
+#include <random>
+
+using namespace Slic3r;
+
+namespace {
+
+// Mimics a 3MF model file with a single large object.
+std::string model_xml(size_t num_vertices, const std::string &extra_triangle = std::string())
+{
+    std::mt19937 rng { 0 };
+    std::uniform_real_distribution<float> coord(-100.f, 100.f);
+    std::string out = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<model unit=\"millimeter\">\n <metadata name=\"Title\">a &lt; b</metadata>\n"
+                      " <resources>\n  <object id=\"1\" type=\"model\">\n   <mesh>\n    <vertices>\n";
+    char buf[256];
+    for (size_t i = 0; i < num_vertices; ++ i) {
+        sprintf(buf, "     <vertex x=\"%.9g\" y=\"%.9g\" z=\"%.9g\"/>\n", coord(rng), coord(rng), coord(rng));
+        out += buf;
+    }
+    out += "    </vertices>\n    <triangles>\n";
+    for (size_t i = 0; i + 2 < num_vertices; ++ i) {
+        sprintf(buf, "     <triangle v1=\"%d\" v2=\"%d\" v3=\"%d\"%s/>\n", int(i), int(i + 1), int(i + 2), i % 5 == 0 ? " paint_color='4'" : "");
+        out += buf;
+        if (i == num_vertices / 2)
+            out += extra_triangle;
+    }
+    out += "    </triangles>\n   </mesh>\n  </object>\n </resources>\n</model>\n";
+    return out;
+}
+
+struct Result
+{
+    std::string  xml;
+    MeshXmlChunk mesh;
+    size_t       num_scanned { 0 };
+};
+
+// Runs the filter over the file fed in pieces of piece_size bytes.
+Result filter(const std::string &data, size_t piece_size)
+{
+    Result out;
+    out.mesh.triangle_attributes.resize(1);
+    MeshXmlFilter filter({ "paint_color" },
+        [&out](const char *s, size_t n, bool) { out.xml.append(s, n); return true; },
+        [&out](MeshXmlChunk &&chunk) {
+            append(out.mesh.vertices, chunk.vertices);
+            append(out.mesh.triangles, chunk.triangles);
+            if (! chunk.triangles.empty())
+                append(out.mesh.triangle_attributes.front(), chunk.triangle_attributes.front());
+        });
+    for (size_t i = 0; i < data.size(); i += piece_size)
+        REQUIRE(filter.feed(data.data() + i, std::min(piece_size, data.size() - i), i + piece_size >= data.size()));
+    out.num_scanned = filter.num_vertices() + filter.num_triangles();
+    return out;
+}
+
+// Removes the content of the <vertices> and <triangles> elements.
+std::string strip_mesh(std::string xml)
+{
+    for (const char *tag : { "vertices", "triangles" }) {
+        size_t begin = xml.find(std::string("<") + tag + ">") + strlen(tag) + 2;
+        size_t end   = xml.find(std::string("</") + tag + ">");
+        xml.erase(begin, end - begin);
+    }
+    return xml;
+}
+
+} // namespace
+
+SCENARIO("Scanner of the 3MF mesh elements", "[3mf]") {
+    GIVEN("vertices and triangles") {
+        MeshXmlChunk out;
+        THEN("plain elements are parsed") {
+            std::string vertices = " <vertex x=\"1\" y='-2.5' z=\"1e2\"/>\n\t<vertex  z = \"3\" />";
+            REQUIRE(parse_mesh_xml_vertices(vertices.data(), vertices.data() + vertices.size(), out));
+            REQUIRE(out.vertices == std::vector<Vec3f>{ Vec3f(1.f, -2.5f, 100.f), Vec3f(0.f, 0.f, 3.f) });
+            std::string triangles = "<triangle v1=\"0\" v2=\"1\" v3=\"2\" paint_seam=\"8\"/><triangle v1=\"2\" v2=\"1\" v3=\"0\" pid=\"1\" paint_color=\"4\"/>";
+            REQUIRE(parse_mesh_xml_triangles(triangles.data(), triangles.data() + triangles.size(), { "paint_color", "paint_seam" }, out));
+            REQUIRE(out.triangles == std::vector<Vec3i>{ Vec3i(0, 1, 2), Vec3i(2, 1, 0) });
+            REQUIRE(out.triangle_attributes == std::vector<std::vector<std::string>>{ { "", "4" }, { "8", "" } });
+        }
+        THEN("anything unusual is left to expat") {
+            for (std::string text : {
+                    "<vertex x=\"1\"/><!-- comment -->",
+                    "<vertex x=\"1\" y=\"2\" x=\"3\"/>",
+                    "<vertex x=\"1mm\"/>",
+                    "<vertex x=\"&#49;\"/>",
+                    "<vertex x=\"1\"></vertex>",
+                    "<vertexx x=\"1\"/>",
+                    "<vertex x=\"1\"y=\"1\"/>",
+                    "<vertex x=\"1\"",
+                    "text" })
+                REQUIRE(! parse_mesh_xml_vertices(text.data(), text.data() + text.size(), out));
+            std::string triangle = "<triangle v1=\"+1\" v2=\"1\" v3=\"0\"/>";
+            REQUIRE(! parse_mesh_xml_triangles(triangle.data(), triangle.data() + triangle.size(), {}, out));
+        }
+    }
+    GIVEN("a model file with a large object") {
+        std::string xml = model_xml(100000);
+        REQUIRE(xml.size() > 5 * MeshXmlFilter::ChunkSize);
+        for (size_t piece_size : { size_t(7), size_t(65536), xml.size() }) {
+            Result result = filter(xml, piece_size);
+            THEN("expat gets the rest of the file, the mesh is parsed completely") {
+                REQUIRE(result.xml == strip_mesh(xml));
+                REQUIRE(result.mesh.vertices.size() == 100000);
+                REQUIRE(result.mesh.triangles.size() == 100000 - 2);
+                REQUIRE(result.mesh.triangles.back() == Vec3i(100000 - 3, 100000 - 2, 100000 - 1));
+                REQUIRE(result.mesh.triangle_attributes.front().size() == 100000 - 2);
+                REQUIRE(result.mesh.triangle_attributes.front()[5] == "4");
+                REQUIRE(result.mesh.triangle_attributes.front()[6].empty());
+                REQUIRE(result.num_scanned == 2 * 100000 - 2);
+            }
+        }
+    }
+    GIVEN("a model file with a comment in the middle of the triangles") {
+        std::string xml    = model_xml(100000, "<!-- comment -->\n");
+        Result      result = filter(xml, 65536);
+        THEN("the file starting with the chunk containing the comment is passed to expat") {
+            REQUIRE(result.mesh.vertices.size() == 100000);
+            REQUIRE(result.num_scanned == 100000 + result.mesh.triangles.size());
+            REQUIRE(result.mesh.triangles.size() < 100000 / 2);
+            // Vertices and triangles either parsed or passed to expat, never both.
+            size_t triangles_in_xml = 0;
+            for (size_t pos = 0; (pos = result.xml.find("<triangle ", pos)) != std::string::npos; ++ pos)
+                ++ triangles_in_xml;
+            REQUIRE(result.mesh.triangles.size() + triangles_in_xml == 100000 - 2);
+            REQUIRE(result.xml.find("<vertex ") == std::string::npos);
+            REQUIRE(result.xml.find("<!-- comment -->") != std::string::npos);
+            REQUIRE(result.xml.substr(result.xml.size() - 9) == "</model>\n");
+        }
+    }
+    GIVEN("mesh tags inside comments and CDATA") {
+        std::string xml = "<model><!-- <vertices> --><![CDATA[<triangles>]]><vertices/><vertices><vertex x=\"1\"/></vertices></model>";
+        Result      result = filter(xml, 3);
+        THEN("only the real elements are scanned") {
+            REQUIRE(result.xml == "<model><!-- <vertices> --><![CDATA[<triangles>]]><vertices/><vertices></vertices></model>");
+            REQUIRE(result.mesh.vertices == std::vector<Vec3f>{ Vec3f(1.f, 0.f, 0.f) });
+        }
+    }
+}
+
+namespace {
+
+// Parses the mesh XML by expat alone and by the scanner passing the rest of the file to expat, the meshes are to be the same.
+void compare_with_expat(size_t num_vertices)
+{
+    std::string xml = model_xml(num_vertices);
+
+    // The mesh of the object as collected by the element handlers of the 3MF importer.
+    struct Mesh
+    {
+        MeshXmlChunk mesh;
+        static void start_element(void *user_data, const char *name, const char **attributes) {
+            auto attribute = [attributes](const char *key) -> const char* {
+                for (const char **a = attributes; *a != nullptr; a += 2)
+                    if (strcmp(*a, key) == 0)
+                        return a[1];
+                return nullptr;
+            };
+            auto number = [&attribute](const char *key) {
+                float v = 0.f;
+                if (const char *text = attribute(key); text != nullptr)
+                    fast_float::from_chars(text, text + strlen(text), v);
+                return v;
+            };
+            MeshXmlChunk &mesh = static_cast<Mesh*>(user_data)->mesh;
+            if (strcmp(name, "vertex") == 0)
+                mesh.vertices.emplace_back(number("x"), number("y"), number("z"));
+            else if (strcmp(name, "triangle") == 0) {
+                mesh.triangles.emplace_back(atoi(attribute("v1")), atoi(attribute("v2")), atoi(attribute("v3")));
+                const char *color = attribute("paint_color");
+                mesh.triangle_attributes.front().emplace_back(color == nullptr ? "" : color);
+            }
+        }
+    };
+    auto parse = [&xml](bool scanner) {
+        Mesh mesh;
+        mesh.mesh.triangle_attributes.resize(1);
+        XML_Parser parser = XML_ParserCreate(nullptr);
+        XML_SetUserData(parser, &mesh);
+        XML_SetElementHandler(parser, Mesh::start_element, [](void*, const char*) {});
+        if (scanner) {
+            MeshXmlFilter filter({ "paint_color" },
+                [parser](const char *s, size_t n, bool is_final) { return XML_Parse(parser, s, int(n), is_final) == XML_STATUS_OK; },
+                [&mesh](MeshXmlChunk &&chunk) {
+                    append(mesh.mesh.vertices, std::move(chunk.vertices));
+                    append(mesh.mesh.triangles, std::move(chunk.triangles));
+                    if (! chunk.triangle_attributes.empty())
+                        append(mesh.mesh.triangle_attributes.front(), std::move(chunk.triangle_attributes.front()));
+                });
+            // Same piece size as mz_zip_reader_extract_to_callback().
+            for (size_t i = 0; i < xml.size(); i += 65536)
+                REQUIRE(filter.feed(xml.data() + i, std::min<size_t>(65536, xml.size() - i), i + 65536 >= xml.size()));
+        } else {
+            for (size_t i = 0; i < xml.size(); i += 65536)
+                REQUIRE(XML_Parse(parser, xml.data() + i, int(std::min<size_t>(65536, xml.size() - i)), i + 65536 >= xml.size()) == XML_STATUS_OK);
+        }
+        XML_ParserFree(parser);
+        return std::move(mesh.mesh);
+    };
+    auto expat   = parse(false);
+    auto scanner = parse(true);
+    REQUIRE(scanner.vertices == expat.vertices);
+    REQUIRE(scanner.triangles == expat.triangles);
+    REQUIRE(scanner.triangle_attributes == expat.triangle_attributes);
+}
+
+} // namespace
+
+TEST_CASE("3MF mesh scanner matches expat", "[3mf]") {
+    compare_with_expat(20000);
+}
+
+// Mesh scanner against expat on a 3MF model of 1M vertices.
+TEST_CASE("3MF mesh scanner on a large model", "[3mf][Benchmark][.]") {
+    compare_with_expat(1000000);
+}
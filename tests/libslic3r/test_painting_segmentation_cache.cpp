@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/MultiMaterialSegmentation.hpp"
+
+using namespace Slic3r;
+
+static std::vector<ExPolygons> segmentation_of(const ExPolygon &expoly, size_t color, size_t num_extruders)
+{
+    std::vector<ExPolygons> out(num_extruders + 1);
+    out[color].emplace_back(expoly);
+    return out;
+}
+
+TEST_CASE("Painting segmentation cache", "[MMSegmentation]") {
+    const size_t             num_layers    = 3;
+    const size_t             num_extruders = 2;
+    const ExPolygons         slices { ExPolygon(Polygon({ { 0, 0 }, { 1000, 0 }, { 1000, 1000 }, { 0, 1000 } })) };
+    std::vector<PaintedLine> painted { { 0, 1, Line({ 1000, 100 }, { 1000, 900 }), 2 } };
+
+    PaintingSegmentationCache::Budget budget;
+    PaintingSegmentationCache         cache(budget);
+    cache.reset(num_layers, num_extruders);
+    REQUIRE(cache.find(1, slices, painted) == nullptr);
+    cache.store(1, slices, std::vector<PaintedLine>(painted), segmentation_of(slices.front(), 2, num_extruders));
+
+    SECTION("The same slices and painting are reused") {
+        cache.reset(num_layers, num_extruders);
+        const std::vector<ExPolygons> *cached = cache.find(1, slices, painted);
+        REQUIRE(cached != nullptr);
+        REQUIRE(cached->size() == num_extruders + 1);
+        REQUIRE((*cached)[2] == slices);
+        REQUIRE(cache.hits() == 1);
+        REQUIRE(cache.misses() == 0);
+    }
+    SECTION("Other layers are not matched") {
+        REQUIRE(cache.find(0, slices, painted) == nullptr);
+        REQUIRE(cache.find(2, slices, painted) == nullptr);
+    }
+    SECTION("A modified stroke is segmented again") {
+        std::vector<PaintedLine> repainted = painted;
+        repainted.front().color = 1;
+        REQUIRE(cache.find(1, slices, repainted) == nullptr);
+        repainted = painted;
+        repainted.front().projected_line.b.y() = 800;
+        REQUIRE(cache.find(1, slices, repainted) == nullptr);
+    }
+    SECTION("Modified slices are segmented again") {
+        ExPolygons moved = slices;
+        moved.front().translate(10, 0);
+        REQUIRE(cache.find(1, moved, painted) == nullptr);
+    }
+    SECTION("Erased layer is not reused") {
+        cache.erase(1);
+        REQUIRE(cache.find(1, slices, painted) == nullptr);
+    }
+    SECTION("The stored layers are bounded by the memory size") {
+        const size_t memory_size = cache.memory_size();
+        REQUIRE(memory_size > 0);
+        cache.store(0, slices, std::vector<PaintedLine>(painted), segmentation_of(slices.front(), 1, num_extruders));
+        REQUIRE(cache.memory_size() == 2 * memory_size);
+        cache.erase(0);
+        REQUIRE(cache.memory_size() == memory_size);
+
+        REQUIRE(budget.memory_size() == memory_size);
+
+        budget.set_max_memory_size(2 * memory_size - 1);
+        cache.store(0, slices, std::vector<PaintedLine>(painted), segmentation_of(slices.front(), 1, num_extruders));
+        REQUIRE(cache.find(0, slices, painted) == nullptr);
+        REQUIRE(cache.find(1, slices, painted) != nullptr);
+        REQUIRE(budget.memory_size() == memory_size);
+    }
+    SECTION("The memory size is shared by the caches of a budget") {
+        const size_t memory_size = cache.memory_size();
+        budget.set_max_memory_size(2 * memory_size - 1);
+        {
+            PaintingSegmentationCache other(budget);
+            other.reset(num_layers, num_extruders);
+            other.store(1, slices, std::vector<PaintedLine>(painted), segmentation_of(slices.front(), 2, num_extruders));
+            REQUIRE(other.find(1, slices, painted) == nullptr);
+            cache.clear();
+            REQUIRE(budget.memory_size() == 0);
+            other.store(1, slices, std::vector<PaintedLine>(painted), segmentation_of(slices.front(), 2, num_extruders));
+            REQUIRE(other.find(1, slices, painted) != nullptr);
+            REQUIRE(budget.memory_size() == memory_size);
+        }
+        // Destroyed with its object.
+        REQUIRE(budget.memory_size() == 0);
+    }
+    SECTION("Zero memory size disables the cache") {
+        cache.clear();
+        budget.set_max_memory_size(0);
+        cache.reset(num_layers, num_extruders);
+        cache.store(1, slices, std::vector<PaintedLine>(painted), segmentation_of(slices.front(), 2, num_extruders));
+        REQUIRE(cache.memory_size() == 0);
+        REQUIRE(cache.find(1, slices, painted) == nullptr);
+    }
+    SECTION("Change of the number of layers or extruders drops the cache") {
+        cache.reset(num_layers, num_extruders + 1);
+        REQUIRE(cache.find(1, slices, painted) == nullptr);
+        cache.reset(num_layers, num_extruders);
+        cache.store(1, slices, std::vector<PaintedLine>(painted), segmentation_of(slices.front(), 2, num_extruders));
+        cache.reset(num_layers + 1, num_extruders);
+        REQUIRE(cache.find(1, slices, painted) == nullptr);
+    }
+}
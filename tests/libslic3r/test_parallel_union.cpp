@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/Surface.hpp"
+
+using namespace Slic3r;
+
+// The unions of inputs with many islands are split into clusters and united in parallel by ClipperUtils.
+// The results are compared to a single Clipper call over the same input.
+
+namespace {
+
+Polygon circle(const Point &center, coord_t radius, size_t num_points)
+{
+    Polygon out;
+    out.points.reserve(num_points);
+    for (size_t i = 0; i < num_points; ++ i) {
+        double angle = 2. * PI * double(i) / double(num_points);
+        out.points.emplace_back(center + Point(coord_t(radius * cos(angle)), coord_t(radius * sin(angle))));
+    }
+    return out;
+}
+
+// Grid of circles with the given spacing of the centers. Neighbour circles overlap if spacing < 2 * radius.
+Polygons grid(size_t cols, size_t rows, coord_t spacing, coord_t radius, size_t num_points)
+{
+    Polygons out;
+    for (size_t row = 0; row < rows; ++ row)
+        for (size_t col = 0; col < cols; ++ col)
+            out.emplace_back(circle(Point(coord_t(col) * spacing, coord_t(row) * spacing), radius, num_points));
+    return out;
+}
+
+// Reference union by a single Clipper call. Only the pftNonZero unions are split, the winding numbers of the test inputs
+// are never negative, thus the pftPositive union produces the same result.
+ExPolygons union_reference(const Polygons &polygons)
+{
+    return union_ex(polygons, ClipperLib::pftPositive);
+}
+
+void require_same(const ExPolygons &result, const ExPolygons &expected)
+{
+    REQUIRE(result.size() == expected.size());
+    REQUIRE(area(result) == Approx(area(expected)));
+    REQUIRE(area(xor_ex(result, expected)) < SCALED_EPSILON * SCALED_EPSILON);
+}
+
+} // namespace
+
+SCENARIO("Parallel union of many islands", "[ClipperUtils]") {
+    GIVEN("a grid of disjoint circles") {
+        Polygons   circles  = grid(60, 60, scaled<coord_t>(3.), scaled<coord_t>(1.), 64);
+        ExPolygons expected = union_reference(circles);
+        REQUIRE(expected.size() == circles.size());
+        THEN("union_ex matches a single union") {
+            require_same(union_ex(circles), expected);
+        }
+        THEN("union_ matches a single union") {
+            require_same(union_ex(union_(circles)), expected);
+        }
+        THEN("union_ex of ExPolygons matches a single union") {
+            require_same(union_ex(union_ex(circles)), expected);
+        }
+        THEN("the result is deterministic") {
+            ExPolygons result = union_ex(circles);
+            for (size_t i = 0; i < 5; ++ i)
+                REQUIRE(union_ex(circles) == result);
+        }
+    }
+    GIVEN("a grid of overlapping circles forming a single lattice") {
+        Polygons   circles  = grid(80, 80, scaled<coord_t>(1.5), scaled<coord_t>(1.), 32);
+        ExPolygons expected = union_reference(circles);
+        REQUIRE(expected.size() == 1);
+        THEN("union_ex matches a single union") {
+            require_same(union_ex(circles), expected);
+        }
+        THEN("union_ex of Surfaces matches a single union") {
+            Surfaces surfaces;
+            for (const Polygon &circle : circles)
+                surfaces.emplace_back(stInternal, ExPolygon(circle));
+            require_same(union_ex(surfaces), expected);
+        }
+    }
+    GIVEN("clusters of overlapping circles and a plate with separate holes") {
+        // A lattice united by a tree reduction.
+        Polygons circles = grid(40, 40, scaled<coord_t>(1.5), scaled<coord_t>(1.), 48);
+        // Pairs of overlapping circles right of the lattice, each pair is a small cluster.
+        for (Polygon circle : grid(20, 20, scaled<coord_t>(4.), scaled<coord_t>(1.), 48)) {
+            circle.translate(scaled<coord_t>(70.), 0);
+            circles.emplace_back(circle);
+            circle.translate(scaled<coord_t>(1.), scaled<coord_t>(1.));
+            circles.emplace_back(std::move(circle));
+        }
+        // A plate around the circles with holes passed as separate clockwise polygons,
+        // which cannot be united by parts.
+        coord_t size = scaled<coord_t>(70.);
+        Polygon plate { { - size, - size }, { 2 * size, - size }, { 2 * size, 2 * size }, { - size, 2 * size } };
+        plate.translate(0, 3 * size);
+        Polygons polygons = circles;
+        polygons.emplace_back(plate);
+        for (const Polygon &circle : grid(30, 30, scaled<coord_t>(5.), scaled<coord_t>(2.), 64)) {
+            Polygon hole = circle;
+            hole.translate(- size + scaled<coord_t>(10.), 2 * size + scaled<coord_t>(10.));
+            hole.reverse();
+            polygons.emplace_back(std::move(hole));
+        }
+        ExPolygons expected = union_reference(polygons);
+        THEN("union_ex matches a single union") {
+            require_same(union_ex(polygons), expected);
+        }
+        THEN("union_ matches a single union") {
+            require_same(union_ex(union_(polygons)), expected);
+        }
+    }
+}
+
+// Parallel union of 20k overlapping circles against a single Clipper union.
+TEST_CASE("Parallel union of a dense grid of circles", "[ClipperUtils][Benchmark][.]") {
+    Polygons circles = grid(100, 100, scaled<coord_t>(1.5), scaled<coord_t>(1.), 32);
+    append(circles, grid(100, 100, scaled<coord_t>(3.), scaled<coord_t>(0.5), 32));
+    require_same(union_ex(circles), union_reference(circles));
+}
@@ -0,0 +1,240 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/ScratchArena.hpp"
+#include "libslic3r/AllocationStats.hpp"
+#include "libslic3r/MultiPoint.hpp"
+#include "libslic3r/ShortestPath.hpp"
+#include "libslic3r/clipper.hpp"
+
+using namespace Slic3r;
+
+TEST_CASE("Scratch arena", "[ScratchArena]") {
+    set_scratch_arena_enabled(true);
+    SECTION("outside of a scope the scratch containers allocate from the heap") {
+        ScratchVector<int> v(100, 1);
+        REQUIRE(v.get_allocator().arena() == nullptr);
+        REQUIRE(ScratchArena::current() == nullptr);
+    }
+    SECTION("inside of a scope the scratch containers allocate from the arena") {
+        ScratchArena::reset_stats();
+        {
+            ScratchArenaScope scratch;
+            REQUIRE(ScratchArena::current() != nullptr);
+            ScratchPoints points;
+            for (coord_t i = 0; i < 1000; ++ i)
+                points.emplace_back(i, 2 * i);
+            REQUIRE(points.get_allocator().arena() == ScratchArena::current());
+            REQUIRE(points[999] == Point(999, 1998));
+        }
+        REQUIRE(ScratchArena::current() == nullptr);
+        ScratchArena::Stats stats = ScratchArena::stats();
+        REQUIRE(stats.allocations > 0);
+        REQUIRE(stats.bytes >= 1000 * sizeof(Point));
+    }
+    SECTION("a nested scope shares the arena and does not release it") {
+        ScratchArenaScope scratch;
+        ScratchArena *arena = ScratchArena::current();
+        ScratchVector<int> outer(10, 7);
+        {
+            ScratchArenaScope nested;
+            REQUIRE(ScratchArena::current() == arena);
+            ScratchVector<int> inner(1000, 3);
+        }
+        REQUIRE(ScratchArena::current() == arena);
+        REQUIRE(outer == ScratchVector<int>(10, 7));
+    }
+    SECTION("the chunks are reused by the next scope of the thread") {
+        auto run = [] {
+            ScratchArenaScope scratch;
+            ScratchVector<double> v;
+            for (size_t i = 0; i < 10000; ++ i)
+                v.push_back(double(i));
+        };
+        run();
+        ScratchArena::reset_stats();
+        run();
+        ScratchArena::Stats stats = ScratchArena::stats();
+        REQUIRE(stats.allocations > 0);
+        REQUIRE(stats.chunks == 0);
+    }
+    SECTION("an oversized allocation gets a chunk of its own") {
+        ScratchArenaScope scratch;
+        ScratchArena *arena = ScratchArena::current();
+        auto *first = static_cast<std::byte*>(arena->allocate(16, 8));
+        void *large = arena->allocate(2 * ScratchArena::ChunkSize, 8);
+        // The free memory of the current chunk is still used by the following allocations.
+        auto *second = static_cast<std::byte*>(arena->allocate(16, 8));
+        REQUIRE(second == first + 16);
+        arena->deallocate(large, 2 * ScratchArena::ChunkSize);
+        REQUIRE(static_cast<std::byte*>(arena->allocate(16, 8)) == second + 16);
+    }
+    SECTION("a frame rewinds the arena when it ends") {
+        ScratchArenaScope scratch;
+        ScratchArena *arena = ScratchArena::current();
+        void *top = arena->allocate(16, 8);
+        arena->deallocate(top, 16);
+        {
+            ScratchArenaFrame frame;
+            REQUIRE(arena->frame_depth() == 1);
+            ScratchVector<int> v(100000, 1);
+            // The frame was not pinned by its own containers.
+            v.resize(200000, 2);
+        }
+        REQUIRE(arena->frame_depth() == 0);
+        REQUIRE(arena->allocate(16, 8) == top);
+    }
+    SECTION("a container growing inside of a deeper frame keeps its memory") {
+        ScratchArenaScope scratch;
+        ScratchArena *arena = ScratchArena::current();
+        ScratchVector<int> outer;
+        {
+            ScratchArenaFrame frame;
+            {
+                ScratchArenaFrame nested;
+                outer.assign(1000, 7);
+            }
+            // The nested frame did not rewind below the memory of the outer container, the new allocation does not overlap it.
+            ScratchVector<int> inner(1000, 3);
+            REQUIRE(outer == ScratchVector<int>(1000, 7));
+        }
+        ScratchVector<int> after(1000, 5);
+        REQUIRE(outer == ScratchVector<int>(1000, 7));
+        // Releasing the top of the arena does not go below the mark of the active frame.
+        void *top = arena->allocate(16, 8);
+        {
+            ScratchArenaFrame frame;
+            arena->deallocate(top, 16);
+            REQUIRE(arena->allocate(16, 8) != top);
+        }
+    }
+    SECTION("the arena may be disabled") {
+        set_scratch_arena_enabled(false);
+        {
+            ScratchArenaScope scratch;
+            REQUIRE(ScratchArena::current() == nullptr);
+            ScratchVector<int> v(100, 1);
+            REQUIRE(v.get_allocator().arena() == nullptr);
+        }
+        set_scratch_arena_enabled(true);
+    }
+}
+
+TEST_CASE("Douglas-Peucker inside of a scratch arena scope", "[ScratchArena]") {
+    Points points;
+    for (coord_t i = 0; i < 1000; ++ i)
+        points.emplace_back(scaled<coord_t>(0.1 * i), (i % 2) * 10);
+    Points simplified = MultiPoint::_douglas_peucker(points, scaled<double>(0.01));
+    ScratchArenaScope scratch;
+    REQUIRE(MultiPoint::_douglas_peucker(points, scaled<double>(0.01)) == simplified);
+    REQUIRE(simplified.size() == 2);
+}
+
+TEST_CASE("Chaining scratch points", "[ScratchArena]") {
+    Points points;
+    for (coord_t i = 0; i < 100; ++ i)
+        points.emplace_back((i * 37) % 101, (i * 53) % 103);
+    std::vector<size_t> expected = chain_points(points);
+    ScratchArenaScope scratch;
+    ScratchPoints scratch_points(points.begin(), points.end());
+    REQUIRE(chain_points(scratch_points) == expected);
+}
+
+TEST_CASE("Clipping inside of a scratch arena scope", "[ScratchArena]") {
+    set_scratch_arena_enabled(true);
+    Slic3r::ClipperLib::Paths subject;
+    for (coord_t i = 0; i < 100; ++ i) {
+        coord_t x = scaled<coord_t>(double(i % 10)), y = scaled<coord_t>(double(i / 10));
+        subject.push_back({ { x, y }, { x + scaled<coord_t>(1.5), y }, { x + scaled<coord_t>(1.5), y + scaled<coord_t>(1.5) }, { x, y + scaled<coord_t>(1.5) } });
+    }
+    auto clip = [&subject] {
+        Slic3r::ClipperLib::Clipper clipper;
+        clipper.AddPaths(subject, Slic3r::ClipperLib::ptSubject, true);
+        Slic3r::ClipperLib::Paths out;
+        clipper.Execute(Slic3r::ClipperLib::ctUnion, out, Slic3r::ClipperLib::pftNonZero, Slic3r::ClipperLib::pftNonZero);
+        return out;
+    };
+    Slic3r::ClipperLib::Paths expected = clip();
+    ScratchArena::reset_stats();
+    ScratchArenaScope scratch;
+    ScratchArena *arena = ScratchArena::current();
+    void *top = arena->allocate(16, 8);
+    arena->deallocate(top, 16);
+    REQUIRE(clip() == expected);
+    REQUIRE(ScratchArena::current() == arena);
+    // The intermediate data of the clipper was taken from the arena and released when the clipper was destroyed.
+    REQUIRE(arena->allocate(16, 8) == top);
+    Slic3r::ClipperLib::ClipperOffset co;
+    co.AddPaths(expected, Slic3r::ClipperLib::jtMiter, Slic3r::ClipperLib::etClosedPolygon);
+    Slic3r::ClipperLib::Paths offsetted;
+    co.Execute(offsetted, scaled<double>(0.1));
+    REQUIRE(offsetted.size() == expected.size());
+}
+
+TEST_CASE("Offsetting many polygons inside of a scratch arena scope", "[ScratchArena]") {
+    // More contours than fit the intermediate data of the offsetter into a chunk, so that it takes oversized chunks,
+    // which are returned to the heap when the offsetter ends. Run under AddressSanitizer to catch their use after free.
+    set_scratch_arena_enabled(true);
+    Slic3r::ClipperLib::Paths subject;
+    for (coord_t i = 0; i < 12000; ++ i) {
+        coord_t x = scaled<coord_t>(2. * (i % 100)), y = scaled<coord_t>(2. * (i / 100));
+        subject.push_back({ { x, y }, { x + scaled<coord_t>(1.), y }, { x + scaled<coord_t>(1.), y + scaled<coord_t>(1.) }, { x, y + scaled<coord_t>(1.) } });
+    }
+    auto offset = [&subject] {
+        Slic3r::ClipperLib::ClipperOffset co;
+        co.AddPaths(subject, Slic3r::ClipperLib::jtMiter, Slic3r::ClipperLib::etClosedPolygon);
+        Slic3r::ClipperLib::Paths out;
+        co.Execute(out, scaled<double>(0.1));
+        return out;
+    };
+    Slic3r::ClipperLib::Paths expected = offset();
+    ScratchArenaScope scratch;
+    for (size_t i = 0; i < 3; ++ i)
+        REQUIRE(offset() == expected);
+    REQUIRE(expected.size() == subject.size());
+}
+
+TEST_CASE("Heap allocations of clipping with and without the scratch arena", "[ScratchArena]") {
+    // Squares with square holes, offsetted and united the way the perimeters and the fills of a layer are.
+    Slic3r::ClipperLib::Paths subject;
+    for (coord_t i = 0; i < 50; ++ i) {
+        coord_t x = scaled<coord_t>(2. * (i % 10)), y = scaled<coord_t>(2. * (i / 10));
+        subject.push_back({ { x, y }, { x + scaled<coord_t>(1.5), y }, { x + scaled<coord_t>(1.5), y + scaled<coord_t>(1.5) }, { x, y + scaled<coord_t>(1.5) } });
+        subject.push_back({ { x + scaled<coord_t>(0.5), y + scaled<coord_t>(0.5) }, { x + scaled<coord_t>(0.5), y + scaled<coord_t>(1.) }, { x + scaled<coord_t>(1.), y + scaled<coord_t>(1.) }, { x + scaled<coord_t>(1.), y + scaled<coord_t>(0.5) } });
+    }
+    auto layer = [&subject] {
+        ScratchArenaScope scratch;
+        std::vector<Slic3r::ClipperLib::Paths> out;
+        for (double delta : { -0.1, -0.2, -0.3, 0.1 }) {
+            Slic3r::ClipperLib::ClipperOffset co;
+            co.AddPaths(subject, Slic3r::ClipperLib::jtMiter, Slic3r::ClipperLib::etClosedPolygon);
+            Slic3r::ClipperLib::Paths offsetted;
+            co.Execute(offsetted, scaled<double>(delta));
+            Slic3r::ClipperLib::Clipper clipper;
+            clipper.AddPaths(offsetted, Slic3r::ClipperLib::ptSubject, true);
+            out.emplace_back();
+            clipper.Execute(Slic3r::ClipperLib::ctUnion, out.back(), Slic3r::ClipperLib::pftNonZero, Slic3r::ClipperLib::pftNonZero);
+        }
+        return out;
+    };
+    auto measure = [&layer](bool arena_enabled, std::vector<Slic3r::ClipperLib::Paths> &out) {
+        set_scratch_arena_enabled(arena_enabled);
+        // The first run allocates the chunks retained by the arena of the thread.
+        layer();
+        AllocationStats start = allocation_stats();
+        out = layer();
+        return allocation_stats() - start;
+    };
+    std::vector<Slic3r::ClipperLib::Paths> out_heap, out_arena;
+    AllocationStats heap  = measure(false, out_heap);
+    AllocationStats arena = measure(true,  out_arena);
+    set_scratch_arena_enabled(true);
+    INFO("Heap allocations without the arena: " << heap.allocations << ", " << heap.bytes << " bytes");
+    INFO("Heap allocations with the arena: " << arena.allocations << ", " << arena.bytes << " bytes");
+    REQUIRE(out_arena == out_heap);
+    if (! allocation_stats_available())
+        // Built without SLIC3R_ALLOCATION_STATS, the heap allocations are not counted.
+        return;
+    // The output paths and the input paths of the offsetter remain on the heap.
+    REQUIRE(arena.allocations < heap.allocations);
+    REQUIRE(arena.bytes < heap.bytes / 4);
+}
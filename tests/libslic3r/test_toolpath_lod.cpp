@@ -0,0 +1,135 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/GCode/ToolpathLOD.hpp"
+
+#include <cmath>
+
+using namespace Slic3r;
+
+// Instances of a single chain over the vertices [first, last], as laid out by the G-code preview.
+static void add_chain(std::vector<float> &instances, uint32_t first, uint32_t last)
+{
+    for (uint32_t i = first; i < last; ++ i) {
+        instances.emplace_back(float(i));
+        instances.emplace_back(float(i + 1));
+        instances.emplace_back(i == first ? 0.f : 1.f);
+        instances.emplace_back(i == first ? 0.f : float(i - 1));
+    }
+}
+
+TEST_CASE("Toolpath LOD merges collinear instances", "[ToolpathLOD]") {
+    std::vector<Vec3f> positions;
+    for (int i = 0; i <= 100; ++ i)
+        positions.emplace_back(0.1f * float(i), 0.f, 0.2f);
+    std::vector<float> instances;
+    add_chain(instances, 0, 100);
+
+    auto position = [&positions](uint32_t i) { return positions[i]; };
+    auto key      = [](uint32_t) { return 1; };
+    std::vector<float> out;
+
+    REQUIRE(ToolpathLOD::simplify_instances(instances, 0.f, position, key, out) == 100);
+    REQUIRE(out == instances);
+
+    REQUIRE(ToolpathLOD::simplify_instances(instances, ToolpathLOD::level_tolerance(1), position, key, out) == 1);
+    REQUIRE(out[0] == 0.f);
+    REQUIRE(out[1] == 100.f);
+
+    SECTION("instances of different keys are not merged") {
+        auto split_key = [](uint32_t i) { return i <= 50 ? 1 : 2; };
+        REQUIRE(ToolpathLOD::simplify_instances(instances, ToolpathLOD::level_tolerance(1), position, split_key, out) == 2);
+        REQUIRE(out[1] == 50.f);
+        REQUIRE(out[4] == 50.f);
+        // the second chain continues the first one
+        REQUIRE(out[6] == 1.f);
+        REQUIRE(out[7] == 0.f);
+    }
+}
+
+TEST_CASE("Toolpath LOD keeps the shape within the tolerance", "[ToolpathLOD]") {
+    // circle of radius 10 mm made of 360 instances
+    std::vector<Vec3f> positions;
+    for (int i = 0; i <= 360; ++ i)
+        positions.emplace_back(10.f * std::cos(float(i) * float(M_PI) / 180.f), 10.f * std::sin(float(i) * float(M_PI) / 180.f), 0.2f);
+    // sub-pixel detail far from the circle
+    positions.emplace_back(50.f, 50.f, 0.2f);
+    positions.emplace_back(50.01f, 50.f, 0.2f);
+    std::vector<float> instances;
+    add_chain(instances, 0, 360);
+    add_chain(instances, 361, 362);
+
+    auto position = [&positions](uint32_t i) { return positions[i]; };
+    auto key      = [](uint32_t) { return 1; };
+    std::vector<float> out;
+    size_t last_count = 361;
+    for (size_t level = 1; level < ToolpathLOD::LevelsCount; ++ level) {
+        const float  tolerance = ToolpathLOD::level_tolerance(level);
+        const size_t count     = ToolpathLOD::simplify_instances(instances, tolerance, position, key, out);
+        REQUIRE(count < last_count);
+        last_count = count;
+        // the tiny instance is dropped, the circle is closed
+        REQUIRE(out[1] != 362.f);
+        REQUIRE(out[0] == 0.f);
+        REQUIRE(out[4 * count - 3] == 360.f);
+        // every dropped vertex stays within the tolerance from the simplified polyline
+        for (size_t i = 0; i < count; ++ i) {
+            const uint32_t first = uint32_t(out[4 * i]), second = uint32_t(out[4 * i + 1]);
+            const Vec3f    a = positions[first], ab = positions[second] - a;
+            for (uint32_t v = first + 1; v < second; ++ v) {
+                const Vec3f ap = positions[v] - a;
+                const float t  = std::clamp(ap.dot(ab) / ab.squaredNorm(), 0.f, 1.f);
+                REQUIRE((ap - t * ab).norm() <= tolerance + EPSILON);
+            }
+        }
+    }
+}
+
+TEST_CASE("Toolpath LOD level follows the screen pixel size", "[ToolpathLOD]") {
+    const BoundingBoxf3 box(Vec3d(0., 0., 0.), Vec3d(100., 100., 10.));
+    // orthographic projection of a 200 mm tall view into 1000 pixels, looking down
+    Transform3d projection = Transform3d::Identity();
+    projection.matrix()(0, 0) = 2. / 200.;
+    projection.matrix()(1, 1) = 2. / 200.;
+    Transform3d view = Transform3d::Identity();
+    view.translate(Vec3d(0., 0., -100.));
+
+    REQUIRE(ToolpathLOD::pixel_size(view, projection, 1000, box) == Approx(0.2f));
+    REQUIRE(ToolpathLOD::pixel_size(view, projection, 1000, BoundingBoxf3()) == 0.f);
+
+    // perspective projection with 90 degrees field of view, the top of the box is 90 mm from the camera
+    Transform3d perspective = Transform3d::Identity();
+    perspective.matrix()(3, 2) = -1.;
+    perspective.matrix()(3, 3) = 0.;
+    REQUIRE(ToolpathLOD::pixel_size(view, perspective, 1000, box) == Approx(0.18f));
+    // camera inside the box
+    REQUIRE(ToolpathLOD::pixel_size(Transform3d::Identity(), perspective, 1000, box) == 0.f);
+
+    REQUIRE(ToolpathLOD::select_level(0.f) == 0);
+    REQUIRE(ToolpathLOD::select_level(0.2f) == 1);
+    REQUIRE(ToolpathLOD::select_level(2.f) == 3);
+    REQUIRE(ToolpathLOD::select_level(1000.f) == ToolpathLOD::LevelsCount - 1);
+}
+
+TEST_CASE("Toolpath LOD keeps the changes of the attribute colored by the view", "[ToolpathLOD]") {
+    REQUIRE(ToolpathLOD::quantize_attribute(5.f, 5.f, 5.f) == 0);
+    REQUIRE(ToolpathLOD::quantize_attribute(0.f, 0.f, 100.f) == 0);
+    REQUIRE(ToolpathLOD::quantize_attribute(100.f, 0.f, 100.f) == ToolpathLOD::AttributeSteps - 1);
+    REQUIRE(ToolpathLOD::quantize_attribute(50.f, 0.f, 100.f) != ToolpathLOD::quantize_attribute(52.f, 0.f, 100.f));
+
+    // a straight line printed at 100 mm/s and slowed down to 20 mm/s in its middle
+    std::vector<Vec3f> positions;
+    std::vector<float> speeds;
+    for (int i = 0; i <= 100; ++ i) {
+        positions.emplace_back(0.1f * float(i), 0.f, 0.2f);
+        speeds.emplace_back(i > 40 && i <= 60 ? 20.f : 100.f);
+    }
+    std::vector<float> instances;
+    add_chain(instances, 0, 100);
+
+    auto position = [&positions](uint32_t i) { return positions[i]; };
+    auto key      = [&speeds](uint32_t i) { return ToolpathLOD::quantize_attribute(speeds[i], 20.f, 100.f); };
+    std::vector<float> out;
+    REQUIRE(ToolpathLOD::simplify_instances(instances, ToolpathLOD::level_tolerance(3), position, key, out) == 3);
+    REQUIRE(out[1] == 40.f);
+    REQUIRE(out[5] == 60.f);
+}
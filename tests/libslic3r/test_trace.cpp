@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/Trace.hpp"
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Slic3r;
+
+static size_t count_occurrences(const std::string &str, const std::string &pattern)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + pattern.size()))
+        ++ count;
+    return count;
+}
+
+TEST_CASE("Trace records scopes of all threads", "[Trace]") {
+    {
+        SLIC3R_TRACE_SCOPE("not_recorded", "test");
+    }
+
+    Trace::start();
+    const size_t threads = 4, layers = 5000;
+    // The workers run at the same time, a worker exiting early would hand its buffer over to the next one.
+    std::atomic<size_t> running { 0 };
+    std::vector<std::thread> workers;
+    for (size_t thread_id = 0; thread_id < threads; ++ thread_id)
+        workers.emplace_back([&running]() {
+            for (size_t layer_id = 0; layer_id < layers; ++ layer_id) {
+                SLIC3R_TRACE_SCOPE_ARG("layer", "test", layer_id);
+            }
+            ++ running;
+            while (running < threads)
+                std::this_thread::yield();
+        });
+    for (std::thread &worker : workers)
+        worker.join();
+    Trace::stop();
+
+    {
+        SLIC3R_TRACE_SCOPE("stopped", "test");
+    }
+
+    REQUIRE(Trace::event_count() == threads * layers);
+
+    std::ostringstream os;
+    Trace::export_chrome_json(os);
+    const std::string json = os.str();
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(count_occurrences(json, "\"name\":\"layer\"") == threads * layers);
+    REQUIRE(count_occurrences(json, "\"name\":\"thread_name\"") == threads);
+    REQUIRE(count_occurrences(json, "\"args\":{\"id\":" + std::to_string(layers - 1) + "}") == threads);
+    REQUIRE(json.find("not_recorded") == std::string::npos);
+    REQUIRE(json.find("stopped") == std::string::npos);
+
+    SECTION("totals sum up the events by name") {
+        std::vector<Trace::Total> totals = Trace::totals();
+        REQUIRE(totals.size() == 1);
+        REQUIRE(totals.front().name == "layer");
+        REQUIRE(totals.front().category == "test");
+        REQUIRE(totals.front().count == threads * layers);
+    }
+
+    SECTION("a new session drops the previous events") {
+        Trace::start();
+        {
+            SLIC3R_TRACE_SCOPE("again", "test");
+        }
+        Trace::stop();
+        REQUIRE(Trace::event_count() == 1);
+    }
+}
+
+TEST_CASE("Trace reuses the buffers of the exited threads", "[Trace]") {
+    Trace::start();
+    const size_t threads = 50;
+    for (size_t thread_id = 0; thread_id < threads; ++ thread_id)
+        std::thread([]() {
+            SLIC3R_TRACE_SCOPE("task", "test");
+        }).join();
+    Trace::stop();
+
+    REQUIRE(Trace::event_count() == threads);
+    std::ostringstream os;
+    Trace::export_chrome_json(os);
+    // The threads running one after the other share a single track.
+    REQUIRE(count_occurrences(os.str(), "\"name\":\"thread_name\"") == 1);
+}
@@ -0,0 +1,192 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/miniz_extension.hpp"
+
+#include <random>
+
+#include <tbb/parallel_for.h>
+
+using namespace Slic3r;
+
+namespace {
+
+// Mimics the mesh XML of a 3MF model file.
+std::string model_xml(size_t num_vertices)
+{
+    std::mt19937 rng { 0 };
+    std::uniform_real_distribution<float> coord(-100.f, 100.f);
+    std::string out = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<model>\n <vertices>\n";
+    char buf[256];
+    for (size_t i = 0; i < num_vertices; ++ i) {
+        sprintf(buf, "  <vertex x=\"%.9g\" y=\"%.9g\" z=\"%.9g\"/>\n", coord(rng), coord(rng), coord(rng));
+        out += buf;
+    }
+    out += " </vertices>\n</model>\n";
+    return out;
+}
+
+std::vector<std::pair<std::string, std::string>> read_archive(void *data, size_t size)
+{
+    std::vector<std::pair<std::string, std::string>> out;
+    mz_zip_archive archive;
+    mz_zip_zero_struct(&archive);
+    REQUIRE(mz_zip_reader_init_mem(&archive, data, size, 0));
+    for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&archive); ++ i) {
+        mz_zip_archive_file_stat stat;
+        REQUIRE(mz_zip_reader_file_stat(&archive, i, &stat));
+        size_t extracted_size = 0;
+        // Verifies the CRC-32 of the entry.
+        void  *extracted = mz_zip_reader_extract_to_heap(&archive, i, &extracted_size, 0);
+        REQUIRE(extracted != nullptr);
+        out.emplace_back(stat.m_filename, std::string((const char*)extracted, extracted_size));
+        mz_free(extracted);
+    }
+    mz_zip_reader_end(&archive);
+    return out;
+}
+
+} // namespace
+
+SCENARIO("Parallel deflate of ZIP entries", "[miniz]") {
+    GIVEN("an archive with entries streamed in parallel among entries added from memory") {
+        std::string large = model_xml(200000);
+        std::string small = "<config/>\n";
+        REQUIRE(large.size() > 5 * MZ_ParallelDeflateWriter::BlockSize);
+
+        mz_zip_archive archive;
+        mz_zip_zero_struct(&archive);
+        REQUIRE(mz_zip_writer_init_heap(&archive, 0, 1024 * 1024));
+        REQUIRE(mz_zip_writer_add_mem(&archive, "first.xml", small.data(), small.size(), MZ_DEFAULT_COMPRESSION));
+        {
+            MZ_ParallelDeflateWriter writer(archive);
+            REQUIRE(writer.open("3D/3dmodel.model", (uint64_t(1) << 30) * 16, MZ_DEFAULT_COMPRESSION));
+            // Write in pieces not aligned with the blocks.
+            for (size_t i = 0; i < large.size(); i += 77777)
+                REQUIRE(writer.write(large.data() + i, std::min<size_t>(77777, large.size() - i)));
+            REQUIRE(writer.size() == large.size());
+            REQUIRE(writer.finish());
+        }
+        {
+            // Exactly a single block.
+            MZ_ParallelDeflateWriter writer(archive);
+            REQUIRE(writer.open("block.xml", (uint64_t(1) << 32) - 1, MZ_DEFAULT_COMPRESSION));
+            REQUIRE(writer.write(large.data(), MZ_ParallelDeflateWriter::BlockSize));
+            REQUIRE(writer.finish());
+        }
+        {
+            MZ_ParallelDeflateWriter writer(archive);
+            REQUIRE(writer.open("empty.xml", (uint64_t(1) << 32) - 1, MZ_DEFAULT_COMPRESSION));
+            REQUIRE(writer.finish());
+        }
+        REQUIRE(mz_zip_writer_add_mem(&archive, "last.xml", small.data(), small.size(), MZ_DEFAULT_COMPRESSION));
+        void  *data = nullptr;
+        size_t size = 0;
+        REQUIRE(mz_zip_writer_finalize_heap_archive(&archive, &data, &size));
+        THEN("the entries are read back in order") {
+            auto entries = read_archive(data, size);
+            REQUIRE(entries.size() == 5);
+            REQUIRE(entries[0] == std::make_pair(std::string("first.xml"), small));
+            REQUIRE(entries[1].first == "3D/3dmodel.model");
+            REQUIRE(entries[1].second == large);
+            REQUIRE(entries[2].second == large.substr(0, MZ_ParallelDeflateWriter::BlockSize));
+            REQUIRE(entries[3] == std::make_pair(std::string("empty.xml"), std::string()));
+            REQUIRE(entries[4] == std::make_pair(std::string("last.xml"), small));
+        }
+        THEN("the large entry is compressed") {
+            REQUIRE(size < large.size() / 2);
+        }
+        mz_free(data);
+        mz_zip_writer_end(&archive);
+    }
+    GIVEN("entries compressed in parallel into in-memory archives and copied into an archive") {
+        std::vector<std::string> xmls;
+        for (size_t i = 0; i < 8; ++ i)
+            xmls.emplace_back(model_xml(1000 + 20000 * i));
+        std::vector<MZ_HeapArchive> heap_archives(xmls.size());
+        std::vector<char>           compressed(xmls.size(), false);
+        tbb::parallel_for(size_t(0), xmls.size(), [&xmls, &heap_archives, &compressed](size_t i) {
+            std::string name = "3D/Objects/object_" + std::to_string(i) + ".model";
+            MZ_ParallelDeflateWriter writer(heap_archives[i].archive());
+            compressed[i] = writer.open(name.c_str(), (uint64_t(1) << 32) - 1, MZ_DEFAULT_COMPRESSION) && writer.write(xmls[i]) && writer.finish();
+        });
+        REQUIRE(std::find(compressed.begin(), compressed.end(), false) == compressed.end());
+
+        mz_zip_archive archive;
+        mz_zip_zero_struct(&archive);
+        REQUIRE(mz_zip_writer_init_heap(&archive, 0, 1024 * 1024));
+        for (MZ_HeapArchive &heap_archive : heap_archives)
+            REQUIRE(heap_archive.copy_to(archive));
+        void  *data = nullptr;
+        size_t size = 0;
+        REQUIRE(mz_zip_writer_finalize_heap_archive(&archive, &data, &size));
+        THEN("the entries are read back in the order they were copied in") {
+            auto entries = read_archive(data, size);
+            REQUIRE(entries.size() == xmls.size());
+            for (size_t i = 0; i < xmls.size(); ++ i) {
+                REQUIRE(entries[i].first == "3D/Objects/object_" + std::to_string(i) + ".model");
+                REQUIRE(entries[i].second == xmls[i]);
+            }
+        }
+        mz_free(data);
+        mz_zip_writer_end(&archive);
+    }
+    GIVEN("CRC-32 of concatenated blocks") {
+        std::string a = "The quick brown fox ", b = "jumps over the lazy dog";
+        std::string ab = a + b;
+        mz_ulong crc_a  = mz_crc32(MZ_CRC32_INIT, (const unsigned char*)a.data(), a.size());
+        mz_ulong crc_b  = mz_crc32(MZ_CRC32_INIT, (const unsigned char*)b.data(), b.size());
+        mz_ulong crc_ab = mz_crc32(MZ_CRC32_INIT, (const unsigned char*)ab.data(), ab.size());
+        THEN("mz_crc32_combine matches the CRC-32 of the concatenation") {
+            REQUIRE(mz_crc32_combine(crc_a, crc_b, b.size()) == crc_ab);
+            REQUIRE(mz_crc32_combine(MZ_CRC32_INIT, crc_ab, ab.size()) == crc_ab);
+            REQUIRE(mz_crc32_combine(crc_ab, MZ_CRC32_INIT, 0) == crc_ab);
+        }
+    }
+}
+
+namespace {
+
+// Deflates the mesh XML serially and in parallel, the parallel deflate loses less than 1% of the compression ratio
+// to the blocks deflated independently.
+void compare_deflate(size_t num_vertices)
+{
+    std::string xml = model_xml(num_vertices);
+
+    auto deflate = [&xml](bool parallel) {
+        mz_zip_archive archive;
+        mz_zip_zero_struct(&archive);
+        mz_zip_writer_init_heap(&archive, 0, 1024 * 1024);
+        if (parallel) {
+            MZ_ParallelDeflateWriter writer(archive);
+            writer.open("3D/3dmodel.model", (uint64_t(1) << 30) * 16, MZ_DEFAULT_COMPRESSION);
+            writer.write(xml);
+            REQUIRE(writer.finish());
+        } else {
+            mz_zip_writer_staged_context context;
+            mz_zip_writer_add_staged_open(&archive, &context, "3D/3dmodel.model", (uint64_t(1) << 30) * 16, nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0);
+            mz_zip_writer_add_staged_data(&context, xml.data(), xml.size());
+            REQUIRE(mz_zip_writer_add_staged_finish(&context));
+        }
+        void  *data = nullptr;
+        size_t size = 0;
+        mz_zip_writer_finalize_heap_archive(&archive, &data, &size);
+        REQUIRE(read_archive(data, size).front().second == xml);
+        mz_zip_writer_end(&archive);
+        return size;
+    };
+    size_t serial   = deflate(false);
+    size_t parallel = deflate(true);
+    REQUIRE(parallel < serial * 101 / 100);
+}
+
+} // namespace
+
+TEST_CASE("Parallel deflate compression ratio", "[miniz]") {
+    // A few blocks of MZ_ParallelDeflateWriter::BlockSize.
+    compare_deflate(50000);
+}
+
+// Parallel against serial deflate of a 3MF model of 500k vertices.
+TEST_CASE("Parallel deflate of a large model", "[miniz][Benchmark][.]") {
+    compare_deflate(500000);
+}
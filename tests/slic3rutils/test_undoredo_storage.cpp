@@ -0,0 +1,132 @@
+#include <catch2/catch.hpp>
+
+#include "slic3r/Utils/UndoRedoStorage.hpp"
+
+#include <random>
+
+using namespace Slic3r::UndoRedo;
+
+namespace {
+
+// Mimics the serialization of a painted mesh (FacetsAnnotation): pairs of triangle ID and bitstream offset followed by the bitstream.
+std::string painting_data(size_t num_triangles, size_t seed)
+{
+	std::mt19937 rng { unsigned(seed) };
+	std::string out;
+	uint64_t timestamp = 1000 + seed;
+	out.append((const char*)&timestamp, 8);
+	for (int i = 0; i < int(num_triangles); ++ i) {
+		int pair[2] { i, int(rng() % 7) };
+		out.append((const char*)pair, sizeof(pair));
+	}
+	for (size_t i = 0; i < num_triangles / 8; ++ i)
+		out.push_back(char(rng() & 0x3));
+	return out;
+}
+
+// Mimics the serialization of a DynamicPrintConfig.
+std::string config_data(int wall_loops)
+{
+	std::string out;
+	for (int i = 0; i < 200; ++ i)
+		out += "option_" + std::to_string(i) + " = " + (i == 100 ? std::to_string(wall_loops) : std::to_string(i * 7 % 13)) + "\n";
+	return out;
+}
+
+} // namespace
+
+TEST_CASE("Undo / Redo storage round trip", "[UndoRedo]") {
+	SnapshotStorage storage;
+	std::string     painting = painting_data(100000, 1);
+	std::string     config1  = config_data(2);
+	std::string     config2  = config_data(3);
+
+	SnapshotStorage::Blob *b_painting = storage.insert(painting);
+	SnapshotStorage::Blob *b_config1  = storage.insert(config1);
+	SnapshotStorage::Blob *b_config2  = storage.insert(config2, b_config1);
+	storage.compress_async();
+
+	SECTION("equal data is shared") {
+		SnapshotStorage::Blob *b_copy = storage.insert(painting_data(100000, 1));
+		REQUIRE(b_copy == b_painting);
+		REQUIRE(b_painting->refcnt() == 2);
+		storage.release(b_copy);
+		REQUIRE(b_painting->refcnt() == 1);
+	}
+	SECTION("small change is stored as delta") {
+		REQUIRE(storage.statistics().num_deltas == 1);
+		REQUIRE(storage.load(b_config2) == config2);
+		// The base of the delta is kept alive by the delta.
+		storage.release(b_config1);
+		REQUIRE(storage.load(b_config2) == config2);
+	}
+	SECTION("large data is compressed in the background") {
+		storage.sync();
+		REQUIRE(storage.statistics().num_compressed == 1);
+		REQUIRE(storage.statistics().stored_bytes < painting.size());
+		REQUIRE(storage.load(b_painting) == painting);
+		REQUIRE(b_painting->matches_timestamp(1001));
+	}
+	SECTION("released while being compressed") {
+		storage.release(b_painting);
+		storage.sync();
+		REQUIRE(storage.statistics().num_blobs == 2);
+	}
+	SECTION("everything released") {
+		storage.release(b_painting);
+		storage.release(b_config1);
+		storage.release(b_config2);
+		REQUIRE(storage.empty());
+	}
+}
+
+namespace {
+
+// Simulates an editing session of a project with copies of a painted object: each snapshot serializes
+// the paintings of all copies and the config, while a single copy is being painted and the config is edited.
+void editing_session(size_t num_copies, size_t num_snapshots, size_t num_triangles)
+{
+	SnapshotStorage                                  storage;
+	std::vector<std::vector<SnapshotStorage::Blob*>> history(num_copies + 1);
+	size_t                                           raw_bytes = 0;
+	for (size_t snapshot = 0; snapshot < num_snapshots; ++ snapshot) {
+		std::vector<std::string> data;
+		for (size_t i = 0; i < num_copies; ++ i)
+			data.emplace_back(painting_data(num_triangles, i == 0 ? snapshot : 0));
+		data.emplace_back(config_data(int(snapshot % 5)));
+		storage.sync();
+		for (size_t i = 0; i < data.size(); ++ i) {
+			raw_bytes += data[i].size();
+			history[i].emplace_back(storage.insert(data[i], history[i].empty() ? nullptr : history[i].back()));
+		}
+		storage.compress_async();
+	}
+	storage.sync();
+	SnapshotStorage::Statistics stats = storage.statistics();
+	REQUIRE(stats.num_deduplicated > 0);
+	REQUIRE(stats.num_deltas > 0);
+	REQUIRE(stats.stored_bytes * 5 < raw_bytes);
+
+	// Verify the stored history.
+	for (size_t snapshot = 0; snapshot < num_snapshots; snapshot += 3) {
+		REQUIRE(storage.load(history[0][snapshot]) == painting_data(num_triangles, snapshot));
+		REQUIRE(storage.load(history[num_copies][snapshot]) == config_data(int(snapshot % 5)));
+	}
+	for (std::vector<SnapshotStorage::Blob*> &blobs : history)
+		for (SnapshotStorage::Blob *blob : blobs)
+			storage.release(blob);
+	REQUIRE(storage.empty());
+	REQUIRE(storage.statistics().num_blobs == 0);
+	REQUIRE(storage.statistics().stored_bytes == 0);
+}
+
+} // namespace
+
+TEST_CASE("Undo / Redo storage of an editing session", "[UndoRedo]") {
+	editing_session(4, 10, 5000);
+}
+
+// Deduplication, deltas and background compression of 50 snapshots of 8 copies of a large painted object.
+TEST_CASE("Undo / Redo storage of a long editing session", "[UndoRedo][Benchmark][.]") {
+	editing_session(8, 50, 50000);
+}